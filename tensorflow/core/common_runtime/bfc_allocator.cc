@@ -36,12 +36,25 @@ namespace tensorflow {
 
 constexpr BFCAllocator::ChunkHandle BFCAllocator::kInvalidChunkHandle;
 constexpr uint64 BFCAllocator::kMemDebugHistorySize;
+constexpr size_t BFCAllocator::kThreadCacheMaxChunksPerBin;
+constexpr size_t BFCAllocator::kThreadCacheMaxBytes;
+
+namespace {
+
+int64 NextAllocatorId() {
+  static std::atomic<int64> next_id(0);
+  return next_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+}  // namespace
 
 BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
                            bool allow_growth, const string& name,
-                           bool garbage_collection)
+                           bool garbage_collection, bool thread_local_cache)
     : garbage_collection_(garbage_collection),
       coalesce_regions_(sub_allocator->SupportsCoalescing()),
+      thread_local_cache_(thread_local_cache),
+      id_(NextAllocatorId()),
       sub_allocator_(sub_allocator),
       name_(name),
       free_chunks_list_(kInvalidChunkHandle),
@@ -401,6 +414,14 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
   // The BFC allocator tries to find the best fit first.
   BinNum bin_num = BinNumForSize(rounded_bytes);
 
+  if (thread_local_cache_ && freed_before == 0 &&
+      bin_num < kNumThreadCacheBins) {
+    void* ptr = AllocateFromThreadCache(rounded_bytes, num_bytes);
+    if (ptr != nullptr) {
+      return ptr;
+    }
+  }
+
   mutex_lock l(lock_);
   if (!timestamped_chunks_.empty()) {
     // Merge timestamped chunks whose counts have become safe for general use.
@@ -412,6 +433,15 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
     return ptr;
   }
 
+  // Before growing, return the chunks that other threads are holding on to.
+  if (thread_local_cache_ && FlushThreadCaches(/*held_locks=*/nullptr)) {
+    ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes, freed_before);
+    if (ptr != nullptr) {
+      AddTraceMe("MemoryAllocation", ptr);
+      return ptr;
+    }
+  }
+
   // Try to extend
   if (Extend(unused_alignment, rounded_bytes)) {
     ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes, freed_before);
@@ -585,6 +615,8 @@ void* BFCAllocator::FindChunkPtr(BinNum bin_num, size_t rounded_bytes,
           size_history_[slot] = stats_.bytes_in_use;
         }
 
+        MaybeRecordCacheableChunk(h);
+
         VLOG(4) << "Returning: " << chunk->ptr;
         if (VLOG_IS_ON(4)) {
           LOG(INFO) << "A: " << RenderOccupancy();
@@ -638,10 +670,201 @@ void BFCAllocator::SplitChunk(BFCAllocator::ChunkHandle h, size_t num_bytes) {
 void BFCAllocator::DeallocateRaw(void* ptr) {
   VLOG(1) << "DeallocateRaw " << Name() << " "
           << (ptr ? RequestedSize(ptr) : 0);
+  if (thread_local_cache_ && ptr != nullptr && DeallocateToThreadCache(ptr)) {
+    return;
+  }
   DeallocateRawInternal(ptr);
   retry_helper_.NotifyDealloc();
 }
 
+BFCAllocator::ThreadCache* BFCAllocator::GetThreadCache() {
+  // Keyed by allocator id rather than by address, so that a new allocator
+  // never picks up the cache of a deleted one.
+  static thread_local absl::flat_hash_map<int64, std::shared_ptr<ThreadCache>>
+      thread_caches;
+  std::shared_ptr<ThreadCache>& cache = thread_caches[id_];
+  if (cache == nullptr) {
+    cache = std::make_shared<ThreadCache>();
+    mutex_lock l(thread_caches_mu_);
+    thread_caches_.push_back(cache);
+  }
+  return cache.get();
+}
+
+BFCAllocator::LiveChunkShard* BFCAllocator::LiveChunkShardFor(
+    const void* ptr) const {
+  // Chunks are aligned to kMinAllocationSize, so the low bits carry no
+  // information.
+  const uintptr_t key = reinterpret_cast<uintptr_t>(ptr) >> kMinAllocationBits;
+  return &live_cacheable_chunks_[key % kNumLiveChunkShards];
+}
+
+bool BFCAllocator::FindLiveCacheableChunk(const void* ptr,
+                                          CacheableChunk* out) const {
+  if (!thread_local_cache_) {
+    return false;
+  }
+  LiveChunkShard* shard = LiveChunkShardFor(ptr);
+  mutex_lock l(shard->mu);
+  auto it = shard->chunks.find(ptr);
+  if (it == shard->chunks.end()) {
+    return false;
+  }
+  *out = it->second;
+  return true;
+}
+
+void* BFCAllocator::AllocateFromThreadCache(size_t rounded_bytes,
+                                            size_t num_bytes) {
+  ThreadCache* cache = GetThreadCache();
+  mutex_lock l(cache->mu);
+  std::vector<CacheableChunk>& bin = cache->bins[BinNumForSize(rounded_bytes)];
+  // Prefer the most recently freed chunk, which is most likely to be warm in
+  // the CPU caches.
+  auto it = bin.rbegin();
+  while (it != bin.rend() && it->size < rounded_bytes) {
+    ++it;
+  }
+  if (it == bin.rend()) {
+    return nullptr;
+  }
+  const CacheableChunk cached = *it;
+  bin.erase(std::next(it).base());
+  cache->cached_bytes -= cached.size;
+  thread_cached_bytes_.fetch_sub(cached.size, std::memory_order_relaxed);
+  num_thread_cached_allocs_.fetch_add(1, std::memory_order_relaxed);
+
+  // Code holding `lock_` may read the `Chunk` of this in-use chunk, e.g. when
+  // coalescing a neighbour, so record the new allocation in the live chunk
+  // shard only. Memory dumps keep reporting the op name and step id of the
+  // allocation that took the chunk from the bins.
+  CacheableChunk live = cached;
+  live.requested_size = num_bytes;
+  live.allocation_id = next_allocation_id_++;
+  LiveChunkShard* shard = LiveChunkShardFor(live.ptr);
+  mutex_lock shard_lock(shard->mu);
+  shard->chunks[live.ptr] = live;
+  return live.ptr;
+}
+
+bool BFCAllocator::DeallocateToThreadCache(void* ptr) {
+  CacheableChunk cached;
+  {
+    LiveChunkShard* shard = LiveChunkShardFor(ptr);
+    mutex_lock l(shard->mu);
+    auto it = shard->chunks.find(ptr);
+    if (it == shard->chunks.end()) {
+      return false;
+    }
+    cached = it->second;
+    shard->chunks.erase(it);
+  }
+  if (timing_counter_ != nullptr) {
+    return false;
+  }
+
+  std::vector<CacheableChunk> evicted;
+  {
+    ThreadCache* cache = GetThreadCache();
+    mutex_lock l(cache->mu);
+    std::vector<CacheableChunk>& bin = cache->bins[BinNumForSize(cached.size)];
+    bin.push_back(cached);
+    cache->cached_bytes += cached.size;
+    thread_cached_bytes_.fetch_add(cached.size, std::memory_order_relaxed);
+    // Evict the least recently freed chunks of the bin while the cache is
+    // over its limits.
+    size_t num_evicted = 0;
+    while (num_evicted < bin.size() &&
+           (bin.size() - num_evicted > kThreadCacheMaxChunksPerBin ||
+            cache->cached_bytes > kThreadCacheMaxBytes)) {
+      cache->cached_bytes -= bin[num_evicted].size;
+      ++num_evicted;
+    }
+    evicted.assign(bin.begin(), bin.begin() + num_evicted);
+    bin.erase(bin.begin(), bin.begin() + num_evicted);
+  }
+
+  if (!evicted.empty()) {
+    {
+      mutex_lock l(lock_);
+      for (const CacheableChunk& c : evicted) {
+        ReturnCachedChunk(c);
+      }
+    }
+    retry_helper_.NotifyDealloc();
+  }
+  return true;
+}
+
+void BFCAllocator::MaybeRecordCacheableChunk(ChunkHandle h) {
+  if (!thread_local_cache_ || timing_counter_ != nullptr) {
+    return;
+  }
+  Chunk* chunk = ChunkFromHandle(h);
+  if (BinNumForSize(chunk->size) >= kNumThreadCacheBins) {
+    return;
+  }
+  CacheableChunk cacheable;
+  cacheable.ptr = chunk->ptr;
+  cacheable.handle = h;
+  cacheable.size = chunk->size;
+  cacheable.requested_size = chunk->requested_size;
+  cacheable.allocation_id = chunk->allocation_id;
+  LiveChunkShard* shard = LiveChunkShardFor(chunk->ptr);
+  mutex_lock l(shard->mu);
+  shard->chunks[chunk->ptr] = cacheable;
+}
+
+void BFCAllocator::ReturnCachedChunk(const CacheableChunk& cached) {
+  thread_cached_bytes_.fetch_sub(cached.size, std::memory_order_relaxed);
+  MarkFree(cached.handle);
+  InsertFreeChunkIntoBin(TryToCoalesce(cached.handle, false));
+}
+
+bool BFCAllocator::FlushThreadCache(ThreadCache* cache) {
+  bool flushed = false;
+  for (std::vector<CacheableChunk>& bin : cache->bins) {
+    for (const CacheableChunk& c : bin) {
+      ReturnCachedChunk(c);
+      flushed = true;
+    }
+    bin.clear();
+  }
+  cache->cached_bytes = 0;
+  return flushed;
+}
+
+bool BFCAllocator::FlushThreadCaches(std::vector<mutex_lock>* held_locks)
+    TF_NO_THREAD_SAFETY_ANALYSIS {
+  if (!thread_local_cache_) {
+    return false;
+  }
+  std::vector<mutex_lock> locks;
+  locks.emplace_back(thread_caches_mu_);
+  bool flushed = false;
+  for (auto it = thread_caches_.begin(); it != thread_caches_.end();) {
+    if (it->use_count() == 1) {
+      // The thread that owned this cache has exited.
+      {
+        mutex_lock l((*it)->mu);
+        flushed |= FlushThreadCache(it->get());
+      }
+      it = thread_caches_.erase(it);
+      continue;
+    }
+    mutex_lock l((*it)->mu);
+    flushed |= FlushThreadCache(it->get());
+    if (held_locks != nullptr) {
+      locks.push_back(std::move(l));
+    }
+    ++it;
+  }
+  if (held_locks != nullptr) {
+    *held_locks = std::move(locks);
+  }
+  return flushed;
+}
+
 void BFCAllocator::DeallocateRawInternal(void* ptr) {
   if (ptr == nullptr) {
     VLOG(2) << "tried to deallocate nullptr";
@@ -889,6 +1112,10 @@ bool BFCAllocator::TracksAllocationSizes() const { return true; }
 
 size_t BFCAllocator::RequestedSize(const void* ptr) const {
   CHECK(ptr);
+  CacheableChunk live;
+  if (FindLiveCacheableChunk(ptr, &live)) {
+    return live.requested_size;
+  }
   mutex_lock l(lock_);
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle)
@@ -907,6 +1134,10 @@ size_t BFCAllocator::AllocatedSize(const void* ptr) const {
 }
 
 int64 BFCAllocator::AllocationId(const void* ptr) const {
+  CacheableChunk live;
+  if (FindLiveCacheableChunk(ptr, &live)) {
+    return live.allocation_id;
+  }
   mutex_lock l(lock_);
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle)
@@ -987,6 +1218,8 @@ string BFCAllocator::RenderOccupancy() {
 }
 
 void BFCAllocator::DumpMemoryLog(size_t num_bytes) {
+  std::vector<mutex_lock> thread_cache_locks;
+  FlushThreadCaches(&thread_cache_locks);
   const std::array<BinDebugInfo, kNumBins> bin_infos = get_bin_debug_info();
   LOG(INFO) << "BFCAllocator dump for " << Name();
   for (BinNum bin_num = 0; bin_num < kNumBins; bin_num++) {
@@ -1092,12 +1325,15 @@ MemoryDump BFCAllocator::RecordMemoryMap() {
 }
 
 MemoryDump BFCAllocator::RecordMemoryMapInternal() {
+  std::vector<mutex_lock> thread_cache_locks;
+  FlushThreadCaches(&thread_cache_locks);
   MemoryDump md;
   md.set_allocator_name(Name());
 
   // Record the general stats
   MemAllocatorStats* mas = md.mutable_stats();
-  mas->set_num_allocs(stats_.num_allocs);
+  mas->set_num_allocs(stats_.num_allocs + num_thread_cached_allocs_.load(
+                                              std::memory_order_relaxed));
   mas->set_bytes_in_use(stats_.bytes_in_use);
   mas->set_peak_bytes_in_use(stats_.peak_bytes_in_use);
   mas->set_largest_alloc_size(stats_.largest_alloc_size);
@@ -1154,12 +1390,17 @@ MemoryDump BFCAllocator::RecordMemoryMapInternal() {
 
 absl::optional<AllocatorStats> BFCAllocator::GetStats() {
   mutex_lock l(lock_);
-  return stats_;
+  AllocatorStats stats = stats_;
+  stats.num_allocs +=
+      num_thread_cached_allocs_.load(std::memory_order_relaxed);
+  stats.bytes_in_use -= thread_cached_bytes_.load(std::memory_order_relaxed);
+  return stats;
 }
 
 void BFCAllocator::ClearStats() {
   mutex_lock l(lock_);
   stats_.num_allocs = 0;
+  num_thread_cached_allocs_.store(0, std::memory_order_relaxed);
   stats_.peak_bytes_in_use = stats_.bytes_in_use;
   stats_.largest_alloc_size = 0;
 }
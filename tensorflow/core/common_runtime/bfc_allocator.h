@@ -17,12 +17,14 @@ limitations under the License.
 #define TENSORFLOW_CORE_COMMON_RUNTIME_BFC_ALLOCATOR_H_
 
 #include <array>
+#include <atomic>
 #include <deque>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/common_runtime/allocator_retry.h"
 #include "tensorflow/core/common_runtime/shared_counter.h"
@@ -46,12 +48,23 @@ class MemoryDump;
 // coalescing.  One assumption we make is that the process using this
 // allocator owns pretty much all of the memory, and that nearly
 // all requests to allocate memory go through this interface.
+//
+// If `thread_local_cache` is true, small chunks that are freed are kept in a
+// cache owned by the freeing thread, and reused by later allocations of the
+// same size class on that thread without taking the allocator-wide lock.
+// Cached chunks are returned to the bins when a thread's cache is full, when
+// an allocation cannot be satisfied from the bins, and before the memory map
+// is recorded or logged. Chunks in a cache do not count as in use in
+// `GetStats()`, but `peak_bytes_in_use` may include them. Allocations that
+// are served from a cache are not traced with `TraceMe`. The cache is not used
+// once a timing counter has been set.
 class BFCAllocator : public Allocator {
  public:
   // Takes ownership of sub_allocator.
   BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
                bool allow_growth, const string& name,
-               bool garbage_collection = false);
+               bool garbage_collection = false,
+               bool thread_local_cache = false);
   ~BFCAllocator() override;
 
   string Name() override { return name_; }
@@ -140,6 +153,16 @@ class BFCAllocator : public Allocator {
   // The following means that the largest bin'd chunk size is 256 << 21 = 512MB.
   static constexpr int kNumBins = 21;
 
+  // Only chunks from the first kNumThreadCacheBins bins, i.e. smaller than
+  // 256 << 9 = 128KB, are kept in thread-local caches.
+  static constexpr int kNumThreadCacheBins = 9;
+  // The maximum number of chunks per bin, and the maximum total size of the
+  // chunks, that a thread-local cache holds.
+  static constexpr size_t kThreadCacheMaxChunksPerBin = 16;
+  static constexpr size_t kThreadCacheMaxBytes = 2 << 20;
+  // The number of shards of `live_cacheable_chunks_`.
+  static constexpr int kNumLiveChunkShards = 16;
+
   // A Chunk points to a piece of memory that's either entirely free or entirely
   // in use by one user memory allocation.
   //
@@ -517,6 +540,72 @@ class BFCAllocator : public Allocator {
   std::array<BinDebugInfo, kNumBins> get_bin_debug_info()
       TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
+  // An in-use chunk that may be kept in a thread-local cache once it is freed.
+  // A chunk taken from a thread-local cache stays in use as far as `lock_` is
+  // concerned, and its `Chunk` is left untouched, because code holding
+  // `lock_` may read it concurrently. Instead, the requested size and
+  // allocation id of its current allocation are kept here.
+  struct CacheableChunk {
+    void* ptr = nullptr;
+    ChunkHandle handle = kInvalidChunkHandle;
+    size_t size = 0;
+    size_t requested_size = 0;
+    int64 allocation_id = -1;
+  };
+
+  // Freed chunks that are owned by one thread. A chunk in a cache is still in
+  // use as far as the bins are concerned.
+  struct ThreadCache {
+    mutex mu;
+    // The cached chunks of each bin, from least to most recently freed.
+    std::array<std::vector<CacheableChunk>, kNumThreadCacheBins> bins
+        TF_GUARDED_BY(mu);
+    size_t cached_bytes TF_GUARDED_BY(mu) = 0;
+  };
+
+  // Cacheable chunks that are currently allocated, keyed by their pointer.
+  struct LiveChunkShard {
+    mutex mu;
+    absl::flat_hash_map<const void*, CacheableChunk> chunks TF_GUARDED_BY(mu);
+  };
+
+  // Returns the cache of the calling thread, creating it if needed.
+  ThreadCache* GetThreadCache();
+
+  LiveChunkShard* LiveChunkShardFor(const void* ptr) const;
+
+  // Looks up the live cacheable chunk at 'ptr'. Returns false if 'ptr' was not
+  // allocated from a cacheable chunk.
+  bool FindLiveCacheableChunk(const void* ptr, CacheableChunk* out) const;
+
+  // Returns a chunk of at least 'rounded_bytes' from the cache of the calling
+  // thread, or nullptr if there is none.
+  void* AllocateFromThreadCache(size_t rounded_bytes, size_t num_bytes);
+
+  // Moves the chunk at 'ptr' to the cache of the calling thread. Returns false
+  // if the chunk must be freed with `DeallocateRawInternal()` instead.
+  bool DeallocateToThreadCache(void* ptr);
+
+  // Records that the in-use chunk 'h' may be moved to a thread-local cache
+  // when it is freed.
+  void MaybeRecordCacheableChunk(ChunkHandle h)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Frees a chunk that was taken out of a thread-local cache.
+  void ReturnCachedChunk(const CacheableChunk& cached)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Returns the chunks of 'cache' to the bins, and returns true if there were
+  // any.
+  bool FlushThreadCache(ThreadCache* cache)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(lock_, cache->mu);
+
+  // Returns the chunks of all thread-local caches to the bins, and returns true
+  // if there were any. If 'held_locks' is not null, the caches stay locked
+  // until it is destroyed, so that no chunk metadata changes meanwhile.
+  bool FlushThreadCaches(std::vector<mutex_lock>* held_locks)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   AllocatorRetry retry_helper_;
 
   // Structures immutable after construction
@@ -581,6 +670,12 @@ class BFCAllocator : public Allocator {
   // device's address space).
   const bool coalesce_regions_;
 
+  // Whether freed small chunks are kept in thread-local caches.
+  const bool thread_local_cache_;
+
+  // Unique among all BFCAllocators, used to look up the thread-local caches.
+  const int64 id_;
+
   std::unique_ptr<SubAllocator> sub_allocator_;
   string name_;
   SharedCounter* timing_counter_ = nullptr;
@@ -592,19 +687,31 @@ class BFCAllocator : public Allocator {
   mutable mutex lock_;
   RegionManager region_manager_ TF_GUARDED_BY(lock_);
 
-  std::vector<Chunk> chunks_ TF_GUARDED_BY(lock_);
+  // A deque, so that pointers to in-use chunks stay valid when it grows.
+  std::deque<Chunk> chunks_ TF_GUARDED_BY(lock_);
 
   // Pointer to head of linked list of free Chunks
   ChunkHandle free_chunks_list_ TF_GUARDED_BY(lock_);
 
   // Counter containing the next unique identifier to assign to a
   // newly-created chunk.
-  int64 next_allocation_id_ TF_GUARDED_BY(lock_);
+  std::atomic<int64> next_allocation_id_;
 
   // Stats.
   AllocatorStats stats_ TF_GUARDED_BY(lock_);
   uint64 action_counter_ TF_GUARDED_BY(lock_);
 
+  // Thread-local caches, see `thread_local_cache_`.
+  mutex thread_caches_mu_;
+  std::vector<std::shared_ptr<ThreadCache>> thread_caches_
+      TF_GUARDED_BY(thread_caches_mu_);
+  mutable std::array<LiveChunkShard, kNumLiveChunkShards>
+      live_cacheable_chunks_;
+  // Total size of the chunks in all thread-local caches.
+  std::atomic<int64> thread_cached_bytes_{0};
+  // Number of allocations served from thread-local caches.
+  std::atomic<int64> num_thread_cached_allocs_{0};
+
   // The circular buffer used to track memory operation history.
   static constexpr uint64 kMemDebugHistorySize = 4096;
   int64 size_history_[kMemDebugHistorySize];
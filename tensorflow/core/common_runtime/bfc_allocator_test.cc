@@ -17,9 +17,15 @@ limitations under the License.
 #include <algorithm>
 #include <random>
 
+#include "tensorflow/core/common_runtime/pool_allocator.h"
 #include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/protobuf/bfc_memory_map.pb.h"
 
 namespace tensorflow {
 
@@ -84,4 +90,140 @@ BENCHMARK(BM_Allocator)
     ->ArgPair(1000, 256)
     ->ArgPair(10000, 256);
 
+BFCAllocator* NewThreadLocalCacheAllocator() {
+  return new BFCAllocator(
+      new BasicCPUAllocator(port::kNUMANoAffinity, {}, {}), 1 << 30,
+      /*allow_growth=*/true, "cpu_bfc", /*garbage_collection=*/false,
+      /*thread_local_cache=*/true);
+}
+
+int NumChunksInUse(const MemoryDump& md) {
+  int num_chunks_in_use = 0;
+  for (const MemChunk& chunk : md.chunk()) {
+    num_chunks_in_use += chunk.in_use();
+  }
+  return num_chunks_in_use;
+}
+
+TEST(BFCAllocatorTest, ThreadLocalCacheReusesChunks) {
+  std::unique_ptr<BFCAllocator> a(NewThreadLocalCacheAllocator());
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 10; ++i) {
+    ptrs.push_back(a->AllocateRaw(1, 1000));
+  }
+  EXPECT_EQ(a->GetStats()->bytes_in_use, 10 * 1024);
+  for (void* ptr : ptrs) {
+    a->DeallocateRaw(ptr);
+  }
+  EXPECT_EQ(a->GetStats()->bytes_in_use, 0);
+
+  // The chunks are reused from the cache, most recently freed first.
+  std::vector<void*> reused_ptrs;
+  for (int i = 0; i < 10; ++i) {
+    reused_ptrs.push_back(a->AllocateRaw(1, 800));
+    EXPECT_EQ(a->RequestedSize(reused_ptrs.back()), 800);
+  }
+  EXPECT_TRUE(std::is_permutation(ptrs.begin(), ptrs.end(),
+                                  reused_ptrs.begin()));
+  absl::optional<AllocatorStats> stats = a->GetStats();
+  EXPECT_EQ(stats->num_allocs, 20);
+  EXPECT_EQ(stats->bytes_in_use, 10 * 1024);
+
+  for (void* ptr : reused_ptrs) {
+    a->DeallocateRaw(ptr);
+  }
+  // Recording the memory map returns the cached chunks to the bins.
+  MemoryDump md = a->RecordMemoryMap();
+  EXPECT_EQ(NumChunksInUse(md), 0);
+  EXPECT_EQ(md.stats().bytes_in_use(), 0);
+  EXPECT_EQ(md.stats().num_allocs(), 20);
+}
+
+TEST(BFCAllocatorTest, ThreadLocalCacheMultiThreaded) {
+  std::unique_ptr<BFCAllocator> a(NewThreadLocalCacheAllocator());
+  constexpr int kNumThreads = 8;
+  thread::ThreadPool pool(Env::Default(), "test", kNumThreads);
+  BlockingCounter counter(kNumThreads);
+  mutex mu;
+  std::vector<void*> leftover_ptrs;
+  for (int t = 0; t < kNumThreads; ++t) {
+    pool.Schedule([&a, &counter, &mu, &leftover_ptrs, t]() {
+      std::default_random_engine rng(t);
+      std::uniform_int_distribution<size_t> size_dist(1, 256 << 10);
+      std::vector<void*> ptrs;
+      for (int i = 0; i < 10000; ++i) {
+        if (ptrs.size() < 32 && (ptrs.empty() || rng() % 2 == 0)) {
+          const size_t size = size_dist(rng);
+          void* ptr = a->AllocateRaw(1, size);
+          ASSERT_NE(ptr, nullptr);
+          // Reads the chunk metadata while other threads coalesce the
+          // neighbours of cached chunks.
+          EXPECT_EQ(a->RequestedSize(ptr), size);
+          EXPECT_GT(a->AllocationId(ptr), 0);
+          ptrs.push_back(ptr);
+        } else {
+          std::swap(ptrs[rng() % ptrs.size()], ptrs.back());
+          a->DeallocateRaw(ptrs.back());
+          ptrs.pop_back();
+        }
+      }
+      {
+        mutex_lock l(mu);
+        leftover_ptrs.insert(leftover_ptrs.end(), ptrs.begin(), ptrs.end());
+      }
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+  // Free the remaining allocations on a different thread than the one that
+  // made them.
+  for (void* ptr : leftover_ptrs) {
+    a->DeallocateRaw(ptr);
+  }
+  EXPECT_EQ(a->GetStats()->bytes_in_use, 0);
+  EXPECT_EQ(NumChunksInUse(a->RecordMemoryMap()), 0);
+}
+
+void BM_AllocatorMultiThreaded(::testing::benchmark::State& state) {
+  constexpr int kAllocSize = 1 << 12;
+  constexpr int kAllocationsPerThread = 1000;
+  const int num_threads = state.range(0);
+  const bool thread_local_cache = state.range(1);
+
+  BFCAllocator bfc_allocator(
+      new BasicCPUAllocator(port::kNUMANoAffinity, {}, {}), 1 << 30,
+      /*allow_growth=*/true, "cpu_bfc", /*garbage_collection=*/false,
+      thread_local_cache);
+  thread::ThreadPool pool(Env::Default(), "bench", num_threads);
+
+  for (auto _ : state) {
+    BlockingCounter counter(num_threads);
+    for (int t = 0; t < num_threads; ++t) {
+      pool.Schedule([&bfc_allocator, &counter]() {
+        void* ptrs[8];
+        for (int i = 0; i < kAllocationsPerThread; i += 8) {
+          for (int j = 0; j < 8; ++j) {
+            ptrs[j] = bfc_allocator.AllocateRaw(1, kAllocSize);
+          }
+          for (int j = 0; j < 8; ++j) {
+            bfc_allocator.DeallocateRaw(ptrs[j]);
+          }
+        }
+        counter.DecrementCount();
+      });
+    }
+    counter.Wait();
+  }
+  state.SetItemsProcessed(static_cast<int64>(state.iterations()) *
+                          num_threads * kAllocationsPerThread);
+}
+BENCHMARK(BM_AllocatorMultiThreaded)
+    ->UseRealTime()
+    ->ArgPair(1, false)
+    ->ArgPair(1, true)
+    ->ArgPair(8, false)
+    ->ArgPair(8, true)
+    ->ArgPair(32, false)
+    ->ArgPair(32, true);
+
 }  // namespace tensorflow
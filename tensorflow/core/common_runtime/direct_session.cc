@@ -1892,6 +1892,25 @@ class DirectSession::RunCallableCallFrame : public CallFrameInterface {
     return Status::OK();
   }
 
+  bool TakeRetvalBuffer(int index, DataType dtype, const TensorShape& shape,
+                        Tensor* val) override {
+    if (!executors_and_keys_->callable_options.fetch_into_caller_buffers() ||
+        index >= fetch_tensors_->size() || !DataTypeCanUseMemcpy(dtype)) {
+      return false;
+    }
+    Tensor& buffer = (*fetch_tensors_)[index];
+    // The caller's tensor must hold the only reference to its buffer, which
+    // may otherwise be shared with a feed, or with state of the graph that a
+    // previous call returned.
+    if (!buffer.IsInitialized() || buffer.dtype() != dtype ||
+        buffer.shape() != shape || !buffer.IsAligned() ||
+        !buffer.RefCountIsOne()) {
+      return false;
+    }
+    *val = std::move(buffer);
+    return true;
+  }
+
  private:
   DirectSession* const session_;                   // Not owned.
   ExecutorsAndKeys* const executors_and_keys_;     // Not owned.
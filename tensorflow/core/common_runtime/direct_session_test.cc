@@ -550,6 +550,62 @@ TEST_F(DirectSessionMinusAXTest, TestFeed_Callable) {
   EXPECT_FLOAT_EQ(39.0, mat(1, 0));
 }
 
+TEST_F(DirectSessionMinusAXTest, TestFetchIntoCallerBuffers_Callable) {
+  Initialize({1, 2, 3, 4});
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  CallableOptions callable_options =
+      MakeCallableOptions({x_}, {y_ + ":0"}, {});
+  callable_options.set_fetch_into_caller_buffers(true);
+  Session::CallableHandle handle;
+  TF_ASSERT_OK(session->MakeCallable(callable_options, &handle));
+
+  const DeviceMgr* mgr;
+  TF_ASSERT_OK(session->LocalDeviceManager(&mgr));
+  Device* device;
+  TF_ASSERT_OK(
+      mgr->LookupDevice("/job:localhost/replica:0/task:0/cpu:0", &device));
+  Allocator* allocator = device->GetAllocator(AllocatorAttributes());
+  const bool stats_enabled = CPUAllocatorStatsEnabled();
+  EnableCPUAllocatorStats();
+
+  std::vector<Tensor> inputs = {Tensor(DT_FLOAT, TensorShape({2, 1}))};
+  std::vector<Tensor> outputs = {Tensor(DT_FLOAT, TensorShape({2, 1}))};
+  const char* y_buffer = outputs[0].tensor_data().data();
+  absl::optional<AllocatorStats> initial_stats = allocator->GetStats();
+  ASSERT_TRUE(initial_stats.has_value());
+  for (float i = 0; i < 3; ++i) {
+    inputs[0].matrix<float>()(0, 0) = 5 + i;
+    inputs[0].matrix<float>()(1, 0) = 6;
+    TF_ASSERT_OK(session->RunCallable(handle, inputs, &outputs, nullptr));
+    ASSERT_EQ(1, outputs.size());
+    // The MatMul kernel wrote its output into the preallocated tensor.
+    EXPECT_EQ(y_buffer, outputs[0].tensor_data().data());
+    EXPECT_FLOAT_EQ(17.0 + i, outputs[0].matrix<float>()(0, 0));
+    EXPECT_FLOAT_EQ(39.0 + 3 * i, outputs[0].matrix<float>()(1, 0));
+  }
+  // No step allocated a tensor on the device.
+  absl::optional<AllocatorStats> final_stats = allocator->GetStats();
+  ASSERT_TRUE(final_stats.has_value());
+  EXPECT_EQ(initial_stats->num_allocs, final_stats->num_allocs);
+
+  // A preallocated tensor whose buffer is shared with another tensor is
+  // replaced instead.
+  Tensor shared = outputs[0];
+  inputs[0].matrix<float>()(0, 0) = 8;
+  TF_ASSERT_OK(session->RunCallable(handle, inputs, &outputs, nullptr));
+  EXPECT_FALSE(outputs[0].SharesBufferWith(shared));
+  EXPECT_FLOAT_EQ(20.0, outputs[0].matrix<float>()(0, 0));
+  EXPECT_FLOAT_EQ(19.0, shared.matrix<float>()(0, 0));
+
+  if (!stats_enabled) {
+    DisableCPUAllocatorStats();
+  }
+  TF_ASSERT_OK(session->ReleaseCallable(handle));
+}
+
 TEST_F(DirectSessionMinusAXTest, TestConcurrency) {
   Initialize({1, 2, 3, 4});
   auto session = CreateSession();
@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/propagator_state.h"
 #include "tensorflow/core/common_runtime/renamed_device.h"
 #include "tensorflow/core/common_runtime/simple_propagator_state.h"
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/cancellation.h"
@@ -70,6 +71,7 @@ limitations under the License.
 #include "tensorflow/core/profiler/lib/scoped_annotation.h"
 #include "tensorflow/core/profiler/lib/traceme_encode.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
 
 namespace tensorflow {
@@ -79,6 +81,22 @@ namespace {
 // 1-D, 0 element tensor.
 static const Tensor* const kEmptyTensor = new Tensor;
 
+// Returns true if the TF_CPU_STEP_ARENA environment variable enables per-step
+// arenas for the step-local tensors on CPU devices.
+bool UseStepArenaFromEnvironment() {
+  static const bool use_step_arena = [] {
+    bool flag;
+    auto status = ReadBoolFromEnvVar("TF_CPU_STEP_ARENA",
+                                     /*default_val=*/false, &flag);
+    if (!status.ok()) {
+      LOG(ERROR) << "UseStepArena: " << status.error_message();
+      return false;
+    }
+    return flag;
+  }();
+  return use_step_arena;
+}
+
 // Helper routines for collecting step stats.
 namespace nodestats {
 inline int64 NowInNsec() { return EnvTime::NowNanos(); }
@@ -141,6 +159,10 @@ class ExecutorImpl : public Executor {
   Status Initialize(const Graph& graph) {
     TF_RETURN_IF_ERROR(immutable_state_.Initialize(graph));
     kernel_stats_.Initialize(immutable_state_.graph_view());
+    Device* device = immutable_state_.params().device;
+    if (UseStepArenaFromEnvironment() && device->device_type() == DEVICE_CPU) {
+      step_arena_params_.wrapped = device->GetAllocator(AllocatorAttributes());
+    }
     return Status::OK();
   }
 
@@ -212,8 +234,20 @@ class ExecutorImpl : public Executor {
     std::unique_ptr<std::atomic_uint_fast64_t[]> cost_estimates_;
   };
 
+  // Configures the arenas that steps use for the tensors of the nodes whose
+  // outputs do not outlive the step.
+  struct StepArenaParams {
+    // The allocator that the arenas wrap. If null, steps do not use an arena.
+    // Not owned.
+    Allocator* wrapped = nullptr;
+    // Bytes that the most recently finished step served from its arena, used
+    // to size the first region of the arena of the next step.
+    std::atomic<size_t> region_bytes{0};
+  };
+
   ImmutableExecutorState immutable_state_;
   KernelStats kernel_stats_;
+  StepArenaParams step_arena_params_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(ExecutorImpl);
 };
@@ -272,7 +306,8 @@ class ExecutorState {
  public:
   ExecutorState(const Executor::Args& args,
                 const ImmutableExecutorState& immutable_state_,
-                ExecutorImpl::KernelStats* kernel_stats_);
+                ExecutorImpl::KernelStats* kernel_stats_,
+                ExecutorImpl::StepArenaParams* step_arena_params);
   ~ExecutorState();
 
   void RunAsync(Executor::DoneCallback done);
@@ -363,6 +398,10 @@ class ExecutorState {
   CallFrameInterface* call_frame_;
   const ImmutableExecutorState& immutable_state_;
   ExecutorImpl::KernelStats* const kernel_stats_;
+  ExecutorImpl::StepArenaParams* const step_arena_params_;
+  // If non-null, serves the tensors of the nodes whose outputs do not outlive
+  // the step. Released when the step ends.
+  StepArenaAllocator* step_arena_ = nullptr;
   CancellationManager* cancellation_manager_;
   // If not null, use this device to schedule intra-op operation
   std::unique_ptr<DeviceBase> user_device_;
@@ -390,7 +429,8 @@ class ExecutorState {
 template <class PropagatorStateType>
 ExecutorState<PropagatorStateType>::ExecutorState(
     const Executor::Args& args, const ImmutableExecutorState& immutable_state,
-    ExecutorImpl::KernelStats* kernel_stats)
+    ExecutorImpl::KernelStats* kernel_stats,
+    ExecutorImpl::StepArenaParams* step_arena_params)
     : vlog_(VLOG_IS_ON(1)),
       log_memory_(LogMemory::IsEnabled()),
       step_id_(args.step_id),
@@ -409,6 +449,7 @@ ExecutorState<PropagatorStateType>::ExecutorState(
       call_frame_(args.call_frame),
       immutable_state_(immutable_state),
       kernel_stats_(kernel_stats),
+      step_arena_params_(step_arena_params),
       cancellation_manager_(args.cancellation_manager),
       runner_(args.runner),
       sync_on_finish_(args.sync_on_finish),
@@ -420,6 +461,11 @@ ExecutorState<PropagatorStateType>::ExecutorState(
     user_device_ = RenamedDevice::NewRenamedDevice(
         device->name(), device, false, false, args.user_intra_op_threadpool);
   }
+  if (step_arena_params_->wrapped != nullptr) {
+    step_arena_ = new StepArenaAllocator(
+        step_arena_params_->wrapped,
+        step_arena_params_->region_bytes.load(std::memory_order_relaxed));
+  }
 }
 
 template <class PropagatorStateType>
@@ -428,6 +474,13 @@ ExecutorState<PropagatorStateType>::~ExecutorState() {
     device_context_->Unref();
   }
   delete slice_reader_cache_;
+  if (step_arena_ != nullptr) {
+    step_arena_params_->region_bytes.store(step_arena_->region_bytes_used(),
+                                           std::memory_order_relaxed);
+    // Tensors that escaped the step anyway keep the arena alive until they
+    // are released.
+    step_arena_->Release();
+  }
 }
 
 template <class PropagatorStateType>
@@ -803,6 +856,9 @@ void ExecutorState<PropagatorStateType>::Process(TaggedNode tagged_node,
       params.output_attr_array = item.output_attrs();
       params.forward_from_array = item.forward_from();
       params.outputs_required_array = item.outputs_required.get();
+      params.output_retval_index_array = item.output_retval_indices.get();
+      params.step_local_allocator =
+          item.outputs_are_step_local ? step_arena_ : nullptr;
 
       if (item.kernel_is_async) {
         ProcessAsync(item, params, tagged_node, first_input, stats);
@@ -1338,11 +1394,12 @@ void ExecutorState<PropagatorStateType>::Finish() {
 
 void ExecutorImpl::RunAsync(const Args& args, DoneCallback done) {
   if (immutable_state_.requires_control_flow_support()) {
-    (new ExecutorState<PropagatorState>(args, immutable_state_, &kernel_stats_))
+    (new ExecutorState<PropagatorState>(args, immutable_state_, &kernel_stats_,
+                                        &step_arena_params_))
         ->RunAsync(std::move(done));
   } else {
-    (new ExecutorState<SimplePropagatorState>(args, immutable_state_,
-                                              &kernel_stats_))
+    (new ExecutorState<SimplePropagatorState>(
+         args, immutable_state_, &kernel_stats_, &step_arena_params_))
         ->RunAsync(std::move(done));
   }
 }
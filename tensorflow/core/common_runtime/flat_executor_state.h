@@ -0,0 +1,173 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_FLAT_EXECUTOR_STATE_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_FLAT_EXECUTOR_STATE_H_
+
+#include <vector>
+
+#include "tensorflow/core/common_runtime/entry.h"
+#include "tensorflow/core/common_runtime/executor.h"
+#include "tensorflow/core/common_runtime/local_executor_params.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/gtl/inlined_vector.h"
+
+namespace tensorflow {
+
+// Represents the read-only state of an executor that runs the kernels of a
+// loopless, condless graph without tracking pending counts, such as the
+// single-threaded executor used by tf.data and the static schedule executor.
+//
+// The inputs to each kernel are stored contiguously in a flat array of
+// `Entry` values, in the topological order of the kernels. We use
+// `kernels()[i].input_start_index` and `kernels()[i].num_inputs` to determine
+// the range of elements in this array that correspond to the inputs of
+// `kernels()[i]`. The array has the following layout:
+//
+// * Kernel 0, input 0.
+// * Kernel 0, input 1.
+// * ...
+// * Kernel 0, input `kernels()[0].num_inputs - 1`.
+// * Kernel 1, input 0.
+// * ...
+// * Kernel `kernels().size() - 1`, input `kernels().back().num_inputs - 1`.
+//
+// Note that kernels with zero inputs do not correspond to any elements in
+// this array. Every element has exactly one producer and one consumer:
+// * Elements are initialized by `InitializeInputs()` (for arguments and
+//   constants), or when the outputs of a kernel execution are propagated to
+//   the inputs of kernels that depend on them.
+// * The elements corresponding to the inputs for kernel `i` are cleared
+//   after kernel `i` executes.
+class FlatExecutorState {
+ public:
+  typedef gtl::InlinedVector<TensorValue, 4> TensorValueVec;
+  typedef gtl::InlinedVector<AllocatorAttributes, 4> AllocatorAttributeVec;
+
+  // Represents cached graph structure state for each kernel.
+  struct KernelState {
+    // The kernel object. Not owned.
+    //
+    // This pointer is managed by `params.create_kernel()` and
+    // `params.delete_kernel()`.
+    OpKernel* kernel;
+
+    // These fields determine the range of elements in the flat inputs array
+    // that corresponds to the inputs of `kernel`.
+    size_t input_start_index;
+    size_t num_inputs;
+
+    size_t num_outputs;
+
+    // For the `j`th output of `kernel`, `output_locations[j]` contains the
+    // locations in the flat inputs array to which that output must be copied.
+    std::vector<std::vector<size_t>>
+        output_locations;  // Length = `num_outputs`.
+
+    // Memory space information for each output of `kernel`.
+    std::vector<AllocatorAttributes>
+        output_alloc_attrs;  // Length = `num_outputs`.
+
+    // Memory space information for each input of `kernel`.
+    AllocatorAttributeVec input_alloc_attrs;  // Length = `num_inputs`.
+  };
+
+  // `executor_name` is used as the subject of error messages, e.g.
+  // "Single-threaded executor".
+  FlatExecutorState(const LocalExecutorParams& params, string executor_name);
+  ~FlatExecutorState();
+
+  // Creates the kernels for `ordered_nodes`, which must contain the nodes of a
+  // graph in topological order, and lays out their inputs. On success,
+  // `(*nodes_with_kernels)[i]` is the node of `kernels()[i]`.
+  Status Initialize(const std::vector<Node*>& ordered_nodes,
+                    std::vector<Node*>* nodes_with_kernels);
+
+  // The kernels in topological order, excluding arguments and kernels that
+  // produce a single constant tensor.
+  const std::vector<KernelState>& kernels() const { return kernels_; }
+
+  // The sum of the number of inputs for each kernel. This determines the
+  // length of the flat inputs array.
+  size_t total_num_inputs() const { return total_num_inputs_; }
+
+  // Fills in the fields of `params` that are the same for every kernel of a
+  // step. `runner` must outlive the kernels that are run with `params`.
+  void PrepareParams(const Executor::Args& args, const string* executor_type,
+                     Executor::Args::Runner* runner,
+                     OpKernelContext::Params* params) const;
+
+  // Forwards the arguments in `args.call_frame` and the values of constant
+  // kernels directly to the elements of `inputs` that consume them.
+  Status InitializeInputs(const Executor::Args& args, Entry* inputs) const;
+
+  // Runs the kernel described by `kernel_state` with `params`, which must have
+  // been prepared by `PrepareParams()`. On success, the inputs of the kernel
+  // are cleared and its outputs are forwarded to the inputs of the kernels
+  // that depend on it. `node_inputs` is scratch space for the kernel inputs.
+  //
+  // Returns the status of the kernel, without the `NodeDef` attached.
+  Status RunKernel(const KernelState& kernel_state,
+                   OpKernelContext::Params* params,
+                   TensorValueVec* node_inputs, Entry* inputs) const;
+
+ private:
+  // Represents cached graph structure state for each kernel that produces
+  // a single constant-valued tensor.
+  struct ConstTensorKernelState {
+    // The kernel object. Not owned.
+    //
+    // This pointer is managed by `params.create_kernel()` and
+    // `params.delete_kernel()`.
+    OpKernel* kernel;
+
+    // The cached value of `kernel->const_tensor()`.
+    //
+    // NOTE: We keep a `Tensor` rather than a `const Tensor*` here in order to
+    // keep the reference count on the underlying buffer above 1. Otherwise, a
+    // kernel could interpret the input as a forwardable tensor, and mutate the
+    // underlying constant tensor.
+    Tensor const_tensor;
+
+    // The locations in the flat inputs array to which the single output of
+    // `kernel` must be copied.
+    std::vector<size_t> output_locations;
+  };
+
+  Status ValidateNode(const Node* n) const;
+
+  const LocalExecutorParams params_;
+  const string executor_name_;
+
+  // All following members are read-only after Initialize().
+
+  size_t total_num_inputs_ = 0;
+
+  std::vector<KernelState> kernels_;
+
+  // For the `i`th argument, `arg_output_locations_[i]` contains the locations
+  // in the flat inputs array to which that argument must be copied.
+  std::vector<std::vector<size_t>>
+      arg_output_locations_;  // Length = `num_args`.
+
+  std::vector<ConstTensorKernelState> const_tensor_kernels_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(FlatExecutorState);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_FLAT_EXECUTOR_STATE_H_
@@ -330,10 +330,17 @@ Allocator* GPUProcessState::GetGpuHostAllocator(int numa_node) {
       LOG(ERROR) << "GetGpuHostAllocator: " << status.error_message();
     }
     int64 gpu_host_mem_limit = gpu_host_mem_limit_in_mb * (1LL << 20);
+    bool thread_local_cache = false;
+    status = ReadBoolFromEnvVar("TF_HOST_BFC_THREAD_LOCAL_CACHE",
+                                /*default_val=*/false, &thread_local_cache);
+    if (!status.ok()) {
+      LOG(ERROR) << "GetGpuHostAllocator: " << status.error_message();
+    }
 
-    Allocator* allocator =
-        new BFCAllocator(sub_allocator, gpu_host_mem_limit,
-                         /*allow_growth=*/true, /*name=*/"gpu_host_bfc");
+    Allocator* allocator = new BFCAllocator(
+        sub_allocator, gpu_host_mem_limit, /*allow_growth=*/true,
+        /*name=*/"gpu_host_bfc", /*garbage_collection=*/false,
+        thread_local_cache);
 
     if (LogMemory::IsEnabled() && !allocator->TracksAllocationSizes()) {
       // Wrap the allocator to track allocation ids for better logging
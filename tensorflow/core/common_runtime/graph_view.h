@@ -83,6 +83,9 @@ struct NodeItem {
                                                      // node.
   bool is_any_input_ref_typed : 1;  // True iff any IsRefType(dt) for dt in this
                                     // node's input types.
+  // True iff no output or temporary that the kernel allocates can outlive the
+  // step. See `ImmutableExecutorState::Initialize()`.
+  bool outputs_are_step_local : 1;
 
   // The kernel for this node.
   OpKernel* kernel = nullptr;
@@ -109,6 +112,11 @@ struct NodeItem {
   // is true if and only if the ith output is consumed by another node.
   std::unique_ptr<bool[]> outputs_required;
 
+  // If non-null, contains an array of num_outputs ints, where the ith int is
+  // the index of the call frame return value that the ith output is returned
+  // as, or -1.
+  std::unique_ptr<int[]> output_retval_indices;
+
   gtl::MutableArraySlice<EdgeInfo> mutable_output_edges() {
     return gtl::MutableArraySlice<EdgeInfo>(output_edge_base(),
                                             num_output_edges);
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/immutable_executor_state.h"
 
 #include "absl/memory/memory.h"
+#include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/node_def_util.h"
@@ -238,6 +239,56 @@ Status ImmutableExecutorState::Initialize(const Graph& graph) {
       }
       item->outputs_required = std::move(outputs_required);
     }
+
+    // Record which outputs are returned directly through the call frame, so
+    // that their kernel can write them into caller-provided host buffers.
+    if (params_.device->device_type() == DEVICE_CPU) {
+      for (const Edge* e : n->out_edges()) {
+        if (e->IsControlEdge() || !e->dst()->IsRetval()) continue;
+        int retval_index;
+        TF_RETURN_IF_ERROR(
+            GetNodeAttr(e->dst()->attrs(), "index", &retval_index));
+        if (item->output_retval_indices == nullptr) {
+          item->output_retval_indices.reset(new int[n->num_outputs()]);
+          std::fill(&item->output_retval_indices[0],
+                    &item->output_retval_indices[n->num_outputs()], -1);
+        }
+        item->output_retval_indices[e->src_output()] = retval_index;
+      }
+    }
+  }
+
+  // Record which nodes only produce tensors that cannot outlive the step, so
+  // that the executor can allocate them from a per-step arena. A node's
+  // outputs escape the step if the node is stateful (e.g. assigns them to a
+  // variable or enqueues them), returns them or sends them to another
+  // partition, or if any consumer may forward them to its own outputs that
+  // escape. Stateless consumers may forward any input, so a node is step-local
+  // iff it does not escape directly and all of its data consumers are
+  // step-local. Compute this as a fixed point, by propagating non-locality
+  // backwards from the nodes that escape directly.
+  std::vector<const Node*> non_local;
+  for (const Node* n : graph.nodes()) {
+    if (IsSink(n)) continue;
+    NodeItem* item = gview_.node(n->id());
+    item->outputs_are_step_local =
+        !n->op_def().is_stateful() && !n->IsRetval() &&
+        !item->is_transfer_node && !item->is_any_input_ref_typed;
+    if (!item->outputs_are_step_local) {
+      non_local.push_back(n);
+    }
+  }
+  while (!non_local.empty()) {
+    const Node* n = non_local.back();
+    non_local.pop_back();
+    for (const Edge* e : n->in_edges()) {
+      if (e->IsControlEdge()) continue;
+      NodeItem* src_item = gview_.node(e->src()->id());
+      if (src_item->outputs_are_step_local) {
+        src_item->outputs_are_step_local = false;
+        non_local.push_back(e->src());
+      }
+    }
   }
 
   // Rewrite each `EdgeInfo::input_slot` member to refer directly to the input
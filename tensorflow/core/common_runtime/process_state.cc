@@ -99,10 +99,17 @@ Allocator* ProcessState::GetCPUAllocator(int numa_node) {
         LOG(ERROR) << "GetCPUAllocator: " << status.error_message();
       }
       int64 cpu_mem_limit = cpu_mem_limit_in_mb * (1LL << 20);
+      bool thread_local_cache = false;
+      status = ReadBoolFromEnvVar("TF_HOST_BFC_THREAD_LOCAL_CACHE",
+                                  /*default_val=*/false, &thread_local_cache);
+      if (!status.ok()) {
+        LOG(ERROR) << "GetCPUAllocator: " << status.error_message();
+      }
       DCHECK(sub_allocator);
       allocator =
           new BFCAllocator(sub_allocator, cpu_mem_limit, /*allow_growth=*/true,
-                           /*name=*/"bfc_cpu_allocator_for_gpu");
+                           /*name=*/"bfc_cpu_allocator_for_gpu",
+                           /*garbage_collection=*/false, thread_local_cache);
       VLOG(2) << "Using BFCAllocator with memory limit of "
               << cpu_mem_limit_in_mb << " MB for ProcessState CPU allocator";
     } else if (sub_allocator) {
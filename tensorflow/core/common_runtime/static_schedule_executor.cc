@@ -0,0 +1,290 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/static_schedule_executor.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/entry.h"
+#include "tensorflow/core/common_runtime/executor_factory.h"
+#include "tensorflow/core/common_runtime/flat_executor_state.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace {
+
+static const string& kStaticScheduleExecutor =
+    *new string("STATIC_SCHEDULE_EXECUTOR");
+
+class StaticScheduleExecutorImpl : public Executor {
+ public:
+  explicit StaticScheduleExecutorImpl(const LocalExecutorParams& params)
+      : params_(params), state_(params, "Static schedule executor") {}
+
+  Status Initialize(const Graph& graph) {
+    // Kernels are run without an `OpDeviceContext`, which only CPU kernels
+    // can handle.
+    if (params_.device->device_type() != DEVICE_CPU) {
+      return errors::Unimplemented(
+          "The static schedule executor only supports CPU devices, but got "
+          "device ",
+          params_.device->name(), " of type ", params_.device->device_type());
+    }
+
+    // Topologicially sort `graph` to get a sequence of OpKernels.
+    std::vector<Node*> ordered_nodes;
+    ordered_nodes.reserve(graph.num_nodes());
+    GetReversePostOrder(graph, &ordered_nodes);
+    if (ordered_nodes.size() != graph.num_nodes()) {
+      return errors::InvalidArgument("Graph had ", graph.num_nodes(),
+                                     " but reverse post-order had ",
+                                     ordered_nodes.size());
+    }
+
+    std::vector<Node*> nodes_with_kernels;
+    TF_RETURN_IF_ERROR(state_.Initialize(ordered_nodes, &nodes_with_kernels));
+
+    // The level of each node, indexed by node id. A node that has no inputs is
+    // in level 0, and every other node is in the level after the last level of
+    // its (data or control) inputs.
+    std::vector<int> node_levels(graph.num_node_ids(), 0);
+    for (const Node* n : ordered_nodes) {
+      int level = 0;
+      for (const Edge* e : n->in_edges()) {
+        level = std::max(level, node_levels[e->src()->id()] + 1);
+      }
+      node_levels[n->id()] = level;
+    }
+
+    // Assign each kernel to its level.
+    for (size_t i = 0; i < nodes_with_kernels.size(); ++i) {
+      const int level = node_levels[nodes_with_kernels[i]->id()];
+      if (level >= levels_.size()) {
+        levels_.resize(level + 1);
+      }
+      if (state_.kernels()[i].kernel->IsExpensive()) {
+        levels_[level].expensive_kernels.push_back(i);
+      } else {
+        levels_[level].inexpensive_kernels.push_back(i);
+      }
+    }
+    // Levels that only contain Arg nodes or constants have no kernels to run.
+    levels_.erase(std::remove_if(levels_.begin(), levels_.end(),
+                                 [](const Level& level) {
+                                   return level.expensive_kernels.empty() &&
+                                          level.inexpensive_kernels.empty();
+                                 }),
+                  levels_.end());
+
+    for (const Level& level : levels_) {
+      if (level.expensive_kernels.size() > 1) {
+        max_num_scheduled_ =
+            std::max(max_num_scheduled_, level.expensive_kernels.size() - 1);
+      }
+    }
+    return Status::OK();
+  }
+
+  Status Run(const Args& args) override {
+    std::unique_ptr<StepBuffers> buffers = AcquireBuffers();
+    Status status = RunWithBuffers(args, buffers.get());
+    ReleaseBuffers(std::move(buffers), status.ok());
+    return status;
+  }
+
+  void RunAsync(const Args& args, DoneCallback done) override {
+    done(Run(args));
+  }
+
+ private:
+  // The kernels of a level, as indices into `state_.kernels()`. None of these
+  // kernels depends on another kernel of the same level.
+  struct Level {
+    std::vector<size_t> expensive_kernels;
+    std::vector<size_t> inexpensive_kernels;
+  };
+
+  // The scratch space of a step. A `StepBuffers` is reused by later steps, so
+  // that `Run()` does not allocate per-step or per-kernel vectors.
+  struct StepBuffers {
+    // The inputs to each kernel, laid out as described in
+    // `FlatExecutorState`. Every element has exactly one producer and one
+    // consumer, so kernels of the same level can read their inputs and write
+    // their outputs concurrently.
+    std::vector<Entry> inputs;  // Length = `state_.total_num_inputs()`.
+
+    // The `TensorValue` inputs of each kernel. Each kernel has its own vector,
+    // since the kernels of a level may run concurrently.
+    std::vector<FlatExecutorState::TensorValueVec>
+        node_inputs;  // Length = `state_.kernels().size()`.
+
+    // The kernel parameters for the calling thread (`params[0]`), and for the
+    // kernels of a level that are run on the runner (`params[j + 1]`).
+    std::vector<OpKernelContext::Params>
+        params;  // Length = `max_num_scheduled_ + 1`.
+
+    // The statuses of the kernels of a level that are run on the runner.
+    std::vector<Status> statuses;  // Length = `max_num_scheduled_`.
+  };
+
+  std::unique_ptr<StepBuffers> AcquireBuffers() {
+    {
+      mutex_lock l(mu_);
+      if (!free_buffers_.empty()) {
+        std::unique_ptr<StepBuffers> buffers = std::move(free_buffers_.back());
+        free_buffers_.pop_back();
+        return buffers;
+      }
+    }
+    auto buffers = absl::make_unique<StepBuffers>();
+    buffers->inputs.resize(state_.total_num_inputs());
+    buffers->node_inputs.resize(state_.kernels().size());
+    for (size_t i = 0; i < state_.kernels().size(); ++i) {
+      buffers->node_inputs[i].resize(state_.kernels()[i].num_inputs);
+    }
+    buffers->params.resize(max_num_scheduled_ + 1);
+    buffers->statuses.resize(max_num_scheduled_);
+    return buffers;
+  }
+
+  void ReleaseBuffers(std::unique_ptr<StepBuffers> buffers, bool step_ok) {
+    // A successful step consumes every input, but a failed step may leave
+    // inputs of kernels that did not run.
+    if (!step_ok) {
+      for (Entry& input : buffers->inputs) {
+        input.ClearVal();
+      }
+    }
+    mutex_lock l(mu_);
+    free_buffers_.push_back(std::move(buffers));
+  }
+
+  Status RunWithBuffers(const Args& args, StepBuffers* buffers) {
+    Entry* inputs = buffers->inputs.data();
+    TF_RETURN_IF_ERROR(state_.InitializeInputs(args, inputs));
+
+    // Prepare the parameters that will be the same for all kernels.
+    Args::Runner runner_copy = args.runner;
+    for (OpKernelContext::Params& params : buffers->params) {
+      state_.PrepareParams(args, &kStaticScheduleExecutor, &runner_copy,
+                           &params);
+    }
+    OpKernelContext::Params* inline_params = &buffers->params[0];
+    const bool run_all_kernels_inline =
+        args.run_all_kernels_inline || runner_copy == nullptr;
+
+    // Execute the levels in order.
+    for (const Level& level : levels_) {
+      if (run_all_kernels_inline || level.expensive_kernels.size() < 2) {
+        for (size_t i : level.expensive_kernels) {
+          TF_RETURN_IF_ERROR(RunKernel(i, inline_params, buffers));
+        }
+        for (size_t i : level.inexpensive_kernels) {
+          TF_RETURN_IF_ERROR(RunKernel(i, inline_params, buffers));
+        }
+        continue;
+      }
+
+      // Run all but the first expensive kernel on the runner, and the
+      // remaining kernels on the calling thread while waiting for them.
+      const size_t num_scheduled = level.expensive_kernels.size() - 1;
+      BlockingCounter counter(num_scheduled);
+      for (size_t j = 0; j < num_scheduled; ++j) {
+        const size_t i = level.expensive_kernels[j + 1];
+        runner_copy([this, buffers, &counter, i, j]() {
+          buffers->statuses[j] = RunKernel(i, &buffers->params[j + 1], buffers);
+          counter.DecrementCount();
+        });
+      }
+      Status status =
+          RunKernel(level.expensive_kernels[0], inline_params, buffers);
+      for (size_t i : level.inexpensive_kernels) {
+        if (!status.ok()) break;
+        status = RunKernel(i, inline_params, buffers);
+      }
+      counter.Wait();
+      for (size_t j = 0; j < num_scheduled; ++j) {
+        status.Update(buffers->statuses[j]);
+      }
+      TF_RETURN_IF_ERROR(status);
+    }
+    return Status::OK();
+  }
+
+  // Runs `state_.kernels()[i]`, and attaches its `NodeDef` to any error.
+  Status RunKernel(size_t i, OpKernelContext::Params* params,
+                   StepBuffers* buffers) const {
+    const FlatExecutorState::KernelState& kernel_state = state_.kernels()[i];
+    Status s = state_.RunKernel(kernel_state, params,
+                                &buffers->node_inputs[i],
+                                buffers->inputs.data());
+    if (!s.ok()) {
+      return AttachDef(s, kernel_state.kernel->def());
+    }
+    return Status::OK();
+  }
+
+  const LocalExecutorParams params_;
+
+  // All following members are read-only after Initialize().
+
+  FlatExecutorState state_;
+
+  // The levels in execution order.
+  std::vector<Level> levels_;
+
+  // The largest number of kernels of a level that are run on the runner.
+  size_t max_num_scheduled_ = 0;
+
+  mutex mu_;
+  // The buffers of steps that have finished, for reuse by later steps.
+  std::vector<std::unique_ptr<StepBuffers>> free_buffers_ TF_GUARDED_BY(mu_);
+};
+
+class StaticScheduleExecutorRegistrar {
+ public:
+  StaticScheduleExecutorRegistrar() {
+    ExecutorFactory::Register(kStaticScheduleExecutor, new Factory());
+  }
+
+ private:
+  class Factory : public ExecutorFactory {
+    Status NewExecutor(const LocalExecutorParams& params, const Graph& graph,
+                       std::unique_ptr<Executor>* out_executor) override {
+      return NewStaticScheduleExecutor(params, graph, out_executor);
+    }
+  };
+};
+static StaticScheduleExecutorRegistrar registrar;
+
+}  // namespace
+
+Status NewStaticScheduleExecutor(const LocalExecutorParams& params,
+                                 const Graph& graph,
+                                 std::unique_ptr<Executor>* executor) {
+  auto impl = absl::make_unique<StaticScheduleExecutorImpl>(params);
+  TF_RETURN_IF_ERROR(impl->Initialize(graph));
+  *executor = std::move(impl);
+  return Status::OK();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,57 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_SCHEDULE_EXECUTOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_SCHEDULE_EXECUTOR_H_
+
+#include "tensorflow/core/common_runtime/executor.h"
+#include "tensorflow/core/common_runtime/local_executor_params.h"
+#include "tensorflow/core/graph/graph.h"
+
+namespace tensorflow {
+
+// Creates a new `Executor` that executes `graph` according to a schedule that
+// is computed once, when the executor is created. The executor is registered
+// with `ExecutorFactory` as "STATIC_SCHEDULE_EXECUTOR", and can be selected
+// for a `DirectSession` with `ConfigProto.experimental.executor_type`.
+//
+// The nodes of `graph` are partitioned into levels, such that every node only
+// depends on nodes in earlier levels. The levels are executed one after the
+// other. Within a level, the kernels that are marked as expensive are run
+// concurrently on the `Args::runner`, and the inexpensive ones are run inline
+// on the calling thread. The input and output slots of all kernels are laid out
+// in a flat array at construction time, so that a step does not need to track
+// pending counts or dispatch a closure per node.
+//
+// The executor targets repeatedly running small, latency-sensitive graphs
+// (e.g. a few hundred nodes when serving a model), where the per-node overhead
+// of the default executor dominates the step time. It has the same limitations
+// as the single-threaded executor used by tf.data:
+//
+// 1. Reference-typed tensors are not supported.
+// 2. Graphs with low-level control flow (containing "Switch" and "Merge"
+//    nodes) are not supported.
+// 3. Partitioned graphs (containing "_Send" or "_Recv" nodes) and collective
+//    ops are not supported.
+// 4. Only CPU devices are supported, since kernels are run without a device
+//    context.
+// 5. Memory logging and allocation forwarding are not supported.
+Status NewStaticScheduleExecutor(const LocalExecutorParams& params,
+                                 const Graph& graph,
+                                 std::unique_ptr<Executor>* executor);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_SCHEDULE_EXECUTOR_H_
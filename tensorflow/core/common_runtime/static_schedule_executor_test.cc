@@ -0,0 +1,296 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/static_schedule_executor.h"
+
+#include <algorithm>
+#include <random>
+
+#include "absl/strings/match.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/executor.h"
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace {
+
+class StaticScheduleExecutorTest : public ::testing::Test {
+ protected:
+  StaticScheduleExecutorTest()
+      : device_(DeviceFactory::NewDevice("CPU", {},
+                                         "/job:localhost/replica:0/task:0")),
+        thread_pool_(Env::Default(), "test", 4) {}
+
+  // Resets `exec_` with a new executor based on `graph`.
+  Status Create(std::unique_ptr<const Graph> graph) {
+    const int version = graph->versions().producer();
+    LocalExecutorParams params;
+    params.device = device_.get();
+    params.create_kernel =
+        [this, version](const std::shared_ptr<const NodeProperties>& props,
+                        OpKernel** kernel) {
+          return CreateNonCachedKernel(device_.get(), nullptr, props, version,
+                                       kernel);
+        };
+    params.delete_kernel = [](OpKernel* kernel) {
+      DeleteNonCachedKernel(kernel);
+    };
+    exec_.reset();
+    return NewStaticScheduleExecutor(params, *graph, &exec_);
+  }
+
+  Status Run(CallFrameInterface* call_frame, bool run_all_kernels_inline) {
+    Executor::Args args;
+    args.call_frame = call_frame;
+    args.run_all_kernels_inline = run_all_kernels_inline;
+    args.runner = [this](std::function<void()> fn) {
+      thread_pool_.Schedule(std::move(fn));
+    };
+    return exec_->Run(args);
+  }
+
+  std::unique_ptr<Device> device_;
+  thread::ThreadPool thread_pool_;
+  std::unique_ptr<Executor> exec_;
+};
+
+// A float val -> Tensor<float>
+Tensor V(const float val) {
+  Tensor tensor(DT_FLOAT, TensorShape({}));
+  tensor.scalar<float>()() = val;
+  return tensor;
+}
+
+// Tensor<float> -> a float val.
+float V(const Tensor& tensor) {
+  CHECK_EQ(tensor.dtype(), DT_FLOAT);
+  CHECK(TensorShapeUtils::IsScalar(tensor.shape()));
+  return tensor.scalar<float>()();
+}
+
+TEST_F(StaticScheduleExecutorTest, SimpleAdd) {
+  // c = a + b
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto in0 = test::graph::Arg(g.get(), 0, DT_FLOAT);
+  auto in1 = test::graph::Arg(g.get(), 1, DT_FLOAT);
+  auto tmp = test::graph::Add(g.get(), in0, in1);
+  auto ret = test::graph::Retval(g.get(), 0, tmp);
+  g->AddControlEdge(in1, ret);
+  FixupSourceAndSinkEdges(g.get());
+  TF_ASSERT_OK(Create(std::move(g)));
+  FunctionCallFrame call_frame({DT_FLOAT, DT_FLOAT}, {DT_FLOAT});
+  TF_ASSERT_OK(call_frame.SetArgs({V(1.0), V(2.0)}));
+  TF_ASSERT_OK(Run(&call_frame, /*run_all_kernels_inline=*/false));
+  std::vector<Tensor> retvals;
+  TF_ASSERT_OK(call_frame.ConsumeRetvals(&retvals, false));
+  EXPECT_EQ(3.0, V(retvals[0]));  // out = 1.0 + 2.0 = 3.0
+}
+
+// Builds a graph which adds N copies of one variable "in", parenthesized
+// randomly, so that the levels of the graph have different widths.
+void BuildTree(int N, Graph* g) {
+  CHECK_GT(N, 1);
+  auto in = test::graph::Arg(g, 0, DT_FLOAT);
+  std::vector<Node*> nodes;
+  for (int i = 0; i < N; ++i) {
+    nodes.push_back(test::graph::Identity(g, in, 0));
+  }
+  random::PhiloxRandom philox(0, 17);
+  random::SimplePhilox rnd(&philox);
+  while (nodes.size() > 1) {
+    int x = rnd.Uniform(nodes.size());
+    auto in0 = nodes[x];
+    nodes[x] = nodes.back();
+    nodes.resize(nodes.size() - 1);
+    x = rnd.Uniform(nodes.size());
+    auto in1 = nodes[x];
+    nodes[x] = test::graph::Add(g, in0, in1);
+  }
+  test::graph::Retval(g, 0, nodes.back());
+  FixupSourceAndSinkEdges(g);
+}
+
+TEST_F(StaticScheduleExecutorTest, RandomTree) {
+  for (bool run_all_kernels_inline : {false, true}) {
+    auto g = absl::make_unique<Graph>(OpRegistry::Global());
+    BuildTree(4096, g.get());
+    TF_ASSERT_OK(Create(std::move(g)));
+    for (int i = 0; i < 3; ++i) {
+      FunctionCallFrame call_frame({DT_FLOAT}, {DT_FLOAT});
+      TF_ASSERT_OK(call_frame.SetArgs({V(1.0)}));
+      TF_ASSERT_OK(Run(&call_frame, run_all_kernels_inline));
+      std::vector<Tensor> retvals;
+      TF_ASSERT_OK(call_frame.ConsumeRetvals(&retvals, false));
+      EXPECT_EQ(4096.0, V(retvals[0]));
+    }
+  }
+}
+
+TEST_F(StaticScheduleExecutorTest, ParallelExpensiveKernels) {
+  // Several independent matrix multiplications in the same level, whose
+  // results are summed up.
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto in = test::graph::Arg(g.get(), 0, DT_FLOAT);
+  const int kNumBranches = 8;
+  std::vector<Node*> products;
+  for (int i = 0; i < kNumBranches; ++i) {
+    products.push_back(test::graph::Matmul(g.get(), in, in, false, false));
+  }
+  Node* sum = products[0];
+  for (int i = 1; i < kNumBranches; ++i) {
+    sum = test::graph::Add(g.get(), sum, products[i]);
+  }
+  test::graph::Retval(g.get(), 0, sum);
+  FixupSourceAndSinkEdges(g.get());
+  TF_ASSERT_OK(Create(std::move(g)));
+
+  Tensor input(DT_FLOAT, TensorShape({2, 2}));
+  test::FillValues<float>(&input, {1, 2, 3, 4});
+  Tensor expected(DT_FLOAT, TensorShape({2, 2}));
+  test::FillValues<float>(&expected, {8 * 7, 8 * 10, 8 * 15, 8 * 22});
+  FunctionCallFrame call_frame({DT_FLOAT}, {DT_FLOAT});
+  TF_ASSERT_OK(call_frame.SetArgs({input}));
+  TF_ASSERT_OK(Run(&call_frame, /*run_all_kernels_inline=*/false));
+  std::vector<Tensor> retvals;
+  TF_ASSERT_OK(call_frame.ConsumeRetvals(&retvals, false));
+  test::ExpectTensorEqual<float>(expected, retvals[0]);
+}
+
+TEST_F(StaticScheduleExecutorTest, OpError) {
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto zero = test::graph::Constant(g.get(), V(0.0));
+  auto inf = test::graph::Unary(g.get(), "Reciprocal", zero);
+  auto check = test::graph::CheckNumerics(g.get(), inf, "message");
+  auto two = test::graph::Constant(g.get(), V(2.0));
+  test::graph::Binary(g.get(), "Mul", check, two);
+  FixupSourceAndSinkEdges(g.get());
+  TF_ASSERT_OK(Create(std::move(g)));
+  // The buffers of the failed step are reused by the second step.
+  for (int i = 0; i < 2; ++i) {
+    FunctionCallFrame call_frame({}, {});
+    Status s = Run(&call_frame, /*run_all_kernels_inline=*/false);
+    EXPECT_TRUE(errors::IsInvalidArgument(s));
+    EXPECT_TRUE(absl::StrContains(s.error_message(), check->name()));
+  }
+}
+
+TEST_F(StaticScheduleExecutorTest, ControlFlowNotSupported) {
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto in = test::graph::Arg(g.get(), 0, DT_FLOAT);
+  auto pred = test::graph::Constant(g.get(), test::AsScalar<bool>(true));
+  test::graph::Switch(g.get(), in, pred);
+  FixupSourceAndSinkEdges(g.get());
+  EXPECT_TRUE(errors::IsFailedPrecondition(Create(std::move(g))));
+}
+
+class FakeDevice : public Device {
+ public:
+  explicit FakeDevice(const DeviceAttributes& device_attributes)
+      : Device(nullptr, device_attributes) {}
+
+  Status Sync() override { return Status::OK(); }
+
+  Allocator* GetAllocator(AllocatorAttributes attr) override { return nullptr; }
+};
+
+TEST_F(StaticScheduleExecutorTest, NonCpuDeviceNotSupported) {
+  DeviceAttributes device_attributes;
+  device_attributes.set_name("/job:localhost/replica:0/task:0/device:GPU:0");
+  device_attributes.set_device_type(DEVICE_GPU);
+  FakeDevice device(device_attributes);
+
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto in = test::graph::Arg(g.get(), 0, DT_FLOAT);
+  test::graph::Retval(g.get(), 0, in);
+  FixupSourceAndSinkEdges(g.get());
+
+  LocalExecutorParams params;
+  params.device = &device;
+  params.create_kernel = [](const std::shared_ptr<const NodeProperties>& props,
+                            OpKernel** kernel) {
+    return errors::Internal("No kernel should be created.");
+  };
+  params.delete_kernel = [](OpKernel* kernel) {
+    DeleteNonCachedKernel(kernel);
+  };
+  std::unique_ptr<Executor> exec;
+  EXPECT_TRUE(
+      errors::IsUnimplemented(NewStaticScheduleExecutor(params, *g, &exec)));
+}
+
+void BM_executor(::testing::benchmark::State& state) {
+  const int width = state.range(0);
+  const int depth = state.range(1);
+
+  Graph* g = new Graph(OpRegistry::Global());
+  random::PhiloxRandom philox(1729, 17);
+  random::SimplePhilox rand(&philox);
+  uint64 cur = 0;
+  uint32 r = 1 + rand.Rand32() % width;
+  std::vector<Node*> ready_nodes;
+  for (int i = 0; i < r; ++i) {
+    ready_nodes.push_back(test::graph::NoOp(g, {}));
+    ++cur;
+  }
+  std::random_device random_device;
+  std::mt19937 rng(random_device());
+  for (int i = 0; i < depth; ++i) {
+    std::shuffle(ready_nodes.begin(), ready_nodes.end(), rng);
+    r = 1 + rand.Rand32() % (ready_nodes.size());
+    std::vector<Node*> control_inputs;
+    for (int j = 0; j < r; ++j) {
+      control_inputs.push_back(ready_nodes.back());
+      ready_nodes.pop_back();
+    }
+    Node* n = test::graph::NoOp(g, control_inputs);
+    ++cur;
+    r = 1 + rand.Rand32() % width;
+    for (int j = 0; j < r; ++j) {
+      ready_nodes.push_back(test::graph::NoOp(g, {n}));
+      ++cur;
+    }
+  }
+  FixupSourceAndSinkEdges(g);
+  test::Benchmark("cpu", g, nullptr, nullptr, nullptr,
+                  "STATIC_SCHEDULE_EXECUTOR", /*old_benchmark_api=*/false)
+      .Run(state);
+  state.SetLabel(strings::StrCat("Nodes = ", cur));
+  state.SetItemsProcessed(cur * static_cast<int64>(state.iterations()));
+}
+
+// Tall skinny graphs
+BENCHMARK(BM_executor)->UseRealTime()->ArgPair(16, 1024);
+BENCHMARK(BM_executor)->UseRealTime()->ArgPair(32, 8192);
+
+// Short fat graphs
+BENCHMARK(BM_executor)->UseRealTime()->ArgPair(1024, 16);
+BENCHMARK(BM_executor)->UseRealTime()->ArgPair(8192, 32);
+
+}  // namespace
+}  // namespace tensorflow
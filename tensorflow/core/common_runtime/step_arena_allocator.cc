@@ -0,0 +1,137 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+constexpr size_t StepArenaAllocator::kMinRegionBytes;
+constexpr size_t StepArenaAllocator::kMaxRegionBytes;
+
+namespace {
+
+size_t RoundUpToAlignment(size_t num_bytes) {
+  const size_t alignment = Allocator::kAllocatorAlignment;
+  return (std::max<size_t>(num_bytes, 1) + alignment - 1) & ~(alignment - 1);
+}
+
+}  // namespace
+
+StepArenaAllocator::StepArenaAllocator(Allocator* wrapped,
+                                       size_t initial_region_bytes)
+    : wrapped_(wrapped),
+      next_region_bytes_(RoundUpToAlignment(
+          std::min(kMaxRegionBytes,
+                   std::max(kMinRegionBytes, initial_region_bytes)))) {}
+
+StepArenaAllocator::~StepArenaAllocator() {
+  DCHECK_EQ(num_live_, 0) << "Deleting a StepArenaAllocator with live "
+                             "allocations";
+  for (const Region& region : regions_) {
+    wrapped_->DeallocateRaw(region.base);
+  }
+}
+
+void StepArenaAllocator::Release() {
+  bool delete_arena;
+  {
+    mutex_lock l(mu_);
+    DCHECK(!released_);
+    released_ = true;
+    delete_arena = num_live_ == 0;
+  }
+  if (delete_arena) {
+    delete this;
+  }
+}
+
+void* StepArenaAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
+  const size_t rounded_bytes = RoundUpToAlignment(num_bytes);
+  mutex_lock l(mu_);
+  DCHECK(!released_);
+  char* ptr = nullptr;
+  if (alignment <= kAllocatorAlignment) {
+    if (!regions_.empty() && used_ + rounded_bytes <= regions_.back().size) {
+      ptr = regions_.back().base + used_;
+    } else if (rounded_bytes <= next_region_bytes_ / 2) {
+      void* base =
+          wrapped_->AllocateRaw(kAllocatorAlignment, next_region_bytes_);
+      if (base == nullptr) {
+        return nullptr;
+      }
+      regions_.push_back({static_cast<char*>(base), next_region_bytes_});
+      stats_.bytes_reserved += next_region_bytes_;
+      next_region_bytes_ = std::min(kMaxRegionBytes, 2 * next_region_bytes_);
+      used_ = 0;
+      ptr = regions_.back().base;
+    }
+  }
+  if (ptr != nullptr) {
+    used_ += rounded_bytes;
+    region_bytes_used_ += rounded_bytes;
+  } else {
+    // Large allocations are not worth packing into a region.
+    ptr = static_cast<char*>(wrapped_->AllocateRaw(alignment, num_bytes));
+    if (ptr == nullptr) {
+      return nullptr;
+    }
+  }
+  ++num_live_;
+  ++stats_.num_allocs;
+  stats_.largest_alloc_size =
+      std::max<int64>(stats_.largest_alloc_size, rounded_bytes);
+  return ptr;
+}
+
+void StepArenaAllocator::DeallocateRaw(void* ptr) {
+  bool delete_arena;
+  {
+    mutex_lock l(mu_);
+    const char* p = static_cast<const char*>(ptr);
+    const bool in_region = std::any_of(
+        regions_.begin(), regions_.end(), [p](const Region& region) {
+          return region.base <= p && p < region.base + region.size;
+        });
+    if (!in_region) {
+      wrapped_->DeallocateRaw(ptr);
+    }
+    DCHECK_GT(num_live_, 0);
+    delete_arena = --num_live_ == 0 && released_;
+  }
+  if (delete_arena) {
+    delete this;
+  }
+}
+
+absl::optional<AllocatorStats> StepArenaAllocator::GetStats() {
+  mutex_lock l(mu_);
+  return stats_;
+}
+
+size_t StepArenaAllocator::region_bytes_used() const {
+  mutex_lock l(mu_);
+  return region_bytes_used_;
+}
+
+int64 StepArenaAllocator::num_regions() const {
+  mutex_lock l(mu_);
+  return regions_.size();
+}
+
+}  // namespace tensorflow
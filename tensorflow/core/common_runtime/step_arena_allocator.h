@@ -0,0 +1,108 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
+
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// An allocator for the tensors of a single step that do not outlive it.
+//
+// The executor creates one arena per step, uses it for the outputs and
+// temporaries of the kernels whose results cannot escape the step, and calls
+// `Release()` when the step ends. Memory is obtained from the wrapped
+// allocator in regions, and handed out by bumping an offset into the last
+// region. Deallocations only decrement the number of live allocations; the
+// regions are returned to the wrapped allocator, and the arena deleted, once
+// the arena has been released and all its allocations have been deallocated.
+//
+// Each step has its own arena, so overlapping steps do not contend on a lock.
+// Allocations larger than half of the next region size, or with an alignment
+// greater than `Allocator::kAllocatorAlignment`, are forwarded to the wrapped
+// allocator.
+class StepArenaAllocator : public Allocator {
+ public:
+  // Smallest region that is obtained from the wrapped allocator.
+  static constexpr size_t kMinRegionBytes = 64 << 10;
+  // Largest region that is obtained from the wrapped allocator.
+  static constexpr size_t kMaxRegionBytes = 64 << 20;
+
+  // `wrapped` is not owned, and must outlive this allocator. The first region
+  // has `initial_region_bytes` bytes, clamped to the range
+  // [`kMinRegionBytes`, `kMaxRegionBytes`]; every further region is twice as
+  // large as the previous one, up to `kMaxRegionBytes`.
+  StepArenaAllocator(Allocator* wrapped, size_t initial_region_bytes);
+
+  // Signals the end of the step. The arena deletes itself as soon as all its
+  // allocations have been deallocated, which may be immediately. The arena
+  // must not be used for new allocations afterwards.
+  void Release();
+
+  string Name() override { return "step_arena"; }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override;
+
+  void DeallocateRaw(void* ptr) override;
+
+  absl::optional<AllocatorStats> GetStats() override;
+
+  // Returns the number of bytes that have been served from regions, which is
+  // a good size for the first region of the next step.
+  size_t region_bytes_used() const;
+
+  // Returns the number of regions obtained from the wrapped allocator.
+  int64 num_regions() const;
+
+ private:
+  struct Region {
+    char* base;
+    size_t size;
+  };
+
+  // Deleted through `Release()` or the last `DeallocateRaw()`.
+  ~StepArenaAllocator() override;
+
+  Allocator* const wrapped_;  // Not owned.
+
+  mutable mutex mu_;
+  // All regions obtained from the wrapped allocator. Allocations are served
+  // from the last one.
+  std::vector<Region> regions_ TF_GUARDED_BY(mu_);
+  // Offset of the first free byte in the last region.
+  size_t used_ TF_GUARDED_BY(mu_) = 0;
+  // Size of the next region obtained from the wrapped allocator.
+  size_t next_region_bytes_ TF_GUARDED_BY(mu_);
+  // Sum of the bytes handed out from all regions.
+  size_t region_bytes_used_ TF_GUARDED_BY(mu_) = 0;
+  // Number of allocations, from regions or forwarded, that have not been
+  // deallocated.
+  int64 num_live_ TF_GUARDED_BY(mu_) = 0;
+  bool released_ TF_GUARDED_BY(mu_) = false;
+  AllocatorStats stats_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StepArenaAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
@@ -0,0 +1,237 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
+
+#include <atomic>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+// Forwards to `cpu_allocator()`, and counts the live allocations.
+class CountingAllocator : public Allocator {
+ public:
+  string Name() override { return "counting"; }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    ++num_live_;
+    return cpu_allocator()->AllocateRaw(alignment, num_bytes);
+  }
+
+  void DeallocateRaw(void* ptr) override {
+    --num_live_;
+    cpu_allocator()->DeallocateRaw(ptr);
+  }
+
+  int num_live() const { return num_live_; }
+
+ private:
+  std::atomic<int> num_live_{0};
+};
+
+// Allocates `num_allocations` buffers of `num_bytes` bytes each.
+std::vector<void*> AllocateStep(Allocator* allocator, int num_allocations,
+                                size_t num_bytes) {
+  std::vector<void*> ptrs;
+  for (int i = 0; i < num_allocations; ++i) {
+    void* ptr = allocator->AllocateRaw(Allocator::kAllocatorAlignment,
+                                       num_bytes);
+    EXPECT_NE(ptr, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) %
+                  Allocator::kAllocatorAlignment,
+              0);
+    ptrs.push_back(ptr);
+  }
+  return ptrs;
+}
+
+void DeallocateStep(Allocator* allocator, const std::vector<void*>& ptrs) {
+  for (void* ptr : ptrs) {
+    allocator->DeallocateRaw(ptr);
+  }
+}
+
+TEST(StepArenaAllocatorTest, ServesStepFromOneRegion) {
+  CountingAllocator wrapped;
+  auto* arena = new StepArenaAllocator(&wrapped, 1 << 20);
+  std::vector<void*> ptrs = AllocateStep(arena, 100, 1000);
+  EXPECT_EQ(arena->num_regions(), 1);
+  EXPECT_EQ(wrapped.num_live(), 1);
+  EXPECT_EQ(arena->region_bytes_used(), 100 * 1024);
+  EXPECT_EQ(arena->GetStats()->num_allocs, 100);
+  DeallocateStep(arena, ptrs);
+  arena->Release();
+  EXPECT_EQ(wrapped.num_live(), 0);
+}
+
+TEST(StepArenaAllocatorTest, SizesFirstRegionFromHint) {
+  CountingAllocator wrapped;
+  // 768 KiB of intermediates do not fit in a minimal region.
+  auto* arena = new StepArenaAllocator(&wrapped, 0);
+  std::vector<void*> ptrs = AllocateStep(arena, 48, 16 << 10);
+  EXPECT_GT(arena->num_regions(), 1);
+  const size_t hint = arena->region_bytes_used();
+  EXPECT_EQ(hint, 48 * (16 << 10));
+  DeallocateStep(arena, ptrs);
+  arena->Release();
+
+  // With the previous step as a hint, the next step fits in a single region.
+  arena = new StepArenaAllocator(&wrapped, hint);
+  ptrs = AllocateStep(arena, 48, 16 << 10);
+  EXPECT_EQ(arena->num_regions(), 1);
+  DeallocateStep(arena, ptrs);
+  arena->Release();
+  EXPECT_EQ(wrapped.num_live(), 0);
+}
+
+TEST(StepArenaAllocatorTest, LiveAllocationOutlivesRelease) {
+  CountingAllocator wrapped;
+  auto* arena = new StepArenaAllocator(&wrapped, 0);
+  std::vector<void*> ptrs = AllocateStep(arena, 10, 1000);
+  // Simulate a tensor that outlives the step.
+  void* escaped = ptrs.back();
+  ptrs.pop_back();
+  static_cast<char*>(escaped)[0] = 42;
+  DeallocateStep(arena, ptrs);
+  arena->Release();
+
+  // The region is kept until the escaped buffer is deallocated.
+  EXPECT_EQ(wrapped.num_live(), 1);
+  EXPECT_EQ(static_cast<char*>(escaped)[0], 42);
+  arena->DeallocateRaw(escaped);
+  EXPECT_EQ(wrapped.num_live(), 0);
+}
+
+TEST(StepArenaAllocatorTest, ForwardsLargeAllocations) {
+  CountingAllocator wrapped;
+  auto* arena = new StepArenaAllocator(&wrapped, 0);
+  void* large = arena->AllocateRaw(Allocator::kAllocatorAlignment,
+                                   StepArenaAllocator::kMinRegionBytes);
+  ASSERT_NE(large, nullptr);
+  void* aligned = arena->AllocateRaw(4 * Allocator::kAllocatorAlignment, 16);
+  ASSERT_NE(aligned, nullptr);
+  EXPECT_EQ(arena->num_regions(), 0);
+  EXPECT_EQ(wrapped.num_live(), 2);
+  arena->Release();
+
+  // Forwarded allocations also keep the arena alive.
+  arena->DeallocateRaw(large);
+  EXPECT_EQ(wrapped.num_live(), 1);
+  arena->DeallocateRaw(aligned);
+  EXPECT_EQ(wrapped.num_live(), 0);
+}
+
+TEST(StepArenaAllocatorTest, OverlappingSteps) {
+  CountingAllocator wrapped;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&wrapped]() {
+      // Each step keeps one allocation alive until the end of the next step.
+      StepArenaAllocator* previous_arena = nullptr;
+      void* held = nullptr;
+      for (int step = 0; step < 100; ++step) {
+        auto* arena = new StepArenaAllocator(&wrapped, 0);
+        std::vector<void*> ptrs = AllocateStep(arena, 20, 4 << 10);
+        if (held != nullptr) {
+          previous_arena->DeallocateRaw(held);
+        }
+        held = ptrs.back();
+        ptrs.pop_back();
+        DeallocateStep(arena, ptrs);
+        arena->Release();
+        previous_arena = arena;
+      }
+      previous_arena->DeallocateRaw(held);
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(wrapped.num_live(), 0);
+}
+
+// Runs steps of `num_allocations` allocations of `num_bytes` bytes each on
+// every benchmark thread, so that the steps of different threads overlap. As
+// with a fetched output, one allocation of each step is held until the end of
+// the next step. If `use_arena` is true, each step allocates from its own
+// `StepArenaAllocator`, and otherwise directly from `cpu_allocator()`.
+void BM_OverlappingSteps(::testing::benchmark::State& state, bool use_arena) {
+  const int num_allocations = state.range(0);
+  const size_t num_bytes = state.range(1);
+  std::vector<void*> ptrs(num_allocations);
+  Allocator* previous_allocator = nullptr;
+  void* held = nullptr;
+  size_t region_bytes = 0;
+  for (auto _ : state) {
+    StepArenaAllocator* arena = nullptr;
+    Allocator* allocator = cpu_allocator();
+    if (use_arena) {
+      arena = new StepArenaAllocator(cpu_allocator(), region_bytes);
+      allocator = arena;
+    }
+    for (int i = 0; i < num_allocations; ++i) {
+      ptrs[i] = allocator->AllocateRaw(Allocator::kAllocatorAlignment,
+                                       num_bytes);
+    }
+    if (held != nullptr) {
+      previous_allocator->DeallocateRaw(held);
+    }
+    held = ptrs[0];
+    previous_allocator = allocator;
+    for (int i = 1; i < num_allocations; ++i) {
+      allocator->DeallocateRaw(ptrs[i]);
+    }
+    if (arena != nullptr) {
+      region_bytes = arena->region_bytes_used();
+      arena->Release();
+    }
+  }
+  if (held != nullptr) {
+    previous_allocator->DeallocateRaw(held);
+  }
+  state.SetItemsProcessed(static_cast<int64>(state.iterations()) *
+                          num_allocations);
+}
+
+void BM_OverlappingStepsCpuAllocator(::testing::benchmark::State& state) {
+  BM_OverlappingSteps(state, /*use_arena=*/false);
+}
+
+void BM_OverlappingStepsStepArenaAllocator(
+    ::testing::benchmark::State& state) {
+  BM_OverlappingSteps(state, /*use_arena=*/true);
+}
+
+BENCHMARK(BM_OverlappingStepsCpuAllocator)
+    ->ArgPair(100, 256)
+    ->ArgPair(100, 16 << 10)
+    ->Threads(1)
+    ->Threads(4)
+    ->Threads(16);
+BENCHMARK(BM_OverlappingStepsStepArenaAllocator)
+    ->ArgPair(100, 256)
+    ->ArgPair(100, 16 << 10)
+    ->Threads(1)
+    ->Threads(4)
+    ->Threads(16);
+
+}  // namespace
+}  // namespace tensorflow
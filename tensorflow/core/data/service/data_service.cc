@@ -33,6 +33,10 @@ namespace data {
 namespace {
 constexpr const char kParallelEpochs[] = "parallel_epochs";
 constexpr const char kDistributedEpoch[] = "distributed_epoch";
+// How much lower a worker's reported CPU utilization must be for clients to
+// prefer it over another worker, so that measurement noise doesn't cause the
+// preference to flip-flop.
+constexpr double kCpuUtilizationSlack = 0.1;
 
 }  // namespace
 
@@ -59,10 +63,28 @@ std::string ProcessingModeToString(ProcessingMode mode) {
   }
 }
 
+int64 TaskBufferedElements(const WorkerLoad& load, int64 task_id) {
+  auto it = load.task_buffered_elements().find(task_id);
+  if (it == load.task_buffered_elements().end()) {
+    return 0;
+  }
+  return it->second;
+}
+
+bool IsLighterLoad(const WorkerLoad& a, int64 task_a, const WorkerLoad& b,
+                   int64 task_b) {
+  int64 buffered_a = TaskBufferedElements(a, task_a);
+  int64 buffered_b = TaskBufferedElements(b, task_b);
+  if (buffered_a != buffered_b) {
+    return buffered_a > buffered_b;
+  }
+  return a.cpu_utilization() + kCpuUtilizationSlack < b.cpu_utilization();
+}
+
 Status DataServiceDispatcherClient::WorkerHeartbeat(
     const std::string& worker_address, const std::string& transfer_address,
-    const std::vector<int64>& current_tasks, std::vector<TaskDef>& new_tasks,
-    std::vector<int64>& tasks_to_delete) {
+    const std::vector<int64>& current_tasks, const WorkerLoad& load,
+    std::vector<TaskDef>& new_tasks, std::vector<int64>& tasks_to_delete) {
   TF_RETURN_IF_ERROR(EnsureInitialized());
   WorkerHeartbeatRequest req;
   req.set_worker_address(worker_address);
@@ -70,6 +92,7 @@ Status DataServiceDispatcherClient::WorkerHeartbeat(
   for (int64 task : current_tasks) {
     req.add_current_tasks(task);
   }
+  *req.mutable_load() = load;
   WorkerHeartbeatResponse resp;
   grpc::ClientContext client_ctx;
   grpc::Status status = stub_->WorkerHeartbeat(&client_ctx, req, &resp);
@@ -307,6 +330,71 @@ class GrpcDataTransferClient : public DataTransferClient {
     }
     GetElementResponse resp;
     grpc::Status s = stub_->GetElement(&ctx, req, &resp);
+    {
+      mutex_lock l(mu_);
+      active_contexts_.erase(&ctx);
+    }
+    if (!s.ok()) {
+      return grpc_util::WrapError("Failed to get element", s);
+    }
+    return ResponseToResult(resp, result);
+  }
+
+  Status GetElements(const GetElementRequest& req, int64 max_elements,
+                     std::vector<GetElementResult>& results) override {
+    if (max_elements <= 1) {
+      return DataTransferClient::GetElements(req, max_elements, results);
+    }
+    {
+      mutex_lock l(mu_);
+      if (cancelled_) {
+        return errors::Cancelled("Client was cancelled.");
+      }
+    }
+    grpc::ClientContext ctx;
+    {
+      mutex_lock l(mu_);
+      active_contexts_.insert(&ctx);
+    }
+    GetElementsRequest elements_req;
+    elements_req.set_task_id(req.task_id());
+    elements_req.set_max_elements(max_elements);
+    GetElementsResponse resp;
+    grpc::Status s = stub_->GetElements(&ctx, elements_req, &resp);
+    {
+      mutex_lock l(mu_);
+      active_contexts_.erase(&ctx);
+    }
+    if (!s.ok()) {
+      return grpc_util::WrapError("Failed to get elements", s);
+    }
+    if (resp.elements_size() > max_elements) {
+      return errors::Internal("Requested at most ", max_elements,
+                              " elements, but received ",
+                              resp.elements_size());
+    }
+    for (GetElementResponse& element : *resp.mutable_elements()) {
+      GetElementResult result;
+      TF_RETURN_IF_ERROR(ResponseToResult(element, result));
+      results.push_back(std::move(result));
+    }
+    return Status::OK();
+  }
+
+  void TryCancel() override {
+    mutex_lock l(mu_);
+    cancelled_ = true;
+    for (const auto& ctx : active_contexts_) {
+      ctx->TryCancel();
+    }
+  }
+
+ private:
+  // Converts a GetElement response into a GetElementResult, consuming the
+  // element stored in `resp`.
+  static Status ResponseToResult(GetElementResponse& resp,
+                                 GetElementResult& result) {
+    result.element_index = resp.element_index();
     result.end_of_sequence = resp.end_of_sequence();
     result.skip = resp.skip_task();
     switch (resp.element_case()) {
@@ -327,25 +415,9 @@ class GrpcDataTransferClient : public DataTransferClient {
       case GetElementResponse::ELEMENT_NOT_SET:
         break;
     }
-    {
-      mutex_lock l(mu_);
-      active_contexts_.erase(&ctx);
-    }
-    if (!s.ok()) {
-      return grpc_util::WrapError("Failed to get element", s);
-    }
     return Status::OK();
   }
 
-  void TryCancel() override {
-    mutex_lock l(mu_);
-    cancelled_ = true;
-    for (const auto& ctx : active_contexts_) {
-      ctx->TryCancel();
-    }
-  }
-
- private:
   mutex mu_;
   std::unique_ptr<WorkerService::Stub> stub_;
   // Set of all currently active clients contexts. Used to support
@@ -374,6 +446,66 @@ class GrpcTransferClientRegistrar {
 };
 static GrpcTransferClientRegistrar registrar;
 
+// Fetches elements from a worker running in the same process by calling into
+// the worker directly. The element tensors are shared with the worker, so
+// nothing is serialized or copied.
+class LocalDataTransferClient : public DataTransferClient {
+ public:
+  explicit LocalDataTransferClient(
+      std::shared_ptr<DataTransferServer::GetElementT> get_element)
+      : get_element_(std::move(get_element)) {}
+
+  Status GetElement(const GetElementRequest& req,
+                    GetElementResult& result) override {
+    {
+      mutex_lock l(mu_);
+      if (cancelled_) {
+        return errors::Cancelled("Client was cancelled.");
+      }
+    }
+    return (*get_element_)(&req, &result);
+  }
+
+  void TryCancel() override {
+    mutex_lock l(mu_);
+    cancelled_ = true;
+  }
+
+ private:
+  const std::shared_ptr<DataTransferServer::GetElementT> get_element_;
+  mutex mu_;
+  // Indicates that the client has been cancelled, so no further requests should
+  // be accepted.
+  bool cancelled_ TF_GUARDED_BY(mu_) = false;
+};
+
+class LocalTransferClientRegistrar {
+ public:
+  LocalTransferClientRegistrar() {
+    DataTransferClient::Register(
+        kLocalTransferProtocol, [](DataTransferClient::Config config,
+                                   std::unique_ptr<DataTransferClient>* out) {
+          std::shared_ptr<DataTransferServer::GetElementT> get_element =
+              LocalWorkers::Get(config.address);
+          if (get_element) {
+            VLOG(2) << "Reading from local worker at " << config.address;
+            *out = std::make_unique<LocalDataTransferClient>(
+                std::move(get_element));
+            return Status::OK();
+          }
+          VLOG(2) << "No local worker found at " << config.address
+                  << ", falling back to gRPC.";
+          std::shared_ptr<grpc::ChannelCredentials> credentials;
+          TF_RETURN_IF_ERROR(CredentialsFactory::CreateClientCredentials(
+              config.protocol, &credentials));
+          *out = std::make_unique<GrpcDataTransferClient>(credentials,
+                                                          config.address);
+          return Status::OK();
+        });
+  }
+};
+static LocalTransferClientRegistrar local_registrar;
+
 Status DataServiceWorkerClient::GetElement(const GetElementRequest& req,
                                            GetElementResult& result) {
   TF_RETURN_IF_ERROR(EnsureInitialized());
@@ -390,6 +522,13 @@ Status DataServiceWorkerClient::EnsureInitialized() {
   return Status::OK();
 }
 
+Status DataServiceWorkerClient::GetElements(
+    const GetElementRequest& req, int64 max_elements,
+    std::vector<GetElementResult>& results) {
+  TF_RETURN_IF_ERROR(EnsureInitialized());
+  return client_->GetElements(req, max_elements, results);
+}
+
 void DataServiceWorkerClient::TryCancel() { client_->TryCancel(); }
 
 Status CreateDataServiceDispatcherClient(
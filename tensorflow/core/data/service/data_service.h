@@ -30,7 +30,7 @@ namespace data {
 
 // Increment this when making backwards-incompatible changes to communication
 // between tf.data servers.
-constexpr int kDataServiceVersion = 3;
+constexpr int kDataServiceVersion = 4;
 
 // Modes for how a tf.data service job should process a dataset.
 enum class ProcessingMode : int64 {
@@ -49,6 +49,19 @@ Status ParseProcessingMode(const std::string& s, ProcessingMode& mode);
 // Converts a processing mode to its corresponding string.
 std::string ProcessingModeToString(ProcessingMode mode);
 
+// Returns the number of elements buffered ahead of requests for task `task_id`
+// in the load reported by the task's worker.
+int64 TaskBufferedElements(const WorkerLoad& load, int64 task_id);
+
+// Returns whether clients should prefer reading task `task_a` from a worker
+// reporting load `a` over reading task `task_b` from a worker reporting load
+// `b`. Tasks which have more elements buffered ahead of requests are
+// preferred, then workers with clearly more spare CPU capacity. Buffered
+// elements are compared per task, since elements buffered for other tasks
+// (e.g. of other jobs) can't serve the request.
+bool IsLighterLoad(const WorkerLoad& a, int64 task_a, const WorkerLoad& b,
+                   int64 task_b);
+
 // Base class for data service clients. Data service clients are
 // threadsafe.
 class DataServiceClientBase {
@@ -86,10 +99,12 @@ class DataServiceDispatcherClient : public DataServiceClientBase {
   // registered with the dispatcher, this will register the worker. The
   // dispatcher will report which new tasks the worker should run, and which
   // tasks it should delete. This is stored into `new_tasks` and
-  // `tasks_to_delete`.
+  // `tasks_to_delete`. `load` reports the worker's recent load, which the
+  // dispatcher shares with clients so that they can favor less loaded workers.
   Status WorkerHeartbeat(const std::string& worker_address,
                          const std::string& transfer_address,
                          const std::vector<int64>& current_tasks,
+                         const WorkerLoad& load,
                          std::vector<TaskDef>& new_tasks,
                          std::vector<int64>& tasks_to_delete);
 
@@ -157,6 +172,11 @@ class DataServiceWorkerClient : public DataServiceClientBase {
   // Fetches an element from the worker.
   Status GetElement(const GetElementRequest& req, GetElementResult& result);
 
+  // Fetches up to `max_elements` elements from the worker, appending them to
+  // `results`. See `DataTransferClient::GetElements`.
+  Status GetElements(const GetElementRequest& req, int64 max_elements,
+                     std::vector<GetElementResult>& results);
+
   // Makes a best effort to cancel all outstanding calls in progress for the
   // client, and causes further calls to return Cancelled status.
   void TryCancel();
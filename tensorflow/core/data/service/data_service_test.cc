@@ -74,5 +74,61 @@ TEST(DataService, GetWorkers) {
   EXPECT_EQ(1, workers.size());
 }
 
+TEST(DataService, GetWorkersReportsLoad) {
+  TestCluster cluster(1);
+  TF_ASSERT_OK(cluster.Initialize());
+  DataServiceDispatcherClient dispatcher(cluster.DispatcherAddress(),
+                                         kProtocol);
+  std::vector<WorkerInfo> workers;
+  TF_EXPECT_OK(dispatcher.GetWorkers(workers));
+  ASSERT_EQ(1, workers.size());
+  // Workers report their load starting with the registration heartbeat.
+  ASSERT_TRUE(workers[0].has_load());
+  EXPECT_GE(workers[0].load().cpu_utilization(), 0.0);
+  EXPECT_LE(workers[0].load().cpu_utilization(), 1.0);
+  EXPECT_EQ(workers[0].load().buffered_elements(), 0);
+}
+
+TEST(DataService, IsLighterLoad) {
+  const int64 task = 1;
+  WorkerLoad idle;
+  WorkerLoad buffered;
+  buffered.set_buffered_elements(4);
+  (*buffered.mutable_task_buffered_elements())[task] = 4;
+  buffered.set_cpu_utilization(0.9);
+  WorkerLoad busy;
+  busy.set_cpu_utilization(0.9);
+  WorkerLoad slightly_busy;
+  slightly_busy.set_cpu_utilization(0.05);
+  // Buffered elements take precedence over CPU utilization.
+  EXPECT_TRUE(IsLighterLoad(buffered, task, idle, task));
+  EXPECT_FALSE(IsLighterLoad(idle, task, buffered, task));
+  EXPECT_TRUE(IsLighterLoad(idle, task, busy, task));
+  EXPECT_FALSE(IsLighterLoad(busy, task, idle, task));
+  // Small differences in CPU utilization don't change the preference.
+  EXPECT_FALSE(IsLighterLoad(idle, task, slightly_busy, task));
+  EXPECT_FALSE(IsLighterLoad(slightly_busy, task, idle, task));
+  EXPECT_FALSE(IsLighterLoad(idle, task, idle, task));
+}
+
+TEST(DataService, IsLighterLoadComparesTaskBufferedElements) {
+  const int64 task = 1;
+  const int64 other_task = 2;
+  // The worker's elements are all buffered for another task, so they can't
+  // serve a request for `task`.
+  WorkerLoad buffered_for_other_task;
+  buffered_for_other_task.set_buffered_elements(8);
+  (*buffered_for_other_task.mutable_task_buffered_elements())[other_task] = 8;
+  WorkerLoad buffered_for_task;
+  buffered_for_task.set_buffered_elements(2);
+  (*buffered_for_task.mutable_task_buffered_elements())[task] = 2;
+  EXPECT_EQ(TaskBufferedElements(buffered_for_other_task, task), 0);
+  EXPECT_EQ(TaskBufferedElements(buffered_for_task, task), 2);
+  EXPECT_TRUE(IsLighterLoad(buffered_for_task, task, buffered_for_other_task,
+                            task));
+  EXPECT_FALSE(IsLighterLoad(buffered_for_other_task, task, buffered_for_task,
+                             task));
+}
+
 }  // namespace data
 }  // namespace tensorflow
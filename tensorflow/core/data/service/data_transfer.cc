@@ -45,6 +45,14 @@ DataTransferClientFactories& transfer_client_factories() {
   static auto& factories = *new DataTransferClientFactories();
   return factories;
 }
+
+using LocalWorkerMap =
+    std::unordered_map<std::string,
+                       std::shared_ptr<DataTransferServer::GetElementT>>;
+LocalWorkerMap& local_workers() {
+  static auto& workers = *new LocalWorkerMap();
+  return workers;
+}
 }  // namespace
 
 void DataTransferServer::Register(
@@ -106,5 +114,27 @@ Status DataTransferClient::Build(std::string name, Config config,
       " ]");
 }
 
+void LocalWorkers::Add(const std::string& transfer_address,
+                       DataTransferServer::GetElementT get_element) {
+  mutex_lock l(*get_lock());
+  local_workers()[transfer_address] =
+      std::make_shared<DataTransferServer::GetElementT>(std::move(get_element));
+}
+
+std::shared_ptr<DataTransferServer::GetElementT> LocalWorkers::Get(
+    const std::string& transfer_address) {
+  mutex_lock l(*get_lock());
+  auto it = local_workers().find(transfer_address);
+  if (it == local_workers().end()) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+void LocalWorkers::Remove(const std::string& transfer_address) {
+  mutex_lock l(*get_lock());
+  local_workers().erase(transfer_address);
+}
+
 }  // namespace data
 }  // namespace tensorflow
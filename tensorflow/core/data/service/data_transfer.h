@@ -17,17 +17,30 @@ limitations under the License.
 #define TENSORFLOW_CORE_DATA_SERVICE_DATA_TRANSFER_H_
 
 #include <functional>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
 #include "tensorflow/core/data/dataset.pb.h"
 #include "tensorflow/core/data/service/worker.pb.h"
 #include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/status.h"
 
 namespace tensorflow {
 namespace data {
 
+// Data transfer protocol for clients running in the same process as the worker
+// they read from. Such clients call into the worker directly instead of going
+// through gRPC, so elements are neither serialized nor copied. Clients using
+// this protocol fall back to gRPC for workers in other processes, including
+// workers in other processes on the same host: handing elements across
+// processes would need shared memory segments and a protocol for the lifetime
+// of their slots, which are not implemented.
+constexpr char kLocalTransferProtocol[] = "local";
+
 // The result of a GetElement request. Exactly one of the following will be
 // true: (1) `components` is nonempty (2) `end_of_sequence` is true (3) `skip`
 // is true.
@@ -59,6 +72,18 @@ class DataTransferClient {
   virtual Status GetElement(const GetElementRequest& req,
                             GetElementResult& result) = 0;
 
+  // Fetches up to `max_elements` elements from the task `req.task_id()`,
+  // appending them to `results`. At least one element is fetched unless an
+  // error is returned. Only supported for tasks which are not read in
+  // round-robin order. The default implementation fetches a single element.
+  virtual Status GetElements(const GetElementRequest& req, int64 max_elements,
+                             std::vector<GetElementResult>& results) {
+    GetElementResult result;
+    TF_RETURN_IF_ERROR(GetElement(req, result));
+    results.push_back(std::move(result));
+    return Status::OK();
+  }
+
   // Makes a best effort to cancel all outstanding calls in progress for the
   // client, and causes further calls to return Cancelled status.
   virtual void TryCancel() = 0;
@@ -94,6 +119,26 @@ class DataTransferServer {
                       std::shared_ptr<DataTransferServer>* out);
 };
 
+// Registry of the workers running in the current process, keyed by the address
+// that clients send data transfer requests to, i.e. the worker's transfer
+// address. Used by clients of the `kLocalTransferProtocol` protocol.
+class LocalWorkers {
+ public:
+  // Registers the element getter of the worker whose transfer address is
+  // `transfer_address`.
+  static void Add(const std::string& transfer_address,
+                  DataTransferServer::GetElementT get_element);
+
+  // Returns the element getter of the worker whose transfer address is
+  // `transfer_address`, or `nullptr` if there is no such worker in the current
+  // process.
+  static std::shared_ptr<DataTransferServer::GetElementT> Get(
+      const std::string& transfer_address);
+
+  // Unregisters the worker whose transfer address is `transfer_address`.
+  static void Remove(const std::string& transfer_address);
+};
+
 }  // namespace data
 }  // namespace tensorflow
 
@@ -14,6 +14,9 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/data/service/data_transfer.h"
 
+#include <memory>
+#include <string>
+
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
@@ -49,6 +52,34 @@ TEST(DataTransferTest, RegisterDataTransferServerBuilder) {
   EXPECT_TRUE(called);
 }
 
+TEST(DataTransferTest, LocalWorkers) {
+  const std::string worker_address = "localhost:1234";
+  EXPECT_EQ(LocalWorkers::Get(worker_address), nullptr);
+
+  int num_calls = 0;
+  LocalWorkers::Add(worker_address,
+                    [&num_calls](const GetElementRequest* request,
+                                 GetElementResult* result) {
+                      ++num_calls;
+                      result->end_of_sequence = true;
+                      return Status::OK();
+                    });
+  std::shared_ptr<DataTransferServer::GetElementT> get_element =
+      LocalWorkers::Get(worker_address);
+  ASSERT_NE(get_element, nullptr);
+  EXPECT_EQ(LocalWorkers::Get("localhost:5678"), nullptr);
+
+  LocalWorkers::Remove(worker_address);
+  EXPECT_EQ(LocalWorkers::Get(worker_address), nullptr);
+
+  // Getters handed out before removal remain callable.
+  GetElementRequest request;
+  GetElementResult result;
+  TF_ASSERT_OK((*get_element)(&request, &result));
+  EXPECT_TRUE(result.end_of_sequence);
+  EXPECT_EQ(num_calls, 1);
+}
+
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
@@ -52,6 +52,9 @@ namespace {
 // The name of the journal directory inside the dispatcher's working directory.
 // This name is load-bearing; do not change.
 constexpr char kJournalDir[] = "tf_data_dispatcher_journal";
+// The name of the dispatcher state snapshot inside the dispatcher's working
+// directory. This name is load-bearing; do not change.
+constexpr char kSnapshotFile[] = "tf_data_dispatcher_snapshot";
 // The name of the datasets directory inside the dispatcher's working directory.
 constexpr char kDatasetsDir[] = "datasets";
 
@@ -76,6 +79,10 @@ std::string JournalDir(const std::string& work_dir) {
   return io::JoinPath(work_dir, kJournalDir);
 }
 
+std::string SnapshotFile(const std::string& work_dir) {
+  return io::JoinPath(work_dir, kSnapshotFile);
+}
+
 std::string DatasetsDir(const std::string& work_dir) {
   return io::JoinPath(work_dir, kDatasetsDir);
 }
@@ -155,12 +162,25 @@ Status DataServiceDispatcherImpl::Start() {
   }
   journal_writer_ = absl::make_unique<FileJournalWriter>(
       env_, JournalDir(config_.work_dir()));
+  int64 journal_start = 0;
+  DispatcherStateSnapshot snapshot;
+  Status s = ReadDispatcherStateSnapshot(
+      env_, SnapshotFile(config_.work_dir()), snapshot);
+  if (s.ok()) {
+    LOG(INFO) << "Restoring dispatcher state from snapshot "
+              << SnapshotFile(config_.work_dir());
+    TF_RETURN_IF_ERROR(state_.Restore(snapshot));
+    journal_start = snapshot.journal_sequence_number();
+  } else if (!errors::IsNotFound(s)) {
+    return s;
+  }
   LOG(INFO) << "Attempting to restore dispatcher state from journal in "
             << JournalDir(config_.work_dir());
   Update update;
   bool end_of_journal = false;
-  FileJournalReader reader(env_, JournalDir(config_.work_dir()));
-  Status s = reader.Read(update, end_of_journal);
+  FileJournalReader reader(env_, JournalDir(config_.work_dir()),
+                           journal_start);
+  s = reader.Read(update, end_of_journal);
   if (errors::IsNotFound(s)) {
     LOG(INFO) << "No journal found. Starting dispatcher from new state.";
   } else if (!s.ok()) {
@@ -293,6 +313,9 @@ Status DataServiceDispatcherImpl::WorkerHeartbeat(
     TF_RETURN_IF_ERROR(CreateTasksForWorker(worker_address));
     TF_RETURN_IF_ERROR(state_.TasksForWorker(worker_address, assigned_tasks));
   }
+  if (request->has_load()) {
+    worker_loads_[worker_address] = request->load();
+  }
   absl::flat_hash_set<int64> current_tasks;
   current_tasks.insert(request->current_tasks().cbegin(),
                        request->current_tasks().cend());
@@ -847,6 +870,10 @@ Status DataServiceDispatcherImpl::ClientHeartbeat(
     task_info->set_task_id(task->task_id);
     task_info->set_job_id(job->job_id);
     task_info->set_starting_round(task->starting_round);
+    auto load_it = worker_loads_.find(task->worker_address);
+    if (load_it != worker_loads_.end()) {
+      *task_info->mutable_worker_load() = load_it->second;
+    }
   }
   response->set_job_finished(job->finished);
   VLOG(4) << "Found " << response->task_info_size()
@@ -863,6 +890,10 @@ Status DataServiceDispatcherImpl::GetWorkers(const GetWorkersRequest* request,
   for (const auto& worker : workers) {
     WorkerInfo* info = response->add_workers();
     info->set_address(worker->address);
+    auto load_it = worker_loads_.find(worker->address);
+    if (load_it != worker_loads_.end()) {
+      *info->mutable_load() = load_it->second;
+    }
   }
   VLOG(3) << "Returning list of " << response->workers_size()
           << " workers from GetWorkers";
@@ -896,10 +927,42 @@ Status DataServiceDispatcherImpl::ApplyWithoutJournaling(const Update& update)
 
 Status DataServiceDispatcherImpl::Apply(const Update& update)
     TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-  if (journal_writer_.has_value()) {
-    TF_RETURN_IF_ERROR(journal_writer_.value()->Write(update));
+  if (!journal_writer_.has_value()) {
+    return state_.Apply(update);
   }
-  return state_.Apply(update);
+  TF_RETURN_IF_ERROR(journal_writer_.value()->Write(update));
+  TF_RETURN_IF_ERROR(state_.Apply(update));
+  if (config_.journal_snapshot_interval() > 0 &&
+      ++updates_since_snapshot_ >= config_.journal_snapshot_interval()) {
+    updates_since_snapshot_ = 0;
+    Status s = SnapshotState();
+    if (!s.ok()) {
+      // The journal is still complete, so a failed snapshot only delays
+      // truncation until the next attempt.
+      LOG(WARNING) << "Failed to snapshot dispatcher state: " << s;
+    }
+  }
+  return Status::OK();
+}
+
+Status DataServiceDispatcherImpl::SnapshotState()
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  // Rotate first so that every update in the snapshot lives in a journal file
+  // older than `sequence_number`. If we crash before the snapshot is renamed
+  // into place, recovery falls back to the previous snapshot and the
+  // untruncated journal; if we crash before truncating, the stale journal
+  // files are simply skipped on recovery.
+  int64 sequence_number;
+  TF_RETURN_IF_ERROR(journal_writer_.value()->Rotate(sequence_number));
+  DispatcherStateSnapshot snapshot;
+  state_.Snapshot(snapshot);
+  snapshot.set_journal_sequence_number(sequence_number);
+  TF_RETURN_IF_ERROR(WriteDispatcherStateSnapshot(
+      env_, SnapshotFile(config_.work_dir()), snapshot));
+  VLOG(1) << "Wrote dispatcher state snapshot at journal sequence number "
+          << sequence_number;
+  return TruncateJournal(env_, JournalDir(config_.work_dir()),
+                         sequence_number);
 }
 
 void DataServiceDispatcherImpl::JobGcThread() {
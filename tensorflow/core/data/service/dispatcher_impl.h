@@ -120,8 +120,9 @@ class DataServiceDispatcherImpl {
 
   ~DataServiceDispatcherImpl();
 
-  // Starts the dispatcher. If there is a journal, this will read from the
-  // journal to restore the dispatcher's state.
+  // Starts the dispatcher. If there is a state snapshot and/or a journal, this
+  // will restore the snapshot and replay the journal written after it to
+  // restore the dispatcher's state.
   Status Start();
 
   // See dispatcher.proto for API documentation.
@@ -248,6 +249,9 @@ class DataServiceDispatcherImpl {
   // used when recovering state when the dispatcher starts.
   Status ApplyWithoutJournaling(const Update& update)
       TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Writes a snapshot of `state_` to the work directory and deletes the
+  // journal files it covers, bounding journal size and recovery time.
+  Status SnapshotState() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
   // A thread which periodically checks for jobs to clean up.
   void JobGcThread();
   // Scans for old jobs and marks them as finished.
@@ -282,12 +286,17 @@ class DataServiceDispatcherImpl {
   // Mapping from round robin job id to the round the job is currently on. This
   // is based on the data provided by client heartbeats, and may be stale.
   absl::flat_hash_map<int64, int64> round_robin_rounds_ TF_GUARDED_BY(mu_);
+  // Map from worker address to the load most recently reported in the worker's
+  // heartbeat. Load is transient, so it is not journaled.
+  absl::flat_hash_map<std::string, WorkerLoad> worker_loads_ TF_GUARDED_BY(mu_);
   // Map from task id to a TaskRemover which determines when to remove the task.
   absl::flat_hash_map<int64, std::shared_ptr<TaskRemover>> remove_task_requests_
       TF_GUARDED_BY(mu_);
 
   absl::optional<std::unique_ptr<JournalWriter>> journal_writer_
       TF_GUARDED_BY(mu_);
+  // Number of journaled updates applied since the last state snapshot.
+  int64 updates_since_snapshot_ TF_GUARDED_BY(mu_) = 0;
   DispatcherState state_ TF_GUARDED_BY(mu_);
   // Condition variable for waking up the job gc thread.
   condition_variable job_gc_thread_cv_;
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/data/service/dispatcher_state.h"
 
+#include <algorithm>
 #include <memory>
 
 #include "tensorflow/core/data/service/journal.h"
@@ -235,6 +236,180 @@ void DispatcherState::FinishTask(const FinishTaskUpdate& finish_task) {
   jobs_[task->job->job_id]->finished = all_finished;
 }
 
+void DispatcherState::Snapshot(DispatcherStateSnapshot& snapshot) const {
+  snapshot.set_next_available_dataset_id(next_available_dataset_id_);
+  snapshot.set_next_available_job_id(next_available_job_id_);
+  snapshot.set_next_available_job_client_id(next_available_job_client_id_);
+  snapshot.set_next_available_task_id(next_available_task_id_);
+  for (const auto& it : datasets_by_id_) {
+    RegisterDatasetUpdate* dataset = snapshot.add_datasets();
+    dataset->set_dataset_id(it.second->dataset_id);
+    dataset->set_fingerprint(it.second->fingerprint);
+  }
+  for (const auto& it : workers_) {
+    RegisterWorkerUpdate* worker = snapshot.add_workers();
+    worker->set_worker_address(it.second->address);
+    worker->set_transfer_address(it.second->transfer_address);
+  }
+  for (const auto& it : jobs_) {
+    const Job& job = *it.second;
+    JobSnapshot* job_snapshot = snapshot.add_jobs();
+    CreateJobUpdate* create_job = job_snapshot->mutable_create_job();
+    create_job->set_job_id(job.job_id);
+    create_job->set_dataset_id(job.dataset_id);
+    create_job->set_processing_mode(ProcessingModeDef(job.processing_mode));
+    if (job.named_job_key.has_value()) {
+      NamedJobKeyDef* key = create_job->mutable_named_job_key();
+      key->set_name(job.named_job_key->name);
+      key->set_index(job.named_job_key->index);
+    }
+    if (job.num_consumers.has_value()) {
+      create_job->set_num_consumers(job.num_consumers.value());
+    }
+    if (job.distributed_epoch_state.has_value()) {
+      job_snapshot->set_repetition(job.distributed_epoch_state->repetition);
+      job_snapshot->set_split_provider_index(
+          job.distributed_epoch_state->split_provider_index);
+    }
+    job_snapshot->set_num_clients(job.num_clients);
+    job_snapshot->set_last_client_released_micros(
+        job.last_client_released_micros);
+    job_snapshot->set_finished(job.finished);
+    auto tasks_it = tasks_by_job_.find(job.job_id);
+    if (tasks_it != tasks_by_job_.end()) {
+      for (const auto& task : tasks_it->second) {
+        job_snapshot->add_task_ids(task->task_id);
+      }
+    }
+    std::queue<PendingTask> pending_tasks = job.pending_tasks;
+    while (!pending_tasks.empty()) {
+      const PendingTask& pending_task = pending_tasks.front();
+      PendingTaskSnapshot* pending_snapshot = job_snapshot->add_pending_tasks();
+      pending_snapshot->set_task_id(pending_task.task->task_id);
+      pending_snapshot->set_target_round(pending_task.target_round);
+      for (int64 consumer : pending_task.ready_consumers) {
+        pending_snapshot->add_ready_consumers(consumer);
+      }
+      pending_snapshot->set_failures(pending_task.failures);
+      pending_tasks.pop();
+    }
+  }
+  for (const auto& it : tasks_) {
+    const Task& task = *it.second;
+    TaskSnapshot* task_snapshot = snapshot.add_tasks();
+    task_snapshot->set_task_id(task.task_id);
+    task_snapshot->set_job_id(task.job->job_id);
+    task_snapshot->set_worker_address(task.worker_address);
+    task_snapshot->set_transfer_address(task.transfer_address);
+    task_snapshot->set_starting_round(task.starting_round);
+    task_snapshot->set_finished(task.finished);
+  }
+  auto& job_clients = *snapshot.mutable_job_clients();
+  for (const auto& it : jobs_for_client_ids_) {
+    // `JobForJobClientId` may leave null entries for unknown client ids.
+    if (it.second) {
+      job_clients[it.first] = it.second->job_id;
+    }
+  }
+}
+
+Status DispatcherState::Restore(const DispatcherStateSnapshot& snapshot) {
+  if (!datasets_by_id_.empty() || !workers_.empty() || !jobs_.empty() ||
+      !tasks_.empty()) {
+    return errors::FailedPrecondition(
+        "Dispatcher state can only be restored before any updates are "
+        "applied.");
+  }
+  for (const auto& dataset : snapshot.datasets()) {
+    RegisterDataset(dataset);
+  }
+  for (const auto& worker : snapshot.workers()) {
+    RegisterWorker(worker);
+  }
+  for (const auto& job_snapshot : snapshot.jobs()) {
+    CreateJob(job_snapshot.create_job());
+    Job& job = *jobs_[job_snapshot.create_job().job_id()];
+    if (job.distributed_epoch_state.has_value()) {
+      job.distributed_epoch_state->repetition = job_snapshot.repetition();
+      job.distributed_epoch_state->split_provider_index =
+          job_snapshot.split_provider_index();
+    }
+    job.num_clients = job_snapshot.num_clients();
+    job.last_client_released_micros =
+        job_snapshot.last_client_released_micros();
+    job.finished = job_snapshot.finished();
+  }
+  for (const auto& task_snapshot : snapshot.tasks()) {
+    auto job_it = jobs_.find(task_snapshot.job_id());
+    if (job_it == jobs_.end()) {
+      return errors::DataLoss("Task ", task_snapshot.task_id(),
+                              " in dispatcher state snapshot refers to "
+                              "unknown job ",
+                              task_snapshot.job_id());
+    }
+    auto task = std::make_shared<Task>(
+        task_snapshot.task_id(), job_it->second,
+        task_snapshot.worker_address(), task_snapshot.transfer_address());
+    task->starting_round = task_snapshot.starting_round();
+    task->finished = task_snapshot.finished();
+    tasks_[task->task_id] = task;
+    auto& worker_tasks = tasks_by_worker_[task->worker_address];
+    if (!task->finished) {
+      worker_tasks[task->task_id] = task;
+    }
+  }
+  for (const auto& job_snapshot : snapshot.jobs()) {
+    Job& job = *jobs_[job_snapshot.create_job().job_id()];
+    std::vector<std::shared_ptr<Task>>& tasks_for_job =
+        tasks_by_job_[job.job_id];
+    for (int64 task_id : job_snapshot.task_ids()) {
+      auto task_it = tasks_.find(task_id);
+      if (task_it == tasks_.end()) {
+        return errors::DataLoss("Job ", job.job_id,
+                                " in dispatcher state snapshot refers to "
+                                "unknown task ",
+                                task_id);
+      }
+      tasks_for_job.push_back(task_it->second);
+    }
+    for (const auto& pending_snapshot : job_snapshot.pending_tasks()) {
+      auto task_it = tasks_.find(pending_snapshot.task_id());
+      if (task_it == tasks_.end()) {
+        return errors::DataLoss("Job ", job.job_id,
+                                " in dispatcher state snapshot refers to "
+                                "unknown pending task ",
+                                pending_snapshot.task_id());
+      }
+      PendingTask pending_task(task_it->second,
+                               pending_snapshot.target_round());
+      pending_task.ready_consumers.insert(
+          pending_snapshot.ready_consumers().begin(),
+          pending_snapshot.ready_consumers().end());
+      pending_task.failures = pending_snapshot.failures();
+      job.pending_tasks.push(std::move(pending_task));
+    }
+  }
+  for (const auto& it : snapshot.job_clients()) {
+    auto job_it = jobs_.find(it.second);
+    if (job_it == jobs_.end()) {
+      return errors::DataLoss("Job client ", it.first,
+                              " in dispatcher state snapshot refers to "
+                              "unknown job ",
+                              it.second);
+    }
+    jobs_for_client_ids_[it.first] = job_it->second;
+  }
+  next_available_dataset_id_ = std::max(next_available_dataset_id_,
+                                        snapshot.next_available_dataset_id());
+  next_available_job_id_ =
+      std::max(next_available_job_id_, snapshot.next_available_job_id());
+  next_available_job_client_id_ = std::max(
+      next_available_job_client_id_, snapshot.next_available_job_client_id());
+  next_available_task_id_ =
+      std::max(next_available_task_id_, snapshot.next_available_task_id());
+  return Status::OK();
+}
+
 int64 DispatcherState::NextAvailableDatasetId() const {
   return next_available_dataset_id_;
 }
@@ -60,6 +60,14 @@ class DispatcherState {
   // Applies the given update to the dispatcher's state.
   Status Apply(const Update& update);
 
+  // Stores a snapshot of the dispatcher's state in `snapshot`. Restoring the
+  // snapshot produces the same state as replaying all updates applied so far.
+  // `snapshot.journal_sequence_number` is left for the caller to set.
+  void Snapshot(DispatcherStateSnapshot& snapshot) const;
+  // Restores the state from a snapshot created by `Snapshot`. Must be called
+  // before any updates are applied.
+  Status Restore(const DispatcherStateSnapshot& snapshot);
+
   // A dataset registered with the dispatcher.
   struct Dataset {
     explicit Dataset(int64 dataset_id, int64 fingerprint)
@@ -16,6 +16,7 @@ limitations under the License.
 
 #include <memory>
 
+#include "absl/strings/str_cat.h"
 #include "tensorflow/core/data/service/common.pb.h"
 #include "tensorflow/core/data/service/journal.h"
 #include "tensorflow/core/data/service/journal.pb.h"
@@ -23,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 namespace data {
@@ -121,6 +123,18 @@ Status FinishTask(int64 task_id, DispatcherState& state) {
   TF_RETURN_IF_ERROR(state.Apply(update));
   return Status::OK();
 }
+
+Status RestoreFromSnapshot(const DispatcherState& state,
+                           DispatcherState& restored) {
+  DispatcherStateSnapshot snapshot;
+  state.Snapshot(snapshot);
+  // Round trip through the wire format, as the dispatcher does.
+  DispatcherStateSnapshot parsed;
+  if (!parsed.ParseFromString(snapshot.SerializeAsString())) {
+    return errors::DataLoss("Failed to parse dispatcher state snapshot.");
+  }
+  return restored.Restore(parsed);
+}
 }  // namespace
 
 TEST(DispatcherState, RegisterDataset) {
@@ -473,5 +487,224 @@ TEST(DispatcherState, ReleaseJobClientId) {
   EXPECT_EQ(s.code(), error::NOT_FOUND);
 }
 
+TEST(DispatcherState, SnapshotRoundTrip) {
+  int64 dataset_id = 10;
+  int64 anonymous_job_id = 3;
+  int64 named_job_id = 4;
+  NamedJobKey named_job_key("job", /*index=*/1);
+  std::string worker_address_1 = "worker_address_1";
+  std::string worker_address_2 = "worker_address_2";
+  int64 finished_task_id = 20;
+  int64 active_task_id = 21;
+  int64 job_client_id = 30;
+  int64 released_job_client_id = 31;
+  int64 release_time = 100;
+  DispatcherState state;
+  TF_EXPECT_OK(RegisterDataset(dataset_id, state));
+  TF_EXPECT_OK(RegisterWorker(worker_address_1, state));
+  TF_EXPECT_OK(RegisterWorker(worker_address_2, state));
+  TF_EXPECT_OK(CreateAnonymousJob(anonymous_job_id, dataset_id, state));
+  TF_EXPECT_OK(
+      CreateNamedJob(named_job_id, dataset_id, named_job_key, state));
+  TF_EXPECT_OK(CreateTask(finished_task_id, anonymous_job_id,
+                          worker_address_1, state));
+  TF_EXPECT_OK(CreateTask(active_task_id, named_job_id, worker_address_2,
+                          state));
+  TF_EXPECT_OK(FinishTask(finished_task_id, state));
+  TF_EXPECT_OK(AcquireJobClientId(named_job_id, job_client_id, state));
+  TF_EXPECT_OK(
+      AcquireJobClientId(anonymous_job_id, released_job_client_id, state));
+  TF_EXPECT_OK(
+      ReleaseJobClientId(released_job_client_id, release_time, state));
+
+  DispatcherState restored;
+  TF_ASSERT_OK(RestoreFromSnapshot(state, restored));
+  EXPECT_EQ(restored.NextAvailableDatasetId(), state.NextAvailableDatasetId());
+  EXPECT_EQ(restored.NextAvailableJobId(), state.NextAvailableJobId());
+  EXPECT_EQ(restored.NextAvailableJobClientId(),
+            state.NextAvailableJobClientId());
+  EXPECT_EQ(restored.NextAvailableTaskId(), state.NextAvailableTaskId());
+  EXPECT_THAT(restored.ListWorkers(), SizeIs(2));
+  {
+    std::shared_ptr<const Dataset> dataset;
+    TF_EXPECT_OK(restored.DatasetFromId(dataset_id, dataset));
+    EXPECT_EQ(dataset->fingerprint, 1);
+  }
+  {
+    std::shared_ptr<const Job> job;
+    TF_EXPECT_OK(restored.JobFromId(anonymous_job_id, job));
+    EXPECT_EQ(job->num_clients, 0);
+    EXPECT_EQ(job->last_client_released_micros, release_time);
+    EXPECT_TRUE(job->finished);
+  }
+  {
+    std::shared_ptr<const Job> job;
+    TF_EXPECT_OK(restored.NamedJobByKey(named_job_key, job));
+    EXPECT_EQ(job->job_id, named_job_id);
+    EXPECT_EQ(job->num_clients, 1);
+    EXPECT_FALSE(job->finished);
+  }
+  {
+    std::shared_ptr<const Job> job;
+    TF_EXPECT_OK(restored.JobForJobClientId(job_client_id, job));
+    EXPECT_EQ(job->job_id, named_job_id);
+    Status s = restored.JobForJobClientId(released_job_client_id, job);
+    EXPECT_EQ(s.code(), error::NOT_FOUND);
+  }
+  {
+    std::vector<std::shared_ptr<const Task>> tasks;
+    TF_EXPECT_OK(restored.TasksForJob(anonymous_job_id, tasks));
+    ASSERT_THAT(tasks, SizeIs(1));
+    EXPECT_TRUE(tasks[0]->finished);
+  }
+  {
+    std::vector<std::shared_ptr<const Task>> tasks;
+    TF_EXPECT_OK(restored.TasksForWorker(worker_address_1, tasks));
+    EXPECT_THAT(tasks, IsEmpty());
+  }
+  {
+    std::vector<std::shared_ptr<const Task>> tasks;
+    TF_EXPECT_OK(restored.TasksForWorker(worker_address_2, tasks));
+    ASSERT_THAT(tasks, SizeIs(1));
+    EXPECT_EQ(tasks[0]->task_id, active_task_id);
+  }
+
+  // Updates journaled after the snapshot apply on top of the restored state.
+  TF_EXPECT_OK(FinishTask(active_task_id, restored));
+  std::shared_ptr<const Job> job;
+  TF_EXPECT_OK(restored.JobFromId(named_job_id, job));
+  EXPECT_TRUE(job->finished);
+}
+
+TEST(DispatcherState, RestoreNonEmptyState) {
+  DispatcherState state;
+  TF_EXPECT_OK(RegisterDataset(/*id=*/1, state));
+  DispatcherState restored;
+  TF_EXPECT_OK(RegisterDataset(/*id=*/2, restored));
+  Status s = RestoreFromSnapshot(state, restored);
+  EXPECT_EQ(s.code(), error::FAILED_PRECONDITION);
+}
+
+namespace {
+// Writes a journal resembling a long-running dispatcher: `num_jobs` short
+// distributed epoch jobs, each of which produces many splits and churns through
+// job clients, over a fixed set of datasets and workers.
+std::vector<Update> MakeJournal(int64 num_jobs) {
+  constexpr int64 kNumWorkers = 4;
+  constexpr int64 kSplitsPerJob = 32;
+  std::vector<Update> updates;
+  Update update;
+  update.mutable_register_dataset()->set_dataset_id(1);
+  updates.push_back(update);
+  for (int64 i = 0; i < kNumWorkers; ++i) {
+    update.Clear();
+    update.mutable_register_worker()->set_worker_address(
+        absl::StrCat("worker_", i));
+    updates.push_back(update);
+  }
+  int64 task_id = 0;
+  for (int64 job_id = 0; job_id < num_jobs; ++job_id) {
+    update.Clear();
+    CreateJobUpdate* create_job = update.mutable_create_job();
+    create_job->set_job_id(job_id);
+    create_job->set_dataset_id(1);
+    create_job->set_processing_mode(ProcessingModeDef::DISTRIBUTED_EPOCH);
+    updates.push_back(update);
+    update.Clear();
+    update.mutable_acquire_job_client()->set_job_id(job_id);
+    update.mutable_acquire_job_client()->set_job_client_id(job_id);
+    updates.push_back(update);
+    for (int64 i = 0; i < kNumWorkers; ++i) {
+      update.Clear();
+      CreateTaskUpdate* create_task = update.mutable_create_task();
+      create_task->set_task_id(task_id + i);
+      create_task->set_job_id(job_id);
+      create_task->set_worker_address(absl::StrCat("worker_", i));
+      updates.push_back(update);
+    }
+    for (int64 i = 0; i < kSplitsPerJob; ++i) {
+      update.Clear();
+      update.mutable_produce_split()->set_job_id(job_id);
+      updates.push_back(update);
+    }
+    for (int64 i = 0; i < kNumWorkers; ++i) {
+      update.Clear();
+      update.mutable_finish_task()->set_task_id(task_id++);
+      updates.push_back(update);
+    }
+    update.Clear();
+    update.mutable_release_job_client()->set_job_client_id(job_id);
+    updates.push_back(update);
+  }
+  return updates;
+}
+
+std::string NewWorkDir() {
+  std::string work_dir = testing::TmpDir();
+  CHECK(Env::Default()->CreateUniqueFileName(&work_dir, "dispatcher_state"));
+  return work_dir;
+}
+
+// Measures dispatcher recovery by replaying the full journal.
+void BM_RecoverFromJournal(::testing::benchmark::State& state) {
+  std::string journal_dir = NewWorkDir();
+  std::vector<Update> updates = MakeJournal(/*num_jobs=*/state.range(0));
+  FileJournalWriter writer(Env::Default(), journal_dir);
+  for (const auto& update : updates) {
+    TF_CHECK_OK(writer.Write(update));
+  }
+  for (auto s : state) {
+    DispatcherState dispatcher_state;
+    FileJournalReader reader(Env::Default(), journal_dir);
+    Update update;
+    bool end_of_journal = false;
+    TF_CHECK_OK(reader.Read(update, end_of_journal));
+    while (!end_of_journal) {
+      TF_CHECK_OK(dispatcher_state.Apply(update));
+      TF_CHECK_OK(reader.Read(update, end_of_journal));
+    }
+  }
+  state.SetLabel(absl::StrCat("journal_updates:", updates.size()));
+}
+
+BENCHMARK(BM_RecoverFromJournal)->Arg(16)->Arg(256)->Arg(4096);
+
+// Measures dispatcher recovery from a snapshot of the same state, as written
+// after journal truncation.
+void BM_RecoverFromSnapshot(::testing::benchmark::State& state) {
+  std::string work_dir = NewWorkDir();
+  std::string snapshot_path = io::JoinPath(work_dir, "snapshot");
+  std::string journal_dir = io::JoinPath(work_dir, "journal");
+  DispatcherState original;
+  for (const auto& update : MakeJournal(/*num_jobs=*/state.range(0))) {
+    TF_CHECK_OK(original.Apply(update));
+  }
+  DispatcherStateSnapshot snapshot;
+  original.Snapshot(snapshot);
+  FileJournalWriter writer(Env::Default(), journal_dir);
+  int64 sequence_number;
+  TF_CHECK_OK(writer.Rotate(sequence_number));
+  snapshot.set_journal_sequence_number(sequence_number);
+  TF_CHECK_OK(
+      WriteDispatcherStateSnapshot(Env::Default(), snapshot_path, snapshot));
+  for (auto s : state) {
+    DispatcherState dispatcher_state;
+    DispatcherStateSnapshot restored;
+    TF_CHECK_OK(ReadDispatcherStateSnapshot(Env::Default(), snapshot_path,
+                                            restored));
+    TF_CHECK_OK(dispatcher_state.Restore(restored));
+    FileJournalReader reader(Env::Default(), journal_dir,
+                             restored.journal_sequence_number());
+    Update update;
+    bool end_of_journal = false;
+    TF_CHECK_OK(reader.Read(update, end_of_journal));
+    CHECK(end_of_journal);
+  }
+  state.SetLabel(absl::StrCat("snapshot_bytes:", snapshot.ByteSizeLong()));
+}
+
+BENCHMARK(BM_RecoverFromSnapshot)->Arg(16)->Arg(256)->Arg(4096);
+}  // namespace
+
 }  // namespace data
 }  // namespace tensorflow
@@ -26,26 +26,27 @@ using ::grpc::ServerContext;
 
 GrpcWorkerImpl::GrpcWorkerImpl(const experimental::WorkerConfig& config,
                                ServerBuilder& server_builder)
-    : impl_(config) {
+    : impl_(std::make_shared<DataServiceWorkerImpl>(config)) {
   server_builder.RegisterService(this);
   VLOG(1) << "Registered data service worker";
 }
 
 Status GrpcWorkerImpl::Start(const std::string& worker_address,
                              const std::string& transfer_address) {
-  return impl_.Start(worker_address, transfer_address);
+  return impl_->Start(worker_address, transfer_address);
 }
 
-void GrpcWorkerImpl::Stop() { impl_.Stop(); }
+void GrpcWorkerImpl::Stop() { impl_->Stop(); }
 
 #define HANDLER(method)                                                 \
   ::grpc::Status GrpcWorkerImpl::method(ServerContext* context,         \
                                         const method##Request* request, \
                                         method##Response* response) {   \
-    return ToGrpcStatus(impl_.method(request, response));               \
+    return ToGrpcStatus(impl_->method(request, response));              \
   }
 HANDLER(ProcessTask);
 HANDLER(GetElement);
+HANDLER(GetElements);
 HANDLER(GetWorkerTasks);
 #undef HANDLER
 
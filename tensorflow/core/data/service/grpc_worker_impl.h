@@ -37,10 +37,13 @@ class GrpcWorkerImpl : public WorkerService::Service {
                const std::string& transfer_address);
   void Stop();
 
+  // Returns a function for fetching elements from the worker. The function
+  // keeps the worker alive, so it may outlive this object.
   std::function<Status(const GetElementRequest*, GetElementResult*)>
   get_element_getter() {
-    return [this](const GetElementRequest* request, GetElementResult* result) {
-      return impl_.GetElementResult(request, result);
+    return [impl = impl_](const GetElementRequest* request,
+                          GetElementResult* result) {
+      return impl->GetElementResult(request, result);
     };
   }
 
@@ -50,11 +53,12 @@ class GrpcWorkerImpl : public WorkerService::Service {
                         method##Response* response) override;
   HANDLER(ProcessTask);
   HANDLER(GetElement);
+  HANDLER(GetElements);
   HANDLER(GetWorkerTasks);
 #undef HANDLER
 
  private:
-  DataServiceWorkerImpl impl_;
+  const std::shared_ptr<DataServiceWorkerImpl> impl_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(GrpcWorkerImpl);
 };
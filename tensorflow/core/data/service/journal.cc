@@ -29,6 +29,7 @@ namespace data {
 
 namespace {
 constexpr StringPiece kJournal = "journal";
+constexpr StringPiece kTmpSuffix = ".tmp";
 
 Status ParseSequenceNumber(const std::string& journal_file,
                            int64* sequence_number) {
@@ -62,14 +63,35 @@ Status FileJournalWriter::EnsureInitialized() {
     TF_RETURN_IF_ERROR(ParseSequenceNumber(file, &sequence_number));
     latest_sequence_number = std::max(latest_sequence_number, sequence_number);
   }
+  return OpenFile(latest_sequence_number + 1);
+}
+
+Status FileJournalWriter::OpenFile(int64 sequence_number) {
   std::string journal_file =
-      DataServiceJournalFile(journal_dir_, latest_sequence_number + 1);
-  TF_RETURN_IF_ERROR(env_->NewAppendableFile(journal_file, &file_));
-  writer_ = absl::make_unique<io::RecordWriter>(file_.get());
+      DataServiceJournalFile(journal_dir_, sequence_number);
+  std::unique_ptr<WritableFile> file;
+  TF_RETURN_IF_ERROR(env_->NewAppendableFile(journal_file, &file));
+  writer_ = absl::make_unique<io::RecordWriter>(file.get());
+  file_ = std::move(file);
+  sequence_number_ = sequence_number;
   VLOG(1) << "Created journal writer to write to " << journal_file;
   return Status::OK();
 }
 
+Status FileJournalWriter::Rotate(int64& sequence_number) {
+  if (!writer_) {
+    TF_RETURN_IF_ERROR(EnsureInitialized());
+    sequence_number = sequence_number_;
+    return Status::OK();
+  }
+  TF_RETURN_IF_ERROR(writer_->Close());
+  TF_RETURN_IF_ERROR(file_->Close());
+  writer_.reset();
+  TF_RETURN_IF_ERROR(OpenFile(sequence_number_ + 1));
+  sequence_number = sequence_number_;
+  return Status::OK();
+}
+
 Status FileJournalWriter::Write(const Update& update) {
   TF_RETURN_IF_ERROR(EnsureInitialized());
   std::string s = update.SerializeAsString();
@@ -86,14 +108,17 @@ Status FileJournalWriter::Write(const Update& update) {
   return Status::OK();
 }
 
-FileJournalReader::FileJournalReader(Env* env, StringPiece journal_dir)
-    : env_(env), journal_dir_(journal_dir) {}
+FileJournalReader::FileJournalReader(Env* env, StringPiece journal_dir,
+                                     int64 start_sequence_number)
+    : env_(env),
+      journal_dir_(journal_dir),
+      sequence_number_(start_sequence_number) {}
 
 Status FileJournalReader::EnsureInitialized() {
   if (reader_) {
     return Status::OK();
   }
-  return UpdateFile(DataServiceJournalFile(journal_dir_, 0));
+  return UpdateFile(DataServiceJournalFile(journal_dir_, sequence_number_));
 }
 
 Status FileJournalReader::Read(Update& update, bool& end_of_journal) {
@@ -134,5 +159,37 @@ Status FileJournalReader::UpdateFile(const std::string& filename) {
   return Status::OK();
 }
 
+Status TruncateJournal(Env* env, const std::string& journal_dir,
+                       int64 sequence_number) {
+  std::vector<std::string> journal_files;
+  TF_RETURN_IF_ERROR(env->GetChildren(journal_dir, &journal_files));
+  for (const auto& file : journal_files) {
+    int64 file_sequence_number;
+    TF_RETURN_IF_ERROR(ParseSequenceNumber(file, &file_sequence_number));
+    if (file_sequence_number >= sequence_number) {
+      continue;
+    }
+    std::string path = io::JoinPath(journal_dir, file);
+    VLOG(1) << "Deleting journal file " << path;
+    TF_RETURN_IF_ERROR(env->DeleteFile(path));
+  }
+  return Status::OK();
+}
+
+Status WriteDispatcherStateSnapshot(Env* env, const std::string& path,
+                                    const DispatcherStateSnapshot& snapshot) {
+  // Write to a temporary file first so that a crash while writing never
+  // leaves a partial snapshot behind.
+  std::string tmp_path = absl::StrCat(path, kTmpSuffix);
+  TF_RETURN_IF_ERROR(WriteBinaryProto(env, tmp_path, snapshot));
+  return env->RenameFile(tmp_path, path);
+}
+
+Status ReadDispatcherStateSnapshot(Env* env, const std::string& path,
+                                   DispatcherStateSnapshot& snapshot) {
+  TF_RETURN_IF_ERROR(env->FileExists(path));
+  return ReadBinaryProto(env, path, &snapshot);
+}
+
 }  // namespace data
 }  // namespace tensorflow
@@ -36,6 +36,10 @@ class JournalWriter {
   virtual Status Write(const Update& update) = 0;
   // Initializes the writer if it is not yet initialized.
   virtual Status EnsureInitialized() = 0;
+  // Finishes the current journal file and directs subsequent writes to a new
+  // one. Stores the sequence number of the new file in `sequence_number`. All
+  // updates written before the call are in files with lower sequence numbers.
+  virtual Status Rotate(int64& sequence_number) = 0;
 };
 
 // FileJournalWriter is not thread-safe, requiring external synchronization when
@@ -53,7 +57,9 @@ class JournalWriter {
 // journal file name. For example, if the journal directory contains
 // "journal_0", "journal_1", and "journal_2", the writer will write to
 // "journal_3". The writer will flush updates as they are written, so that they
-// can be stored durably in case of machine failure.
+// can be stored durably in case of machine failure. `Rotate` moves the writer
+// on to the next journal file, so that the files preceding it can be dropped
+// once their updates are captured by a `DispatcherStateSnapshot`.
 class FileJournalWriter : public JournalWriter {
  public:
   // Creates a journal writer to write to the given journal directory.
@@ -65,10 +71,16 @@ class FileJournalWriter : public JournalWriter {
 
   Status Write(const Update& update) override;
   Status EnsureInitialized() override;
+  Status Rotate(int64& sequence_number) override;
 
  private:
+  // Opens the journal file with the given sequence number for writing.
+  Status OpenFile(int64 sequence_number);
+
   Env* env_;
   const std::string journal_dir_;
+  // Sequence number of the journal file currently being written.
+  int64 sequence_number_ = -1;
   std::unique_ptr<WritableFile> file_;
   std::unique_ptr<io::RecordWriter> writer_;
 };
@@ -86,10 +98,12 @@ class JournalReader {
 // used by multiple threads.
 //
 // The journal reader reads through all journal files in the configured journal
-// directory, in order of their sequence numbers. See FileJournalWriter above.
+// directory, in order of their sequence numbers, starting from
+// `start_sequence_number`. See FileJournalWriter above.
 class FileJournalReader : public JournalReader {
  public:
-  explicit FileJournalReader(Env* env, StringPiece journal_dir);
+  explicit FileJournalReader(Env* env, StringPiece journal_dir,
+                             int64 start_sequence_number = 0);
   FileJournalReader(const FileJournalReader&) = delete;
   FileJournalReader& operator=(const FileJournalReader&) = delete;
 
@@ -111,6 +125,20 @@ class FileJournalReader : public JournalReader {
   std::unique_ptr<io::RecordReader> reader_;
 };
 
+// Deletes all journal files in `journal_dir` with sequence numbers lower than
+// `sequence_number`.
+Status TruncateJournal(Env* env, const std::string& journal_dir,
+                       int64 sequence_number);
+
+// Atomically writes `snapshot` to `path`, replacing any previous snapshot.
+Status WriteDispatcherStateSnapshot(Env* env, const std::string& path,
+                                    const DispatcherStateSnapshot& snapshot);
+
+// Reads the snapshot at `path` into `snapshot`. Returns NOT_FOUND if no
+// snapshot has been written.
+Status ReadDispatcherStateSnapshot(Env* env, const std::string& path,
+                                   DispatcherStateSnapshot& snapshot);
+
 }  // namespace data
 }  // namespace tensorflow
 
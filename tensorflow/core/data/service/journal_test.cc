@@ -62,8 +62,9 @@ Update MakeRegisterDatasetUpdate() {
 }
 
 Status CheckJournalContent(StringPiece journal_dir,
-                           const std::vector<Update>& expected) {
-  FileJournalReader reader(Env::Default(), journal_dir);
+                           const std::vector<Update>& expected,
+                           int64 start_sequence_number = 0) {
+  FileJournalReader reader(Env::Default(), journal_dir, start_sequence_number);
   for (const auto& update : expected) {
     Update result;
     bool end_of_journal = true;
@@ -159,5 +160,69 @@ TEST(Journal, InvalidRecordData) {
   EXPECT_THAT(s.error_message(), HasSubstr("Failed to parse journal record"));
   EXPECT_EQ(s.code(), error::DATA_LOSS);
 }
+
+TEST(Journal, RotateAndTruncate) {
+  std::string journal_dir;
+  EXPECT_TRUE(NewJournalDir(journal_dir));
+  std::vector<Update> before = {MakeCreateJobUpdate(),
+                                MakeRegisterDatasetUpdate()};
+  std::vector<Update> after = {MakeFinishTaskUpdate()};
+  FileJournalWriter writer(Env::Default(), journal_dir);
+  for (const auto& update : before) {
+    TF_EXPECT_OK(writer.Write(update));
+  }
+  int64 sequence_number;
+  TF_ASSERT_OK(writer.Rotate(sequence_number));
+  EXPECT_EQ(sequence_number, 1);
+  for (const auto& update : after) {
+    TF_EXPECT_OK(writer.Write(update));
+  }
+  std::vector<Update> all = before;
+  all.insert(all.end(), after.begin(), after.end());
+  TF_EXPECT_OK(CheckJournalContent(journal_dir, all));
+  TF_EXPECT_OK(CheckJournalContent(journal_dir, after, sequence_number));
+
+  TF_ASSERT_OK(TruncateJournal(Env::Default(), journal_dir, sequence_number));
+  EXPECT_TRUE(errors::IsNotFound(Env::Default()->FileExists(
+      DataServiceJournalFile(journal_dir, /*sequence_number=*/0))));
+  TF_EXPECT_OK(CheckJournalContent(journal_dir, after, sequence_number));
+}
+
+TEST(Journal, RotateBeforeWrite) {
+  std::string journal_dir;
+  EXPECT_TRUE(NewJournalDir(journal_dir));
+  {
+    FileJournalWriter writer(Env::Default(), journal_dir);
+    TF_EXPECT_OK(writer.Write(MakeCreateJobUpdate()));
+  }
+  FileJournalWriter writer(Env::Default(), journal_dir);
+  int64 sequence_number;
+  TF_ASSERT_OK(writer.Rotate(sequence_number));
+  EXPECT_EQ(sequence_number, 1);
+  TF_EXPECT_OK(writer.Write(MakeFinishTaskUpdate()));
+  TF_EXPECT_OK(CheckJournalContent(journal_dir, {MakeFinishTaskUpdate()},
+                                   sequence_number));
+}
+
+TEST(Journal, SnapshotRoundTrip) {
+  std::string journal_dir;
+  EXPECT_TRUE(NewJournalDir(journal_dir));
+  TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(journal_dir));
+  std::string path = io::JoinPath(journal_dir, "snapshot");
+  DispatcherStateSnapshot snapshot;
+  Status s = ReadDispatcherStateSnapshot(Env::Default(), path, snapshot);
+  EXPECT_TRUE(errors::IsNotFound(s));
+
+  snapshot.set_journal_sequence_number(5);
+  snapshot.set_next_available_job_id(7);
+  *snapshot.add_datasets() = MakeRegisterDatasetUpdate().register_dataset();
+  TF_ASSERT_OK(WriteDispatcherStateSnapshot(Env::Default(), path, snapshot));
+  snapshot.set_journal_sequence_number(6);
+  TF_ASSERT_OK(WriteDispatcherStateSnapshot(Env::Default(), path, snapshot));
+
+  DispatcherStateSnapshot result;
+  TF_ASSERT_OK(ReadDispatcherStateSnapshot(Env::Default(), path, result));
+  EXPECT_EQ(result.SerializeAsString(), snapshot.SerializeAsString());
+}
 }  // namespace data
 }  // namespace tensorflow
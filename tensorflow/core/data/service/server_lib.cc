@@ -120,7 +120,12 @@ WorkerGrpcDataServer::WorkerGrpcDataServer(
     : GrpcDataServerBase(config.port(), config.protocol(), "WorkerServer"),
       config_(config) {}
 
-WorkerGrpcDataServer::~WorkerGrpcDataServer() { delete service_; }
+WorkerGrpcDataServer::~WorkerGrpcDataServer() {
+  if (!transfer_address_.empty()) {
+    LocalWorkers::Remove(transfer_address_);
+  }
+  delete service_;
+}
 
 void WorkerGrpcDataServer::AddDataServiceToBuilder(
     ::grpc::ServerBuilder& builder) {
@@ -149,10 +154,20 @@ Status WorkerGrpcDataServer::StartServiceInternal() {
                                 /*replace_all=*/false);
   }
   TF_RETURN_IF_ERROR(service_->Start(worker_address, transfer_address));
+  // Allow clients in this process to read from the worker without going
+  // through gRPC. Clients look the worker up by the address of the tasks they
+  // read from, which is the transfer address.
+  LocalWorkers::Add(transfer_address, service_->get_element_getter());
+  transfer_address_ = transfer_address;
   return Status::OK();
 }
 
-void WorkerGrpcDataServer::StopServiceInternal() { service_->Stop(); }
+void WorkerGrpcDataServer::StopServiceInternal() {
+  if (!transfer_address_.empty()) {
+    LocalWorkers::Remove(transfer_address_);
+  }
+  service_->Stop();
+}
 
 Status WorkerGrpcDataServer::NumTasks(int* num_tasks) {
   GetWorkerTasksRequest req;
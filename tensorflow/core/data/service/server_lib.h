@@ -113,6 +113,9 @@ class WorkerGrpcDataServer : public GrpcDataServerBase {
   // Owned. We use a raw pointer because GrpcWorkerImpl is forward-declared.
   GrpcWorkerImpl* service_;
   std::shared_ptr<DataTransferServer> transfer_server_;
+  // The address that clients send data transfer requests to, under which the
+  // worker is registered in `LocalWorkers`. Empty until the worker is started.
+  std::string transfer_address_;
 };
 
 // Creates a dispatch tf.data server and stores it in `out_server`.
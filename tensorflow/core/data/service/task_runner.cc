@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/data/service/task_runner.h"
 
+#include <algorithm>
+
+#include "absl/memory/memory.h"
 #include "tensorflow/core/data/standalone.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/dataset.h"
@@ -47,6 +50,8 @@ int64 StandaloneTaskIterator::Cardinality() const {
   return dataset_->Get()->Cardinality();
 }
 
+void StandaloneTaskIterator::Cancel() { iterator_->Cancel(); }
+
 Status TaskRunner::Create(const experimental::WorkerConfig& worker_config,
                           const TaskDef& task_def,
                           CancellationManager& cancellation_manager,
@@ -72,27 +77,356 @@ Status TaskRunner::Create(const experimental::WorkerConfig& worker_config,
   return Status::OK();
 }
 
+constexpr int64 FirstComeFirstServedTaskRunner::kMaxBufferedElements;
+
 FirstComeFirstServedTaskRunner::FirstComeFirstServedTaskRunner(
     std::unique_ptr<TaskIterator> iterator)
-    : iterator_(std::move(iterator)) {}
+    : iterator_(std::move(iterator)) {
+  prefetch_thread_ = absl::WrapUnique(Env::Default()->StartThread(
+      {}, "fcfs-prefetch", [this] { RunPrefetchThread(); }));
+}
 
-Status FirstComeFirstServedTaskRunner::GetNext(const GetElementRequest& req,
-                                               GetElementResult& result) {
-  std::vector<Tensor> element;
-  bool end_of_task;
-  result.skip = false;
+FirstComeFirstServedTaskRunner::~FirstComeFirstServedTaskRunner() {
   {
     mutex_lock l(mu_);
-    TF_RETURN_IF_ERROR(iterator_->GetNext(element, end_of_task));
-    result.end_of_sequence = end_of_task;
+    cancelled_ = true;
+    cv_.notify_all();
+  }
+  // The prefetch thread, which is joined when `prefetch_thread_` is
+  // destroyed, may be waiting for other readers of a shared iterator.
+  iterator_->Cancel();
+}
+
+void FirstComeFirstServedTaskRunner::RunPrefetchThread() {
+  while (true) {
+    {
+      mutex_lock l(mu_);
+      while (!cancelled_ && buffer_.size() >= kMaxBufferedElements) {
+        cv_.wait(l);
+      }
+      if (cancelled_) {
+        return;
+      }
+    }
+    GetElementResult result;
+    result.skip = false;
+    Status s = iterator_->GetNext(result.components, result.end_of_sequence);
+    mutex_lock l(mu_);
+    cv_.notify_all();
+    if (!s.ok()) {
+      status_ = s;
+      return;
+    }
     result.element_index = element_index_++;
+    const bool end_of_sequence = result.end_of_sequence;
+    buffer_.push_back(std::move(result));
+    if (end_of_sequence) {
+      return;
+    }
+  }
+}
+
+void FirstComeFirstServedTaskRunner::TakeElement(GetElementResult& result)
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  if (buffer_.front().end_of_sequence) {
+    result = buffer_.front();
+    return;
+  }
+  result = std::move(buffer_.front());
+  buffer_.pop_front();
+  cv_.notify_all();
+}
+
+Status FirstComeFirstServedTaskRunner::GetNext(const GetElementRequest& req,
+                                               GetElementResult& result) {
+  mutex_lock l(mu_);
+  while (!cancelled_ && buffer_.empty() && status_.ok()) {
+    cv_.wait(l);
+  }
+  if (!buffer_.empty()) {
+    TakeElement(result);
+    return Status::OK();
   }
-  if (!end_of_task) {
-    result.components = std::move(element);
+  TF_RETURN_IF_ERROR(status_);
+  return errors::Cancelled("Task runner is shutting down.");
+}
+
+Status FirstComeFirstServedTaskRunner::TryGetNext(const GetElementRequest& req,
+                                                  GetElementResult& result,
+                                                  bool& ready) {
+  mutex_lock l(mu_);
+  ready = !buffer_.empty();
+  if (ready) {
+    TakeElement(result);
   }
   return Status::OK();
 }
 
+int64 FirstComeFirstServedTaskRunner::NumBufferedElements() {
+  mutex_lock l(mu_);
+  if (!buffer_.empty() && buffer_.back().end_of_sequence) {
+    return buffer_.size() - 1;
+  }
+  return buffer_.size();
+}
+
+SharedElementProducer::SharedElementProducer(
+    std::unique_ptr<TaskIterator> iterator,
+    std::function<Status(std::unique_ptr<TaskIterator>&)> make_private_iterator,
+    int64 window_size, int64 lag_timeout_us,
+    CancellationManager& cancellation_manager)
+    : iterator_(std::move(iterator)),
+      make_private_iterator_(std::move(make_private_iterator)),
+      window_size_(window_size),
+      lag_timeout_us_(lag_timeout_us) {
+  VLOG(1) << "Creating shared element producer with window size "
+          << window_size;
+  Status s = RegisterCancellationCallback(
+      &cancellation_manager,
+      [&] {
+        mutex_lock l(mu_);
+        cancelled_ = true;
+        cv_.notify_all();
+      },
+      &deregister_cancel_callback_);
+  if (!s.ok()) {
+    mutex_lock l(mu_);
+    cancelled_ = true;
+  }
+}
+
+SharedElementProducer::~SharedElementProducer() {
+  if (deregister_cancel_callback_) deregister_cancel_callback_();
+}
+
+std::unique_ptr<TaskIterator> SharedElementProducer::AddReader() {
+  mutex_lock l(mu_);
+  if (buffer_start_ > 0 && Cardinality() != kInfiniteCardinality) {
+    return nullptr;
+  }
+  int64 reader_id = next_reader_id_++;
+  positions_[reader_id] = buffer_start_;
+  VLOG(1) << "Added reader " << reader_id
+          << " to shared element producer, starting at element "
+          << buffer_start_;
+  return absl::make_unique<SharedTaskIterator>(shared_from_this(), reader_id);
+}
+
+void SharedElementProducer::CancelReader(int64 reader_id) {
+  mutex_lock l(mu_);
+  cancelled_readers_.insert(reader_id);
+  cv_.notify_all();
+}
+
+void SharedElementProducer::RemoveReader(int64 reader_id) {
+  mutex_lock l(mu_);
+  positions_.erase(reader_id);
+  detached_readers_.erase(reader_id);
+  cancelled_readers_.erase(reader_id);
+  DropConsumedElements();
+  cv_.notify_all();
+}
+
+void SharedElementProducer::DropConsumedElements()
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  if (positions_.empty()) {
+    return;
+  }
+  int64 min_position = kint64max;
+  for (const auto& it : positions_) {
+    min_position = std::min(min_position, it.second);
+  }
+  while (buffer_start_ < min_position && !buffer_.empty()) {
+    buffer_.pop_front();
+    buffer_start_++;
+  }
+}
+
+void SharedElementProducer::DetachLaggingReaders()
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  const int64 window_end = buffer_start_ + buffer_.size();
+  for (auto it = positions_.begin(); it != positions_.end();) {
+    if (it->second != buffer_start_) {
+      ++it;
+      continue;
+    }
+    if (Cardinality() == kInfiniteCardinality) {
+      LOG(WARNING) << "Reader " << it->first << " did not read from the "
+                   << "shared element producer for " << lag_timeout_us_
+                   << "us. Skipping " << window_end - it->second
+                   << " elements for it so that other readers can proceed.";
+      it->second = window_end;
+      ++it;
+    } else {
+      LOG(WARNING) << "Reader " << it->first << " did not read from the "
+                   << "shared element producer for " << lag_timeout_us_
+                   << "us. Detaching it so that other readers can proceed. "
+                   << "It continues with a private iterator.";
+      detached_readers_[it->first] = it->second;
+      positions_.erase(it++);
+    }
+  }
+  DropConsumedElements();
+  cv_.notify_all();
+}
+
+Status SharedElementProducer::GetNext(int64 reader_id,
+                                      std::vector<Tensor>& element,
+                                      bool& end_of_sequence,
+                                      int64& detached_position) {
+  detached_position = -1;
+  // Where the window started when this reader started waiting for the slowest
+  // readers, and when it did.
+  int64 blocked_buffer_start = -1;
+  int64 blocked_since_us = 0;
+  while (true) {
+    {
+      mutex_lock l(mu_);
+      while (true) {
+        auto detached_it = detached_readers_.find(reader_id);
+        if (detached_it != detached_readers_.end()) {
+          detached_position = detached_it->second;
+          detached_readers_.erase(detached_it);
+          return Status::OK();
+        }
+        auto it = positions_.find(reader_id);
+        if (it == positions_.end()) {
+          return errors::Internal("Reader ", reader_id,
+                                  " is not registered with the shared "
+                                  "element producer.");
+        }
+        int64& position = it->second;
+        if (position < buffer_start_ + static_cast<int64>(buffer_.size())) {
+          element = buffer_[position - buffer_start_];
+          end_of_sequence = false;
+          position++;
+          DropConsumedElements();
+          cv_.notify_all();
+          return Status::OK();
+        }
+        if (end_of_sequence_) {
+          end_of_sequence = true;
+          return Status::OK();
+        }
+        TF_RETURN_IF_ERROR(status_);
+        if (cancelled_) {
+          return errors::Cancelled("Worker is shutting down.");
+        }
+        if (cancelled_readers_.contains(reader_id)) {
+          return errors::Cancelled("Reader ", reader_id,
+                                   " of the shared element producer was "
+                                   "cancelled.");
+        }
+        if (!producing_ &&
+            static_cast<int64>(buffer_.size()) < window_size_) {
+          producing_ = true;
+          break;
+        }
+        if (producing_) {
+          cv_.wait(l);
+          continue;
+        }
+        // The window is full, so this reader waits for the slowest readers.
+        const int64 now_us = Env::Default()->NowMicros();
+        if (blocked_buffer_start != buffer_start_) {
+          blocked_buffer_start = buffer_start_;
+          blocked_since_us = now_us;
+        }
+        const int64 remaining_us = blocked_since_us + lag_timeout_us_ - now_us;
+        if (remaining_us <= 0) {
+          DetachLaggingReaders();
+          continue;
+        }
+        cv_.wait_for(l, std::chrono::microseconds(remaining_us));
+      }
+    }
+    // Produce the next element without holding `mu_`, so that other readers
+    // can keep consuming buffered elements in the meantime.
+    std::vector<Tensor> produced;
+    bool end_of_produced;
+    Status s = iterator_->GetNext(produced, end_of_produced);
+    mutex_lock l(mu_);
+    producing_ = false;
+    cv_.notify_all();
+    if (!s.ok()) {
+      status_ = s;
+      return s;
+    }
+    if (end_of_produced) {
+      end_of_sequence_ = true;
+    } else {
+      buffer_.push_back(std::move(produced));
+    }
+  }
+}
+
+Status SharedElementProducer::MakePrivateIterator(
+    int64 position, std::unique_ptr<TaskIterator>& out) {
+  VLOG(1) << "Creating a private iterator starting at element " << position;
+  std::unique_ptr<TaskIterator> iterator;
+  TF_RETURN_IF_ERROR(make_private_iterator_(iterator));
+  for (int64 i = 0; i < position; ++i) {
+    std::vector<Tensor> element;
+    bool end_of_sequence;
+    TF_RETURN_IF_ERROR(iterator->GetNext(element, end_of_sequence));
+    if (end_of_sequence) {
+      break;
+    }
+  }
+  out = std::move(iterator);
+  return Status::OK();
+}
+
+SharedTaskIterator::SharedTaskIterator(
+    std::shared_ptr<SharedElementProducer> producer, int64 reader_id)
+    : producer_(std::move(producer)), reader_id_(reader_id) {}
+
+SharedTaskIterator::~SharedTaskIterator() {
+  producer_->RemoveReader(reader_id_);
+}
+
+Status SharedTaskIterator::GetNext(std::vector<Tensor>& element,
+                                   bool& end_of_sequence) {
+  TaskIterator* private_iterator;
+  {
+    mutex_lock l(mu_);
+    private_iterator = private_iterator_.get();
+  }
+  if (private_iterator == nullptr) {
+    int64 detached_position;
+    TF_RETURN_IF_ERROR(producer_->GetNext(reader_id_, element, end_of_sequence,
+                                          detached_position));
+    if (detached_position < 0) {
+      return Status::OK();
+    }
+    std::unique_ptr<TaskIterator> iterator;
+    TF_RETURN_IF_ERROR(
+        producer_->MakePrivateIterator(detached_position, iterator));
+    mutex_lock l(mu_);
+    if (cancelled_) {
+      return errors::Cancelled("Reader ", reader_id_,
+                               " of the shared element producer was "
+                               "cancelled.");
+    }
+    private_iterator_ = std::move(iterator);
+    private_iterator = private_iterator_.get();
+  }
+  return private_iterator->GetNext(element, end_of_sequence);
+}
+
+int64 SharedTaskIterator::Cardinality() const {
+  return producer_->Cardinality();
+}
+
+void SharedTaskIterator::Cancel() {
+  producer_->CancelReader(reader_id_);
+  mutex_lock l(mu_);
+  cancelled_ = true;
+  if (private_iterator_) {
+    private_iterator_->Cancel();
+  }
+}
+
 RoundRobinTaskRunner::RoundRobinTaskRunner(
     std::unique_ptr<TaskIterator> iterator, int64 num_consumers,
     string worker_address, CancellationManager& cancellation_manager)
@@ -121,6 +455,10 @@ RoundRobinTaskRunner::~RoundRobinTaskRunner() {
   if (deregister_cancel_callback_) deregister_cancel_callback_();
 }
 
+int64 RoundRobinTaskRunner::NumBufferedElements() {
+  return prefetch_thread_.NumBufferedElements();
+}
+
 Status RoundRobinTaskRunner::ValidateRequest(const GetElementRequest& req) {
   if (req.consumer_index() < 0 || req.round_index() < 0) {
     return errors::FailedPrecondition(
@@ -310,5 +648,10 @@ Status PrefetchThread::GetStatus() {
   mutex_lock l(mu_);
   return status_;
 }
+
+int64 PrefetchThread::NumBufferedElements() {
+  mutex_lock l(mu_);
+  return buffer_.size();
+}
 }  // namespace data
 }  // namespace tensorflow
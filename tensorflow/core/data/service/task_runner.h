@@ -15,6 +15,13 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DATA_SERVICE_TASK_RUNNER_H_
 #define TENSORFLOW_CORE_DATA_SERVICE_TASK_RUNNER_H_
 
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/data/service/common.pb.h"
 #include "tensorflow/core/data/service/data_transfer.h"
 #include "tensorflow/core/data/service/worker.pb.h"
@@ -37,6 +44,10 @@ class TaskIterator {
                          bool& end_of_sequence) = 0;
   // Reports the cardinality of the dataset that created this iterator.
   virtual int64 Cardinality() const = 0;
+  // Makes ongoing and future `GetNext` calls return early with `Cancelled`
+  // where they would otherwise wait for input or for other iterators. May be
+  // called concurrently with `GetNext`.
+  virtual void Cancel() {}
 };
 
 // Implementation of TaskIterator wrapping a standalone iterator.
@@ -49,6 +60,7 @@ class StandaloneTaskIterator : public TaskIterator {
                          std::unique_ptr<standalone::Iterator> iterator);
   Status GetNext(std::vector<Tensor>& element, bool& end_of_sequence) override;
   int64 Cardinality() const override;
+  void Cancel() override;
 
  private:
   std::unique_ptr<standalone::Dataset> dataset_;
@@ -68,21 +80,170 @@ class TaskRunner {
   // Gets the next element for the given request.
   virtual Status GetNext(const GetElementRequest& req,
                          GetElementResult& result) = 0;
+  // Gets the next element for the given request if it has already been
+  // produced, without waiting for the input. Otherwise, sets `ready` to false.
+  // Runners which produce elements on demand never have elements ready.
+  virtual Status TryGetNext(const GetElementRequest& req,
+                            GetElementResult& result, bool& ready) {
+    ready = false;
+    return Status::OK();
+  }
+  // Returns the number of elements the runner has produced ahead of consumer
+  // requests. Runners which produce elements on demand return 0.
+  virtual int64 NumBufferedElements() { return 0; }
 };
 
 // A task runner which provides elements on a first-come first-served basis.
-// It does not consider which consumer is making the request.
+// It does not consider which consumer is making the request. A background
+// thread produces up to `kMaxBufferedElements` elements ahead of requests.
 class FirstComeFirstServedTaskRunner : public TaskRunner {
  public:
+  static constexpr int64 kMaxBufferedElements = 8;
+
   explicit FirstComeFirstServedTaskRunner(
       std::unique_ptr<TaskIterator> iterator);
+  ~FirstComeFirstServedTaskRunner() override;
+
   Status GetNext(const GetElementRequest& req,
                  GetElementResult& result) override;
+  Status TryGetNext(const GetElementRequest& req, GetElementResult& result,
+                    bool& ready) override;
+  int64 NumBufferedElements() override;
 
  private:
+  // Produces elements into `buffer_` until the end of the input is reached,
+  // the input fails, or the runner is destroyed.
+  void RunPrefetchThread();
+  // Moves the first element of `buffer_` to `result`. The end of sequence is
+  // kept in `buffer_`, so that it is returned to all subsequent requests.
+  void TakeElement(GetElementResult& result) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Only accessed by the prefetch thread, except for `Cancel()`.
+  const std::unique_ptr<TaskIterator> iterator_;
+
   mutex mu_;
-  std::unique_ptr<TaskIterator> iterator_ TF_GUARDED_BY(mu_);
+  // Notified when elements are produced or consumed, when the input fails,
+  // and on destruction.
+  condition_variable cv_;
+  bool cancelled_ TF_GUARDED_BY(mu_) = false;
+  // The status of the input. Reported once `buffer_` has been drained.
+  Status status_ TF_GUARDED_BY(mu_);
+  // Elements produced ahead of requests.
+  std::deque<GetElementResult> buffer_ TF_GUARDED_BY(mu_);
   int64 element_index_ TF_GUARDED_BY(mu_) = 0;
+  std::unique_ptr<Thread> prefetch_thread_;
+};
+
+// Produces the elements of a single iterator for the tasks of several jobs
+// which read the same dataset, so that the dataset is only processed once.
+// Produced elements are kept in a sliding window until all readers have
+// consumed them. A reader which gets `window_size` elements ahead of the
+// slowest reader blocks until the slowest reader catches up.
+//
+// If the slowest readers make no progress for `lag_timeout_us` while another
+// reader is blocked, they are detached so that they can't hold back the other
+// jobs forever. For infinite datasets, a detached reader skips the buffered
+// elements and continues from the end of the window, like a reader joining
+// late. For finite datasets, skipping elements would lose part of the epoch,
+// so a detached reader instead continues with a private iterator created by
+// `make_private_iterator`, advanced past the elements the reader has consumed.
+// This assumes that the dataset produces its elements in a deterministic
+// order.
+class SharedElementProducer
+    : public std::enable_shared_from_this<SharedElementProducer> {
+ public:
+  SharedElementProducer(
+      std::unique_ptr<TaskIterator> iterator,
+      std::function<Status(std::unique_ptr<TaskIterator>&)>
+          make_private_iterator,
+      int64 window_size, int64 lag_timeout_us,
+      CancellationManager& cancellation_manager);
+  ~SharedElementProducer();
+
+  // Adds a reader which will see the elements produced from now on, or
+  // returns `nullptr` if the reader can't join. Readers can't join once
+  // elements of a finite dataset have been dropped from the window, since the
+  // reader would miss part of the epoch.
+  std::unique_ptr<TaskIterator> AddReader();
+
+  // Reports the cardinality of the dataset that created the shared iterator.
+  int64 Cardinality() const { return iterator_->Cardinality(); }
+
+ private:
+  friend class SharedTaskIterator;
+
+  // Gets the next element for `reader_id`, producing it if no other reader
+  // has done so yet. If the reader has been detached from a finite dataset,
+  // sets `detached_position` to the index of the next element it should read,
+  // and leaves `element` and `end_of_sequence` unset. Otherwise sets
+  // `detached_position` to -1.
+  Status GetNext(int64 reader_id, std::vector<Tensor>& element,
+                 bool& end_of_sequence, int64& detached_position);
+  // Creates a private iterator for a detached reader, which produces the
+  // elements from index `position` on.
+  Status MakePrivateIterator(int64 position,
+                             std::unique_ptr<TaskIterator>& out);
+  // Wakes up `reader_id` if it is waiting for other readers, and makes its
+  // subsequent `GetNext` calls fail with `Cancelled`.
+  void CancelReader(int64 reader_id);
+  void RemoveReader(int64 reader_id);
+  // Drops elements which all readers have consumed.
+  void DropConsumedElements() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Detaches the readers which haven't consumed the first buffered element.
+  void DetachLaggingReaders() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Only accessed by the reader which set `producing_`.
+  const std::unique_ptr<TaskIterator> iterator_;
+  const std::function<Status(std::unique_ptr<TaskIterator>&)>
+      make_private_iterator_;
+  const int64 window_size_;
+  const int64 lag_timeout_us_;
+
+  mutex mu_;
+  // Notified when elements are produced or dropped, and on cancellation.
+  condition_variable cv_;
+  bool cancelled_ TF_GUARDED_BY(mu_) = false;
+  // Whether a reader is currently producing the next element.
+  bool producing_ TF_GUARDED_BY(mu_) = false;
+  bool end_of_sequence_ TF_GUARDED_BY(mu_) = false;
+  // The status of the shared iterator. Errors are reported to all readers.
+  Status status_ TF_GUARDED_BY(mu_);
+  // Produced elements which some reader hasn't consumed yet.
+  std::deque<std::vector<Tensor>> buffer_ TF_GUARDED_BY(mu_);
+  // The index of `buffer_.front()` among all produced elements.
+  int64 buffer_start_ TF_GUARDED_BY(mu_) = 0;
+  int64 next_reader_id_ TF_GUARDED_BY(mu_) = 0;
+  // The index of the next element to read, keyed by reader id.
+  absl::flat_hash_map<int64, int64> positions_ TF_GUARDED_BY(mu_);
+  // The index of the next element to read for the readers of a finite dataset
+  // which have been detached for lagging behind, keyed by reader id.
+  absl::flat_hash_map<int64, int64> detached_readers_ TF_GUARDED_BY(mu_);
+  // Readers which have been cancelled.
+  absl::flat_hash_set<int64> cancelled_readers_ TF_GUARDED_BY(mu_);
+  std::function<void()> deregister_cancel_callback_;
+};
+
+// A task iterator which reads from a `SharedElementProducer`, or from a
+// private iterator once it has been detached from the producer.
+class SharedTaskIterator : public TaskIterator {
+ public:
+  SharedTaskIterator(std::shared_ptr<SharedElementProducer> producer,
+                     int64 reader_id);
+  ~SharedTaskIterator() override;
+
+  Status GetNext(std::vector<Tensor>& element, bool& end_of_sequence) override;
+  int64 Cardinality() const override;
+  void Cancel() override;
+
+ private:
+  const std::shared_ptr<SharedElementProducer> producer_;
+  const int64 reader_id_;
+
+  mutex mu_;
+  bool cancelled_ TF_GUARDED_BY(mu_) = false;
+  // Set once the reader has been detached from `producer_`. Only reset on
+  // destruction.
+  std::unique_ptr<TaskIterator> private_iterator_ TF_GUARDED_BY(mu_);
 };
 
 // An element produced by a task.
@@ -111,6 +272,8 @@ class PrefetchThread {
   Status FillBuffer(int64 wait_us, std::vector<std::unique_ptr<Element>>& out);
   // Returns the status for any failures encountered by the prefetch thread.
   Status GetStatus();
+  // Returns the number of elements buffered for the next round.
+  int64 NumBufferedElements();
 
  private:
   const std::unique_ptr<TaskIterator> iterator_;
@@ -156,6 +319,9 @@ class RoundRobinTaskRunner : public TaskRunner {
 
   Status GetNext(const GetElementRequest& req,
                  GetElementResult& result) override;
+  // Only counts the elements prefetched for the next round, since `mu_` may
+  // be held while waiting for the current round to fill up.
+  int64 NumBufferedElements() override;
 
  private:
   // Prepares a full round of data. `wait_us` indicates how long to wait before
@@ -12,6 +12,9 @@ limitations under the License.
 
 #include "tensorflow/core/data/service/task_runner.h"
 
+#include <memory>
+#include <vector>
+
 #include "absl/memory/memory.h"
 #include "tensorflow/core/data/dataset.pb.h"
 #include "tensorflow/core/data/service/worker.pb.h"
@@ -26,6 +29,9 @@ namespace tensorflow {
 namespace data {
 namespace {
 
+// Long enough for shared element producer readers to never be detached.
+constexpr int64 kLagTimeoutUs = 60 * 1000 * 1000;
+
 class TestTaskIterator : public TaskIterator {
  public:
   explicit TestTaskIterator(const std::vector<std::vector<Tensor>>& elements)
@@ -47,6 +53,66 @@ class TestTaskIterator : public TaskIterator {
   int64 index_;
 };
 
+// Task iterator producing the elements 0, 1, ..., `num_elements` - 1. Counts
+// its `GetNext` calls in `num_calls`, unless it is null.
+class RangeTaskIterator : public TaskIterator {
+ public:
+  explicit RangeTaskIterator(int64 num_elements, int64* num_calls)
+      : num_elements_(num_elements), num_calls_(num_calls) {}
+
+  Status GetNext(std::vector<Tensor>& element, bool& end_of_sequence) override {
+    if (num_calls_ != nullptr) {
+      ++*num_calls_;
+    }
+    end_of_sequence = next_ >= num_elements_;
+    if (!end_of_sequence) {
+      element = {Tensor(next_++)};
+    }
+    return Status::OK();
+  }
+
+  int64 Cardinality() const override { return num_elements_; }
+
+ private:
+  const int64 num_elements_;
+  int64* const num_calls_;
+  int64 next_ = 0;
+};
+
+// Returns a factory of private iterators for the readers of a shared element
+// producer over `RangeTaskIterator(num_elements)`.
+std::function<Status(std::unique_ptr<TaskIterator>&)> RangeIteratorFactory(
+    int64 num_elements) {
+  return [num_elements](std::unique_ptr<TaskIterator>& out) {
+    out = absl::make_unique<RangeTaskIterator>(num_elements,
+                                               /*num_calls=*/nullptr);
+    return Status::OK();
+  };
+}
+
+// Returns a factory of private iterators for the readers of a shared element
+// producer over `TestTaskIterator(elements)`.
+std::function<Status(std::unique_ptr<TaskIterator>&)> TestIteratorFactory(
+    const std::vector<std::vector<Tensor>>& elements) {
+  return [elements](std::unique_ptr<TaskIterator>& out) {
+    out = absl::make_unique<TestTaskIterator>(elements);
+    return Status::OK();
+  };
+}
+
+// Reads all elements from `iterator`, storing them in `output`.
+Status ReadAll(TaskIterator& iterator, std::vector<int64>& output) {
+  while (true) {
+    std::vector<Tensor> element;
+    bool end_of_sequence;
+    TF_RETURN_IF_ERROR(iterator.GetNext(element, end_of_sequence));
+    if (end_of_sequence) {
+      return Status::OK();
+    }
+    output.push_back(element[0].flat<int64>()(0));
+  }
+}
+
 // Reads from the task runner, storing results in `*output`.
 Status RunConsumer(int64 consumer_index, int64 start_index, int64 end_index,
                    TaskRunner& task_runner, std::vector<int64>& output) {
@@ -87,6 +153,282 @@ TEST(FirstComeFirstServedTaskRunner, GetNext) {
   }
 }
 
+TEST(FirstComeFirstServedTaskRunner, TryGetNext) {
+  const int64 num_elements = 3;
+  int64 num_calls = 0;
+  FirstComeFirstServedTaskRunner runner(
+      absl::make_unique<RangeTaskIterator>(num_elements, &num_calls));
+  // The prefetch thread produces all elements and the end of sequence in the
+  // background, which is not counted as a buffered element.
+  for (int i = 0; i < 1000 && runner.NumBufferedElements() < num_elements;
+       ++i) {
+    Env::Default()->SleepForMicroseconds(1000);
+  }
+  EXPECT_EQ(runner.NumBufferedElements(), num_elements);
+
+  GetElementRequest request;
+  for (int64 i = 0; i < num_elements; ++i) {
+    GetElementResult result;
+    bool ready;
+    TF_ASSERT_OK(runner.TryGetNext(request, result, ready));
+    ASSERT_TRUE(ready);
+    ASSERT_FALSE(result.end_of_sequence);
+    EXPECT_EQ(result.element_index, i);
+    test::ExpectEqual(result.components[0], Tensor(i));
+  }
+  EXPECT_EQ(runner.NumBufferedElements(), 0);
+  // The end of sequence is returned to every subsequent request.
+  for (int i = 0; i < 2; ++i) {
+    GetElementResult result;
+    TF_ASSERT_OK(runner.GetNext(request, result));
+    EXPECT_TRUE(result.end_of_sequence);
+  }
+}
+
+TEST(FirstComeFirstServedTaskRunner, BoundedBuffer) {
+  const int64 max_buffered =
+      FirstComeFirstServedTaskRunner::kMaxBufferedElements;
+  std::vector<std::vector<Tensor>> elements;
+  for (int64 i = 0; i < 2 * max_buffered; ++i) {
+    elements.push_back({Tensor(i)});
+  }
+  FirstComeFirstServedTaskRunner runner(
+      absl::make_unique<TestTaskIterator>(elements));
+  for (int i = 0; i < 1000 && runner.NumBufferedElements() < max_buffered;
+       ++i) {
+    Env::Default()->SleepForMicroseconds(1000);
+  }
+  // Give the prefetch thread a chance to exceed the bound.
+  Env::Default()->SleepForMicroseconds(10 * 1000);
+  EXPECT_EQ(runner.NumBufferedElements(), max_buffered);
+}
+
+TEST(SharedElementProducer, ReadersShareElements) {
+  const int64 num_elements = 10;
+  int64 num_calls = 0;
+  CancellationManager cancellation_manager;
+  auto producer = std::make_shared<SharedElementProducer>(
+      absl::make_unique<RangeTaskIterator>(num_elements, &num_calls),
+      RangeIteratorFactory(num_elements),
+      /*window_size=*/2, /*lag_timeout_us=*/kLagTimeoutUs,
+      cancellation_manager);
+  std::unique_ptr<TaskIterator> reader1 = producer->AddReader();
+  std::unique_ptr<TaskIterator> reader2 = producer->AddReader();
+  ASSERT_NE(reader1, nullptr);
+  ASSERT_NE(reader2, nullptr);
+  EXPECT_EQ(reader1->Cardinality(), num_elements);
+  for (int64 i = 0; i < num_elements; ++i) {
+    for (TaskIterator* reader : {reader1.get(), reader2.get()}) {
+      std::vector<Tensor> element;
+      bool end_of_sequence;
+      TF_ASSERT_OK(reader->GetNext(element, end_of_sequence));
+      ASSERT_FALSE(end_of_sequence);
+      test::ExpectEqual(element[0], Tensor(i));
+    }
+  }
+  for (TaskIterator* reader : {reader1.get(), reader2.get()}) {
+    std::vector<Tensor> element;
+    bool end_of_sequence;
+    TF_ASSERT_OK(reader->GetNext(element, end_of_sequence));
+    EXPECT_TRUE(end_of_sequence);
+  }
+  // Each element is only produced once.
+  EXPECT_EQ(num_calls, num_elements + 1);
+}
+
+TEST(SharedElementProducer, ConsumeParallel) {
+  const int64 num_elements = 1000;
+  const int64 num_readers = 5;
+  int64 num_calls = 0;
+  CancellationManager cancellation_manager;
+  auto producer = std::make_shared<SharedElementProducer>(
+      absl::make_unique<RangeTaskIterator>(num_elements, &num_calls),
+      RangeIteratorFactory(num_elements),
+      /*window_size=*/3, /*lag_timeout_us=*/kLagTimeoutUs,
+      cancellation_manager);
+  std::vector<std::unique_ptr<TaskIterator>> readers;
+  for (int i = 0; i < num_readers; ++i) {
+    readers.push_back(producer->AddReader());
+    ASSERT_NE(readers.back(), nullptr);
+  }
+  std::vector<std::vector<int64>> per_reader_results(num_readers);
+  std::vector<Status> statuses(num_readers);
+  {
+    std::vector<std::unique_ptr<Thread>> threads;
+    for (int i = 0; i < num_readers; ++i) {
+      threads.push_back(absl::WrapUnique(Env::Default()->StartThread(
+          {}, absl::StrCat("reader_", i), [&, i] {
+            statuses[i] = ReadAll(*readers[i], per_reader_results[i]);
+          })));
+    }
+  }
+  std::vector<int64> expected;
+  for (int64 i = 0; i < num_elements; ++i) {
+    expected.push_back(i);
+  }
+  for (int i = 0; i < num_readers; ++i) {
+    TF_ASSERT_OK(statuses[i]);
+    EXPECT_EQ(per_reader_results[i], expected);
+  }
+  EXPECT_EQ(num_calls, num_elements + 1);
+}
+
+TEST(SharedElementProducer, LateReaderOfFiniteDataset) {
+  int64 num_calls = 0;
+  CancellationManager cancellation_manager;
+  auto producer = std::make_shared<SharedElementProducer>(
+      absl::make_unique<RangeTaskIterator>(/*num_elements=*/10, &num_calls),
+      RangeIteratorFactory(10),
+      /*window_size=*/2, /*lag_timeout_us=*/kLagTimeoutUs,
+      cancellation_manager);
+  std::unique_ptr<TaskIterator> reader = producer->AddReader();
+  std::vector<Tensor> element;
+  bool end_of_sequence;
+  TF_ASSERT_OK(reader->GetNext(element, end_of_sequence));
+  // The first element is no longer buffered, so a new reader would miss it.
+  EXPECT_EQ(producer->AddReader(), nullptr);
+}
+
+TEST(SharedElementProducer, LateReaderOfInfiniteDataset) {
+  std::vector<std::vector<Tensor>> elements;
+  for (int64 i = 0; i < 10; ++i) {
+    elements.push_back({Tensor(i)});
+  }
+  CancellationManager cancellation_manager;
+  auto producer = std::make_shared<SharedElementProducer>(
+      absl::make_unique<TestTaskIterator>(elements),
+      TestIteratorFactory(elements), /*window_size=*/2,
+      /*lag_timeout_us=*/kLagTimeoutUs, cancellation_manager);
+  std::unique_ptr<TaskIterator> reader1 = producer->AddReader();
+  std::vector<Tensor> element;
+  bool end_of_sequence;
+  TF_ASSERT_OK(reader1->GetNext(element, end_of_sequence));
+  TF_ASSERT_OK(reader1->GetNext(element, end_of_sequence));
+  std::unique_ptr<TaskIterator> reader2 = producer->AddReader();
+  ASSERT_NE(reader2, nullptr);
+  TF_ASSERT_OK(reader2->GetNext(element, end_of_sequence));
+  test::ExpectEqual(element[0], Tensor(int64{2}));
+}
+
+TEST(SharedElementProducer, Cancellation) {
+  int64 num_calls = 0;
+  CancellationManager cancellation_manager;
+  auto producer = std::make_shared<SharedElementProducer>(
+      absl::make_unique<RangeTaskIterator>(/*num_elements=*/10, &num_calls),
+      RangeIteratorFactory(10),
+      /*window_size=*/1, /*lag_timeout_us=*/kLagTimeoutUs,
+      cancellation_manager);
+  std::unique_ptr<TaskIterator> reader1 = producer->AddReader();
+  std::unique_ptr<TaskIterator> reader2 = producer->AddReader();
+  std::vector<Tensor> element;
+  bool end_of_sequence;
+  TF_ASSERT_OK(reader1->GetNext(element, end_of_sequence));
+  cancellation_manager.StartCancel();
+  // `reader1` is a full window ahead of `reader2`.
+  Status s = reader1->GetNext(element, end_of_sequence);
+  EXPECT_TRUE(errors::IsCancelled(s)) << s;
+}
+
+TEST(SharedElementProducer, CancelReader) {
+  int64 num_calls = 0;
+  CancellationManager cancellation_manager;
+  auto producer = std::make_shared<SharedElementProducer>(
+      absl::make_unique<RangeTaskIterator>(/*num_elements=*/10, &num_calls),
+      RangeIteratorFactory(10),
+      /*window_size=*/1, /*lag_timeout_us=*/kLagTimeoutUs,
+      cancellation_manager);
+  std::unique_ptr<TaskIterator> reader1 = producer->AddReader();
+  std::unique_ptr<TaskIterator> reader2 = producer->AddReader();
+  std::vector<Tensor> element;
+  bool end_of_sequence;
+  TF_ASSERT_OK(reader1->GetNext(element, end_of_sequence));
+  // `reader1` is a full window ahead of `reader2`, so it waits until it is
+  // cancelled.
+  std::unique_ptr<Thread> cancel_thread =
+      absl::WrapUnique(Env::Default()->StartThread({}, "cancel", [&] {
+        Env::Default()->SleepForMicroseconds(10 * 1000);
+        reader1->Cancel();
+      }));
+  Status s = reader1->GetNext(element, end_of_sequence);
+  EXPECT_TRUE(errors::IsCancelled(s)) << s;
+  // Other readers are not affected.
+  TF_ASSERT_OK(reader2->GetNext(element, end_of_sequence));
+  test::ExpectEqual(element[0], Tensor(int64{0}));
+}
+
+TEST(FirstComeFirstServedTaskRunner, DestroyWhileWaitingForSharedReaders) {
+  int64 num_calls = 0;
+  CancellationManager cancellation_manager;
+  auto producer = std::make_shared<SharedElementProducer>(
+      absl::make_unique<RangeTaskIterator>(/*num_elements=*/10, &num_calls),
+      RangeIteratorFactory(10),
+      /*window_size=*/1, /*lag_timeout_us=*/kLagTimeoutUs,
+      cancellation_manager);
+  std::unique_ptr<TaskIterator> lagging_reader = producer->AddReader();
+  const int64 start_us = Env::Default()->NowMicros();
+  {
+    FirstComeFirstServedTaskRunner runner(producer->AddReader());
+    // Once the first element is buffered, the prefetch thread waits for
+    // `lagging_reader`, which never reads.
+    for (int i = 0; i < 1000 && runner.NumBufferedElements() < 1; ++i) {
+      Env::Default()->SleepForMicroseconds(1000);
+    }
+    ASSERT_EQ(runner.NumBufferedElements(), 1);
+  }
+  // Destroying the runner does not wait for the lag timeout.
+  EXPECT_LT(Env::Default()->NowMicros() - start_us, kLagTimeoutUs / 2);
+}
+
+TEST(SharedElementProducer, DetachLaggingReaderOfFiniteDataset) {
+  int64 num_calls = 0;
+  CancellationManager cancellation_manager;
+  auto producer = std::make_shared<SharedElementProducer>(
+      absl::make_unique<RangeTaskIterator>(/*num_elements=*/10, &num_calls),
+      RangeIteratorFactory(10),
+      /*window_size=*/1, /*lag_timeout_us=*/1000, cancellation_manager);
+  std::unique_ptr<TaskIterator> reader1 = producer->AddReader();
+  std::unique_ptr<TaskIterator> reader2 = producer->AddReader();
+  std::vector<Tensor> element;
+  bool end_of_sequence;
+  TF_ASSERT_OK(reader2->GetNext(element, end_of_sequence));
+  test::ExpectEqual(element[0], Tensor(int64{0}));
+  // `reader2` stops reading, so `reader1` only proceeds once `reader2` has
+  // been detached.
+  for (int64 i = 0; i < 10; ++i) {
+    TF_ASSERT_OK(reader1->GetNext(element, end_of_sequence));
+    ASSERT_FALSE(end_of_sequence);
+    test::ExpectEqual(element[0], Tensor(i));
+  }
+  // `reader2` continues where it left off with a private iterator.
+  std::vector<int64> reader2_results;
+  TF_ASSERT_OK(ReadAll(*reader2, reader2_results));
+  EXPECT_EQ(reader2_results, std::vector<int64>({1, 2, 3, 4, 5, 6, 7, 8, 9}));
+}
+
+TEST(SharedElementProducer, SkipForLaggingReaderOfInfiniteDataset) {
+  std::vector<std::vector<Tensor>> elements;
+  for (int64 i = 0; i < 10; ++i) {
+    elements.push_back({Tensor(i)});
+  }
+  CancellationManager cancellation_manager;
+  auto producer = std::make_shared<SharedElementProducer>(
+      absl::make_unique<TestTaskIterator>(elements),
+      TestIteratorFactory(elements), /*window_size=*/2,
+      /*lag_timeout_us=*/1000, cancellation_manager);
+  std::unique_ptr<TaskIterator> reader1 = producer->AddReader();
+  std::unique_ptr<TaskIterator> reader2 = producer->AddReader();
+  std::vector<Tensor> element;
+  bool end_of_sequence;
+  for (int64 i = 0; i < 3; ++i) {
+    TF_ASSERT_OK(reader1->GetNext(element, end_of_sequence));
+    test::ExpectEqual(element[0], Tensor(i));
+  }
+  // `reader2` skipped the window it was holding back and continues from the
+  // element after it.
+  TF_ASSERT_OK(reader2->GetNext(element, end_of_sequence));
+  test::ExpectEqual(element[0], Tensor(int64{2}));
+}
+
 class ConsumeParallelTest
     : public ::testing::Test,
       public ::testing::WithParamInterface<std::tuple<int64, int64>> {};
@@ -102,7 +444,8 @@ TEST_P(ConsumeParallelTest, ConsumeParallel) {
   }
   CancellationManager cancellation_manager;
   RoundRobinTaskRunner runner(
-      absl::make_unique<TestTaskIterator>(elements), num_consumers,
+      absl::make_unique<TestTaskIterator>(elements),
+      TestIteratorFactory(elements), num_consumers,
       /*worker_address=*/"test_worker_address", cancellation_manager);
   std::vector<std::vector<int64>> per_consumer_results;
   std::vector<std::unique_ptr<Thread>> consumers;
@@ -157,7 +500,8 @@ TEST(RoundRobinTaskRunner, ConsumeParallelPartialRound) {
   }
   CancellationManager cancellation_manager;
   RoundRobinTaskRunner runner(
-      absl::make_unique<TestTaskIterator>(elements), num_consumers,
+      absl::make_unique<TestTaskIterator>(elements),
+      TestIteratorFactory(elements), num_consumers,
       /*worker_address=*/"test_worker_address", cancellation_manager);
   std::vector<std::vector<int64>> per_consumer_results;
   std::vector<std::unique_ptr<Thread>> consumers;
@@ -188,5 +532,27 @@ TEST(RoundRobinTaskRunner, ConsumeParallelPartialRound) {
               expected_consumer_results[consumer]);
   }
 }
+
+TEST(RoundRobinTaskRunner, NumBufferedElements) {
+  int64 num_consumers = 3;
+  std::vector<std::vector<Tensor>> elements;
+  for (int64 i = 0; i < 10; ++i) {
+    std::vector<Tensor> element;
+    element.push_back(Tensor(i));
+    elements.push_back(element);
+  }
+  CancellationManager cancellation_manager;
+  RoundRobinTaskRunner runner(
+      absl::make_unique<TestTaskIterator>(elements),
+      TestIteratorFactory(elements), num_consumers,
+      /*worker_address=*/"test_worker_address", cancellation_manager);
+  // The prefetch thread fills up a round's worth of elements in the
+  // background.
+  for (int i = 0; i < 1000 && runner.NumBufferedElements() < num_consumers;
+       ++i) {
+    Env::Default()->SleepForMicroseconds(1000);
+  }
+  EXPECT_EQ(runner.NumBufferedElements(), num_consumers);
+}
 }  // namespace data
 }  // namespace tensorflow
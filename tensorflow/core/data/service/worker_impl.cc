@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/data/service/worker_impl.h"
 
+#include <algorithm>
+#include <ctime>
+
 #include "grpcpp/create_channel.h"
 #include "absl/memory/memory.h"
 #include "tensorflow/c/c_api_internal.h"
@@ -36,6 +39,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/io/zlib_outputbuffer.h"
 #include "tensorflow/core/lib/monitoring/gauge.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/refcount.h"
 #include "tensorflow/core/platform/snappy.h"
@@ -46,6 +50,11 @@ namespace tensorflow {
 namespace data {
 
 const constexpr uint64 kRetryIntervalMicros = 5ull * 1000 * 1000;
+// How long the jobs sharing an iterator wait for a job which doesn't read
+// before detaching it from the shared iterator, unless
+// `cross_job_sharing_lag_timeout_ms` is set.
+const constexpr int64 kDefaultSharedReaderLagTimeoutMicros =
+    60ll * 1000 * 1000;
 
 namespace {
 // Moves the element into the response. If the tensor contains a single
@@ -72,6 +81,18 @@ Status MoveElementToResponse(std::vector<Tensor>&& element,
   *resp.mutable_compressed() = *compressed;
   return Status::OK();
 }
+
+// Moves `result` into the response to a GetElement request.
+Status MoveResultToResponse(GetElementResult&& result,
+                            GetElementResponse& resp) {
+  resp.set_end_of_sequence(result.end_of_sequence);
+  resp.set_skip_task(result.skip);
+  if (!resp.end_of_sequence() && !resp.skip_task()) {
+    TF_RETURN_IF_ERROR(
+        MoveElementToResponse(std::move(result.components), resp));
+  }
+  return Status::OK();
+}
 }  // namespace
 
 DataServiceWorkerImpl::DataServiceWorkerImpl(
@@ -140,9 +161,21 @@ void DataServiceWorkerImpl::Stop() {
 
 Status DataServiceWorkerImpl::GetElementResult(
     const GetElementRequest* request, struct GetElementResult* result) {
+  bool ready;
+  return GetElementResultInternal(request, /*wait=*/true, result, ready);
+}
+
+Status DataServiceWorkerImpl::GetElementResultInternal(
+    const GetElementRequest* request, bool wait,
+    struct GetElementResult* result, bool& ready) {
+  ready = true;
+  bool produced_element = false;
   auto cleanup = gtl::MakeCleanup([&] {
     mutex_lock l(mu_);
     outstanding_requests_--;
+    if (produced_element) {
+      num_elements_produced_++;
+    }
     cv_.notify_all();
   });
   Task* task;
@@ -174,7 +207,25 @@ Status DataServiceWorkerImpl::GetElementResult(
     task = it->second.get();
     TF_RETURN_IF_ERROR(EnsureTaskInitialized(*task));
   }
-  TF_RETURN_IF_ERROR(task->task_runner->GetNext(*request, *result));
+  if (wait) {
+    TF_RETURN_IF_ERROR(task->task_runner->GetNext(*request, *result));
+  } else {
+    TF_RETURN_IF_ERROR(
+        task->task_runner->TryGetNext(*request, *result, ready));
+    if (!ready) {
+      return Status::OK();
+    }
+  }
+  produced_element = !result->end_of_sequence && !result->skip;
+  if (result->end_of_sequence) {
+    // Record task completion here rather than in `GetElement` so that it is
+    // also reported when elements are served by a data transfer server or to
+    // local clients.
+    mutex_lock l(mu_);
+    VLOG(3) << "Reached end_of_sequence for task " << request->task_id();
+    pending_completed_tasks_.insert(request->task_id());
+    task_completion_cv_.notify_one();
+  }
   return Status::OK();
 }
 
@@ -206,23 +257,71 @@ Status DataServiceWorkerImpl::EnsureTaskInitialized(
   if (task.initialized) {
     return Status::OK();
   }
+  const TaskDef& task_def = task.task_def;
+  const bool share_iterator =
+      config_.cross_job_sharing_window_size() > 0 &&
+      task_def.processing_mode() == PARALLEL_EPOCHS &&
+      task_def.optional_num_consumers_case() != TaskDef::kNumConsumers;
+  std::unique_ptr<TaskIterator> task_iterator;
+  if (share_iterator) {
+    auto it = shared_producers_.find(task_def.dataset_id());
+    if (it != shared_producers_.end()) {
+      std::shared_ptr<SharedElementProducer> producer = it->second.lock();
+      if (producer) {
+        task_iterator = producer->AddReader();
+      }
+    }
+  }
+  if (task_iterator) {
+    VLOG(1) << "Task " << task_def.task_id()
+            << " shares an iterator for dataset " << task_def.dataset_id();
+  } else {
+    TF_RETURN_IF_ERROR(MakeTaskIterator(task_def, task_iterator));
+    if (share_iterator) {
+      const int64 lag_timeout_us =
+          config_.cross_job_sharing_lag_timeout_ms() > 0
+              ? config_.cross_job_sharing_lag_timeout_ms() * 1000
+              : kDefaultSharedReaderLagTimeoutMicros;
+      auto producer = std::make_shared<SharedElementProducer>(
+          std::move(task_iterator),
+          [this, task_def](std::unique_ptr<TaskIterator>& out) {
+            return MakeTaskIterator(task_def, out);
+          },
+          config_.cross_job_sharing_window_size(), lag_timeout_us,
+          cancellation_manager_);
+      shared_producers_[task_def.dataset_id()] = producer;
+      task_iterator = producer->AddReader();
+    }
+  }
+  TF_RETURN_IF_ERROR(TaskRunner::Create(config_, task_def,
+                                        cancellation_manager_,
+                                        std::move(task_iterator),
+                                        task.task_runner));
+
+  task.initialized = true;
+  VLOG(3) << "Created iterator for task " << task_def.task_id();
+  return Status::OK();
+}
+
+Status DataServiceWorkerImpl::MakeTaskIterator(
+    const TaskDef& task_def, std::unique_ptr<TaskIterator>& out) {
   standalone::Dataset::Params params;
   std::unique_ptr<standalone::Dataset> dataset;
   std::unique_ptr<standalone::Iterator> iterator;
 
-  switch (task.task_def.dataset_case()) {
+  switch (task_def.dataset_case()) {
     case TaskDef::kDatasetDef:
       TF_RETURN_IF_ERROR(standalone::Dataset::FromGraph(
-          params, task.task_def.dataset_def().graph(), &dataset));
+          params, task_def.dataset_def().graph(), &dataset));
       break;
     case TaskDef::kPath: {
       DatasetDef def;
-      Status s = ReadDatasetDef(task.task_def.path(), def);
+      Status s = ReadDatasetDef(task_def.path(), def);
       if (!s.ok()) {
-        LOG(INFO) << "Failed to read dataset from " << task.task_def.path()
-                  << ": " << s << ". Falling back to reading from dispatcher.";
+        LOG(INFO) << "Failed to read dataset from " << task_def.path() << ": "
+                  << s << ". Falling back to reading from dispatcher.";
         TF_RETURN_IF_ERROR(
-            dispatcher_->GetDatasetDef(task.task_def.dataset_id(), def));
+            dispatcher_->GetDatasetDef(task_def.dataset_id(), def));
       }
       TF_RETURN_IF_ERROR(
           standalone::Dataset::FromGraph(params, def.graph(), &dataset));
@@ -230,13 +329,13 @@ Status DataServiceWorkerImpl::EnsureTaskInitialized(
     }
     case TaskDef::DATASET_NOT_SET:
       return errors::Internal("Unrecognized dataset case: ",
-                              task.task_def.dataset_case());
+                              task_def.dataset_case());
   }
-  switch (task.task_def.processing_mode()) {
+  switch (task_def.processing_mode()) {
     case DISTRIBUTED_EPOCH: {
       auto split_provider = absl::make_unique<DataServiceSplitProvider>(
-          config_.dispatcher_address(), config_.protocol(),
-          task.task_def.job_id(), config_.dispatcher_timeout_ms());
+          config_.dispatcher_address(), config_.protocol(), task_def.job_id(),
+          config_.dispatcher_timeout_ms());
       TF_RETURN_IF_ERROR(
           dataset->MakeIterator(std::move(split_provider), &iterator));
       break;
@@ -246,16 +345,10 @@ Status DataServiceWorkerImpl::EnsureTaskInitialized(
       break;
     default:
       return errors::InvalidArgument("Unrecognized processing mode: ",
-                                     task.task_def.processing_mode());
+                                     task_def.processing_mode());
   }
-  auto task_iterator = absl::make_unique<StandaloneTaskIterator>(
-      std::move(dataset), std::move(iterator));
-  TF_RETURN_IF_ERROR(
-      TaskRunner::Create(config_, task.task_def, cancellation_manager_,
-                         std::move(task_iterator), task.task_runner));
-
-  task.initialized = true;
-  VLOG(3) << "Created iterator for task " << task.task_def.task_id();
+  out = absl::make_unique<StandaloneTaskIterator>(std::move(dataset),
+                                                  std::move(iterator));
   return Status::OK();
 }
 
@@ -264,22 +357,55 @@ Status DataServiceWorkerImpl::GetElement(const GetElementRequest* request,
   VLOG(3) << "Received GetElement request for task " << request->task_id();
   struct GetElementResult result;
   TF_RETURN_IF_ERROR(GetElementResult(request, &result));
-  response->set_end_of_sequence(result.end_of_sequence);
-  response->set_skip_task(result.skip);
-  if (response->end_of_sequence()) {
-    mutex_lock l(mu_);
-    VLOG(3) << "Reached end_of_sequence for task " << request->task_id();
-    pending_completed_tasks_.insert(request->task_id());
-    task_completion_cv_.notify_one();
-  } else if (!response->skip_task()) {
-    TF_RETURN_IF_ERROR(
-        MoveElementToResponse(std::move(result.components), *response));
+  TF_RETURN_IF_ERROR(MoveResultToResponse(std::move(result), *response));
+  if (!response->end_of_sequence() && !response->skip_task()) {
     VLOG(3) << "Producing an element for task " << request->task_id();
   }
 
   return Status::OK();
 }
 
+Status DataServiceWorkerImpl::GetElements(const GetElementsRequest* request,
+                                          GetElementsResponse* response) {
+  VLOG(3) << "Received GetElements request for task " << request->task_id()
+          << " with max_elements " << request->max_elements();
+  if (request->max_elements() <= 0) {
+    return errors::InvalidArgument(
+        "GetElements requires max_elements to be positive, but got ",
+        request->max_elements());
+  }
+  GetElementRequest element_request;
+  element_request.set_task_id(request->task_id());
+  for (int64 i = 0; i < request->max_elements(); ++i) {
+    // Only the first element is waited for. Further elements are added only
+    // if the task has already produced them, so that they never hold back
+    // the response.
+    struct GetElementResult result;
+    bool ready;
+    Status s = GetElementResultInternal(&element_request, /*wait=*/i == 0,
+                                        &result, ready);
+    if (!s.ok()) {
+      // Don't drop the elements we already have if the worker is shutting
+      // down. The client will see the error when it asks for more elements.
+      if (i > 0 && (errors::IsCancelled(s) || errors::IsUnavailable(s))) {
+        break;
+      }
+      return s;
+    }
+    if (!ready) {
+      break;
+    }
+    GetElementResponse* element = response->add_elements();
+    TF_RETURN_IF_ERROR(MoveResultToResponse(std::move(result), *element));
+    if (element->end_of_sequence()) {
+      break;
+    }
+  }
+  VLOG(3) << "Producing " << response->elements_size()
+          << " elements for task " << request->task_id();
+  return Status::OK();
+}
+
 Status DataServiceWorkerImpl::GetWorkerTasks(
     const GetWorkerTasksRequest* request, GetWorkerTasksResponse* response) {
   mutex_lock l(mu_);
@@ -369,34 +495,80 @@ void DataServiceWorkerImpl::HeartbeatThread() TF_LOCKS_EXCLUDED(mu_) {
   }
 }
 
+WorkerLoad DataServiceWorkerImpl::ComputeLoad()
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  WorkerLoad load;
+  for (const auto& it : tasks_) {
+    Task& task = *it.second;
+    mutex_lock l(task.mu);
+    if (task.initialized) {
+      int64 buffered_elements = task.task_runner->NumBufferedElements();
+      load.set_buffered_elements(load.buffered_elements() + buffered_elements);
+      if (buffered_elements > 0) {
+        (*load.mutable_task_buffered_elements())[it.first] = buffered_elements;
+      }
+    }
+  }
+  int64 now_micros = Env::Default()->NowMicros();
+  // `std::clock` measures the CPU time used by all threads of the process.
+  std::clock_t cpu_ticks = std::clock();
+  if (last_load_micros_ > 0 && now_micros > last_load_micros_) {
+    double elapsed_seconds = (now_micros - last_load_micros_) / 1e6;
+    double cpu_seconds =
+        static_cast<double>(cpu_ticks - last_load_cpu_ticks_) / CLOCKS_PER_SEC;
+    double capacity_seconds = elapsed_seconds * port::NumSchedulableCPUs();
+    load.set_cpu_utilization(
+        std::min(1.0, std::max(0.0, cpu_seconds / capacity_seconds)));
+    load.set_elements_per_second(
+        (num_elements_produced_ - last_load_num_elements_) / elapsed_seconds);
+  }
+  last_load_micros_ = now_micros;
+  last_load_cpu_ticks_ = cpu_ticks;
+  last_load_num_elements_ = num_elements_produced_;
+  return load;
+}
+
 Status DataServiceWorkerImpl::Heartbeat() TF_LOCKS_EXCLUDED(mu_) {
   std::vector<int64> current_tasks;
+  WorkerLoad load;
   {
     mutex_lock l(mu_);
     for (const auto& task : tasks_) {
       current_tasks.push_back(task.first);
     }
+    load = ComputeLoad();
   }
   std::vector<TaskDef> new_tasks;
   std::vector<int64> tasks_to_delete;
-  TF_RETURN_IF_ERROR(
-      dispatcher_->WorkerHeartbeat(worker_address_, transfer_address_,
-                                   current_tasks, new_tasks, tasks_to_delete));
-  mutex_lock l(mu_);
-  for (const auto& task : new_tasks) {
-    VLOG(1) << "Received new task from dispatcher with id " << task.task_id();
-    Status s = ProcessTaskInternal(task);
-    if (!s.ok() && !errors::IsAlreadyExists(s)) {
-      LOG(WARNING) << "Failed to start processing task " << task.task_id()
-                   << ": " << s;
+  TF_RETURN_IF_ERROR(dispatcher_->WorkerHeartbeat(
+      worker_address_, transfer_address_, current_tasks, load, new_tasks,
+      tasks_to_delete));
+  std::vector<std::shared_ptr<Task>> deleted_tasks;
+  {
+    mutex_lock l(mu_);
+    for (const auto& task : new_tasks) {
+      VLOG(1) << "Received new task from dispatcher with id "
+              << task.task_id();
+      Status s = ProcessTaskInternal(task);
+      if (!s.ok() && !errors::IsAlreadyExists(s)) {
+        LOG(WARNING) << "Failed to start processing task " << task.task_id()
+                     << ": " << s;
+      }
+    }
+    for (int64 task_id : tasks_to_delete) {
+      VLOG(3) << "Deleting task " << task_id
+              << " at the request of the dispatcher";
+      auto it = tasks_.find(task_id);
+      if (it != tasks_.end()) {
+        deleted_tasks.push_back(std::move(it->second));
+        tasks_.erase(it);
+      }
+      finished_tasks_.insert(task_id);
     }
   }
-  for (int64 task_id : tasks_to_delete) {
-    VLOG(3) << "Deleting task " << task_id
-            << " at the request of the dispatcher";
-    tasks_.erase(task_id);
-    finished_tasks_.insert(task_id);
-  }
+  // Destroying a task runner waits for its threads to stop, so it is done
+  // without holding `mu_`.
+  deleted_tasks.clear();
   return Status::OK();
 }
 
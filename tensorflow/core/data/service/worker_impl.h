@@ -15,6 +15,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DATA_SERVICE_WORKER_IMPL_H_
 #define TENSORFLOW_CORE_DATA_SERVICE_WORKER_IMPL_H_
 
+#include <ctime>
+
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/data/service/common.pb.h"
@@ -62,6 +64,8 @@ class DataServiceWorkerImpl {
   /// Client-facing API.
   Status GetElement(const GetElementRequest* request,
                     GetElementResponse* response);
+  Status GetElements(const GetElementsRequest* request,
+                     GetElementsResponse* response);
   Status GetWorkerTasks(const GetWorkerTasksRequest* request,
                         GetWorkerTasksResponse* response);
 
@@ -77,16 +81,28 @@ class DataServiceWorkerImpl {
 
   // Sends task status to the dispatcher and checks for dispatcher commands.
   Status SendTaskUpdates() TF_LOCKS_EXCLUDED(mu_);
+  // Serves a GetElement request. If `wait` is false, only returns an element
+  // which the task has already produced, and sets `ready` to false if there is
+  // no such element.
+  Status GetElementResultInternal(const GetElementRequest* request, bool wait,
+                                  struct GetElementResult* result, bool& ready)
+      TF_LOCKS_EXCLUDED(mu_);
   // Creates an iterator to process a task.
   Status ProcessTaskInternal(const TaskDef& task)
       TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
-  Status EnsureTaskInitialized(Task& task);
+  Status EnsureTaskInitialized(Task& task) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Creates an iterator over the elements of the task's dataset.
+  Status MakeTaskIterator(const TaskDef& task_def,
+                          std::unique_ptr<TaskIterator>& out);
   // A thread for notifying the dispatcher when tasks complete.
   void TaskCompletionThread() TF_LOCKS_EXCLUDED(mu_);
   // A thread for doing periodic heartbeats to the dispatcher.
   void HeartbeatThread() TF_LOCKS_EXCLUDED(mu_);
   // Performs a heartbeat to the dispatcher.
   Status Heartbeat() TF_LOCKS_EXCLUDED(mu_);
+  // Computes the load to report in the next heartbeat. CPU utilization and the
+  // produce rate are measured since the previous call.
+  WorkerLoad ComputeLoad() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
   const experimental::WorkerConfig config_;
   // The worker's own address.
@@ -112,6 +128,18 @@ class DataServiceWorkerImpl {
   std::unique_ptr<Thread> heartbeat_thread_;
   condition_variable heartbeat_cv_ TF_GUARDED_BY(mu_);
   int64 outstanding_requests_ TF_GUARDED_BY(mu_) = 0;
+  // The number of elements served to clients.
+  int64 num_elements_produced_ TF_GUARDED_BY(mu_) = 0;
+  // Wall time, process CPU time, and `num_elements_produced_` as of the last
+  // `ComputeLoad` call.
+  int64 last_load_micros_ TF_GUARDED_BY(mu_) = 0;
+  std::clock_t last_load_cpu_ticks_ TF_GUARDED_BY(mu_) = 0;
+  int64 last_load_num_elements_ TF_GUARDED_BY(mu_) = 0;
+  // Producers shared by the tasks of different jobs reading the same dataset,
+  // keyed by dataset id. Only used when cross-job sharing is enabled. The
+  // producers are owned by the iterators of the tasks reading from them.
+  absl::flat_hash_map<int64, std::weak_ptr<SharedElementProducer>>
+      shared_producers_ TF_GUARDED_BY(mu_);
   CancellationManager cancellation_manager_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(DataServiceWorkerImpl);
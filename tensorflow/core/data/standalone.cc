@@ -36,11 +36,19 @@ namespace data {
 namespace standalone {
 
 Status Iterator::GetNext(std::vector<Tensor>* outputs, bool* end_of_input) {
+  if (cancellation_manager_->IsCancelled()) {
+    return errors::Cancelled("Iterator was cancelled");
+  }
   return iterator_->GetNext(ctx_.get(), outputs, end_of_input);
 }
 
-Iterator::Iterator(IteratorBase* iterator, IteratorContext* ctx)
-    : iterator_(iterator), ctx_(ctx) {}
+void Iterator::Cancel() { cancellation_manager_->StartCancel(); }
+
+Iterator::Iterator(IteratorBase* iterator, IteratorContext* ctx,
+                   std::unique_ptr<CancellationManager> cancellation_manager)
+    : cancellation_manager_(std::move(cancellation_manager)),
+      iterator_(iterator),
+      ctx_(ctx) {}
 
 Status Dataset::FromGraph(Params params, const GraphDef& graph_def,
                           std::unique_ptr<Dataset>* result) {
@@ -102,6 +110,10 @@ Status Dataset::MakeIterator(std::unique_ptr<SplitProvider> split_provider,
                              std::unique_ptr<Iterator>* result) {
   // Create an `IteratorContext`, which bundles together the necessary runtime
   // support to create and get elements from an iterator.
+  // Each iterator gets its own cancellation manager, so that it can be
+  // cancelled independently of the other iterators of the dataset.
+  auto cancellation_manager =
+      absl::make_unique<CancellationManager>(&cancellation_manager_);
   std::unique_ptr<IteratorContext> ctx;
   {
     // NOTE(mrry): In the current API, an `IteratorContext` is always initially
@@ -115,7 +127,7 @@ Status Dataset::MakeIterator(std::unique_ptr<SplitProvider> split_provider,
     IteratorContext::Params params(&op_ctx);
     params.function_handle_cache = function_handle_cache_.get();
     params.resource_mgr = &resource_mgr_;
-    params.cancellation_manager = &cancellation_manager_;
+    params.cancellation_manager = cancellation_manager.get();
     params.split_provider = std::move(split_provider);
 
     ctx = absl::make_unique<IteratorContext>(std::move(params));
@@ -126,7 +138,8 @@ Status Dataset::MakeIterator(std::unique_ptr<SplitProvider> split_provider,
   TF_RETURN_IF_ERROR(dataset_->MakeIterator(ctx.get(), /*parent=*/nullptr,
                                             "Iterator", &iterator));
 
-  *result = WrapUnique(new Iterator(iterator.release(), ctx.release()));
+  *result = WrapUnique(new Iterator(iterator.release(), ctx.release(),
+                                    std::move(cancellation_manager)));
 
   return Status::OK();
 }
@@ -19,6 +19,7 @@ limitations under the License.
 #include <memory>
 
 #include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/function_handle_cache.h"
 #include "tensorflow/core/lib/core/threadpool.h"
@@ -72,11 +73,20 @@ class Iterator {
   // indication of whether the end of the input pipeline has been reached.
   Status GetNext(std::vector<Tensor>* outputs, bool* end_of_input);
 
+  // Cancels the input pipeline. Ongoing `GetNext` calls which wait for input
+  // return early where the pipeline supports cancellation, and future calls
+  // return `Cancelled`. May be called concurrently with `GetNext`.
+  void Cancel();
+
  private:
   friend class Dataset;
 
-  Iterator(IteratorBase* iterator, IteratorContext* ctx);
+  Iterator(IteratorBase* iterator, IteratorContext* ctx,
+           std::unique_ptr<CancellationManager> cancellation_manager);
 
+  // Cancels `iterator_`. Declared first, so that it outlives `iterator_` and
+  // `ctx_`, which refer to it.
+  std::unique_ptr<CancellationManager> cancellation_manager_;
   std::unique_ptr<IteratorBase> iterator_;
   std::unique_ptr<IteratorContext> ctx_;
 };
@@ -20,6 +20,7 @@ limitations under the License.
 
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -301,6 +302,28 @@ TEST(Scalar, Standalone) {
   }
 }
 
+TEST(Scalar, StandaloneCancel) {
+  GraphDef graph_def;
+  protobuf::TextFormat::ParseFromString(kRangeGraphProto, &graph_def);
+  std::unique_ptr<Dataset> dataset;
+  TF_ASSERT_OK(Dataset::FromGraph({}, graph_def, &dataset));
+  std::unique_ptr<Iterator> iterator;
+  TF_ASSERT_OK(dataset->MakeIterator(&iterator));
+  std::unique_ptr<Iterator> other_iterator;
+  TF_ASSERT_OK(dataset->MakeIterator(&other_iterator));
+
+  std::vector<tensorflow::Tensor> outputs;
+  bool end_of_input = false;
+  TF_ASSERT_OK(iterator->GetNext(&outputs, &end_of_input));
+  iterator->Cancel();
+  EXPECT_TRUE(errors::IsCancelled(iterator->GetNext(&outputs, &end_of_input)));
+
+  // Other iterators of the dataset are not cancelled.
+  TF_ASSERT_OK(other_iterator->GetNext(&outputs, &end_of_input));
+  EXPECT_FALSE(end_of_input);
+  EXPECT_EQ(outputs[0].scalar<int64>()(), 0);
+}
+
 }  // namespace
 }  // namespace standalone
 }  // namespace data
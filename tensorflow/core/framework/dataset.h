@@ -346,6 +346,7 @@ class IteratorContext {
           function_handle_cache(ctx->function_handle_cache()),
           resource_mgr(ctx->resource_mgr()),
           model(ctx->model()),
+          numa_aware(ctx->numa_aware()),
           runner(*(ctx->runner())),
           runner_threadpool_size(ctx->runner_threadpool_size()),
           split_provider(ctx->split_provider()),
@@ -410,6 +411,11 @@ class IteratorContext {
     // If non-null, identifies the object used for performance modeling.
     std::shared_ptr<model::Model> model = nullptr;
 
+    // Whether iterators that process independent shards of their input (e.g.
+    // the branches of a parallel interleave) should pin each shard to a NUMA
+    // node and allocate its buffers from memory local to that node.
+    bool numa_aware = false;
+
     // Function call support.
     std::function<void(std::function<void()>)> runner = nullptr;
 
@@ -459,6 +465,8 @@ class IteratorContext {
 
   const std::shared_ptr<model::Model>& model() { return params_.model; }
 
+  bool numa_aware() const { return params_.numa_aware; }
+
   std::function<void(std::function<void()>)>* runner() {
     return &params_.runner;
   }
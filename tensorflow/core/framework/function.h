@@ -289,6 +289,16 @@ class CallFrameInterface {
   virtual bool CanConsumeArg(int index) const { return false; }
 
   virtual Status SetRetval(int index, const Tensor& val) = 0;
+
+  // Optionally provides the buffer of return value `index`, so that the kernel
+  // that produces the value can write it in place. If the caller provided a
+  // buffer for the value with the given `dtype` and `shape`, moves it to
+  // `*val` and returns true. Otherwise returns false, and the kernel allocates
+  // the value as usual. A buffer is provided at most once.
+  virtual bool TakeRetvalBuffer(int index, DataType dtype,
+                                const TensorShape& shape, Tensor* val) {
+    return false;
+  }
 };
 
 // Represents a function call frame. I.e., the data structure used to
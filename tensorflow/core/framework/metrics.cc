@@ -15,9 +15,12 @@ limitations under the License.
 
 #include "tensorflow/core/framework/metrics.h"
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/str_cat.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/gauge.h"
 #include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow/core/platform/mutex.h"
 
 namespace tensorflow {
 namespace metrics {
@@ -50,6 +53,15 @@ auto* graph_pending_queue_length_histogram = monitoring::Sampler<0>::New(
     // Power of 1.5 with bucket count 30 (> 191k)
     {monitoring::Buckets::Exponential(1, 1.5, 30)});
 
+auto* run_handler_queueing_delay_usecs_histogram =
+    monitoring::Sampler<1>::New(
+        {"/tensorflow/core/run_handler_queueing_delay_usecs_histogram",
+         "The time in microseconds a request waited in the run handler pool "
+         "before its first inter-op closure started running.",
+         "priority"},
+        // Power of 2 with bucket count 20 (> 1 second)
+        {monitoring::Buckets::Exponential(1, 2, 20)});
+
 auto* graph_run_input_tensor_bytes = monitoring::Sampler<0>::New(
     {"/tensorflow/core/graph_run_input_tensor_bytes",
      "The size of input tensors in bytes."},
@@ -121,10 +133,25 @@ auto* tf_data_service_workers_created_counter =
     monitoring::Counter<0>::New("/tensorflow/data/service/workers_created",
                                 "Number of tf.data service workers created");
 
+auto* tf_data_service_task_elements_in_flight_gauge =
+    monitoring::Gauge<int64, 1>::New(
+        "/tensorflow/data/service/task_elements_in_flight",
+        "The number of elements requested from a tf.data service task and not "
+        "yet received.",
+        "task_id");
+
 auto* tf_data_filename_counter = monitoring::Counter<2>::New(
     "/tensorflow/data/filename", "The file name read by a tf.data Dataset.",
     "name", "filename");
 
+auto* tf_data_cache_lookup_counter = monitoring::Counter<1>::New(
+    "/tensorflow/data/cache_lookups",
+    "The number of lookups in tf.data in-memory caches.", "result");
+
+auto* tf_data_cache_bytes_resident_gauge = monitoring::Gauge<int64, 0>::New(
+    "/tensorflow/data/cache_bytes_resident",
+    "The number of bytes held by tf.data in-memory caches.");
+
 auto* parse_dense_feature_counter = monitoring::Counter<0>::New(
     "/tensorflow/data/dense_feature",
     "The number of dense features parsed by ops for parsing tf.Example.");
@@ -236,10 +263,45 @@ void RecordTFDataServiceWorkerCreated() {
   tf_data_service_workers_created_counter->GetCell()->IncrementBy(1);
 }
 
+void UpdateTFDataServiceTaskElementsInFlight(int64 task_id, int64 delta) {
+  static mutex* mu = new mutex();
+  static auto* elements_in_flight = new absl::flat_hash_map<int64, int64>();
+  // Update and publish under the same lock, so that a concurrent update cannot
+  // overwrite the gauge with an older total.
+  mutex_lock l(*mu);
+  int64 total = (*elements_in_flight)[task_id] += delta;
+  if (total == 0) {
+    elements_in_flight->erase(task_id);
+  }
+  tf_data_service_task_elements_in_flight_gauge
+      ->GetCell(absl::StrCat(task_id))
+      ->Set(total);
+}
+
 void RecordTFDataFilename(const string& name, const string& filename) {
   tf_data_filename_counter->GetCell(name, filename)->IncrementBy(1);
 }
 
+void RecordTFDataCacheLookup(bool hit) {
+  static auto* tf_data_cache_hit_cell =
+      tf_data_cache_lookup_counter->GetCell("hit");
+  static auto* tf_data_cache_miss_cell =
+      tf_data_cache_lookup_counter->GetCell("miss");
+  (hit ? tf_data_cache_hit_cell : tf_data_cache_miss_cell)->IncrementBy(1);
+}
+
+void UpdateTFDataCacheBytesResident(int64 delta_bytes) {
+  static mutex* mu = new mutex();
+  static int64 bytes_resident = 0;
+  static auto* tf_data_cache_bytes_resident_cell =
+      tf_data_cache_bytes_resident_gauge->GetCell();
+  // Update and publish under the same lock, so that a concurrent update cannot
+  // overwrite the gauge with an older total.
+  mutex_lock l(*mu);
+  bytes_resident += delta_bytes;
+  tf_data_cache_bytes_resident_cell->Set(bytes_resident);
+}
+
 void RecordParseDenseFeature(int64 num_features) {
   static auto* parse_dense_feature_counter_cell =
       parse_dense_feature_counter->GetCell();
@@ -293,6 +355,11 @@ void UpdateGraphPendingQueueLength(uint64 len) {
   graph_pending_queue_length_cell->Add(len);
 }
 
+void RecordRunHandlerQueueingDelay(int64 priority, uint64 delay_usecs) {
+  run_handler_queueing_delay_usecs_histogram->GetCell(absl::StrCat(priority))
+      ->Add(delay_usecs);
+}
+
 void UpdateGraphOptimizationPassTime(const string& pass_name,
                                      const uint64 running_time_usecs) {
   if (running_time_usecs > 0) {
@@ -87,11 +87,24 @@ void RecordTFDataOptimization(const string& name, int64 num_changes);
 // Records that a tf.data service worker has been created.
 void RecordTFDataServiceWorkerCreated();
 
+// Updates the number of elements that tf.data service clients in this process
+// have requested from the task `task_id` and not yet received, by `delta`,
+// which may be negative.
+void UpdateTFDataServiceTaskElementsInFlight(int64 task_id, int64 delta);
+
 // Records the file name read by a tf.data Dataset.
 //
 // The `name` argument identifies the Dataset type (e.g. "TFRecordDataset").
 void RecordTFDataFilename(const string& name, const string& filename);
 
+// Records a lookup in a tf.data in-memory cache. `hit` indicates whether the
+// element was already cached or had to be produced by the input pipeline.
+void RecordTFDataCacheLookup(bool hit);
+
+// Updates the number of bytes resident in tf.data in-memory caches by
+// `delta_bytes`, which may be negative.
+void UpdateTFDataCacheBytesResident(int64 delta_bytes);
+
 // Records parsing of dense tensor features.
 void RecordParseDenseFeature(int64 num_features);
 
@@ -111,6 +124,10 @@ void RecordTPUXlaSpmdCoresPerReplica(int64 cores_per_replica);
 void UpdateGraphExecTime(const uint64 running_time_usecs);
 void UpdateGraphPendingQueueLength(uint64 len);
 
+// Records the time a request with the given run handler `priority` waited
+// before its first inter-op closure started running.
+void RecordRunHandlerQueueingDelay(int64 priority, uint64 delay_usecs);
+
 // Records that one output of an op of type `op_name` was unused.
 void RecordUnusedOutput(const string& op_name);
 
@@ -15,8 +15,10 @@ limitations under the License.
 
 #include "tensorflow/core/framework/model.h"
 
+#include <cmath>
 #include <memory>
 
+#include "absl/strings/match.h"
 #include "absl/time/clock.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
@@ -28,6 +30,7 @@ namespace model {
 
 constexpr int64 Model::kOptimizationPeriodMinMs;
 constexpr int64 Model::kOptimizationPeriodMaxMs;
+constexpr double AutotuneCoordinator::kEvenShare;
 
 namespace {
 
@@ -756,16 +759,29 @@ class UnknownRatio : public Node {
  public:
   using Node::Node;
 
+  UnknownRatio(Node::Args args,
+               std::vector<std::shared_ptr<Parameter>> parameters)
+      : Node(args) {
+    for (auto& parameter : parameters) {
+      parameters_[parameter->name] = std::move(parameter);
+    }
+  }
+
   virtual ~UnknownRatio() {}
 
  protected:
   std::shared_ptr<Node> Clone(std::shared_ptr<Node> output) const override
       TF_SHARED_LOCKS_REQUIRED(mu_) {
-    return std::make_shared<UnknownRatio>(Args{id_, name_, std::move(output)});
+    std::vector<std::shared_ptr<Parameter>> parameters;
+    for (auto& pair : parameters_) {
+      parameters.push_back(pair.second);
+    }
+    return std::make_shared<UnknownRatio>(Args{id_, name_, std::move(output)},
+                                          parameters);
   }
 
-  // The input time is the sum of inherited input time and self processing time,
-  // divided by the ratio estimate.
+  // The input time is the sum of inherited input time and parallelism adjusted
+  // self processing time, divided by the ratio estimate.
   void InputTimeLocked(absl::flat_hash_map<string, double>* input_times)
       const override TF_SHARED_LOCKS_REQUIRED(mu_) {
     double inherited_input_time;
@@ -784,27 +800,31 @@ class UnknownRatio : public Node {
     double ratio = static_cast<double>(input->num_elements()) /
                    static_cast<double>(num_elements_);
     double input_time =
-        (inherited_input_time + SelfProcessingTimeLocked()) / ratio;
+        (inherited_input_time + SelfProcessingTimeLocked() / Parallelism()) /
+        ratio;
     (*input_times)[long_name()] = input_time;
   }
 
-  // The output time is the sum of the self processing time and the product of
-  // the ratio estimate and the sum of output times of inputs.
+  // The output time is the sum of the parallelism adjusted self processing time
+  // and the product of the ratio estimate and the sum of output times of
+  // inputs.
   void OutputTimeLocked(
       const absl::flat_hash_map<string, double>& input_times,
       absl::flat_hash_map<string, double>* gradients,
       absl::flat_hash_map<string, double>* output_times,
       absl::flat_hash_map<string, double>* output_time_gradients) const override
       TF_SHARED_LOCKS_REQUIRED(mu_) {
+    double parallelism = Parallelism();
     double self_processing_time = SelfProcessingTimeLocked();
     if (num_elements_ == 0 || inputs_.empty() ||
         inputs_.front()->num_elements() == 0) {
-      (*output_times)[long_name()] = self_processing_time;
+      (*output_times)[long_name()] = self_processing_time / parallelism;
       if (gradients) {
         for (const auto& node :
              CollectNodes(TraversalOrder::REVERSE_BFS, IsAutotuneNode)) {
           gradients->erase(node->long_name());
         }
+        AddParallelismGradient(self_processing_time, parallelism, gradients);
       }
       return;
     }
@@ -822,9 +842,11 @@ class UnknownRatio : public Node {
       }
       (*output_time_gradients)[long_name()] =
           OutputTimeGradientsForInputs(*output_time_gradients);
+      AddParallelismGradient(self_processing_time, parallelism, gradients);
     }
     double inputs_output_time = ratio * OutputTimeForInputs(*output_times);
-    (*output_times)[long_name()] = self_processing_time + inputs_output_time;
+    (*output_times)[long_name()] =
+        self_processing_time / parallelism + inputs_output_time;
   }
 
   // The processing time is the sum of the self processing time and the product
@@ -857,6 +879,26 @@ class UnknownRatio : public Node {
     node_proto->set_node_class(NodeClass::UNKNOWN_RATIO);
     return Status::OK();
   }
+
+ private:
+  // Returns the value of the parallelism parameter, or 1 if the node does not
+  // have one.
+  double Parallelism() const TF_SHARED_LOCKS_REQUIRED(mu_) {
+    auto* parallelism_parameter = gtl::FindOrNull(parameters_, kParallelism);
+    return parallelism_parameter ? (*parallelism_parameter)->value : 1.0;
+  }
+
+  // The node processes its inputs synchronously, so the derivative of its
+  // output time w.r.t. a tunable parallelism parameter only accounts for the
+  // parallelism adjusted self processing time.
+  void AddParallelismGradient(double self_processing_time, double parallelism,
+                              absl::flat_hash_map<string, double>* gradients)
+      const TF_SHARED_LOCKS_REQUIRED(mu_) {
+    auto* parallelism_parameter = gtl::FindOrNull(parameters_, kParallelism);
+    if (parallelism_parameter && (*parallelism_parameter)->state->tunable) {
+      (*gradients)[long_name()] = -self_processing_time / Square(parallelism);
+    }
+  }
 };
 
 class Unknown : public Node {
@@ -962,6 +1004,11 @@ std::shared_ptr<Node> MakeUnknownRatioNode(Node::Args args) {
   return std::make_shared<UnknownRatio>(std::move(args));
 }
 
+std::shared_ptr<Node> MakeUnknownRatioNode(
+    Node::Args args, std::vector<std::shared_ptr<Parameter>> parameters) {
+  return std::make_shared<UnknownRatio>(std::move(args), std::move(parameters));
+}
+
 std::shared_ptr<Node> MakeUnknownNode(Node::Args args) {
   return std::make_shared<Unknown>(std::move(args));
 }
@@ -1736,6 +1783,17 @@ Status Model::OptimizeLoop(AutotuneAlgorithm algorithm, int64 cpu_budget,
       },
       /*deregister_fn=*/&unused));
 
+  AutotuneCoordinator* coordinator = nullptr;
+  if (AutotuneCoordinator::Enabled()) {
+    coordinator = AutotuneCoordinator::Global();
+    coordinator->Register(this, cpu_budget, ram_budget);
+  }
+  auto unregister = gtl::MakeCleanup([this, coordinator]() {
+    if (coordinator) {
+      coordinator->Unregister(this);
+    }
+  });
+
   int64 last_optimization_ms = 0;
   int64 current_time_ms = EnvTime::NowMicros() / EnvTime::kMillisToMicros;
   while (true) {
@@ -1754,8 +1812,15 @@ Status Model::OptimizeLoop(AutotuneAlgorithm algorithm, int64 cpu_budget,
       }
     }
 
+    int64 optimization_cpu_budget = cpu_budget;
+    int64 optimization_ram_budget = ram_budget;
+    if (coordinator) {
+      coordinator->GetBudgets(this, &optimization_cpu_budget,
+                              &optimization_ram_budget);
+    }
     int64 optimization_start_us = EnvTime::NowMicros();
-    Optimize(algorithm, cpu_budget, ram_budget, /*model_input_time=*/0);
+    Optimize(algorithm, optimization_cpu_budget, optimization_ram_budget,
+             /*model_input_time=*/0);
     VLOG(2) << "Optimized for "
             << (EnvTime::NowMicros() - optimization_start_us) << " us.";
 
@@ -2018,6 +2083,78 @@ Status Model::SaveLoop() {
   }
 }
 
+AutotuneCoordinator* AutotuneCoordinator::Global() {
+  static AutotuneCoordinator* coordinator = new AutotuneCoordinator();
+  return coordinator;
+}
+
+bool AutotuneCoordinator::Enabled() {
+  static const bool enabled = []() {
+    const char* value = std::getenv("TF_DATA_AUTOTUNE_SHARED_BUDGETS");
+    return value != nullptr && (absl::string_view(value) == "1" ||
+                                absl::EqualsIgnoreCase(value, "true"));
+  }();
+  return enabled;
+}
+
+void AutotuneCoordinator::Register(const Model* model, int64 cpu_budget,
+                                   int64 ram_budget) {
+  ModelState state;
+  state.cpu_budget = cpu_budget;
+  state.ram_budget = ram_budget;
+  state.last_consumer_wait_time_nanos = model->consumer_wait_time_nanos();
+  state.last_update_nanos = EnvTime::NowNanos();
+  mutex_lock l(mu_);
+  models_[model] = state;
+  VLOG(2) << "Registered model with the autotune coordinator. Number of "
+             "registered models: "
+          << models_.size();
+}
+
+void AutotuneCoordinator::Unregister(const Model* model) {
+  mutex_lock l(mu_);
+  models_.erase(model);
+}
+
+void AutotuneCoordinator::GetBudgets(const Model* model, int64* cpu_budget,
+                                     int64* ram_budget) {
+  const int64 now_nanos = EnvTime::NowNanos();
+  const int64 consumer_wait_time_nanos = model->consumer_wait_time_nanos();
+  mutex_lock l(mu_);
+  auto it = models_.find(model);
+  if (it == models_.end()) {
+    return;
+  }
+  ModelState& state = it->second;
+  const int64 elapsed_nanos =
+      std::max<int64>(now_nanos - state.last_update_nanos, 1);
+  state.weight = static_cast<double>(consumer_wait_time_nanos -
+                                     state.last_consumer_wait_time_nanos) /
+                 elapsed_nanos;
+  state.last_consumer_wait_time_nanos = consumer_wait_time_nanos;
+  state.last_update_nanos = now_nanos;
+
+  int64 total_cpu_budget = 0;
+  int64 total_ram_budget = 0;
+  double total_weight = 0.0;
+  for (const auto& pair : models_) {
+    total_cpu_budget = std::max(total_cpu_budget, pair.second.cpu_budget);
+    total_ram_budget = std::max(total_ram_budget, pair.second.ram_budget);
+    total_weight += pair.second.weight;
+  }
+  const double even_share = 1.0 / models_.size();
+  double share = even_share;
+  if (total_weight > 0) {
+    share = kEvenShare * even_share +
+            (1.0 - kEvenShare) * state.weight / total_weight;
+  }
+  *cpu_budget = std::max<int64>(std::round(total_cpu_budget * share), 1);
+  *ram_budget = std::max<int64>(std::round(total_ram_budget * share), 1);
+  VLOG(2) << "Autotune coordinator assigned a " << share
+          << " share of the budgets to a model: CPU budget " << *cpu_budget
+          << ", RAM budget " << *ram_budget << ".";
+}
+
 }  // namespace model
 }  // namespace data
 }  // namespace tensorflow
@@ -621,6 +621,11 @@ std::shared_ptr<Node> MakeSourceNode(Node::Args args);
 // specified as a parameter, UnknownRatio estimates the ratio empirically.
 std::shared_ptr<Node> MakeUnknownRatioNode(Node::Args args);
 
+// Same as above, except that the node synchronously applies its function to
+// `parallelism` input elements at a time.
+std::shared_ptr<Node> MakeUnknownRatioNode(
+    Node::Args args, std::vector<std::shared_ptr<Parameter>> parameters);
+
 // Unknown nodes represent datasets for which we do not have a model. It acts
 // as pass-through between inputs and output.
 std::shared_ptr<Node> MakeUnknownNode(Node::Args args);
@@ -683,6 +688,16 @@ class Model {
   void Optimize(AutotuneAlgorithm algorithm, int64 cpu_budget, int64 ram_budget,
                 double model_input_time);
 
+  // Records that the consumer of the model's output spent `time_nanos`
+  // waiting for an element.
+  void RecordConsumerWaitTime(int64 time_nanos) {
+    consumer_wait_time_nanos_ += time_nanos;
+  }
+
+  // Returns the total time the consumer of the model's output has spent
+  // waiting for elements.
+  int64 consumer_wait_time_nanos() const { return consumer_wait_time_nanos_; }
+
   // Removes the given node.
   void RemoveNode(std::shared_ptr<Node> node) TF_LOCKS_EXCLUDED(mu_);
 
@@ -795,6 +810,10 @@ class Model {
   // the parameter) and never stops.
   std::atomic<bool> collect_resource_usage_;
 
+  // Total time the consumer of the model's output has spent waiting for
+  // elements. Used for sharing resource budgets between models.
+  std::atomic<int64> consumer_wait_time_nanos_{0};
+
   // Determines the time the optimization loop should wait between
   // running optimizations.
   int64 optimization_period_ms_ TF_GUARDED_BY(mu_);
@@ -819,6 +838,62 @@ class Model {
       TF_GUARDED_BY(mu_);
 };
 
+// Shares CPU and RAM budgets between the models of all input pipelines that
+// run in the same process, so that concurrently running pipelines (e.g. for
+// multi-task training or interleaved training and evaluation) do not each
+// tune themselves to use the entire machine.
+//
+// Models register with the coordinator for the duration of their optimization
+// loop. Before each optimization, a model asks the coordinator for its share
+// of the budgets. The shares are proportional to how much time the consumer
+// of each model spent waiting for elements since that model's previous
+// optimization, with a fraction of the budgets split evenly between all models
+// so that idle pipelines can still make progress when they become active.
+class AutotuneCoordinator {
+ public:
+  AutotuneCoordinator() = default;
+
+  // Returns the process-wide coordinator.
+  static AutotuneCoordinator* Global();
+
+  // Indicates whether the optimization loop of models should use the
+  // process-wide coordinator. Controlled by the
+  // `TF_DATA_AUTOTUNE_SHARED_BUDGETS` environment variable.
+  static bool Enabled();
+
+  // Registers `model` with the budgets it would use on its own. The budgets
+  // shared by all registered models are the largest registered budgets.
+  void Register(const Model* model, int64 cpu_budget, int64 ram_budget)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Unregisters `model`. It is a no-op if the model is not registered.
+  void Unregister(const Model* model) TF_LOCKS_EXCLUDED(mu_);
+
+  // Updates the weight of `model` based on the wait time of its consumer and
+  // stores its share of the shared budgets in `cpu_budget` and `ram_budget`.
+  // If `model` is not registered, the outputs are left unchanged.
+  void GetBudgets(const Model* model, int64* cpu_budget, int64* ram_budget)
+      TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  // Fraction of the budgets that is split evenly between all models,
+  // independent of their wait time.
+  static constexpr double kEvenShare = 0.2;
+
+  struct ModelState {
+    int64 cpu_budget;
+    int64 ram_budget;
+    int64 last_consumer_wait_time_nanos;
+    int64 last_update_nanos;
+    // Fraction of wall time the consumer of the model spent waiting for
+    // elements between the two most recent updates.
+    double weight = 0.0;
+  };
+
+  mutex mu_;
+  absl::flat_hash_map<const Model*, ModelState> models_ TF_GUARDED_BY(mu_);
+};
+
 }  // namespace model
 }  // namespace data
 }  // namespace tensorflow
@@ -348,6 +348,38 @@ TEST(UnknownRatioTest, Model) {
   EXPECT_EQ(unknown_many->OutputTime(&input_times, nullptr), 200);
 }
 
+TEST(UnknownRatioTest, ModelWithParallelism) {
+  const int64 parallelism = 4;
+  std::shared_ptr<Node> unknown_many = model::MakeUnknownRatioNode(
+      {0, "unknown_many", nullptr},
+      {model::MakeParameter("parallelism",
+                            std::make_shared<SharedState>(/*value=*/parallelism,
+                                                          nullptr, nullptr),
+                            /*min=*/1,
+                            /*max=*/16)});
+  std::shared_ptr<Node> source1 =
+      model::MakeSourceNode({1, "source1", unknown_many});
+  unknown_many->add_input(source1);
+  std::shared_ptr<Node> source2 =
+      model::MakeSourceNode({2, "source2", unknown_many});
+  unknown_many->add_input(source2);
+  absl::flat_hash_map<string, double> input_times;
+  input_times[kModelInputTimeKey] = 0.0;
+  unknown_many->add_processing_time(400);
+  unknown_many->record_element();
+  EXPECT_EQ(unknown_many->TotalProcessingTime(/*processing_times=*/nullptr),
+            400);
+  EXPECT_EQ(unknown_many->OutputTime(&input_times, nullptr), 400 / parallelism);
+  source1->add_processing_time(100);
+  source2->add_processing_time(200);
+  source1->record_element();
+  source2->record_element();
+  EXPECT_EQ(unknown_many->TotalProcessingTime(/*processing_times=*/nullptr),
+            700);
+  EXPECT_EQ(unknown_many->OutputTime(&input_times, nullptr),
+            400 / parallelism + 300);
+}
+
 TEST(UnknownTest, Model) {
   std::shared_ptr<Node> unknown =
       model::MakeUnknownNode({0, "unknown", nullptr});
@@ -812,6 +844,36 @@ TEST(UnknownRatioGradientTest, Model) {
               kComparisonPrecision);
 }
 
+TEST(UnknownRatioGradientTest, ModelWithParallelism) {
+  const double input_time = 100;
+  std::shared_ptr<Node> unknown_many = model::MakeUnknownRatioNode(
+      {0, "unknown_many", nullptr},
+      {model::MakeParameter("parallelism",
+                            std::make_shared<SharedState>(
+                                /*value=*/model::kAutotune, nullptr, nullptr),
+                            /*min=*/1,
+                            /*max=*/5)});
+  std::shared_ptr<Node> source =
+      model::MakeSourceNode({1, "source", unknown_many});
+  unknown_many->add_input(source);
+  unknown_many->record_element();
+  unknown_many->add_processing_time(300);
+  source->record_element();
+  source->add_processing_time(100);
+  absl::flat_hash_map<string, double> input_times;
+  input_times[kModelInputTimeKey] = input_time;
+  absl::flat_hash_map<string, std::shared_ptr<Parameter>> parameters;
+  absl::flat_hash_map<string, double> gradients;
+  unknown_many->CollectTunableParameters(&parameters);
+  parameters[unknown_many->long_name()]->value = 1;
+  double output_time = unknown_many->OutputTime(&input_times, &gradients);
+  parameters[unknown_many->long_name()]->value += kParameterStep;
+  double new_output_time = unknown_many->OutputTime(&input_times, nullptr);
+  EXPECT_NEAR(gradients[unknown_many->long_name()],
+              (new_output_time - output_time) / kParameterStep,
+              kComparisonPrecision);
+}
+
 TEST(UnknownGradientTest, Model) {
   const double input_time = 100;
   const int64 num_inputs_per_output = 2;
@@ -1161,6 +1223,83 @@ TEST(RecordTimeTest, RecordTimeTest) {
   EXPECT_FALSE(source->is_recording());
 }
 
+TEST(AutotuneCoordinatorTest, SingleModelUsesFullBudgets) {
+  AutotuneCoordinator coordinator;
+  Model model;
+  coordinator.Register(&model, /*cpu_budget=*/8, /*ram_budget=*/1000);
+  model.RecordConsumerWaitTime(100);
+  int64 cpu_budget = 0;
+  int64 ram_budget = 0;
+  coordinator.GetBudgets(&model, &cpu_budget, &ram_budget);
+  EXPECT_EQ(cpu_budget, 8);
+  EXPECT_EQ(ram_budget, 1000);
+}
+
+TEST(AutotuneCoordinatorTest, IdleModelsShareBudgetsEvenly) {
+  AutotuneCoordinator coordinator;
+  Model model_a;
+  Model model_b;
+  coordinator.Register(&model_a, /*cpu_budget=*/8, /*ram_budget=*/1000);
+  coordinator.Register(&model_b, /*cpu_budget=*/8, /*ram_budget=*/1000);
+  int64 cpu_budget = 0;
+  int64 ram_budget = 0;
+  coordinator.GetBudgets(&model_a, &cpu_budget, &ram_budget);
+  EXPECT_EQ(cpu_budget, 4);
+  EXPECT_EQ(ram_budget, 500);
+  coordinator.GetBudgets(&model_b, &cpu_budget, &ram_budget);
+  EXPECT_EQ(cpu_budget, 4);
+  EXPECT_EQ(ram_budget, 500);
+}
+
+TEST(AutotuneCoordinatorTest, WaitingModelGetsLargerShare) {
+  AutotuneCoordinator coordinator;
+  Model model_a;
+  Model model_b;
+  coordinator.Register(&model_a, /*cpu_budget=*/10, /*ram_budget=*/1000);
+  coordinator.Register(&model_b, /*cpu_budget=*/10, /*ram_budget=*/1000);
+  model_a.RecordConsumerWaitTime(1000);
+  int64 cpu_budget = 0;
+  int64 ram_budget = 0;
+  // Only the consumer of `model_a` waited, so it gets all of the budgets
+  // except for `model_b`'s part of the evenly split share.
+  coordinator.GetBudgets(&model_a, &cpu_budget, &ram_budget);
+  EXPECT_EQ(cpu_budget, 9);
+  EXPECT_EQ(ram_budget, 900);
+  coordinator.GetBudgets(&model_b, &cpu_budget, &ram_budget);
+  EXPECT_EQ(cpu_budget, 1);
+  EXPECT_EQ(ram_budget, 100);
+}
+
+TEST(AutotuneCoordinatorTest, SharedBudgetsUseLargestRegisteredBudgets) {
+  AutotuneCoordinator coordinator;
+  Model model_a;
+  Model model_b;
+  coordinator.Register(&model_a, /*cpu_budget=*/4, /*ram_budget=*/2000);
+  coordinator.Register(&model_b, /*cpu_budget=*/8, /*ram_budget=*/1000);
+  int64 cpu_budget = 0;
+  int64 ram_budget = 0;
+  coordinator.GetBudgets(&model_a, &cpu_budget, &ram_budget);
+  EXPECT_EQ(cpu_budget, 4);
+  EXPECT_EQ(ram_budget, 1000);
+}
+
+TEST(AutotuneCoordinatorTest, UnregisteredModelKeepsBudgets) {
+  AutotuneCoordinator coordinator;
+  Model model_a;
+  Model model_b;
+  coordinator.Register(&model_a, /*cpu_budget=*/8, /*ram_budget=*/1000);
+  coordinator.Register(&model_b, /*cpu_budget=*/8, /*ram_budget=*/1000);
+  coordinator.Unregister(&model_b);
+  int64 cpu_budget = 3;
+  int64 ram_budget = 300;
+  coordinator.GetBudgets(&model_b, &cpu_budget, &ram_budget);
+  EXPECT_EQ(cpu_budget, 3);
+  EXPECT_EQ(ram_budget, 300);
+  coordinator.GetBudgets(&model_a, &cpu_budget, &ram_budget);
+  EXPECT_EQ(cpu_budget, 8);
+  EXPECT_EQ(ram_budget, 1000);
+}
+
 }  // namespace
 }  // namespace model
 }  // namespace data
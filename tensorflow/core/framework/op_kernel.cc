@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/attr_value_util.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
+#include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/kernel_def.pb.h"
 #include "tensorflow/core/framework/kernel_def_util.h"
@@ -706,7 +707,13 @@ Status OpKernelContext::allocate_output(StringPiece name,
 Status OpKernelContext::allocate_tensor(
     DataType type, const TensorShape& shape, Tensor* out_tensor,
     AllocatorAttributes attr, const AllocationAttributes& allocation_attr) {
-  Allocator* a = get_allocator(attr);
+  return allocate_tensor(get_allocator(attr), type, shape, out_tensor,
+                         allocation_attr);
+}
+
+Status OpKernelContext::allocate_tensor(
+    Allocator* a, DataType type, const TensorShape& shape, Tensor* out_tensor,
+    const AllocationAttributes& allocation_attr) {
   Tensor new_tensor(
       a, type, shape,
       AllocationAttributes(
@@ -727,6 +734,19 @@ Status OpKernelContext::allocate_tensor(
   return Status::OK();
 }
 
+Allocator* OpKernelContext::get_step_local_allocator(
+    AllocatorAttributes attr) {
+  // Scoped allocations have their own backing buffer, allocations that other
+  // devices access need the device allocator, and tracked allocations must go
+  // through the tracking allocator of `get_allocator()`.
+  if (params_->step_local_allocator == nullptr || attr.scope_id > 0 ||
+      attr.gpu_compatible() || attr.nic_compatible() ||
+      track_allocations()) {
+    return get_allocator(attr);
+  }
+  return params_->step_local_allocator;
+}
+
 Status OpKernelContext::allocate_output(int index, const TensorShape& shape,
                                         Tensor** output,
                                         AllocatorAttributes attr) {
@@ -764,7 +784,18 @@ Status OpKernelContext::allocate_output(int index, const TensorShape& shape,
   ScopedMemoryDebugAnnotation op_annotation(op_kernel().name_view().data(),
                                             step_id(), "output", type, &shape);
   auto output_tensor = MakeUnique<Tensor>();
-  Status s = allocate_tensor(type, shape, output_tensor.get(), attr);
+  if (params_->output_retval_index_array != nullptr &&
+      params_->output_retval_index_array[index] >= 0 && attr.scope_id == 0 &&
+      params_->call_frame != nullptr &&
+      params_->call_frame->TakeRetvalBuffer(
+          params_->output_retval_index_array[index], type, shape,
+          output_tensor.get())) {
+    outputs_[index] = TensorValue(output_tensor.release());
+    *output = outputs_[index].tensor;
+    return Status::OK();
+  }
+  Status s = allocate_tensor(get_step_local_allocator(attr), type, shape,
+                             output_tensor.get(), AllocationAttributes());
   if (s.ok()) {
     outputs_[index] = TensorValue(output_tensor.release());
     *output = outputs_[index].tensor;
@@ -794,8 +825,8 @@ Status OpKernelContext::allocate_temp(
   }
   ScopedMemoryDebugAnnotation op_annotation(op_kernel().name_view().data(),
                                             step_id(), "temp", type, &shape);
-  Status s =
-      allocate_tensor(type, shape, out_temp, allocator_attr, allocation_attr);
+  Status s = allocate_tensor(get_step_local_allocator(allocator_attr), type,
+                             shape, out_temp, allocation_attr);
   if (track_allocations() && s.ok() && out_temp->TotalBytes() > 0) {
     Allocator* a = get_allocator(allocator_attr);
     if (a->TracksAllocationSizes()) {
@@ -707,6 +707,16 @@ class OpKernelContext {
     // For implementing `OpKernelContext::output_required()`. If null, all
     // outputs are required.
     bool* outputs_required_array = nullptr;
+
+    // If non-null, contains the index of the `call_frame` return value that
+    // each output is returned as, or -1. allocate_output() asks `call_frame`
+    // for the buffer of those outputs before allocating one.
+    const int* output_retval_index_array = nullptr;
+
+    // If non-null, allocate_output() and allocate_temp() serve tensors from
+    // this allocator rather than the device allocator. The executor only sets
+    // it for kernels whose outputs and temporaries cannot outlive the step.
+    Allocator* step_local_allocator = nullptr;
   };
 
   // params must outlive the OpKernelContext.
@@ -1284,6 +1294,14 @@ class OpKernelContext {
                          Tensor* out_tensor, AllocatorAttributes allocator_attr,
                          const AllocationAttributes& allocation_attr);
 
+  Status allocate_tensor(Allocator* a, DataType type, const TensorShape& shape,
+                         Tensor* out_tensor,
+                         const AllocationAttributes& allocation_attr);
+
+  // Returns `params_->step_local_allocator` if it is set and can serve
+  // tensors with `attr`, and `get_allocator(attr)` otherwise.
+  Allocator* get_step_local_allocator(AllocatorAttributes attr);
+
   // Helpers for `set_output()`.
 
   // Returns `true` if the tensor was copied into an allocated output.
@@ -18,11 +18,13 @@ limitations under the License.
 #include "tensorflow/core/framework/run_handler.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <list>
 #include <memory>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/run_handler_util.h"
 #include "tensorflow/core/lib/core/threadpool_interface.h"
 #include "tensorflow/core/lib/strings/strcat.h"
@@ -131,6 +133,9 @@ ThreadWorkSource::ThreadWorkSource()
       blocking_inflight_(0),
       non_blocking_inflight_(0),
       traceme_id_(0),
+      priority_(0),
+      start_time_us_(0),
+      queueing_delay_recorded_(true),
       version_(0),
       sub_thread_pool_waiter_(nullptr) {
   queue_waiters_.next = &queue_waiters_;
@@ -260,6 +265,23 @@ int64 ThreadWorkSource::GetTracemeId() {
 
 void ThreadWorkSource::SetTracemeId(int64 value) { traceme_id_ = value; }
 
+void ThreadWorkSource::ResetQueueingDelay(int64 priority,
+                                          uint64 start_time_us) {
+  priority_ = priority;
+  start_time_us_ = start_time_us;
+  queueing_delay_recorded_.store(false, std::memory_order_release);
+}
+
+void ThreadWorkSource::MaybeRecordQueueingDelay() {
+  if (queueing_delay_recorded_.load(std::memory_order_acquire) ||
+      queueing_delay_recorded_.exchange(true, std::memory_order_acq_rel)) {
+    return;
+  }
+  const uint64 now = EnvTime::NowMicros();
+  metrics::RecordRunHandlerQueueingDelay(
+      priority_, now > start_time_us_ ? now - start_time_us_ : 0);
+}
+
 void ThreadWorkSource::SetWaiter(uint64 version, Waiter* waiter, mutex* mutex) {
   {
     tf_shared_lock lock(run_handler_waiter_mu_);
@@ -388,6 +410,9 @@ void RunHandlerThreadPool::AddWorkToQueue(ThreadWorkSource* tws,
   if (t.f) {
     VLOG(3) << "Running " << (is_blocking ? "inter" : "intra") << " work for "
             << tws->GetTracemeId();
+    if (is_blocking) {
+      tws->MaybeRecordQueueingDelay();
+    }
     env_.ExecuteTask(t);
   }
 }
@@ -624,6 +649,9 @@ void RunHandlerThreadPool::WorkerLoop(int thread_id,
           profiler::TraceMeLevel::kInfo);
       VLOG(2) << "Running " << (task_from_blocking_queue ? "inter" : "intra")
               << " work from " << tws->GetTracemeId();
+      if (task_from_blocking_queue) {
+        tws->MaybeRecordQueueingDelay();
+      }
       tws->IncrementInflightTaskCount(task_from_blocking_queue);
       env_.ExecuteTask(t);
       tws->DecrementInflightTaskCount(task_from_blocking_queue);
@@ -728,6 +756,9 @@ class RunHandler::Impl {
   // Stores now time (in microseconds) since unix epoch when the handler is
   // requested via RunHandlerPool::Get().
   uint64 start_time_us() const { return start_time_us_; }
+  // Time (in microseconds) since unix epoch by which the request should
+  // finish, or kuint64max if it has no deadline.
+  uint64 deadline_us() const { return deadline_us_; }
   int64 step_id() const { return step_id_; }
   void ScheduleInterOpClosure(std::function<void()> fn);
   void ScheduleIntraOpClosure(std::function<void()> fn);
@@ -739,7 +770,15 @@ class RunHandler::Impl {
 
   internal::ThreadWorkSource* tws() { return &tws_; }
 
-  int64 priority() { return options_.priority(); }
+  int64 priority() const { return options_.priority(); }
+
+  // Returns true if the work of this handler should be stolen before the work
+  // of `other`, which was obtained earlier.
+  bool ScheduleBefore(const Impl& other) const {
+    return priority() > other.priority() ||
+           (priority() == other.priority() &&
+            deadline_us() < other.deadline_us());
+  }
 
  private:
   class ThreadPoolInterfaceWrapper : public thread::ThreadPoolInterface {
@@ -757,6 +796,7 @@ class RunHandler::Impl {
 
   RunHandlerPool::Impl* pool_impl_;  // NOT OWNED.
   uint64 start_time_us_;
+  uint64 deadline_us_;
   int64 step_id_;
   std::unique_ptr<thread::ThreadPoolInterface> thread_pool_interface_;
   internal::ThreadWorkSource tws_;
@@ -808,6 +848,14 @@ class RunHandlerPool::Impl {
     DCHECK_EQ(handlers_.size(), max_handlers_);
     DCHECK_EQ(free_handlers_.size(), handlers_.size());
     DCHECK_EQ(sorted_active_handlers_.size(), 0);
+    std::unique_ptr<Thread> deadline_thread;
+    {
+      mutex_lock l(mu_);
+      stop_deadline_thread_ = true;
+      deadline_thread = std::move(deadline_thread_);
+    }
+    deadline_cv_.notify_all();
+    deadline_thread.reset();
     // Stop the threads in run_handler_thread_pool_ before freeing other
     // pointers. Otherwise a thread may try to access a pointer after the
     // pointer has been freed.
@@ -854,28 +902,30 @@ class RunHandlerPool::Impl {
           return nullptr;
         }
       }
-      // Remove the last entry from free_handlers_ and add to the end of
-      // sorted_active_handlers_.
+      // Remove the last entry from free_handlers_ and insert it into
+      // sorted_active_handlers_, after all handlers that should be scheduled
+      // before it.
       handler_impl = free_handlers_.back();
       handler_impl->Reset(step_id, options);
       free_handlers_.pop_back();
-
-      num_active_requests = sorted_active_handlers_.size() + 1;
-      thread_work_sources->resize(num_active_requests);
-      int priority = options.priority();
-      auto it = sorted_active_handlers_.cbegin();
-      bool new_handler_inserted = false;
-      for (int i = 0; i < num_active_requests; ++i) {
-        if (!new_handler_inserted && (it == sorted_active_handlers_.cend() ||
-                                      priority > (*it)->priority())) {
-          sorted_active_handlers_.insert(it, handler_impl);
-          new_handler_inserted = true;
-          // Point to the newly added handler.
-          --it;
+      auto it = std::find_if(sorted_active_handlers_.cbegin(),
+                             sorted_active_handlers_.cend(),
+                             [handler_impl](const RunHandler::Impl* other) {
+                               return handler_impl->ScheduleBefore(*other);
+                             });
+      sorted_active_handlers_.insert(it, handler_impl);
+      if (handler_impl->deadline_us() != kuint64max) {
+        if (deadline_thread_ == nullptr) {
+          deadline_thread_.reset(Env::Default()->StartThread(
+              ThreadOptions(), "tf_run_handler_deadlines",
+              [this]() { DeadlineLoop(); }));
         }
-        (*thread_work_sources)[i] = (*it)->tws();
-        ++it;
+        // The new deadline may be earlier than the one being waited for.
+        deadline_cv_.notify_all();
       }
+
+      num_active_requests = ComputeThreadWorkSources(
+          handler_impl->start_time_us(), thread_work_sources.get());
       version = ++version_;
     }
     RecomputePoolStats(num_active_requests, version, *thread_work_sources);
@@ -923,7 +973,37 @@ class RunHandlerPool::Impl {
     return ret;
   }
 
+  std::vector<int64> GetActiveHandlerStepIdsForTesting()
+      TF_LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    std::vector<int64> ret;
+    for (const auto& handler_impl : sorted_active_handlers_) {
+      ret.push_back(handler_impl->step_id());
+    }
+    return ret;
+  }
+
+  std::vector<int64> GetThreadWorkSourceStepIdsForTesting()
+      TF_LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    return thread_work_source_step_ids_;
+  }
+
  private:
+  // Orders the thread work sources of the active handlers as in
+  // sorted_active_handlers_, except that requests whose deadline is before
+  // `now_us` are deprioritized: their work is only stolen after the work of
+  // all other requests. Returns the number of active requests.
+  int ComputeThreadWorkSources(
+      uint64 now_us,
+      Eigen::MaxSizeVector<internal::ThreadWorkSource*>* thread_work_sources)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Recomputes the thread work sources whenever the deadline of an active
+  // request passes, so that late requests are deprioritized even if no new
+  // request calls Get().
+  void DeadlineLoop() TF_LOCKS_EXCLUDED(mu_);
+
   void RecomputePoolStats(
       int num_active_requests, uint64 version,
       const Eigen::MaxSizeVector<internal::ThreadWorkSource*>&
@@ -942,8 +1022,7 @@ class RunHandlerPool::Impl {
 
   std::unique_ptr<internal::RunHandlerThreadPool> run_handler_thread_pool_;
   // Thread compatible part used only by lock under RunHandlerPool.
-  // Handlers are sorted by start time.
-  // TODO(azaks): sort by the remaining latency budget.
+  // Handlers are sorted by priority, then deadline, then start time.
   // TODO(chaox): Consider other data structure for maintaining the sorted
   // active handlers if the searching overhead(currently O(n)) becomes the
   // bottleneck.
@@ -958,8 +1037,80 @@ class RunHandlerPool::Impl {
   mutex mu_;
   int64 version_ TF_GUARDED_BY(mu_);
   const std::vector<double> sub_thread_pool_end_request_percentage_;
+
+  // The step ids of the last computed thread work sources, in order.
+  std::vector<int64> thread_work_source_step_ids_ TF_GUARDED_BY(mu_);
+  // Runs DeadlineLoop(). Started by the first request with a deadline.
+  std::unique_ptr<Thread> deadline_thread_ TF_GUARDED_BY(mu_);
+  condition_variable deadline_cv_;
+  bool stop_deadline_thread_ TF_GUARDED_BY(mu_) = false;
 };
 
+int RunHandlerPool::Impl::ComputeThreadWorkSources(
+    uint64 now_us,
+    Eigen::MaxSizeVector<internal::ThreadWorkSource*>* thread_work_sources) {
+  const int num_active_requests = sorted_active_handlers_.size();
+  thread_work_sources->resize(num_active_requests);
+  thread_work_source_step_ids_.clear();
+  int i = 0;
+  for (RunHandler::Impl* active_handler : sorted_active_handlers_) {
+    if (active_handler->deadline_us() >= now_us) {
+      (*thread_work_sources)[i++] = active_handler->tws();
+      thread_work_source_step_ids_.push_back(active_handler->step_id());
+    }
+  }
+  for (RunHandler::Impl* active_handler : sorted_active_handlers_) {
+    if (active_handler->deadline_us() < now_us) {
+      (*thread_work_sources)[i++] = active_handler->tws();
+      thread_work_source_step_ids_.push_back(active_handler->step_id());
+    }
+  }
+  return num_active_requests;
+}
+
+void RunHandlerPool::Impl::DeadlineLoop() {
+  Eigen::MaxSizeVector<internal::ThreadWorkSource*> thread_work_sources(
+      max_handlers_);
+  uint64 last_check_us = Env::Default()->NowMicros();
+  while (true) {
+    uint64 version;
+    int num_active_requests;
+    {
+      mutex_lock l(mu_);
+      uint64 now;
+      while (true) {
+        if (stop_deadline_thread_) {
+          return;
+        }
+        now = Env::Default()->NowMicros();
+        bool deadline_passed = false;
+        uint64 next_deadline_us = kuint64max;
+        for (const RunHandler::Impl* active_handler : sorted_active_handlers_) {
+          const uint64 deadline_us = active_handler->deadline_us();
+          if (deadline_us < now) {
+            deadline_passed |= deadline_us >= last_check_us;
+          } else {
+            next_deadline_us = std::min(next_deadline_us, deadline_us);
+          }
+        }
+        last_check_us = now;
+        if (deadline_passed) {
+          break;
+        }
+        if (next_deadline_us == kuint64max) {
+          deadline_cv_.wait(l);
+        } else {
+          deadline_cv_.wait_for(
+              l, std::chrono::microseconds(next_deadline_us - now + 1));
+        }
+      }
+      num_active_requests = ComputeThreadWorkSources(now, &thread_work_sources);
+      version = ++version_;
+    }
+    RecomputePoolStats(num_active_requests, version, thread_work_sources);
+  }
+}
+
 void RunHandlerPool::Impl::RecomputePoolStats(
     int num_active_requests, uint64 version,
     const Eigen::MaxSizeVector<internal::ThreadWorkSource*>&
@@ -1067,9 +1218,18 @@ void RunHandler::Impl::Reset(
     int64 step_id,
     const RunOptions::Experimental::RunHandlerPoolOptions& options) {
   start_time_us_ = tensorflow::Env::Default()->NowMicros();
+  deadline_us_ = kuint64max;
+  if (options.deadline_in_ms() > 0) {
+    // Deadlines too far in the future to be represented are ignored.
+    const uint64 deadline_in_ms = options.deadline_in_ms();
+    if (deadline_in_ms < (kuint64max - start_time_us_) / 1000) {
+      deadline_us_ = start_time_us_ + deadline_in_ms * 1000;
+    }
+  }
   step_id_ = step_id;
   options_ = options;
   tws_.SetTracemeId(step_id);
+  tws_.ResetQueueingDelay(options.priority(), start_time_us_);
 }
 
 RunHandlerPool::RunHandlerPool(int num_inter_op_threads)
@@ -1092,6 +1252,15 @@ std::vector<int64> RunHandlerPool::GetActiveHandlerPrioritiesForTesting()
   return impl_->GetActiveHandlerPrioritiesForTesting();
 }
 
+std::vector<int64> RunHandlerPool::GetActiveHandlerStepIdsForTesting() const {
+  return impl_->GetActiveHandlerStepIdsForTesting();
+}
+
+std::vector<int64> RunHandlerPool::GetThreadWorkSourceStepIdsForTesting()
+    const {
+  return impl_->GetThreadWorkSourceStepIdsForTesting();
+}
+
 RunHandler::RunHandler(Impl* impl) : impl_(impl) {}
 
 void RunHandler::ScheduleInterOpClosure(std::function<void()> fn) {
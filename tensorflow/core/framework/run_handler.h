@@ -72,6 +72,14 @@ class RunHandlerPool {
   // order of the active handler list.
   std::vector<int64> GetActiveHandlerPrioritiesForTesting() const;
 
+  // Get the step ids for active handlers, in the order of the active handler
+  // list.
+  std::vector<int64> GetActiveHandlerStepIdsForTesting() const;
+
+  // Get the step ids of the thread work sources in the order in which their
+  // work was last handed to the threads of the pool.
+  std::vector<int64> GetThreadWorkSourceStepIdsForTesting() const;
+
  private:
   class Impl;
   friend class RunHandler;
@@ -82,7 +90,9 @@ class RunHandlerPool {
 // RunHandler can be used to schedule inter/intra-op closures to run on a global
 // pool shared across all Session::Run(s). The closures are enqueued to a
 // handler specific queue, from which the work is stolen in a priority order
-// (time of the Get() call).
+// (the priority of the request, then its deadline, then the time of the Get()
+// call). Handlers whose deadline has passed are stolen from last, from the
+// moment the deadline passes.
 //
 // It can only be created via RunHandlerPool::Get().
 //
@@ -173,6 +183,14 @@ class ThreadWorkSource {
 
   void SetTracemeId(int64 value);
 
+  // Resets the state used to record the queueing delay of a new request with
+  // the given `priority`, which obtained its handler at `start_time_us`.
+  void ResetQueueingDelay(int64 priority, uint64 start_time_us);
+
+  // Records the time since `start_time_us` in the queueing delay metric, if
+  // this is the first inter-op closure of the request to run.
+  void MaybeRecordQueueingDelay();
+
   void SetWaiter(uint64 version, Waiter* waiter, mutex* mutex);
 
   int64 GetInflightTaskCount(bool is_blocking);
@@ -205,6 +223,11 @@ class ThreadWorkSource {
   Waiter queue_waiters_ TF_GUARDED_BY(waiters_mu_);
   std::atomic<int64> traceme_id_;
 
+  // Only written while no tasks of the request are queued.
+  int64 priority_;
+  uint64 start_time_us_;
+  std::atomic<bool> queueing_delay_recorded_;
+
   mutex run_handler_waiter_mu_;
   uint64 version_ TF_GUARDED_BY(run_handler_waiter_mu_);
   mutex* sub_thread_pool_waiter_mu_ TF_GUARDED_BY(run_handler_waiter_mu_);
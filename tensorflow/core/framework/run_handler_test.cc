@@ -29,6 +29,8 @@ limitations under the License.
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/testlib.h"
 #include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/monitoring/collected_metrics.h"
+#include "tensorflow/core/lib/monitoring/collection_registry.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
@@ -113,6 +115,136 @@ TEST(RunHandlerUtilTest, PrioritySchedulingTest) {
   EXPECT_EQ(sorted_active_list[3], 1);
 }
 
+TEST(RunHandlerUtilTest, DeadlineSchedulingTest) {
+  int num_threads = 2;
+  std::unique_ptr<RunHandlerPool> pool(
+      new RunHandlerPool(num_threads, num_threads));
+
+  RunOptions::Experimental::RunHandlerPoolOptions options =
+      RunOptions::Experimental::RunHandlerPoolOptions();
+  options.set_priority(1);
+  auto handler1 = pool->Get(/*step_id=*/1, /*timeout_in_ms=*/0, options);
+  options.set_deadline_in_ms(100000);
+  auto handler2 = pool->Get(/*step_id=*/2, /*timeout_in_ms=*/0, options);
+  options.set_deadline_in_ms(1000);
+  auto handler3 = pool->Get(/*step_id=*/3, /*timeout_in_ms=*/0, options);
+  options.set_deadline_in_ms(1000);
+  auto handler4 = pool->Get(/*step_id=*/4, /*timeout_in_ms=*/0, options);
+  // A higher priority takes precedence over an earlier deadline.
+  options.set_priority(2);
+  options.set_deadline_in_ms(0);
+  auto handler5 = pool->Get(/*step_id=*/5, /*timeout_in_ms=*/0, options);
+
+  // Requests with the same priority are ordered by deadline, and requests
+  // without a deadline come last.
+  std::vector<int64> sorted_step_ids =
+      pool->GetActiveHandlerStepIdsForTesting();
+  EXPECT_EQ(sorted_step_ids, std::vector<int64>({5, 3, 4, 2, 1}));
+}
+
+TEST(RunHandlerUtilTest, MissedDeadlineIsDemotedOnGet) {
+  int num_threads = 2;
+  std::unique_ptr<RunHandlerPool> pool(
+      new RunHandlerPool(num_threads, num_threads));
+
+  RunOptions::Experimental::RunHandlerPoolOptions options;
+  options.set_deadline_in_ms(200);
+  auto handler1 = pool->Get(/*step_id=*/1, /*timeout_in_ms=*/0, options);
+  options.set_deadline_in_ms(0);
+  auto handler2 = pool->Get(/*step_id=*/2, /*timeout_in_ms=*/0, options);
+  EXPECT_EQ(pool->GetThreadWorkSourceStepIdsForTesting(),
+            std::vector<int64>({1, 2}));
+
+  Env::Default()->SleepForMicroseconds(300 * 1000);
+  auto handler3 = pool->Get(/*step_id=*/3, /*timeout_in_ms=*/0, options);
+  // The late request keeps its place among the active handlers, but its work
+  // is stolen last.
+  EXPECT_EQ(pool->GetActiveHandlerStepIdsForTesting(),
+            std::vector<int64>({1, 2, 3}));
+  EXPECT_EQ(pool->GetThreadWorkSourceStepIdsForTesting(),
+            std::vector<int64>({2, 3, 1}));
+}
+
+TEST(RunHandlerUtilTest, MissedDeadlineIsDemotedWithoutNewRequests) {
+  int num_threads = 2;
+  std::unique_ptr<RunHandlerPool> pool(
+      new RunHandlerPool(num_threads, num_threads));
+
+  RunOptions::Experimental::RunHandlerPoolOptions options;
+  options.set_deadline_in_ms(100);
+  auto handler1 = pool->Get(/*step_id=*/1, /*timeout_in_ms=*/0, options);
+  options.set_deadline_in_ms(0);
+  auto handler2 = pool->Get(/*step_id=*/2, /*timeout_in_ms=*/0, options);
+
+  // The thread work sources are recomputed once the deadline passes.
+  const std::vector<int64> demoted({2, 1});
+  for (int i = 0; i < 1000; ++i) {
+    if (pool->GetThreadWorkSourceStepIdsForTesting() == demoted) {
+      break;
+    }
+    Env::Default()->SleepForMicroseconds(10 * 1000);
+  }
+  EXPECT_EQ(pool->GetThreadWorkSourceStepIdsForTesting(), demoted);
+}
+
+TEST(RunHandlerUtilTest, OverflowingDeadlineIsIgnored) {
+  int num_threads = 2;
+  std::unique_ptr<RunHandlerPool> pool(
+      new RunHandlerPool(num_threads, num_threads));
+
+  RunOptions::Experimental::RunHandlerPoolOptions options;
+  auto handler1 = pool->Get(/*step_id=*/1, /*timeout_in_ms=*/0, options);
+  options.set_deadline_in_ms(kint64max);
+  auto handler2 = pool->Get(/*step_id=*/2, /*timeout_in_ms=*/0, options);
+  options.set_deadline_in_ms(0);
+  auto handler3 = pool->Get(/*step_id=*/3, /*timeout_in_ms=*/0, options);
+
+  // A deadline that does not fit in microseconds counts as no deadline, rather
+  // than wrapping around into the past.
+  EXPECT_EQ(pool->GetThreadWorkSourceStepIdsForTesting(),
+            std::vector<int64>({1, 2, 3}));
+}
+
+// Returns the number of queueing delays recorded for requests with `priority`.
+int64 NumQueueingDelaySamples(int64 priority) {
+  std::unique_ptr<monitoring::CollectedMetrics> collected_metrics =
+      monitoring::CollectionRegistry::Default()->CollectMetrics(
+          monitoring::CollectionRegistry::CollectMetricsOptions());
+  auto it = collected_metrics->point_set_map.find(
+      "/tensorflow/core/run_handler_queueing_delay_usecs_histogram");
+  if (it == collected_metrics->point_set_map.end()) {
+    return 0;
+  }
+  for (const auto& point : it->second->points) {
+    if (point->labels.size() == 1 &&
+        point->labels[0].value == strings::StrCat(priority)) {
+      return point->histogram_value.num();
+    }
+  }
+  return 0;
+}
+
+TEST(RunHandlerUtilTest, RecordsQueueingDelayOnce) {
+  // No other test uses this priority.
+  constexpr int64 kPriority = 17;
+  const int64 initial_num_samples = NumQueueingDelaySamples(kPriority);
+
+  int num_threads = 2;
+  std::unique_ptr<RunHandlerPool> pool(
+      new RunHandlerPool(num_threads, num_threads));
+  RunOptions::Experimental::RunHandlerPoolOptions options;
+  options.set_priority(kPriority);
+  auto handler = pool->Get(/*step_id=*/1, /*timeout_in_ms=*/0, options);
+  BlockingCounter counter(2);
+  for (int i = 0; i < 2; ++i) {
+    handler->ScheduleInterOpClosure([&counter]() { counter.DecrementCount(); });
+  }
+  counter.Wait();
+
+  // Only the first inter-op closure of the request is counted.
+  EXPECT_EQ(NumQueueingDelaySamples(kPriority), initial_num_samples + 1);
+}
+
 TEST(RunHandlerThreadPool, EnqueueTask) {
   Eigen::MaxSizeVector<mutex> waiters_mu(2);
   waiters_mu.resize(2);
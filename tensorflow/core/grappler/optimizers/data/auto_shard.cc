@@ -71,7 +71,7 @@ constexpr std::array<const char*, 2> kMultipleInputsDatasetOps = {
     "ZipDataset"
 };
 
-constexpr std::array<const char*, 28> kPassThroughOps = {
+constexpr std::array<const char*, 29> kPassThroughOps = {
     "_Retval",
     "AssertNextDataset",
     "BatchDataset",
@@ -85,6 +85,7 @@ constexpr std::array<const char*, 28> kPassThroughOps = {
     "MapDataset",
     "MaxIntraOpParallelismDataset",
     "ModelDataset",
+    "NumaAwareDataset",
     "OptimizeDataset",
     "PaddedBatchDataset",
     "ParallelMapDataset",
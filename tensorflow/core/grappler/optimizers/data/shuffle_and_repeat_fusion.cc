@@ -42,6 +42,7 @@ constexpr char kShuffleAndRepeatDatasetV2[] = "ShuffleAndRepeatDatasetV2";
 constexpr char kOutputShapes[] = "output_shapes";
 constexpr char kOutputTypes[] = "output_types";
 constexpr char kReshuffleEachIteration[] = "reshuffle_each_iteration";
+constexpr char kMaxBufferBytes[] = "max_buffer_bytes";
 
 Status FuseShuffleV1AndRepeat(const NodeDef& shuffle_node,
                               const NodeDef& repeat_node,
@@ -175,6 +176,11 @@ Status ShuffleAndRepeatFusion::OptimizeAndCollectStats(
                                                 &graph, output, &fused_node));
 
     } else if (shuffle_node.op() == kShuffleDatasetV3) {
+      // The fused op does not support a memory budget for its buffer.
+      auto it = shuffle_node.attr().find(kMaxBufferBytes);
+      if (it != shuffle_node.attr().end() && it->second.i() > 0) {
+        continue;
+      }
       TF_RETURN_IF_ERROR(FuseShuffleV3AndRepeat(shuffle_node, repeat_node,
                                                 &graph, output, &fused_node));
     } else {
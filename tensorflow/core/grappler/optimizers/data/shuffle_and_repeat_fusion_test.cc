@@ -28,6 +28,7 @@ namespace {
 constexpr char kOutputShapes[] = "output_shapes";
 constexpr char kOutputTypes[] = "output_types";
 constexpr char kReshuffleEachIteration[] = "reshuffle_each_iteration";
+constexpr char kMaxBufferBytes[] = "max_buffer_bytes";
 
 TEST(ShuffleAndRepeatFusionTest, FuseShuffleV1AndRepeat) {
   GrapplerItem item;
@@ -234,6 +235,60 @@ TEST(ShuffleAndRepeatFusionTest, FuseShuffleV3AndRepeat) {
   }
 }
 
+TEST(ShuffleAndRepeatFusionTest, NoFusionWithMemoryBudget) {
+  GrapplerItem item;
+  MutableGraphView graph(&item.graph);
+
+  std::vector<std::pair<string, AttrValue>> common_attrs(2);
+  AttrValue shapes_attr;
+  SetAttrValue(kOutputShapes, &shapes_attr);
+  common_attrs[0] = std::make_pair(kOutputShapes, shapes_attr);
+  AttrValue types_attr;
+  SetAttrValue(kOutputTypes, &types_attr);
+  common_attrs[1] = std::make_pair(kOutputTypes, types_attr);
+
+  NodeDef *start_node = graph_utils::AddScalarConstNode<int64>(0, &graph);
+  NodeDef *stop_node = graph_utils::AddScalarConstNode<int64>(10, &graph);
+  NodeDef *step_node = graph_utils::AddScalarConstNode<int64>(1, &graph);
+
+  std::vector<string> range_inputs(3);
+  range_inputs[0] = start_node->name();
+  range_inputs[1] = stop_node->name();
+  range_inputs[2] = step_node->name();
+  NodeDef *range_node = graph_utils::AddNode("", "RangeDataset", range_inputs,
+                                             common_attrs, &graph);
+
+  NodeDef *buffer_size_node =
+      graph_utils::AddScalarConstNode<int64>(128, &graph);
+  NodeDef *seed_node = graph_utils::AddScalarConstNode<int64>(-1, &graph);
+  NodeDef *seed2_node = graph_utils::AddScalarConstNode<int64>(-1, &graph);
+  NodeDef *seed_generator_node =
+      graph_utils::AddScalarConstNode<StringPiece>("dummy_resource", &graph);
+  std::vector<string> shuffle_inputs(5);
+  shuffle_inputs[0] = range_node->name();
+  shuffle_inputs[1] = buffer_size_node->name();
+  shuffle_inputs[2] = seed_node->name();
+  shuffle_inputs[3] = seed2_node->name();
+  shuffle_inputs[4] = seed_generator_node->name();
+  NodeDef *shuffle_node = graph_utils::AddNode(
+      "", "ShuffleDatasetV3", shuffle_inputs, common_attrs, &graph);
+  (*shuffle_node->mutable_attr())[kReshuffleEachIteration].set_b(true);
+  (*shuffle_node->mutable_attr())[kMaxBufferBytes].set_i(1 << 20);
+
+  NodeDef *count_node = graph_utils::AddScalarConstNode<int64>(-1, &graph);
+  std::vector<string> repeat_inputs(2);
+  repeat_inputs[0] = shuffle_node->name();
+  repeat_inputs[1] = count_node->name();
+  graph_utils::AddNode("", "RepeatDataset", repeat_inputs, common_attrs,
+                       &graph);
+
+  ShuffleAndRepeatFusion optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_TRUE(graph_utils::Compare(*graph.graph(), output));
+}
+
 TEST(ShuffleAndRepeatFusionTest, NoChange) {
   GrapplerItem item;
   MutableGraphView graph(&item.graph);
@@ -50,7 +50,7 @@ bool IsDatasetNodeOfType(const NodeDef& node,
 constexpr std::array<const char*, 2> kMultipleInputsDatasetOps = {
     "ZipDataset", "ConcatenateDataset"};
 
-constexpr std::array<const char*, 22> kPassThroughOps = {
+constexpr std::array<const char*, 23> kPassThroughOps = {
     "CacheDataset",
     "CacheDatasetV2",
     "ExperimentalMaxIntraOpParallelismDataset",
@@ -60,6 +60,7 @@ constexpr std::array<const char*, 22> kPassThroughOps = {
     "MapDataset",
     "MaxIntraOpParallelismDataset",
     "ModelDataset",
+    "NumaAwareDataset",
     "OptimizeDataset",
     "ParallelMapDataset",
     "PrivateThreadPoolDataset",
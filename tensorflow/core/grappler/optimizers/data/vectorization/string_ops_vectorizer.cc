@@ -0,0 +1,103 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/grappler/optimizers/data/vectorization/vectorizer_registry.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+// Vectorizer for string ops that transform each string of their first input
+// independently, such as `StringLower` or `StringToNumber`. Any remaining
+// inputs (e.g. the pattern and rewrite of `RegexReplace`) are scalars that
+// configure the transformation, and must therefore be the same for every
+// element of the batch, i.e. unstacked. With that, the vectorized op is the
+// same as the original one, applied to the stacked strings.
+class StringOpVectorizer : public Vectorizer {
+ public:
+  Status Vectorize(const Node& node, Graph* outer_scope,
+                   VectorizerInput&& inputs,
+                   VectorizerOutput* outputs) override {
+    if (inputs.size() < 1) {
+      return errors::Internal("Failed to vectorize ", node.type_string(),
+                              ". The op should have at least 1 input, but has ",
+                              inputs.size());
+    }
+
+    NodeBuilder::NodeOut input;
+    TF_RETURN_IF_ERROR(inputs.stacked(0, &input));
+
+    std::vector<NodeBuilder::NodeOut> params;
+    params.resize(inputs.size() - 1);
+    for (size_t i = 1; i < inputs.size(); ++i) {
+      TF_RETURN_IF_ERROR(inputs.unstacked(i, &params[i - 1]));
+    }
+
+    Node* new_node;
+    auto node_builder = NodeBuilder(strings::StrCat("vectorized/", node.name()),
+                                    node.type_string())
+                            .Input(input);
+    for (const auto& param : params) {
+      node_builder = node_builder.Input(param);
+    }
+    for (const auto& attr : node.attrs()) {
+      node_builder = node_builder.Attr(attr.first, attr.second);
+    }
+    TF_RETURN_IF_ERROR(node_builder.Finalize(outer_scope, &new_node));
+
+    // Add output mappings
+    outputs->emplace_back(new_node, 0, true);
+    return Status::OK();
+  }
+};
+
+// String conversion ops
+REGISTER_VECTORIZER("AsString", StringOpVectorizer);
+REGISTER_VECTORIZER("DecodeBase64", StringOpVectorizer);
+REGISTER_VECTORIZER("EncodeBase64", StringOpVectorizer);
+REGISTER_VECTORIZER("StringToNumber", StringOpVectorizer);
+
+// String transformation ops
+REGISTER_VECTORIZER("StringLength", StringOpVectorizer);
+REGISTER_VECTORIZER("StringLower", StringOpVectorizer);
+REGISTER_VECTORIZER("StringStrip", StringOpVectorizer);
+REGISTER_VECTORIZER("StringUpper", StringOpVectorizer);
+
+// String hashing ops
+REGISTER_VECTORIZER("StringToHashBucket", StringOpVectorizer);
+REGISTER_VECTORIZER("StringToHashBucketFast", StringOpVectorizer);
+REGISTER_VECTORIZER("StringToHashBucketStrong", StringOpVectorizer);
+
+// Regular expression ops
+REGISTER_VECTORIZER("RegexFullMatch", StringOpVectorizer);
+REGISTER_VECTORIZER("RegexReplace", StringOpVectorizer);
+REGISTER_VECTORIZER("StaticRegexFullMatch", StringOpVectorizer);
+REGISTER_VECTORIZER("StaticRegexReplace", StringOpVectorizer);
+
+// TODO: Only element-wise string ops are vectorized so far. Map functions
+// that also decode images (`DecodeJpeg`, `DecodeAndCropJpeg`, `DecodePng`,
+// `DecodeImage`) or split strings into ragged outputs (`StringSplitV2`,
+// `UnicodeDecode`, `NgramsV2`) still fall back to `MapDefun` for those ops.
+// Image decoding can be vectorized when the map function resizes or crops to
+// a static shape right after decoding, by fusing the two into one batched
+// node. The ragged ops need the batch rewrite to support outputs with a
+// varying number of values per element, e.g. by emitting a values/row
+// splits pair like `RaggedTensor`.
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -200,7 +200,8 @@ class BatchDatasetOp::Dataset : public DatasetBase {
       // overload that supports zero-copy, and might make sense in an
       // optimization pass.
       TF_RETURN_IF_ERROR(CopyBatch(/*parallel_copy=*/dataset()->parallel_copy_,
-                                   ctx, out_tensors, &batch_elements));
+                                   /*shard_large_copies=*/true, ctx,
+                                   out_tensors, &batch_elements));
 
       *end_of_sequence = false;
       return Status::OK();
@@ -12,6 +12,8 @@ limitations under the License.
 #include "tensorflow/core/kernels/data/batch_dataset_op.h"
 
 #include "tensorflow/core/kernels/data/dataset_test_base.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 namespace data {
@@ -289,6 +291,94 @@ TEST_F(BatchDatasetOpTest, InvalidBatchSize) {
             tensorflow::error::INVALID_ARGUMENT);
 }
 
+// Batches elements that are large enough for the copy into the batch to be
+// sharded across the runner threadpool, even though `parallel_copy` is false.
+TEST_F(BatchDatasetOpTest, LargeElements) {
+  constexpr int64 kBatchSize = 8;
+  constexpr int64 kElementSize = 64 << 10;
+  Tensor components(DT_FLOAT, TensorShape({kBatchSize, kElementSize}));
+  test::FillIota<float>(&components, 0.0f);
+  auto batch_dataset_params = BatchDatasetParams(
+      TensorSliceDatasetParams(/*components=*/{components},
+                               /*node_name=*/"tensor_slice"),
+      /*batch_size=*/kBatchSize,
+      /*drop_remainder=*/false,
+      /*parallel_copy=*/false,
+      /*output_dtypes=*/{DT_FLOAT},
+      /*output_shapes=*/{PartialTensorShape({-1, kElementSize})},
+      /*node_name=*/kNodeName);
+  TF_ASSERT_OK(Initialize(batch_dataset_params));
+  std::vector<Tensor> out_tensors;
+  bool end_of_sequence = false;
+  TF_ASSERT_OK(
+      iterator_->GetNext(iterator_ctx_.get(), &out_tensors, &end_of_sequence));
+  ASSERT_FALSE(end_of_sequence);
+  ASSERT_EQ(out_tensors.size(), 1);
+  test::ExpectTensorEqual<float>(out_tensors[0], components);
+}
+
+// Measures the throughput of batching elements of `element_size` floats. The
+// input is a tensor slice dataset over exactly one batch worth of elements,
+// and a new iterator is created (untimed) for every batch.
+class BatchDatasetBenchmark : public DatasetOpsTestBase {
+ public:
+  void TestBody() override {}
+
+  void Run(::testing::benchmark::State& state, int64 batch_size,
+           int64 element_size, bool parallel_copy) {
+    thread_num_ = port::MaxParallelism();
+    Tensor components(DT_FLOAT, TensorShape({batch_size, element_size}));
+    components.flat<float>().setRandom();
+    auto dataset_params = BatchDatasetParams(
+        TensorSliceDatasetParams(/*components=*/{components},
+                                 /*node_name=*/"tensor_slice"),
+        /*batch_size=*/batch_size,
+        /*drop_remainder=*/true,
+        /*parallel_copy=*/parallel_copy,
+        /*output_dtypes=*/{DT_FLOAT},
+        /*output_shapes=*/{PartialTensorShape({batch_size, element_size})},
+        /*node_name=*/kNodeName);
+    TF_CHECK_OK(Initialize(dataset_params));
+    std::vector<Tensor> out_tensors;
+    bool end_of_sequence = false;
+    for (auto s : state) {
+      state.PauseTiming();
+      TF_CHECK_OK(dataset_->MakeIterator(
+          iterator_ctx_.get(), /*parent=*/nullptr,
+          dataset_params.iterator_prefix(), &iterator_));
+      state.ResumeTiming();
+      TF_CHECK_OK(iterator_->GetNext(iterator_ctx_.get(), &out_tensors,
+                                     &end_of_sequence));
+    }
+    state.SetBytesProcessed(state.iterations() * batch_size * element_size *
+                            sizeof(float));
+  }
+};
+
+void BM_Batch(::testing::benchmark::State& state) {
+  BatchDatasetBenchmark benchmark;
+  benchmark.Run(state, /*batch_size=*/state.range(0),
+                /*element_size=*/state.range(1), /*parallel_copy=*/false);
+}
+
+BENCHMARK(BM_Batch)
+    ->ArgPair(32, 1 << 10)
+    ->ArgPair(1024, 1 << 10)
+    ->ArgPair(1024, 16 << 10)
+    ->ArgPair(128, 256 << 10);
+
+void BM_BatchParallelCopy(::testing::benchmark::State& state) {
+  BatchDatasetBenchmark benchmark;
+  benchmark.Run(state, /*batch_size=*/state.range(0),
+                /*element_size=*/state.range(1), /*parallel_copy=*/true);
+}
+
+BENCHMARK(BM_BatchParallelCopy)
+    ->ArgPair(32, 1 << 10)
+    ->ArgPair(1024, 1 << 10)
+    ->ArgPair(1024, 16 << 10)
+    ->ArgPair(128, 256 << 10);
+
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/cache_dataset_ops.h"
 
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -57,6 +58,8 @@ constexpr char kCache[] = "cache";
 constexpr char kSizeSuffix[] = ".size";
 constexpr char kCacheCompleted[] = "cache_completed";
 constexpr char kIndex[] = "index";
+constexpr char kFollower[] = "follower";
+constexpr char kFallback[] = "fallback";
 constexpr char kImpl[] = "Impl";
 constexpr char kCacheDataset[] = "CacheDataset";
 constexpr char kIncompleteCacheErrorMessage[] =
@@ -738,6 +741,9 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
         TF_RETURN_IF_ERROR(
             WriteElementsToCheckpoint(writer, prefix(), cache_->data()));
       }
+      if (following_) {
+        TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kFollower), ""));
+      }
       return SaveInput(ctx, writer, iterator_);
     }
 
@@ -745,55 +751,59 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
                            IteratorStateReader* reader) override {
       mutex_lock l(mu_);
       iterator_.reset();
-      cache_->Reset();
+      // A follower does not own the cache, which may be in use by other
+      // iterators, and therefore must not reset it.
+      const bool follower = reader->Contains(full_name(kFollower));
+      if (!follower) {
+        cache_->Reset();
+      }
       if (reader->Contains(full_name(kCacheCompleted))) {
         std::vector<std::vector<Tensor>> temp_cache;
         TF_RETURN_IF_ERROR(
             ReadElementsFromCheckpoint(reader, prefix(), &temp_cache));
         cache_->Complete(std::move(temp_cache));
       }
-      TF_RETURN_IF_ERROR(InitializeIterator(ctx));
+      TF_RETURN_IF_ERROR(InitializeIterator(ctx, /*follow=*/follower));
       return RestoreInput(ctx, reader, iterator_);
     }
 
    private:
-    class MemoryWriterIterator : public DatasetIterator<MemoryDatasetBase> {
+    // Iterates over the cache while it is being populated by a
+    // `MemoryWriterIterator`, advancing the writer's input whenever it reaches
+    // the end of the cached prefix. If the writer discards the cache before
+    // completing it, the iterator falls back to producing the remaining
+    // elements from its own input iterator.
+    class MemoryFollowerIterator : public DatasetIterator<MemoryDatasetBase> {
      public:
-      explicit MemoryWriterIterator(const Params& params, MemoryCache* cache)
-          : DatasetIterator<MemoryDatasetBase>(params), cache_(cache) {}
-
-      ~MemoryWriterIterator() override {
-        mutex_lock l(mu_);
-        if (!temp_cache_.empty() && !cache_->IsCompleted()) {
-          LOG(WARNING) << kIncompleteCacheErrorMessage;
-          cache_->Reset();
-        }
-      }
-
-      Status Initialize(IteratorContext* ctx) override {
-        return dataset()->input_->MakeIterator(ctx, this, prefix(),
-                                               &input_impl_);
-      }
+      explicit MemoryFollowerIterator(const Params& params, MemoryCache* cache,
+                                      int64 generation)
+          : DatasetIterator<MemoryDatasetBase>(params),
+            cache_(cache),
+            generation_(generation) {}
 
       Status GetNextInternal(IteratorContext* ctx,
                              std::vector<Tensor>* out_tensors,
                              bool* end_of_sequence) override {
         mutex_lock l(mu_);
-        TF_RETURN_IF_ERROR(
-            input_impl_->GetNext(ctx, out_tensors, end_of_sequence));
-        if (*end_of_sequence) {
-          if (!cache_->IsCompleted()) {
-            VLOG(2) << "Finalizing the cache because EOF has been reached.";
-            cache_->Complete(std::move(temp_cache_));
+        if (!fallback_) {
+          bool stopped = false;
+          TF_RETURN_IF_ERROR(cache_->GetOrProduce(generation_, index_,
+                                                  out_tensors, end_of_sequence,
+                                                  &stopped));
+          if (!stopped) {
+            if (!*end_of_sequence) {
+              index_++;
+            }
+            return Status::OK();
           }
-          return Status::OK();
+          VLOG(2) << "The cache was discarded before it was completed. "
+                     "Producing the remaining elements from the input.";
+          TF_RETURN_IF_ERROR(StartFallback(ctx, /*num_to_skip=*/index_));
         }
-        RecordBufferEnqueue(ctx, *out_tensors);
-        temp_cache_.emplace_back(*out_tensors);
-        if (temp_cache_.size() == dataset()->input_->Cardinality()) {
-          VLOG(2) << "Finalizing the cache because its size matches the "
-                     "expected input cardinality.";
-          cache_->Complete(std::move(temp_cache_));
+        TF_RETURN_IF_ERROR(
+            input_impl_->GetNext(ctx, out_tensors, end_of_sequence));
+        if (!*end_of_sequence) {
+          index_++;
         }
         return Status::OK();
       }
@@ -808,28 +818,151 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
       Status SaveInternal(SerializationContext* ctx,
                           IteratorStateWriter* writer) override {
         mutex_lock l(mu_);
-        if (!cache_->IsCompleted()) {
-          TF_RETURN_IF_ERROR(
-              WriteElementsToCheckpoint(writer, prefix(), temp_cache_));
+        TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kIndex), index_));
+        if (fallback_) {
+          TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kFallback), ""));
+          TF_RETURN_IF_ERROR(SaveInput(ctx, writer, input_impl_));
         }
-        return SaveInput(ctx, writer, input_impl_);
+        return Status::OK();
       }
 
       Status RestoreInternal(IteratorContext* ctx,
                              IteratorStateReader* reader) override {
         mutex_lock l(mu_);
-        if (!reader->Contains(full_name(kCacheCompleted))) {
-          TF_RETURN_IF_ERROR(
-              ReadElementsFromCheckpoint(reader, prefix(), &temp_cache_));
+        {
+          int64 temp;
+          TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kIndex), &temp));
+          index_ = static_cast<size_t>(temp);
         }
-        return RestoreInput(ctx, reader, input_impl_);
+        if (reader->Contains(full_name(kFallback))) {
+          TF_RETURN_IF_ERROR(StartFallback(ctx, /*num_to_skip=*/0));
+          return RestoreInput(ctx, reader, input_impl_);
+        }
+        fallback_ = false;
+        input_impl_.reset();
+        generation_ = cache_->generation();
+        return Status::OK();
+      }
+
+      // Creates an input iterator for producing the elements that can no
+      // longer be obtained from the cache, skipping the first `num_to_skip`
+      // elements that have already been produced by this iterator.
+      Status StartFallback(IteratorContext* ctx, size_t num_to_skip)
+          TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        fallback_ = true;
+        TF_RETURN_IF_ERROR(
+            dataset()->input_->MakeIterator(ctx, this, prefix(), &input_impl_));
+        for (size_t i = 0; i < num_to_skip; ++i) {
+          std::vector<Tensor> unused;
+          bool end_of_input = false;
+          TF_RETURN_IF_ERROR(input_impl_->GetNext(ctx, &unused, &end_of_input));
+          if (end_of_input) {
+            break;
+          }
+        }
+        return Status::OK();
       }
 
-     private:
       mutex mu_;
-      std::unique_ptr<IteratorBase> input_impl_ TF_GUARDED_BY(mu_);
       MemoryCache* const cache_ TF_GUARDED_BY(mu_);  // not owned.
-      std::vector<std::vector<Tensor>> temp_cache_ TF_GUARDED_BY(mu_);
+      int64 generation_ TF_GUARDED_BY(mu_);
+      // The number of elements produced by this iterator.
+      size_t index_ TF_GUARDED_BY(mu_) = 0;
+      // Determines whether elements are produced from `input_impl_` rather
+      // than obtained from the cache.
+      bool fallback_ TF_GUARDED_BY(mu_) = false;
+      std::unique_ptr<IteratorBase> input_impl_ TF_GUARDED_BY(mu_);
+    };  // MemoryFollowerIterator
+
+    // Populates the cache with the elements of its input. The writer obtains
+    // its own elements through the cache as well, since concurrent
+    // `MemoryFollowerIterator`s may have advanced its input.
+    class MemoryWriterIterator : public MemoryFollowerIterator {
+     public:
+      explicit MemoryWriterIterator(const Params& params, MemoryCache* cache,
+                                    int64 generation)
+          : MemoryFollowerIterator(params, cache, generation) {}
+
+      ~MemoryWriterIterator() override {
+        mutex_lock l(mu_);
+        if (!fallback_ && cache_->size() > 0 && !cache_->IsCompleted()) {
+          LOG(WARNING) << kIncompleteCacheErrorMessage;
+        }
+        cache_->StopFilling(generation_);
+      }
+
+      Status Initialize(IteratorContext* ctx) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(
+            dataset()->input_->MakeIterator(ctx, this, prefix(), &input_impl_));
+        input_ctx_ = absl::make_unique<IteratorContext>(*ctx);
+        cache_->SetInput(generation_, input_impl_.get(), input_ctx_.get(),
+                         dataset()->input_->Cardinality());
+        return Status::OK();
+      }
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        TF_RETURN_IF_ERROR(MemoryFollowerIterator::GetNextInternal(
+            ctx, out_tensors, end_of_sequence));
+        if (!*end_of_sequence) {
+          RecordBufferEnqueue(ctx, *out_tensors);
+        }
+        return Status::OK();
+      }
+
+     protected:
+      Status SaveInternal(SerializationContext* ctx,
+                          IteratorStateWriter* writer) override {
+        {
+          mutex_lock l(mu_);
+          if (!fallback_) {
+            TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kIndex), index_));
+            IteratorBase* input = input_impl_.get();
+            return cache_->SaveFillState(
+                [this, ctx, writer, input](
+                    const std::vector<std::vector<Tensor>>& elements,
+                    bool completed) {
+                  if (!completed) {
+                    TF_RETURN_IF_ERROR(
+                        WriteElementsToCheckpoint(writer, prefix(), elements));
+                  }
+                  return input->Save(ctx, writer);
+                });
+          }
+        }
+        return MemoryFollowerIterator::SaveInternal(ctx, writer);
+      }
+
+      Status RestoreInternal(IteratorContext* ctx,
+                             IteratorStateReader* reader) override {
+        {
+          mutex_lock l(mu_);
+          if (!reader->Contains(full_name(kFallback))) {
+            std::vector<std::vector<Tensor>> temp_cache;
+            TF_RETURN_IF_ERROR(
+                ReadElementsFromCheckpoint(reader, prefix(), &temp_cache));
+            // Checkpoints that predate followers do not record the index,
+            // which then matches the number of cached elements.
+            index_ = temp_cache.size();
+            if (reader->Contains(full_name(kIndex))) {
+              int64 temp;
+              TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kIndex), &temp));
+              index_ = static_cast<size_t>(temp);
+            }
+            cache_->Fill(generation_, std::move(temp_cache));
+            return RestoreInput(ctx, reader, input_impl_);
+          }
+          cache_->StopFilling(generation_);
+        }
+        return MemoryFollowerIterator::RestoreInternal(ctx, reader);
+      }
+
+     private:
+      // The context that the input is advanced with, regardless of which
+      // iterator triggers the advancement.
+      std::unique_ptr<IteratorContext> input_ctx_;
     };  // MemoryWriterIterator
 
     class MemoryReaderIterator : public DatasetIterator<MemoryDatasetBase> {
@@ -857,6 +990,7 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
                              bool* end_of_sequence) override {
         mutex_lock l(mu_);
         if (index_ < cache_->size()) {
+          metrics::RecordTFDataCacheLookup(/*hit=*/true);
           const std::vector<Tensor>& cache_tensors = cache_->at(index_);
           out_tensors->insert(out_tensors->begin(), cache_tensors.begin(),
                               cache_tensors.end());
@@ -900,18 +1034,29 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
       size_t index_ TF_GUARDED_BY(mu_);
     };  // MemoryReaderIterator
 
-    Status InitializeIterator(IteratorContext* ctx)
+    // Creates a reader if the cache is completed, a writer if no other
+    // iterator is populating the cache (and `follow` is false), and a
+    // follower otherwise.
+    Status InitializeIterator(IteratorContext* ctx, bool follow = false)
         TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      int64 generation;
+      following_ = false;
       if (cache_->IsCompleted()) {
         iterator_ = absl::make_unique<MemoryReaderIterator>(
             MemoryReaderIterator::Params{dataset(),
                                          strings::StrCat(prefix(), kImpl)},
             cache_);
-      } else {
+      } else if (!follow && cache_->TryStartFilling(&generation)) {
         iterator_ = absl::make_unique<MemoryWriterIterator>(
             MemoryWriterIterator::Params{dataset(),
                                          strings::StrCat(prefix(), kImpl)},
-            cache_);
+            cache_, generation);
+      } else {
+        following_ = true;
+        iterator_ = absl::make_unique<MemoryFollowerIterator>(
+            MemoryFollowerIterator::Params{dataset(),
+                                           strings::StrCat(prefix(), kImpl)},
+            cache_, cache_->generation());
       }
       TF_RETURN_IF_ERROR(iterator_->InitializeBase(ctx, this));
       return iterator_->Initialize(ctx);
@@ -920,6 +1065,8 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
     mutex mu_;
     MemoryCache* cache_ TF_GUARDED_BY(mu_);  // not owned.
     std::unique_ptr<IteratorBase> iterator_ TF_GUARDED_BY(mu_);
+    // Determines whether `iterator_` is a `MemoryFollowerIterator`.
+    bool following_ TF_GUARDED_BY(mu_) = false;
   };  // MemoryIterator
 
   const DatasetBase* const input_;
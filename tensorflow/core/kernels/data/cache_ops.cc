@@ -15,6 +15,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/data/cache_ops.h"
 
 #include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -33,10 +34,20 @@ constexpr char kMemoryCache[] = "MemoryCache";
 
 string MemoryCacheManager::DebugString() const { return kMemoryCache; }
 
+MemoryCache::~MemoryCache() {
+  mutex_lock l(mu_);
+  ClearLocked();
+}
+
 void MemoryCache::Complete(std::vector<std::vector<Tensor>>&& cache) {
   mutex_lock l(mu_);
   if (!completed_) {
+    ClearLocked();
     cache_ = std::move(cache);
+    for (const auto& element : cache_) {
+      bytes_ += GetAllocatedBytes(element);
+    }
+    metrics::UpdateTFDataCacheBytesResident(bytes_);
     completed_ = true;
   }
 }
@@ -47,9 +58,15 @@ bool MemoryCache::IsCompleted() {
 }
 
 void MemoryCache::Reset() {
+  mutex_lock fill_l(fill_mu_);
   mutex_lock l(mu_);
   completed_ = false;
-  cache_.clear();
+  ClearLocked();
+  filling_ = false;
+  input_ = nullptr;
+  input_ctx_ = nullptr;
+  cardinality_ = kUnknownCardinality;
+  ++generation_;
 }
 
 const std::vector<Tensor>& MemoryCache::at(int64 index) {
@@ -68,6 +85,151 @@ const std::vector<std::vector<Tensor>>& MemoryCache::data() {
   return cache_;
 }
 
+int64 MemoryCache::generation() {
+  tf_shared_lock l(mu_);
+  return generation_;
+}
+
+bool MemoryCache::TryStartFilling(int64* generation) {
+  mutex_lock l(mu_);
+  if (completed_ || filling_) {
+    return false;
+  }
+  filling_ = true;
+  *generation = generation_;
+  return true;
+}
+
+void MemoryCache::SetInput(int64 generation, IteratorBase* input,
+                           IteratorContext* ctx, int64 cardinality) {
+  mutex_lock fill_l(fill_mu_);
+  tf_shared_lock l(mu_);
+  if (generation == generation_ && filling_) {
+    input_ = input;
+    input_ctx_ = ctx;
+    cardinality_ = cardinality;
+  }
+}
+
+void MemoryCache::Fill(int64 generation,
+                       std::vector<std::vector<Tensor>>&& elements) {
+  mutex_lock fill_l(fill_mu_);
+  mutex_lock l(mu_);
+  if (generation != generation_ || completed_) {
+    return;
+  }
+  ClearLocked();
+  cache_ = std::move(elements);
+  for (const auto& element : cache_) {
+    bytes_ += GetAllocatedBytes(element);
+  }
+  metrics::UpdateTFDataCacheBytesResident(bytes_);
+}
+
+void MemoryCache::StopFilling(int64 generation) {
+  mutex_lock fill_l(fill_mu_);
+  mutex_lock l(mu_);
+  if (generation != generation_) {
+    return;
+  }
+  filling_ = false;
+  input_ = nullptr;
+  input_ctx_ = nullptr;
+  if (!completed_) {
+    // Iterators following the writer detect that the partially cached
+    // elements have been discarded through the change of generation.
+    ClearLocked();
+    ++generation_;
+  }
+}
+
+Status MemoryCache::SaveFillState(const SaveFn& fn) {
+  mutex_lock fill_l(fill_mu_);
+  tf_shared_lock l(mu_);
+  return fn(cache_, completed_);
+}
+
+Status MemoryCache::GetOrProduce(int64 generation, size_t index,
+                                 std::vector<Tensor>* out_tensors,
+                                 bool* end_of_sequence, bool* stopped) {
+  *end_of_sequence = false;
+  *stopped = false;
+  {
+    tf_shared_lock l(mu_);
+    if (LookupLocked(generation, index, out_tensors, end_of_sequence,
+                     stopped)) {
+      return Status::OK();
+    }
+  }
+  mutex_lock fill_l(fill_mu_);
+  while (true) {
+    {
+      // The element may have been produced by another iterator while this one
+      // was waiting for `fill_mu_`.
+      tf_shared_lock l(mu_);
+      if (LookupLocked(generation, index, out_tensors, end_of_sequence,
+                       stopped)) {
+        return Status::OK();
+      }
+    }
+    if (input_ == nullptr) {
+      *stopped = true;
+      return Status::OK();
+    }
+    std::vector<Tensor> element;
+    bool end_of_input = false;
+    // The input is advanced with the writer's context rather than the
+    // caller's, since the input was created with (and its resources are
+    // associated with) the former.
+    TF_RETURN_IF_ERROR(input_->GetNext(input_ctx_, &element, &end_of_input));
+    mutex_lock l(mu_);
+    if (end_of_input) {
+      VLOG(2) << "Finalizing the cache because EOF has been reached.";
+      completed_ = true;
+      continue;
+    }
+    metrics::RecordTFDataCacheLookup(/*hit=*/false);
+    const int64 num_bytes = GetAllocatedBytes(element);
+    bytes_ += num_bytes;
+    metrics::UpdateTFDataCacheBytesResident(num_bytes);
+    cache_.push_back(std::move(element));
+    if (static_cast<int64>(cache_.size()) == cardinality_) {
+      VLOG(2) << "Finalizing the cache because its size matches the "
+                 "expected input cardinality.";
+      completed_ = true;
+    }
+    if (index == cache_.size() - 1) {
+      *out_tensors = cache_.back();
+      return Status::OK();
+    }
+  }
+}
+
+bool MemoryCache::LookupLocked(int64 generation, size_t index,
+                               std::vector<Tensor>* out_tensors,
+                               bool* end_of_sequence, bool* stopped) {
+  if (generation != generation_) {
+    *stopped = true;
+    return true;
+  }
+  if (index < cache_.size()) {
+    metrics::RecordTFDataCacheLookup(/*hit=*/true);
+    *out_tensors = cache_[index];
+    return true;
+  }
+  if (completed_) {
+    *end_of_sequence = true;
+    return true;
+  }
+  return false;
+}
+
+void MemoryCache::ClearLocked() {
+  cache_.clear();
+  metrics::UpdateTFDataCacheBytesResident(-bytes_);
+  bytes_ = 0;
+}
+
 AnonymousMemoryCacheHandleOp::AnonymousMemoryCacheHandleOp(
     OpKernelConstruction* ctx)
     : AnonymousResourceOp<MemoryCacheManager>(ctx) {}
@@ -25,12 +25,18 @@ namespace data {
 // A thread-safe data structure for caching dataset elements.
 //
 // The expected use is that a single `MemoryWriterIterator` populates the
-// cache with dataset elements. Once all elements are cached, the cache can
-// be used by one or more `MemoryReaderIterator`s.
+// cache with dataset elements. Iterators created while the cache is being
+// populated follow the writer: they read the elements cached so far and, upon
+// reaching the end of the cached prefix, advance the writer's input on its
+// behalf (see `GetOrProduce()`), so that each input element is produced only
+// once regardless of the number of concurrent iterators. Once all elements are
+// cached, the cache can be used by one or more `MemoryReaderIterator`s.
 class MemoryCache {
  public:
   MemoryCache() = default;
 
+  ~MemoryCache();
+
   // Marks the cache as completed.
   void Complete(std::vector<std::vector<Tensor>>&& cache);
 
@@ -50,11 +56,74 @@ class MemoryCache {
   // invalidated by any call to Reset().
   const std::vector<std::vector<Tensor>>& data();
 
+  // Returns the generation of the cache, which changes every time the cached
+  // elements are discarded.
+  int64 generation();
+
+  // Attempts to make the caller the (only) writer of the cache. Returns false
+  // if the cache is completed or is already being populated. Otherwise, stores
+  // the generation of the cache in `generation`, which must be passed to the
+  // remaining writer methods.
+  bool TryStartFilling(int64* generation);
+
+  // Registers `input` as the iterator that produces the cached elements and
+  // `ctx` as the context it is advanced with. The writer retains ownership of
+  // `input` and `ctx`, which must remain valid until `StopFilling()` is
+  // called. If `cardinality` is known, the cache is completed once it contains
+  // `cardinality` elements.
+  void SetInput(int64 generation, IteratorBase* input, IteratorContext* ctx,
+                int64 cardinality);
+
+  // Replaces the cached elements with `elements`, without completing the
+  // cache. Used when restoring a partially populated cache from a checkpoint.
+  void Fill(int64 generation, std::vector<std::vector<Tensor>>&& elements);
+
+  // Unregisters the writer. If the cache has not been completed, the cached
+  // elements are discarded.
+  void StopFilling(int64 generation);
+
+  using SaveFn = std::function<Status(
+      const std::vector<std::vector<Tensor>>& elements, bool completed)>;
+
+  // Invokes `fn` with the cached elements and whether the cache is completed,
+  // while preventing the writer's input from being advanced, so that the input
+  // can be checkpointed consistently with the cached elements.
+  Status SaveFillState(const SaveFn& fn);
+
+  // Copies the element at position `index` to `out_tensors`, producing it
+  // from the writer's input, with the writer's context, if it has not been
+  // cached yet. Sets
+  // `end_of_sequence` if the cache is completed and has fewer than `index + 1`
+  // elements. Sets `stopped` if the element cannot be obtained from the cache
+  // of the given `generation`, because the cache has been discarded or there is
+  // no writer, in which case the caller needs to produce the element itself.
+  Status GetOrProduce(int64 generation, size_t index,
+                      std::vector<Tensor>* out_tensors, bool* end_of_sequence,
+                      bool* stopped);
+
  private:
+  // Looks up the element at position `index`. Returns true if the lookup was
+  // resolved without advancing the writer's input.
+  bool LookupLocked(int64 generation, size_t index,
+                    std::vector<Tensor>* out_tensors, bool* end_of_sequence,
+                    bool* stopped) TF_SHARED_LOCKS_REQUIRED(mu_);
+
+  void ClearLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Serializes advancing the writer's input. Acquired before `mu_`.
+  mutex fill_mu_;
   mutex mu_;
   // Determines whether all elements of the dataset have been cached.
   bool completed_ TF_GUARDED_BY(mu_) = false;
   std::vector<std::vector<Tensor>> cache_ TF_GUARDED_BY(mu_);
+  // The number of bytes held by `cache_`.
+  int64 bytes_ TF_GUARDED_BY(mu_) = 0;
+  int64 generation_ TF_GUARDED_BY(mu_) = 0;
+  // Determines whether a writer is populating the cache.
+  bool filling_ TF_GUARDED_BY(mu_) = false;
+  IteratorBase* input_ TF_GUARDED_BY(fill_mu_) = nullptr;  // Not owned.
+  IteratorContext* input_ctx_ TF_GUARDED_BY(fill_mu_) = nullptr;  // Not owned.
+  int64 cardinality_ TF_GUARDED_BY(fill_mu_) = kUnknownCardinality;
 };
 
 // A resource wrapping a shared instance of a memory cache.
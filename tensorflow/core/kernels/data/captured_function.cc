@@ -17,7 +17,10 @@ limitations under the License.
 #include <utility>
 
 #include "absl/time/clock.h"
+#include "tensorflow/core/common_runtime/executor.h"
 #include "tensorflow/core/common_runtime/function.h"
+#include "tensorflow/core/common_runtime/function_body.h"
+#include "tensorflow/core/common_runtime/function_def_utils.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/cancellation.h"
@@ -26,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/stats_aggregator.h"
 #include "tensorflow/core/kernels/data/dataset_utils.h"
+#include "tensorflow/core/kernels/data/single_threaded_executor.h"
 #include "tensorflow/core/kernels/data/stats_utils.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/gtl/optional.h"
@@ -46,6 +50,10 @@ namespace {
 
 const char kDataServiceDataset[] = "DataServiceDataset";
 
+// Functions with at most this many nodes are candidates for inline execution,
+// which trades inter-op parallelism for lower per-invocation overhead.
+constexpr int kMaxInlineExecutionNodes = 16;
+
 // Simplistic implementation of the `StepStatsCollectorInterface` that only
 // cares about collecting the CPU time needed to execute a captured function.
 class SimpleStepStatsCollector : public StepStatsCollectorInterface {
@@ -273,6 +281,70 @@ Status LookupFunction(const FunctionLibraryDefinition& lib_def,
   return Status::OK();
 }
 
+// Creates an executor that runs the kernels of `func` one after another on the
+// calling thread, if `func` is a small, stateless function that does not call
+// other functions and only uses synchronous CPU kernels. Otherwise, leaves
+// `executor` unset.
+Status CreateInlineExecutor(FunctionLibraryRuntime* lib,
+                            const FunctionLibraryDefinition& lib_def,
+                            const NameAttrList& func,
+                            std::unique_ptr<Executor>* executor) {
+  if (lib->device()->device_type() != DEVICE_CPU) {
+    return Status::OK();
+  }
+  const FunctionDef* fdef;
+  TF_RETURN_IF_ERROR(LookupFunction(lib_def, func.name(), &fdef));
+  if (fdef->node_def_size() > kMaxInlineExecutionNodes) {
+    return Status::OK();
+  }
+  for (const NodeDef& node : fdef->node_def()) {
+    if (lib_def.Find(node.op()) != nullptr) {
+      return Status::OK();
+    }
+    const OpDef* op_def;
+    if (!OpRegistry::Global()->LookUpOpDef(node.op(), &op_def).ok() ||
+        op_def->is_stateful()) {
+      return Status::OK();
+    }
+    for (const auto& attr : node.attr()) {
+      if (attr.second.has_func() || attr.second.list().func_size() > 0) {
+        return Status::OK();
+      }
+    }
+  }
+
+  std::unique_ptr<FunctionBody> fbody;
+  TF_RETURN_IF_ERROR(FunctionDefToBodyHelper(*fdef, AttrSlice(&func.attr()),
+                                             &lib_def, &fbody));
+  LocalExecutorParams params;
+  params.device = lib->device();
+  params.function_library = lib;
+  params.create_kernel =
+      [lib](const std::shared_ptr<const NodeProperties>& props,
+            OpKernel** kernel) {
+        TF_RETURN_IF_ERROR(lib->CreateKernel(props, kernel));
+        if ((*kernel)->AsAsync() != nullptr) {
+          DeleteNonCachedKernel(*kernel);
+          *kernel = nullptr;
+          return errors::Unimplemented(
+              "Inline execution does not support asynchronous kernels.");
+        }
+        return Status::OK();
+      };
+  params.delete_kernel = [](OpKernel* kernel) {
+    DeleteNonCachedKernel(kernel);
+  };
+  Executor* raw_executor;
+  Status s = NewSingleThreadedExecutor(params, *fbody->graph, &raw_executor);
+  if (!s.ok()) {
+    VLOG(2) << "Function " << func.name() << " will not be executed inline: "
+            << s;
+    return Status::OK();
+  }
+  executor->reset(raw_executor);
+  return Status::OK();
+}
+
 class CallFrameBase : public CallFrameInterface {
  public:
   explicit CallFrameBase(DataTypeSlice ret_types)
@@ -711,9 +783,17 @@ Status CapturedFunction::Instantiate(
 
   bool is_multi_device;
   TF_RETURN_IF_ERROR(IsMultiDevice(ctx, &is_multi_device));
+
+  std::unique_ptr<Executor> inline_executor;
+  if (!is_multi_device && short_circuit_info().indices.empty()) {
+    TF_RETURN_IF_ERROR(CreateInlineExecutor(lib, *metadata_->lib_def(),
+                                            metadata_->func(),
+                                            &inline_executor));
+  }
   return InstantiatedCapturedFunction::Create(
       lib, f_handle, std::move(ret_types), *ctx->runner(), this,
-      is_multi_device, instantiated_captured_function);
+      is_multi_device, std::move(inline_executor),
+      instantiated_captured_function);
 }
 
 Status CapturedFunction::CheckExternalState() const {
@@ -807,22 +887,28 @@ Status InstantiatedCapturedFunction::Create(
     FunctionLibraryRuntime* lib, FunctionLibraryRuntime::Handle f_handle,
     DataTypeVector ret_types, std::function<void(std::function<void()>)> runner,
     CapturedFunction* captured_func, bool is_multi_device,
+    std::unique_ptr<Executor> inline_executor,
     std::unique_ptr<InstantiatedCapturedFunction>* out_function) {
   out_function->reset(new InstantiatedCapturedFunction(
-      lib, f_handle, ret_types, runner, captured_func, is_multi_device));
+      lib, f_handle, ret_types, runner, captured_func, is_multi_device,
+      std::move(inline_executor)));
   return Status::OK();
 }
 
 InstantiatedCapturedFunction::InstantiatedCapturedFunction(
     FunctionLibraryRuntime* lib, FunctionLibraryRuntime::Handle f_handle,
     DataTypeVector ret_types, std::function<void(std::function<void()>)> runner,
-    CapturedFunction* captured_func, bool is_multi_device)
+    CapturedFunction* captured_func, bool is_multi_device,
+    std::unique_ptr<Executor> inline_executor)
     : lib_(lib),
       f_handle_(f_handle),
       ret_types_(std::move(ret_types)),
       captured_runner_(std::move(runner)),
       captured_func_(captured_func),
-      is_multi_device_(is_multi_device) {}
+      is_multi_device_(is_multi_device),
+      inline_executor_(std::move(inline_executor)) {}
+
+InstantiatedCapturedFunction::~InstantiatedCapturedFunction() = default;
 
 Status InstantiatedCapturedFunction::Run(IteratorContext* ctx,
                                          std::vector<Tensor>&& args,
@@ -838,6 +924,19 @@ Status InstantiatedCapturedFunction::Run(
     return RunShortCircuit(info, std::move(args), captured_func_, rets);
   }
 
+  if (inline_executor_) {
+    OwnedArgsCallFrame frame(std::move(args),
+                             &captured_func_->captured_inputs(), ret_types_);
+    const bool collect_usage =
+        node && ctx->model() && ctx->model()->collect_resource_usage();
+    if (collect_usage) node->record_stop(EnvTime::NowNanos());
+    Status s = RunInline(&frame, ctx->cancellation_manager(), *ctx->runner(),
+                         node, ctx->stats_aggregator());
+    if (collect_usage) node->record_start(EnvTime::NowNanos());
+    TF_RETURN_IF_ERROR(s);
+    return frame.ConsumeRetvals(rets);
+  }
+
   FunctionLibraryRuntime::Options f_opts;
   ScopedStepContainer step_container(
       f_opts.step_id, [this](const string& name) {
@@ -901,6 +1000,19 @@ Status InstantiatedCapturedFunction::RunWithBorrowedArgs(
     return RunShortCircuit(info, args, captured_func_, rets);
   }
 
+  if (inline_executor_) {
+    BorrowedArgsCallFrame frame(args, &captured_func_->captured_inputs(),
+                                ret_types_);
+    const bool collect_usage =
+        node && ctx->model() && ctx->model()->collect_resource_usage();
+    if (collect_usage) node->record_stop(EnvTime::NowNanos());
+    Status s = RunInline(&frame, ctx->cancellation_manager(), *ctx->runner(),
+                         node, ctx->stats_aggregator());
+    if (collect_usage) node->record_start(EnvTime::NowNanos());
+    TF_RETURN_IF_ERROR(s);
+    return frame.ConsumeRetvals(rets);
+  }
+
   FunctionLibraryRuntime::Options f_opts;
   ScopedStepContainer step_container(
       f_opts.step_id, [this](const string& name) {
@@ -956,6 +1068,15 @@ Status InstantiatedCapturedFunction::RunInstantiated(
     return RunShortCircuit(info, args, captured_func_, rets);
   }
 
+  if (inline_executor_) {
+    BorrowedArgsCallFrame frame(args, &captured_func_->captured_inputs(),
+                                ret_types_);
+    TF_RETURN_IF_ERROR(RunInline(&frame, /*cancellation_manager=*/nullptr,
+                                 captured_runner_, /*node=*/nullptr,
+                                 /*stats_aggregator=*/nullptr));
+    return frame.ConsumeRetvals(rets);
+  }
+
   FunctionLibraryRuntime::Options f_opts;
   ScopedStepContainer step_container(
       f_opts.step_id, [this](const string& name) {
@@ -1001,6 +1122,36 @@ void InstantiatedCapturedFunction::RunAsync(
   OwnedArgsCallFrame* frame = new OwnedArgsCallFrame(
       std::move(args), &captured_func_->captured_inputs(), ret_types_);
 
+  if (inline_executor_) {
+    // Run the function on a threadpool thread, so that the caller can issue
+    // further invocations concurrently.
+    const bool collect_usage =
+        node && ctx->model() && ctx->model()->collect_resource_usage();
+    (*ctx->runner())(std::bind(
+        [this, rets, frame, node, collect_usage](
+            const FunctionLibraryRuntime::DoneCallback& done,
+            CancellationManager* cancellation_manager,
+            const std::function<void(std::function<void()>)>& runner,
+            const std::shared_ptr<StatsAggregator>& stats_aggregator) {
+          Status s = RunInline(frame, cancellation_manager, runner, node,
+                               stats_aggregator);
+          if (s.ok()) {
+            s = frame->ConsumeRetvals(rets);
+          }
+          delete frame;
+          if (collect_usage) {
+            node->record_start(EnvTime::NowNanos());
+          }
+          done(s);
+          if (collect_usage) {
+            node->record_stop(EnvTime::NowNanos());
+          }
+        },
+        std::move(done), ctx->cancellation_manager(), *ctx->runner(),
+        ctx->stats_aggregator()));
+    return;
+  }
+
   FunctionLibraryRuntime::Options f_opts;
   ResourceMgr* resource_mgr = lib_->device()->resource_manager();
   ScopedStepContainer* step_container = new ScopedStepContainer(
@@ -1078,6 +1229,40 @@ void InstantiatedCapturedFunction::RunAsync(
   if (collect_usage) node->record_start(EnvTime::NowNanos());
 }
 
+Status InstantiatedCapturedFunction::RunInline(
+    CallFrameInterface* frame, CancellationManager* cancellation_manager,
+    std::function<void(std::function<void()>)> runner,
+    const std::shared_ptr<model::Node>& node,
+    const std::shared_ptr<StatsAggregator>& stats_aggregator) const {
+  profiler::TraceMe activity("InstantiatedCapturedFunction::RunInline",
+                             profiler::TraceMeLevel::kInfo);
+  // The single-threaded executor does not observe cancellation, so check it
+  // here the same way the function library runtime does.
+  if (cancellation_manager != nullptr && cancellation_manager->IsCancelled()) {
+    return errors::Cancelled("Function was cancelled before it was started");
+  }
+  Executor::Args args;
+  args.call_frame = frame;
+  args.cancellation_manager = cancellation_manager;
+  args.runner = std::move(runner);
+  args.run_all_kernels_inline = true;
+  if (!node) {
+    return inline_executor_->Run(args);
+  }
+  const int64 start_time_ns = EnvTime::NowNanos();
+  Status s = inline_executor_->Run(args);
+  const int64 processing_time = EnvTime::NowNanos() - start_time_ns;
+  if (stats_aggregator) {
+    string prefix_with_func_name = strings::StrCat(
+        node->name(), stats_utils::kDelimiter, captured_func_->func().name());
+    stats_aggregator->AddToHistogram(
+        stats_utils::ExecutionTimeHistogramName(prefix_with_func_name),
+        {static_cast<float>(processing_time)}, node->num_elements());
+  }
+  node->add_processing_time(processing_time);
+  return s;
+}
+
 bool InstantiatedCapturedFunction::ShouldCreateRendezvous() const {
   // Rendezvous should only be created by the FLR for non-CPU single-device
   // functions. For multi-device functions the appropriate rendezvous will be
@@ -32,6 +32,7 @@ limitations under the License.
 namespace tensorflow {
 
 class Device;
+class Executor;
 class OpKernelContext;
 class ResourceMgr;
 
@@ -216,8 +217,11 @@ class InstantiatedCapturedFunction {
       DataTypeVector ret_types,
       std::function<void(std::function<void()>)> runner,
       CapturedFunction* captured_func, bool is_multi_device,
+      std::unique_ptr<Executor> inline_executor,
       std::unique_ptr<InstantiatedCapturedFunction>* out_function);
 
+  ~InstantiatedCapturedFunction();
+
   // Runs the instantiated captured function. This method takes ownership of
   // the tensors in `args`, in order to be able to deallocate them as early as
   // possible. Use `RunWithBorrowedArgs()` if the caller needs to retain
@@ -269,17 +273,31 @@ class InstantiatedCapturedFunction {
                 FunctionLibraryRuntime::DoneCallback done,
                 const std::shared_ptr<model::Node>& node) const;
 
+  // Returns true if the function is executed inline on the calling thread.
+  bool IsRunInlineForTesting() const { return inline_executor_ != nullptr; }
+
  private:
   InstantiatedCapturedFunction(
       FunctionLibraryRuntime* lib, FunctionLibraryRuntime::Handle f_handle,
       DataTypeVector ret_types,
       std::function<void(std::function<void()>)> runner,
-      CapturedFunction* captured_func, bool is_multi_device);
+      CapturedFunction* captured_func, bool is_multi_device,
+      std::unique_ptr<Executor> inline_executor);
 
   // Determines whether a rendezvous object should be created when running the
   // instantiated function.
   bool ShouldCreateRendezvous() const;
 
+  // Runs the function on the calling thread using `inline_executor_`. Pass
+  // non-null `node` to record processing time for modeling Iterator's
+  // GetNext() resource usage.
+  Status RunInline(CallFrameInterface* frame,
+                   CancellationManager* cancellation_manager,
+                   std::function<void(std::function<void()>)> runner,
+                   const std::shared_ptr<model::Node>& node,
+                   const std::shared_ptr<StatsAggregator>& stats_aggregator)
+      const;
+
   FunctionLibraryRuntime* const lib_;  // Not owned.
   const FunctionLibraryRuntime::Handle f_handle_;
   const DataTypeVector ret_types_;
@@ -288,6 +306,9 @@ class InstantiatedCapturedFunction {
   std::function<void(std::function<void()>)> captured_runner_;
   CapturedFunction* const captured_func_;  // Not owned.
   const bool is_multi_device_;
+  // If set, the function is small enough to be executed by running its kernels
+  // one after another on the calling thread, without going through `lib_`.
+  const std::unique_ptr<Executor> inline_executor_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(InstantiatedCapturedFunction);
 };
@@ -0,0 +1,349 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/captured_function.h"
+
+#include "tensorflow/core/framework/common_shape_fns.h"
+#include "tensorflow/core/framework/model.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/stats_aggregator.h"
+#include "tensorflow/core/kernels/data/dataset_test_base.h"
+#include "tensorflow/core/kernels/data/stats_utils.h"
+#include "tensorflow/core/platform/notification.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+using FDH = FunctionDefHelper;
+
+constexpr char kNodeName[] = "captured_function";
+
+// Holds the metadata of the function in its `f` attribute, so that tests can
+// create a `CapturedFunction` from it.
+class CapturedFunctionTestOp : public OpKernel {
+ public:
+  explicit CapturedFunctionTestOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, FunctionMetadata::Create(ctx, "f", /*params=*/{},
+                                                 &metadata_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {}
+
+  const std::shared_ptr<FunctionMetadata>& metadata() const {
+    return metadata_;
+  }
+
+ private:
+  std::shared_ptr<FunctionMetadata> metadata_;
+};
+
+REGISTER_OP("CapturedFunctionTestOp")
+    .Attr("f: func")
+    .SetShapeFn(shape_inference::NoOutputs);
+REGISTER_KERNEL_BUILDER(Name("CapturedFunctionTestOp").Device(DEVICE_CPU),
+                        CapturedFunctionTestOp);
+
+// A stateless identity op with an asynchronous kernel.
+class CapturedFunctionTestAsyncIdentityOp : public AsyncOpKernel {
+ public:
+  explicit CapturedFunctionTestAsyncIdentityOp(OpKernelConstruction* ctx)
+      : AsyncOpKernel(ctx) {}
+
+  void ComputeAsync(OpKernelContext* ctx, DoneCallback done) override {
+    ctx->set_output(0, ctx->input(0));
+    done();
+  }
+};
+
+REGISTER_OP("CapturedFunctionTestAsyncIdentity")
+    .Input("x: float")
+    .Output("y: float")
+    .SetShapeFn(shape_inference::UnchangedShape);
+REGISTER_KERNEL_BUILDER(
+    Name("CapturedFunctionTestAsyncIdentity").Device(DEVICE_CPU),
+    CapturedFunctionTestAsyncIdentityOp);
+
+// A stateful identity op with a synchronous kernel.
+class CapturedFunctionTestStatefulIdentityOp : public OpKernel {
+ public:
+  explicit CapturedFunctionTestStatefulIdentityOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    ctx->set_output(0, ctx->input(0));
+  }
+};
+
+REGISTER_OP("CapturedFunctionTestStatefulIdentity")
+    .Input("x: float")
+    .Output("y: float")
+    .SetIsStateful()
+    .SetShapeFn(shape_inference::UnchangedShape);
+REGISTER_KERNEL_BUILDER(
+    Name("CapturedFunctionTestStatefulIdentity").Device(DEVICE_CPU),
+    CapturedFunctionTestStatefulIdentityOp);
+
+FunctionDef AsyncIdentity() {
+  return FDH::Define(
+      // Name
+      "AsyncIdentity",
+      // Args
+      {"x: float"},
+      // Return values
+      {"y: float"},
+      // Attr def
+      {},
+      // Nodes
+      {{{"y"}, "CapturedFunctionTestAsyncIdentity", {"x"}}});
+}
+
+FunctionDef StatefulIdentity() {
+  return FDH::Define(
+      // Name
+      "StatefulIdentity",
+      // Args
+      {"x: float"},
+      // Return values
+      {"y: float"},
+      // Attr def
+      {},
+      // Nodes
+      {{{"y"}, "CapturedFunctionTestStatefulIdentity", {"x"}}});
+}
+
+// Records the names of the histograms it is asked to update.
+class TestStatsAggregator : public StatsAggregator {
+ public:
+  void AddToHistogram(const string& name, gtl::ArraySlice<double> values,
+                      int64 global_step) override {
+    histogram_names_.push_back(name);
+  }
+
+  void AddScalar(const string& name, float value, int64 global_step) override {
+  }
+
+  void EncodeToProto(Summary* out_summary) override {}
+
+  Status SetSummaryWriter(SummaryWriterInterface* summary_writer) override {
+    return Status::OK();
+  }
+
+  void IncrementCounter(const string& name, const string& label,
+                        int64 val) override {}
+
+  const std::vector<string>& histogram_names() const {
+    return histogram_names_;
+  }
+
+ private:
+  std::vector<string> histogram_names_;
+};
+
+class CapturedFunctionTest : public DatasetOpsTestBase {
+ protected:
+  // Instantiates the function referenced by `func`, which must be defined in
+  // `func_lib`.
+  Status InstantiateFunction(const FDH::AttrValueWrapper& func,
+                             const std::vector<FunctionDef>& func_lib) {
+    TF_RETURN_IF_ERROR(InitThreadPool(thread_num_));
+    TF_RETURN_IF_ERROR(InitFunctionLibraryRuntime(func_lib, cpu_num_));
+    NodeDef node_def = test::function::NDef(
+        kNodeName, "CapturedFunctionTestOp", /*inputs=*/{}, {{"f", func}});
+    TF_RETURN_IF_ERROR(CreateOpKernel(node_def, &op_kernel_));
+    TF_RETURN_IF_ERROR(CreateOpKernelContext(op_kernel_.get(), &op_inputs_,
+                                             &op_ctx_params_, &op_ctx_));
+    TF_RETURN_IF_ERROR(CreateIteratorContext(op_ctx_.get(), &ctx_));
+    auto* op = static_cast<CapturedFunctionTestOp*>(op_kernel_.get());
+    TF_RETURN_IF_ERROR(CapturedFunction::Create(
+        op_ctx_.get(), op->metadata(),
+        /*captured_inputs=*/std::vector<Tensor>(), &func_));
+    return func_->Instantiate(ctx_.get(), &instantiated_func_);
+  }
+
+  std::unique_ptr<OpKernel> op_kernel_;
+  gtl::InlinedVector<TensorValue, 4> op_inputs_;
+  std::unique_ptr<OpKernelContext::Params> op_ctx_params_;
+  std::unique_ptr<OpKernelContext> op_ctx_;
+  std::unique_ptr<IteratorContext> ctx_;
+  std::unique_ptr<CapturedFunction> func_;
+  std::unique_ptr<InstantiatedCapturedFunction> instantiated_func_;
+};
+
+TEST_F(CapturedFunctionTest, RunInline) {
+  TF_ASSERT_OK(InstantiateFunction(
+      FDH::FunctionRef("XTimesTwo", {{"T", DT_FLOAT}}),
+      {test::function::XTimesTwo()}));
+  EXPECT_TRUE(instantiated_func_->IsRunInlineForTesting());
+
+  std::vector<Tensor> rets;
+  TF_ASSERT_OK(instantiated_func_->RunWithBorrowedArgs(
+      ctx_.get(), {test::AsScalar<float>(3.0)}, &rets));
+  ASSERT_EQ(rets.size(), 1);
+  test::ExpectTensorEqual<float>(rets[0], test::AsScalar<float>(6.0));
+
+  rets.clear();
+  TF_ASSERT_OK(instantiated_func_->Run(
+      ctx_.get(), {test::AsScalar<float>(5.0)}, &rets));
+  ASSERT_EQ(rets.size(), 1);
+  test::ExpectTensorEqual<float>(rets[0], test::AsScalar<float>(10.0));
+}
+
+TEST_F(CapturedFunctionTest, RunAsyncInline) {
+  TF_ASSERT_OK(InstantiateFunction(
+      FDH::FunctionRef("XTimesTwo", {{"T", DT_FLOAT}}),
+      {test::function::XTimesTwo()}));
+  ASSERT_TRUE(instantiated_func_->IsRunInlineForTesting());
+
+  std::shared_ptr<model::Node> node =
+      model::MakeUnknownRatioNode({/*id=*/1, kNodeName, /*output=*/nullptr});
+  std::vector<Tensor> rets;
+  Status status;
+  Notification done;
+  instantiated_func_->RunAsync(
+      ctx_.get(), {test::AsScalar<float>(3.0)}, &rets,
+      [&status, &done](const Status& s) {
+        status = s;
+        done.Notify();
+      },
+      node);
+  done.WaitForNotification();
+  TF_ASSERT_OK(status);
+  ASSERT_EQ(rets.size(), 1);
+  test::ExpectTensorEqual<float>(rets[0], test::AsScalar<float>(6.0));
+  EXPECT_GT(node->processing_time(), 0);
+}
+
+TEST_F(CapturedFunctionTest, RunAsyncInlineCancelled) {
+  TF_ASSERT_OK(InstantiateFunction(
+      FDH::FunctionRef("XTimesTwo", {{"T", DT_FLOAT}}),
+      {test::function::XTimesTwo()}));
+  ASSERT_TRUE(instantiated_func_->IsRunInlineForTesting());
+
+  CancellationManager cancellation_manager;
+  cancellation_manager.StartCancel();
+  IteratorContext::Params params(ctx_.get());
+  params.cancellation_manager = &cancellation_manager;
+  IteratorContext cancelled_ctx(std::move(params));
+
+  std::vector<Tensor> rets;
+  Status status;
+  Notification done;
+  instantiated_func_->RunAsync(
+      &cancelled_ctx, {test::AsScalar<float>(3.0)}, &rets,
+      [&status, &done](const Status& s) {
+        status = s;
+        done.Notify();
+      },
+      /*node=*/nullptr);
+  done.WaitForNotification();
+  EXPECT_EQ(status.code(), error::CANCELLED);
+}
+
+TEST_F(CapturedFunctionTest, RunInstantiatedInline) {
+  TF_ASSERT_OK(InstantiateFunction(
+      FDH::FunctionRef("XTimesTwo", {{"T", DT_FLOAT}}),
+      {test::function::XTimesTwo()}));
+  ASSERT_TRUE(instantiated_func_->IsRunInlineForTesting());
+
+  std::vector<Tensor> rets;
+  TF_ASSERT_OK(
+      instantiated_func_->RunInstantiated({test::AsScalar<float>(3.0)}, &rets));
+  ASSERT_EQ(rets.size(), 1);
+  test::ExpectTensorEqual<float>(rets[0], test::AsScalar<float>(6.0));
+}
+
+TEST_F(CapturedFunctionTest, StatefulFunctionIsNotRunInline) {
+  TF_ASSERT_OK(InstantiateFunction(FDH::FunctionRef("StatefulIdentity"),
+                                   {StatefulIdentity()}));
+  EXPECT_FALSE(instantiated_func_->IsRunInlineForTesting());
+
+  std::vector<Tensor> rets;
+  TF_ASSERT_OK(instantiated_func_->RunWithBorrowedArgs(
+      ctx_.get(), {test::AsScalar<float>(3.0)}, &rets));
+  ASSERT_EQ(rets.size(), 1);
+  test::ExpectTensorEqual<float>(rets[0], test::AsScalar<float>(3.0));
+}
+
+TEST_F(CapturedFunctionTest, FunctionCallingFunctionIsNotRunInline) {
+  TF_ASSERT_OK(InstantiateFunction(
+      FDH::FunctionRef("XTimesFour", {{"T", DT_FLOAT}}),
+      {test::function::XTimesTwo(), test::function::XTimesFour()}));
+  EXPECT_FALSE(instantiated_func_->IsRunInlineForTesting());
+
+  std::vector<Tensor> rets;
+  TF_ASSERT_OK(instantiated_func_->RunWithBorrowedArgs(
+      ctx_.get(), {test::AsScalar<float>(3.0)}, &rets));
+  ASSERT_EQ(rets.size(), 1);
+  test::ExpectTensorEqual<float>(rets[0], test::AsScalar<float>(12.0));
+}
+
+TEST_F(CapturedFunctionTest, AsyncKernelIsNotRunInline) {
+  TF_ASSERT_OK(InstantiateFunction(FDH::FunctionRef("AsyncIdentity"),
+                                   {AsyncIdentity()}));
+  EXPECT_FALSE(instantiated_func_->IsRunInlineForTesting());
+
+  std::vector<Tensor> rets;
+  TF_ASSERT_OK(instantiated_func_->RunWithBorrowedArgs(
+      ctx_.get(), {test::AsScalar<float>(3.0)}, &rets));
+  ASSERT_EQ(rets.size(), 1);
+  test::ExpectTensorEqual<float>(rets[0], test::AsScalar<float>(3.0));
+}
+
+TEST_F(CapturedFunctionTest, RunInlineCancelled) {
+  TF_ASSERT_OK(InstantiateFunction(
+      FDH::FunctionRef("XTimesTwo", {{"T", DT_FLOAT}}),
+      {test::function::XTimesTwo()}));
+  ASSERT_TRUE(instantiated_func_->IsRunInlineForTesting());
+
+  CancellationManager cancellation_manager;
+  cancellation_manager.StartCancel();
+  IteratorContext::Params params(ctx_.get());
+  params.cancellation_manager = &cancellation_manager;
+  IteratorContext cancelled_ctx(std::move(params));
+
+  std::vector<Tensor> rets;
+  Status s = instantiated_func_->RunWithBorrowedArgs(
+      &cancelled_ctx, {test::AsScalar<float>(3.0)}, &rets);
+  EXPECT_EQ(s.code(), error::CANCELLED);
+}
+
+TEST_F(CapturedFunctionTest, RunInlineRecordsStats) {
+  TF_ASSERT_OK(InstantiateFunction(
+      FDH::FunctionRef("XTimesTwo", {{"T", DT_FLOAT}}),
+      {test::function::XTimesTwo()}));
+  ASSERT_TRUE(instantiated_func_->IsRunInlineForTesting());
+
+  auto stats_aggregator = std::make_shared<TestStatsAggregator>();
+  IteratorContext::Params params(ctx_.get());
+  params.stats_aggregator = stats_aggregator;
+  IteratorContext stats_ctx(std::move(params));
+  std::shared_ptr<model::Node> node =
+      model::MakeUnknownRatioNode({/*id=*/1, kNodeName, /*output=*/nullptr});
+
+  std::vector<Tensor> rets;
+  TF_ASSERT_OK(instantiated_func_->RunWithBorrowedArgs(
+      &stats_ctx, {test::AsScalar<float>(3.0)}, &rets, node));
+  test::ExpectTensorEqual<float>(rets[0], test::AsScalar<float>(6.0));
+  EXPECT_GT(node->processing_time(), 0);
+  EXPECT_THAT(stats_aggregator->histogram_names(),
+              ::testing::ElementsAre(stats_utils::ExecutionTimeHistogramName(
+                  strings::StrCat(kNodeName, stats_utils::kDelimiter,
+                                  "XTimesTwo"))));
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -21,6 +21,7 @@ limitations under the License.
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/common_runtime/function.h"
+#include "tensorflow/core/common_runtime/pool_allocator.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/function.h"
@@ -35,6 +36,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/regexp.h"
 #include "tensorflow/core/util/work_sharder.h"
 
@@ -51,6 +53,11 @@ constexpr char kCode[] = "code";
 constexpr char kMessage[] = "msg";
 constexpr char kOutput[] = "output";
 
+// The minimum number of bytes copied by each shard of a batch copy that
+// `ParallelCopy()` shards on its own accord. Below that, the cost of
+// scheduling the shards on the runner outweighs the benefit of parallelism.
+constexpr int64 kMinBytesPerCopyShard = 256 << 10;  // 256 KiB
+
 }  // namespace
 
 Status WriteElementsToCheckpoint(
@@ -844,8 +851,57 @@ Status ProcessBatch(int64 batch_size, int64 num_elements, bool drop_remainder,
   return Status::OK();
 }
 
-Status CopyBatch(bool parallel_copy, IteratorContext* ctx,
-                 std::vector<Tensor>* out_tensors,
+Status ParallelCopy(IteratorContext* ctx, bool parallel_copy,
+                    bool shard_large_copies, int64 num_elements,
+                    int64 bytes_per_element,
+                    const std::function<Status(int64)>& copy_element_fn) {
+  int64 num_shards =
+      std::min<int64>(num_elements, ctx->runner_threadpool_size());
+  if (!parallel_copy) {
+    num_shards = shard_large_copies
+                     ? std::min(num_shards, num_elements * bytes_per_element /
+                                                kMinBytesPerCopyShard)
+                     : 1;
+  }
+  if (num_shards <= 1) {
+    for (int64 i = 0; i < num_elements; ++i) {
+      TF_RETURN_IF_ERROR(copy_element_fn(i));
+    }
+    return Status::OK();
+  }
+
+  // Each shard copies a contiguous range of elements, so that consecutive
+  // writes into the batch tensor come from the same thread.
+  Status status;
+  mutex status_mu;
+  auto copy_shard_fn = [num_elements, num_shards, &status, &status_mu,
+                        &copy_element_fn](int64 shard) {
+    const int64 begin = num_elements * shard / num_shards;
+    const int64 end = num_elements * (shard + 1) / num_shards;
+    for (int64 i = begin; i < end; ++i) {
+      Status s = copy_element_fn(i);
+      if (!s.ok()) {
+        mutex_lock l(status_mu);
+        status.Update(s);
+        return;
+      }
+    }
+  };
+  BlockingCounter counter(num_shards - 1);
+  for (int64 shard = 1; shard < num_shards; ++shard) {
+    (*ctx->runner())([shard, &counter, &copy_shard_fn]() {
+      copy_shard_fn(shard);
+      counter.DecrementCount();
+    });
+  }
+  // The calling thread copies the first shard instead of idling.
+  copy_shard_fn(0);
+  counter.Wait();
+  return status;
+}
+
+Status CopyBatch(bool parallel_copy, bool shard_large_copies,
+                 IteratorContext* ctx, std::vector<Tensor>* out_tensors,
                  std::vector<std::vector<Tensor>>* batch_elements) {
   const size_t num_tuple_components = (*batch_elements)[0].size();
   out_tensors->reserve(num_tuple_components);
@@ -858,7 +914,19 @@ Status CopyBatch(bool parallel_copy, IteratorContext* ctx,
     // `first_element.shape()` will become undefined after the 0th batch element
     // is moved into the output batch.
     TensorShape first_element_shape(first_element.shape());
+    const int64 bytes_per_element = first_element.TotalBytes();
     batch_component_shape.AppendShape(first_element_shape);
+    for (size_t i = 1; i < num_batch_elements; ++i) {
+      if ((*batch_elements)[i][component_index].shape() !=
+          first_element_shape) {
+        return errors::InvalidArgument(
+            "Cannot batch tensors with different shapes in component ",
+            component_index, ". First element had shape ",
+            first_element_shape.DebugString(), " and element ", i,
+            " had shape ",
+            (*batch_elements)[i][component_index].shape().DebugString(), ".");
+      }
+    }
     out_tensors->emplace_back(ctx->allocator({}), first_element.dtype(),
                               batch_component_shape);
     if (!out_tensors->back().IsInitialized()) {
@@ -870,50 +938,35 @@ Status CopyBatch(bool parallel_copy, IteratorContext* ctx,
     // Build the output tuple component by copying one slice from each input
     // element in the batch.
     auto copy_element_fn = [component_index, &batch_elements,
-                            &batch_component](int index) {
-      TF_RETURN_IF_ERROR(batch_util::CopyElementToSlice(
+                            &batch_component](int64 index) {
+      return batch_util::CopyElementToSlice(
           std::move((*batch_elements)[index][component_index]),
-          &batch_component, index));
-      return Status::OK();
+          &batch_component, index);
     };
-    Status status;
-    std::unique_ptr<BlockingCounter> counter;
-    std::unique_ptr<mutex> status_mu;
-    if (TF_PREDICT_FALSE(parallel_copy)) {
-      counter = std::make_unique<BlockingCounter>(num_batch_elements);
-      status_mu = std::make_unique<mutex>();
-    }
-    for (size_t i = 0; i < num_batch_elements; ++i) {
-      if ((*batch_elements)[i][component_index].shape() !=
-          first_element_shape) {
-        return errors::InvalidArgument(
-            "Cannot batch tensors with different shapes in component ",
-            component_index, ". First element had shape ",
-            first_element_shape.DebugString(), " and element ", i,
-            " had shape ",
-            (*batch_elements)[i][component_index].shape().DebugString(), ".");
-      }
-      if (TF_PREDICT_FALSE(parallel_copy)) {
-        (*ctx->runner())(
-            [i, &status, &status_mu, &counter, &copy_element_fn]() {
-              Status s = copy_element_fn(i);
-              {
-                mutex_lock l(*status_mu);
-                status.Update(s);
-              }
-              counter->DecrementCount();
-            });
-      } else {
-        status.Update(copy_element_fn(i));
-      }
-    }
-    if (TF_PREDICT_FALSE(parallel_copy)) {
-      counter->Wait();
-    }
-    TF_RETURN_IF_ERROR(status);
+    TF_RETURN_IF_ERROR(ParallelCopy(ctx, parallel_copy, shard_large_copies,
+                                    num_batch_elements, bytes_per_element,
+                                    copy_element_fn));
   }
   return Status::OK();
 }
 
+Allocator* GetNumaLocalAllocator(int numa_node) {
+  if (!port::NUMAEnabled() || numa_node == port::kNUMANoAffinity) {
+    return cpu_allocator();
+  }
+  static mutex* mu = new mutex();
+  static auto* allocators = new absl::flat_hash_map<int, Allocator*>();
+  mutex_lock l(*mu);
+  Allocator*& allocator = (*allocators)[numa_node];
+  if (allocator == nullptr) {
+    // NUMAMalloc is slow, so the allocations are pooled.
+    allocator = new PoolAllocator(
+        /*pool_size_limit=*/100, /*auto_resize=*/true,
+        new BasicCPUAllocator(numa_node, {}, {}), new NoopRounder,
+        strings::StrCat("tf_data_numa_", numa_node));
+  }
+  return allocator;
+}
+
 }  // namespace data
 }  // namespace tensorflow
@@ -325,11 +325,33 @@ Status ProcessBatch(int64 batch_size, int64 num_elements, bool drop_remainder,
                     std::vector<Tensor>* output, bool* end_of_sequence,
                     std::vector<Tensor>* batch);
 
-// Copies the input elements to a batch.
-Status CopyBatch(bool parallel_copy, IteratorContext* ctx,
-                 std::vector<Tensor>* out_tensors,
+// Calls `copy_element_fn` for each index in `[0, num_elements)`, where each
+// call copies one element of `bytes_per_element` bytes into a batch. The calls
+// are sharded across the runner threadpool of `ctx` if `parallel_copy` is true,
+// or if `shard_large_copies` is true and the batch is large enough for the
+// parallelism to pay off. Otherwise, they are made on the calling thread.
+//
+// Sharding blocks the calling thread until all shards have run, so
+// `shard_large_copies` must only be set by callers that are not themselves
+// running on the runner threadpool of `ctx`.
+Status ParallelCopy(IteratorContext* ctx, bool parallel_copy,
+                    bool shard_large_copies, int64 num_elements,
+                    int64 bytes_per_element,
+                    const std::function<Status(int64)>& copy_element_fn);
+
+// Copies the input elements to a batch. See `ParallelCopy()` for the meaning
+// of `parallel_copy` and `shard_large_copies`.
+Status CopyBatch(bool parallel_copy, bool shard_large_copies,
+                 IteratorContext* ctx, std::vector<Tensor>* out_tensors,
                  std::vector<std::vector<Tensor>>* batch_elements);
 
+// Returns a process-wide allocator for host memory that is local to NUMA node
+// `numa_node`, or `cpu_allocator()` if NUMA is not supported.
+//
+// Unlike `cpu_allocator(numa_node)`, this does not depend on NUMA having been
+// enabled for the `ProcessState` allocators.
+Allocator* GetNumaLocalAllocator(int numa_node);
+
 }  // namespace data
 }  // namespace tensorflow
 
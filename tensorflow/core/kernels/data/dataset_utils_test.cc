@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/framework/variant.h"
 #include "tensorflow/core/kernels/data/dataset_test_base.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
 #include "tensorflow/core/util/work_sharder.h"
@@ -514,6 +515,23 @@ INSTANTIATE_TEST_SUITE_P(Test, SelectOptimizationsJobTest,
                                             ::testing::Values("",
                                                               "exp2,exp3")));
 
+TEST(DatasetUtilsTest, NumaLocalAllocator) {
+  if (!port::NUMAEnabled()) {
+    EXPECT_EQ(GetNumaLocalAllocator(0), cpu_allocator());
+    return;
+  }
+  for (int node = 0; node < port::NUMANumNodes(); ++node) {
+    Allocator* allocator = GetNumaLocalAllocator(node);
+    EXPECT_EQ(allocator, GetNumaLocalAllocator(node));
+    void* ptr = allocator->AllocateRaw(Allocator::kAllocatorAlignment, 1024);
+    ASSERT_NE(ptr, nullptr);
+    // Affinity cannot be tested until the page is touched.
+    *static_cast<int*>(ptr) = 0;
+    EXPECT_EQ(port::NUMAGetMemAffinity(ptr), node);
+    allocator->DeallocateRaw(ptr);
+  }
+}
+
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
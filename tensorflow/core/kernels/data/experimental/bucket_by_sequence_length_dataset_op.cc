@@ -0,0 +1,797 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <deque>
+
+#include "tensorflow/core/common_runtime/input_colocation_exemption_registry.h"
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/model.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/kernels/data/captured_function.h"
+#include "tensorflow/core/kernels/data/dataset_utils.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/batch_util.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+namespace {
+
+// See documentation in ../../ops/experimental_dataset_ops.cc for a high-level
+// description of the following op.
+//
+// The dataset fuses `group_by_window` and `padded_batch` for the common case
+// where the key is the bucket of an element's length. The element lengths of
+// up to `num_parallel_calls` input elements are computed in parallel, and the
+// copies into large padded output batches are sharded across the runner
+// threadpool.
+
+constexpr char kEndOfInput[] = "end_of_input";
+constexpr char kBuckets[] = "buckets";
+constexpr char kReadyBatches[] = "ready_batches";
+constexpr char kSize[] = "size";
+constexpr char kBucketId[] = "bucket_id";
+constexpr char kPendingElements[] = "pending_elements";
+
+class BucketBySequenceLengthDatasetOp : public UnaryDatasetOpKernel {
+ public:
+  explicit BucketBySequenceLengthDatasetOp(OpKernelConstruction* ctx)
+      : UnaryDatasetOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, FunctionMetadata::Create(ctx, "element_length_func",
+                                                 /*params=*/{},
+                                                 &func_metadata_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("pad_to_bucket_boundary",
+                                     &pad_to_bucket_boundary_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("Toutput_types", &output_types_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("output_shapes", &output_shapes_));
+  }
+
+  void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
+                   DatasetBase** output) override {
+    std::unique_ptr<CapturedFunction> captured_func;
+    OP_REQUIRES_OK(ctx, CapturedFunction::Create(
+                            ctx, func_metadata_,
+                            "element_length_func_other_arguments",
+                            &captured_func));
+
+    const Tensor* bucket_boundaries_t;
+    OP_REQUIRES_OK(ctx, ctx->input("bucket_boundaries", &bucket_boundaries_t));
+    OP_REQUIRES(
+        ctx, TensorShapeUtils::IsVector(bucket_boundaries_t->shape()),
+        errors::InvalidArgument("`bucket_boundaries` must be a vector."));
+    std::vector<int64> bucket_boundaries(
+        bucket_boundaries_t->vec<int64>().data(),
+        bucket_boundaries_t->vec<int64>().data() +
+            bucket_boundaries_t->NumElements());
+
+    const Tensor* bucket_batch_sizes_t;
+    OP_REQUIRES_OK(ctx,
+                   ctx->input("bucket_batch_sizes", &bucket_batch_sizes_t));
+    OP_REQUIRES(
+        ctx, TensorShapeUtils::IsVector(bucket_batch_sizes_t->shape()),
+        errors::InvalidArgument("`bucket_batch_sizes` must be a vector."));
+    std::vector<int64> bucket_batch_sizes(
+        bucket_batch_sizes_t->vec<int64>().data(),
+        bucket_batch_sizes_t->vec<int64>().data() +
+            bucket_batch_sizes_t->NumElements());
+    OP_REQUIRES(ctx, bucket_batch_sizes.size() == bucket_boundaries.size() + 1,
+                errors::InvalidArgument(
+                    "len(bucket_batch_sizes) must equal "
+                    "len(bucket_boundaries) + 1, but got ",
+                    bucket_batch_sizes.size(), " and ",
+                    bucket_boundaries.size()));
+    for (int64 batch_size : bucket_batch_sizes) {
+      OP_REQUIRES(
+          ctx, batch_size > 0,
+          errors::InvalidArgument("Batch size must be greater than zero."));
+    }
+
+    OpInputList padded_shape_tensors;
+    OP_REQUIRES_OK(ctx,
+                   ctx->input_list("padded_shapes", &padded_shape_tensors));
+    OP_REQUIRES(ctx,
+                padded_shape_tensors.size() == input->output_shapes().size(),
+                errors::InvalidArgument("Number of padded shapes (",
+                                        padded_shape_tensors.size(),
+                                        ") must match the number of components "
+                                        "in the input dataset's elements (",
+                                        input->output_shapes().size(), ")"));
+    std::vector<PartialTensorShape> padded_shapes;
+    padded_shapes.reserve(padded_shape_tensors.size());
+    for (const Tensor& padded_shape_t : padded_shape_tensors) {
+      OP_REQUIRES(ctx, TensorShapeUtils::IsVector(padded_shape_t.shape()),
+                  errors::InvalidArgument("All padded shapes must be vectors"));
+      PartialTensorShape padded_shape;
+      OP_REQUIRES_OK(ctx, PartialTensorShape::MakePartialShape(
+                              padded_shape_t.vec<int64>().data(),
+                              padded_shape_t.NumElements(), &padded_shape));
+      padded_shapes.push_back(std::move(padded_shape));
+    }
+
+    OpInputList padding_values_list;
+    OP_REQUIRES_OK(ctx,
+                   ctx->input_list("padding_values", &padding_values_list));
+    OP_REQUIRES(ctx,
+                padding_values_list.size() == input->output_shapes().size(),
+                errors::InvalidArgument(
+                    "Number of padding values (", padding_values_list.size(),
+                    ") must match the number of components in the input "
+                    "dataset's elements (",
+                    input->output_shapes().size(), ")"));
+    std::vector<Tensor> padding_values;
+    padding_values.reserve(padding_values_list.size());
+    for (int i = 0; i < padding_values_list.size(); ++i) {
+      const Tensor& padding_value_t = padding_values_list[i];
+      OP_REQUIRES(
+          ctx, TensorShapeUtils::IsScalar(padding_value_t.shape()),
+          errors::InvalidArgument("All padding values must be scalars"));
+      OP_REQUIRES(ctx, padding_value_t.dtype() == input->output_dtypes()[i],
+                  errors::InvalidArgument(
+                      "Mismatched type between padding value ", i,
+                      " and input dataset's component ", i, ": ",
+                      DataTypeString(padding_value_t.dtype()), " vs. ",
+                      DataTypeString(input->output_dtypes()[i])));
+      padding_values.push_back(tensor::DeepCopy(padding_value_t));
+    }
+
+    bool drop_remainder;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<bool>(ctx, "drop_remainder",
+                                                  &drop_remainder));
+
+    int64 num_parallel_calls;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(ctx, "num_parallel_calls",
+                                                   &num_parallel_calls));
+    OP_REQUIRES(
+        ctx, num_parallel_calls > 0 || num_parallel_calls == model::kAutotune,
+        errors::InvalidArgument(
+            "num_parallel_calls must be greater than zero."));
+
+    *output = new Dataset(
+        ctx, input, std::move(captured_func), std::move(bucket_boundaries),
+        std::move(bucket_batch_sizes), std::move(padded_shapes),
+        std::move(padding_values), pad_to_bucket_boundary_, drop_remainder,
+        num_parallel_calls, output_types_, output_shapes_);
+  }
+
+ private:
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(OpKernelContext* ctx, const DatasetBase* input,
+            std::unique_ptr<CapturedFunction> captured_func,
+            std::vector<int64> bucket_boundaries,
+            std::vector<int64> bucket_batch_sizes,
+            std::vector<PartialTensorShape> padded_shapes,
+            std::vector<Tensor> padding_values, bool pad_to_bucket_boundary,
+            bool drop_remainder, int64 num_parallel_calls,
+            const DataTypeVector& output_types,
+            const std::vector<PartialTensorShape>& output_shapes)
+        : DatasetBase(DatasetContext(ctx)),
+          input_(input),
+          captured_func_(std::move(captured_func)),
+          bucket_boundaries_(std::move(bucket_boundaries)),
+          bucket_batch_sizes_(std::move(bucket_batch_sizes)),
+          padded_shapes_(std::move(padded_shapes)),
+          padding_values_(std::move(padding_values)),
+          pad_to_bucket_boundary_(pad_to_bucket_boundary),
+          drop_remainder_(drop_remainder),
+          num_parallel_calls_(num_parallel_calls),
+          output_types_(output_types),
+          output_shapes_(output_shapes) {
+      input_->Ref();
+    }
+
+    ~Dataset() override { input_->Unref(); }
+
+    std::unique_ptr<IteratorBase> MakeIteratorInternal(
+        const string& prefix) const override {
+      return absl::make_unique<Iterator>(Iterator::Params{
+          this, strings::StrCat(prefix, "::BucketBySequenceLength")});
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return output_types_;
+    }
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return output_shapes_;
+    }
+
+    string DebugString() const override {
+      return "BucketBySequenceLengthDatasetOp::Dataset";
+    }
+
+    int64 Cardinality() const override {
+      int64 n = input_->Cardinality();
+      if (n == kInfiniteCardinality) {
+        return n;
+      }
+      return kUnknownCardinality;
+    }
+
+    Status InputDatasets(
+        std::vector<const DatasetBase*>* inputs) const override {
+      inputs->push_back(input_);
+      return Status::OK();
+    }
+
+    Status CheckExternalState() const override {
+      TF_RETURN_IF_ERROR(captured_func_->CheckExternalState());
+      return input_->CheckExternalState();
+    }
+
+   protected:
+    Status AsGraphDefInternal(SerializationContext* ctx,
+                              DatasetGraphDefBuilder* b,
+                              Node** output) const override {
+      Node* input_graph_node = nullptr;
+      TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_graph_node));
+
+      std::vector<Node*> other_arguments;
+      DataTypeVector other_arguments_types;
+      TF_RETURN_IF_ERROR(captured_func_->AddToGraph(ctx, b, &other_arguments,
+                                                    &other_arguments_types));
+
+      Node* bucket_boundaries = nullptr;
+      TF_RETURN_IF_ERROR(b->AddVector(bucket_boundaries_, &bucket_boundaries));
+      Node* bucket_batch_sizes = nullptr;
+      TF_RETURN_IF_ERROR(
+          b->AddVector(bucket_batch_sizes_, &bucket_batch_sizes));
+
+      std::vector<Node*> padded_shapes;
+      padded_shapes.reserve(padded_shapes_.size());
+      for (int i = 0; i < padded_shapes_.size(); i++) {
+        Node* node;
+        Tensor t(DT_INT64, TensorShape({padded_shapes_[i].dims()}));
+        for (int j = 0; j < padded_shapes_[i].dims(); j++) {
+          t.vec<int64>()(j) = padded_shapes_[i].dim_size(j);
+        }
+        TF_RETURN_IF_ERROR(b->AddTensor(t, &node));
+        padded_shapes.emplace_back(node);
+      }
+
+      std::vector<Node*> padding_values;
+      padding_values.reserve(padding_values_.size());
+      for (const Tensor& t : padding_values_) {
+        Node* node;
+        TF_RETURN_IF_ERROR(b->AddTensor(t, &node));
+        padding_values.emplace_back(node);
+      }
+
+      Node* drop_remainder = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(drop_remainder_, &drop_remainder));
+      Node* num_parallel_calls = nullptr;
+      TF_RETURN_IF_ERROR(
+          b->AddScalar(num_parallel_calls_, &num_parallel_calls));
+
+      AttrValue element_length_func;
+      b->BuildAttrValue(captured_func_->func(), &element_length_func);
+      AttrValue other_arguments_types_attr;
+      b->BuildAttrValue(other_arguments_types, &other_arguments_types_attr);
+      AttrValue pad_to_bucket_boundary;
+      b->BuildAttrValue(pad_to_bucket_boundary_, &pad_to_bucket_boundary);
+      AttrValue output_types;
+      b->BuildAttrValue(output_dtypes(), &output_types);
+      AttrValue N;
+      b->BuildAttrValue<int64>(padded_shapes_.size(), &N);
+
+      TF_RETURN_IF_ERROR(b->AddDataset(
+          this,
+          {{0, input_graph_node},
+           {2, bucket_boundaries},
+           {3, bucket_batch_sizes},
+           {6, drop_remainder},
+           {7, num_parallel_calls}},
+          {{1, other_arguments}, {4, padded_shapes}, {5, padding_values}},
+          {{"element_length_func", element_length_func},
+           {"Telement_length_func_other_arguments",
+            other_arguments_types_attr},
+           {"pad_to_bucket_boundary", pad_to_bucket_boundary},
+           {"Toutput_types", output_types},
+           {"N", N}},
+          output));
+      return Status::OK();
+    }
+
+   private:
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Params& params)
+          : DatasetIterator<Dataset>(params),
+            mu_(std::make_shared<mutex>()),
+            cond_var_(std::make_shared<condition_variable>()),
+            num_parallel_calls_(std::make_shared<model::SharedState>(
+                params.dataset->num_parallel_calls_, mu_, cond_var_)),
+            buckets_(params.dataset->bucket_batch_sizes_.size()) {}
+
+      Status Initialize(IteratorContext* ctx) override {
+        {
+          mutex_lock l(*mu_);
+          if (num_parallel_calls_->value == model::kAutotune) {
+            num_parallel_calls_->value = ctx->runner_threadpool_size();
+          }
+        }
+        TF_RETURN_IF_ERROR(
+            dataset()->input_->MakeIterator(ctx, this, prefix(), &input_impl_));
+        return dataset()->captured_func_->Instantiate(ctx,
+                                                      &instantiated_func_);
+      }
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        std::pair<int64, std::vector<std::vector<Tensor>>> batch;
+        {
+          mutex_lock l(*mu_);
+          while (ready_batches_.empty() &&
+                 (!end_of_input_ || !pending_elements_.empty())) {
+            TF_RETURN_IF_ERROR(FillBuckets(ctx));
+          }
+          if (ready_batches_.empty()) {
+            *end_of_sequence = true;
+            return Status::OK();
+          }
+          batch = std::move(ready_batches_.front());
+          ready_batches_.pop_front();
+        }
+        *end_of_sequence = false;
+        return CopyBatch(ctx, batch.first, batch.second, out_tensors);
+      }
+
+     protected:
+      std::shared_ptr<model::Node> CreateNode(
+          IteratorContext* ctx, model::Node::Args args) const override {
+        return model::MakeUnknownRatioNode(
+            std::move(args),
+            {model::MakeParameter("parallelism", num_parallel_calls_, /*min=*/1,
+                                  /*max=*/ctx->runner_threadpool_size())});
+      }
+
+      Status SaveInternal(SerializationContext* ctx,
+                          IteratorStateWriter* writer) override {
+        TF_RETURN_IF_ERROR(ctx->HandleCheckExternalStateStatus(
+            dataset()->captured_func_->CheckExternalState()));
+        mutex_lock l(*mu_);
+        TF_RETURN_IF_ERROR(SaveInput(ctx, writer, input_impl_));
+        if (end_of_input_) {
+          TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kEndOfInput), ""));
+        }
+        for (int i = 0; i < buckets_.size(); ++i) {
+          TF_RETURN_IF_ERROR(SaveGroup(
+              writer, full_name(strings::StrCat(kBuckets, "[", i, "]")),
+              buckets_[i]));
+        }
+        TF_RETURN_IF_ERROR(writer->WriteScalar(
+            full_name(strings::StrCat(kReadyBatches, "_", kSize)),
+            ready_batches_.size()));
+        for (int i = 0; i < ready_batches_.size(); ++i) {
+          const string name = strings::StrCat(kReadyBatches, "[", i, "]");
+          TF_RETURN_IF_ERROR(
+              writer->WriteScalar(full_name(strings::StrCat(name, "_",
+                                                            kBucketId)),
+                                  ready_batches_[i].first));
+          TF_RETURN_IF_ERROR(
+              SaveGroup(writer, full_name(name), ready_batches_[i].second));
+        }
+        TF_RETURN_IF_ERROR(writer->WriteScalar(
+            full_name(strings::StrCat(kPendingElements, "_", kSize)),
+            pending_elements_.size()));
+        for (int i = 0; i < pending_elements_.size(); ++i) {
+          const PendingElement& pending = pending_elements_[i];
+          const string name = strings::StrCat(kPendingElements, "[", i, "]");
+          TF_RETURN_IF_ERROR(
+              writer->WriteScalar(full_name(strings::StrCat(name, "_",
+                                                            kBucketId)),
+                                  pending.bucket_id));
+          TF_RETURN_IF_ERROR(
+              WriteStatus(prefix(), name, pending.status, writer));
+          TF_RETURN_IF_ERROR(writer->WriteScalar(
+              full_name(strings::StrCat(name, "_", kSize)),
+              pending.element.size()));
+          for (int j = 0; j < pending.element.size(); ++j) {
+            TF_RETURN_IF_ERROR(writer->WriteTensor(
+                full_name(strings::StrCat(name, "[", j, "]")),
+                pending.element[j]));
+          }
+        }
+        return Status::OK();
+      }
+
+      Status RestoreInternal(IteratorContext* ctx,
+                             IteratorStateReader* reader) override {
+        mutex_lock l(*mu_);
+        TF_RETURN_IF_ERROR(RestoreInput(ctx, reader, input_impl_));
+        end_of_input_ = reader->Contains(full_name(kEndOfInput));
+        for (int i = 0; i < buckets_.size(); ++i) {
+          TF_RETURN_IF_ERROR(RestoreGroup(
+              reader, full_name(strings::StrCat(kBuckets, "[", i, "]")),
+              &buckets_[i]));
+        }
+        int64 num_ready_batches;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            full_name(strings::StrCat(kReadyBatches, "_", kSize)),
+            &num_ready_batches));
+        ready_batches_.clear();
+        ready_batches_.resize(num_ready_batches);
+        for (int i = 0; i < num_ready_batches; ++i) {
+          const string name = strings::StrCat(kReadyBatches, "[", i, "]");
+          TF_RETURN_IF_ERROR(reader->ReadScalar(
+              full_name(strings::StrCat(name, "_", kBucketId)),
+              &ready_batches_[i].first));
+          TF_RETURN_IF_ERROR(
+              RestoreGroup(reader, full_name(name), &ready_batches_[i].second));
+        }
+        int64 num_pending_elements;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            full_name(strings::StrCat(kPendingElements, "_", kSize)),
+            &num_pending_elements));
+        pending_elements_.clear();
+        pending_elements_.resize(num_pending_elements);
+        for (int i = 0; i < num_pending_elements; ++i) {
+          PendingElement& pending = pending_elements_[i];
+          const string name = strings::StrCat(kPendingElements, "[", i, "]");
+          TF_RETURN_IF_ERROR(reader->ReadScalar(
+              full_name(strings::StrCat(name, "_", kBucketId)),
+              &pending.bucket_id));
+          TF_RETURN_IF_ERROR(
+              ReadStatus(prefix(), name, reader, &pending.status));
+          int64 num_components;
+          TF_RETURN_IF_ERROR(reader->ReadScalar(
+              full_name(strings::StrCat(name, "_", kSize)), &num_components));
+          pending.element.resize(num_components);
+          for (int j = 0; j < num_components; ++j) {
+            TF_RETURN_IF_ERROR(reader->ReadTensor(
+                full_name(strings::StrCat(name, "[", j, "]")),
+                &pending.element[j]));
+          }
+        }
+        return Status::OK();
+      }
+
+     private:
+      Status SaveGroup(IteratorStateWriter* writer, const string& name,
+                       const std::vector<std::vector<Tensor>>& group)
+          TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(strings::StrCat(name, "_size"), group.size()));
+        for (int i = 0; i < group.size(); i++) {
+          TF_RETURN_IF_ERROR(writer->WriteScalar(
+              strings::StrCat(name, "[", i, "]_size"), group[i].size()));
+          for (int j = 0; j < group[i].size(); j++) {
+            TF_RETURN_IF_ERROR(writer->WriteTensor(
+                strings::StrCat(name, "[", i, "][", j, "]"), group[i][j]));
+          }
+        }
+        return Status::OK();
+      }
+
+      Status RestoreGroup(IteratorStateReader* reader, const string& name,
+                          std::vector<std::vector<Tensor>>* group)
+          TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+        int64 group_size;
+        TF_RETURN_IF_ERROR(
+            reader->ReadScalar(strings::StrCat(name, "_size"), &group_size));
+        group->clear();
+        group->resize(group_size);
+        for (int i = 0; i < group_size; i++) {
+          int64 vector_size;
+          TF_RETURN_IF_ERROR(reader->ReadScalar(
+              strings::StrCat(name, "[", i, "]_size"), &vector_size));
+          group->at(i).resize(vector_size);
+          for (int j = 0; j < vector_size; j++) {
+            TF_RETURN_IF_ERROR(reader->ReadTensor(
+                strings::StrCat(name, "[", i, "][", j, "]"), &group->at(i)[j]));
+          }
+        }
+        return Status::OK();
+      }
+
+      // Reads the next chunk of input elements and computes their lengths in
+      // parallel, unless elements of the previous chunk are still pending.
+      // Then appends the pending elements to their buckets in input order.
+      // Buckets that become full are moved to `ready_batches_`, so the order
+      // of the output batches does not depend on the degree of parallelism.
+      //
+      // If an element (or the input) fails, the error is returned and the
+      // following elements remain pending for the next call, as if the input
+      // had been processed one element at a time.
+      Status FillBuckets(IteratorContext* ctx)
+          TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+        if (pending_elements_.empty()) {
+          TF_RETURN_IF_ERROR(ReadChunk(ctx));
+        }
+
+        while (!pending_elements_.empty()) {
+          PendingElement pending = std::move(pending_elements_.front());
+          pending_elements_.pop_front();
+          TF_RETURN_IF_ERROR(pending.status);
+          const int64 bucket_id = pending.bucket_id;
+          std::vector<std::vector<Tensor>>& bucket = buckets_[bucket_id];
+          bucket.push_back(std::move(pending.element));
+          if (bucket.size() == dataset()->bucket_batch_sizes_[bucket_id]) {
+            ready_batches_.emplace_back(bucket_id, std::move(bucket));
+            bucket.clear();
+          }
+        }
+
+        if (end_of_input_) {
+          // We have consumed all of the input, so flush the remaining partial
+          // batches in bucket order.
+          for (int64 bucket_id = 0; bucket_id < buckets_.size(); ++bucket_id) {
+            std::vector<std::vector<Tensor>>& bucket = buckets_[bucket_id];
+            if (!bucket.empty() && !dataset()->drop_remainder_) {
+              ready_batches_.emplace_back(bucket_id, std::move(bucket));
+            }
+            bucket.clear();
+          }
+        }
+        return Status::OK();
+      }
+
+      // Reads up to `num_parallel_calls` input elements, computes their bucket
+      // ids in parallel, and appends them to `pending_elements_`. If the input
+      // fails after some elements have been read, the error is appended as a
+      // pending element without components.
+      Status ReadChunk(IteratorContext* ctx) TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+        // `mu_ == num_parallel_calls_->mu`, so the value may not be changed by
+        // the autotuning model while the chunk is read.
+        const int64 chunk_size = num_parallel_calls_->value;
+        std::vector<std::vector<Tensor>> elements;
+        elements.reserve(chunk_size);
+        Status input_status;
+        for (int64 i = 0; i < chunk_size && !end_of_input_; ++i) {
+          std::vector<Tensor> element;
+          input_status = input_impl_->GetNext(ctx, &element, &end_of_input_);
+          if (!input_status.ok()) {
+            if (elements.empty()) {
+              return input_status;
+            }
+            break;
+          }
+          if (!end_of_input_) {
+            elements.push_back(std::move(element));
+          }
+        }
+
+        const size_t num_elements = elements.size();
+        std::vector<int64> bucket_ids(num_elements);
+        std::vector<Status> statuses(num_elements);
+        if (num_elements == 1) {
+          statuses[0] =
+              ComputeBucketId(ctx, elements[0], model_node(), &bucket_ids[0]);
+        } else if (num_elements > 1) {
+          // The calls below record their processing time on the model node
+          // from the runner threads, so this thread must not be recording
+          // while it waits for them.
+          std::shared_ptr<model::Node> node = model_node();
+          BlockingCounter counter(num_elements);
+          RecordStop(ctx);
+          for (size_t i = 0; i < num_elements; ++i) {
+            (*ctx->runner())([this, ctx, i, &node, &elements, &bucket_ids,
+                              &statuses, &counter]() {
+              RecordStart(ctx);
+              statuses[i] =
+                  ComputeBucketId(ctx, elements[i], node, &bucket_ids[i]);
+              RecordStop(ctx);
+              counter.DecrementCount();
+            });
+          }
+          counter.Wait();
+          RecordStart(ctx);
+        }
+
+        for (size_t i = 0; i < num_elements; ++i) {
+          pending_elements_.push_back(
+              {std::move(elements[i]), bucket_ids[i], statuses[i]});
+        }
+        if (!input_status.ok()) {
+          pending_elements_.push_back({{}, -1, input_status});
+        }
+        return Status::OK();
+      }
+
+      Status ComputeBucketId(IteratorContext* ctx,
+                             const std::vector<Tensor>& element,
+                             const std::shared_ptr<model::Node>& node,
+                             int64* bucket_id) {
+        std::vector<Tensor> length_output;
+        TF_RETURN_IF_ERROR(instantiated_func_->RunWithBorrowedArgs(
+            ctx, element, &length_output, node));
+        if (length_output.size() != 1 ||
+            !TensorShapeUtils::IsScalar(length_output[0].shape()) ||
+            (length_output[0].dtype() != DT_INT32 &&
+             length_output[0].dtype() != DT_INT64)) {
+          return errors::InvalidArgument(
+              "`element_length_func` must return a scalar int32 or int64.");
+        }
+        const int64 length = length_output[0].dtype() == DT_INT32
+                                 ? length_output[0].scalar<int32>()()
+                                 : length_output[0].scalar<int64>()();
+
+        // Bucket `i` holds the elements with length in
+        // [bucket_boundaries[i - 1], bucket_boundaries[i]), where the first
+        // and the last bucket are bounded by the range of int32.
+        const std::vector<int64>& boundaries = dataset()->bucket_boundaries_;
+        for (int64 i = 0; i <= boundaries.size(); ++i) {
+          const int64 lower = i == 0 ? kint32min : boundaries[i - 1];
+          const int64 upper =
+              i == boundaries.size() ? kint32max : boundaries[i];
+          if (lower <= length && length < upper) {
+            *bucket_id = i;
+            return Status::OK();
+          }
+        }
+        return errors::InvalidArgument("Element of length ", length,
+                                       " does not belong to any bucket.");
+      }
+
+      // Copies the elements of `batch` into one padded output tensor per
+      // tuple component.
+      Status CopyBatch(IteratorContext* ctx, int64 bucket_id,
+                       const std::vector<std::vector<Tensor>>& batch_elements,
+                       std::vector<Tensor>* out_tensors) {
+        int64 bucket_padded_size = -1;
+        if (dataset()->pad_to_bucket_boundary_) {
+          if (bucket_id == dataset()->bucket_boundaries_.size()) {
+            return errors::InvalidArgument(
+                "When pad_to_bucket_boundary=True, elements must have length "
+                "< max(bucket_boundaries).");
+          }
+          bucket_padded_size = dataset()->bucket_boundaries_[bucket_id] - 1;
+        }
+
+        const size_t num_tuple_components = batch_elements[0].size();
+        const int64 num_batch_elements = batch_elements.size();
+        for (size_t component_index = 0; component_index < num_tuple_components;
+             ++component_index) {
+          // 1. Determine the shape of the padded tensor.
+          TensorShape batch_component_shape({num_batch_elements});
+          const PartialTensorShape& padded_shape =
+              dataset()->padded_shapes_[component_index];
+          for (int dim = 0; dim < padded_shape.dims(); ++dim) {
+            if (padded_shape.dim_size(dim) != -1) {
+              batch_component_shape.AddDim(padded_shape.dim_size(dim));
+            } else if (bucket_padded_size != -1) {
+              batch_component_shape.AddDim(bucket_padded_size);
+            } else {
+              batch_component_shape.AddDim(0);
+            }
+          }
+
+          for (int64 i = 0; i < num_batch_elements; ++i) {
+            const TensorShape& element_shape =
+                batch_elements[i][component_index].shape();
+            if (element_shape.dims() != padded_shape.dims()) {
+              return errors::InvalidArgument(
+                  "All elements in a batch must have the same rank as the "
+                  "padded shape for component",
+                  component_index, ": expected rank ", padded_shape.dims(),
+                  " but got element with rank ", element_shape.dims());
+            }
+            for (int dim = 0; dim < padded_shape.dims(); ++dim) {
+              if (element_shape.dim_size(dim) <=
+                  batch_component_shape.dim_size(dim + 1)) {
+                continue;
+              }
+              if (padded_shape.dim_size(dim) == -1 &&
+                  bucket_padded_size == -1) {
+                // Take the max of all batch elements in this dimension.
+                batch_component_shape.set_dim(dim + 1,
+                                              element_shape.dim_size(dim));
+              } else {
+                return errors::DataLoss(
+                    "Attempted to pad to a smaller size than the input "
+                    "element.");
+              }
+            }
+          }
+
+          // 2. Copy each batch element to the appropriate location in the
+          // output component tensor.
+          out_tensors->emplace_back(ctx->allocator({}),
+                                    output_dtypes()[component_index],
+                                    batch_component_shape);
+          Tensor& batch_component = out_tensors->back();
+          TF_RETURN_IF_ERROR(batch_util::SetElementZero(
+              &batch_component,
+              dataset()->padding_values_[component_index]));
+
+          TensorShape component_shape(batch_component_shape);
+          component_shape.RemoveDim(0);
+          auto copy_element_fn = [component_index, &batch_elements,
+                                  &batch_component,
+                                  &component_shape](int64 index) {
+            // Take the fast path if possible.
+            if (batch_elements[index][component_index].shape() ==
+                component_shape) {
+              return batch_util::CopyElementToSlice(
+                  batch_elements[index][component_index], &batch_component,
+                  index);
+            }
+            return batch_util::CopyElementToLargerSlice(
+                batch_elements[index][component_index], &batch_component,
+                index);
+          };
+          TF_RETURN_IF_ERROR(ParallelCopy(
+              ctx, /*parallel_copy=*/false, /*shard_large_copies=*/true,
+              num_batch_elements,
+              batch_component.TotalBytes() / num_batch_elements,
+              copy_element_fn));
+        }
+        return Status::OK();
+      }
+
+      // An input element whose bucket id has been computed, but which has not
+      // been added to its bucket yet.
+      struct PendingElement {
+        std::vector<Tensor> element;
+        int64 bucket_id = -1;
+        // The status of computing the bucket id. If it is an error, it is
+        // returned instead of adding the element to a bucket.
+        Status status;
+      };
+
+      // Guards the iterator state. It is shared with `num_parallel_calls_` so
+      // that the autotuning model can update the parallelism.
+      const std::shared_ptr<mutex> mu_;
+      const std::shared_ptr<condition_variable> cond_var_;
+      // Identifies the maximum number of elements whose bucket ids are computed
+      // in parallel.
+      const std::shared_ptr<model::SharedState> num_parallel_calls_;
+      std::unique_ptr<IteratorBase> input_impl_ TF_GUARDED_BY(*mu_);
+      bool end_of_input_ TF_GUARDED_BY(*mu_) = false;
+      // Elements of the batches that are still being filled, indexed by
+      // bucket.
+      std::vector<std::vector<std::vector<Tensor>>> buckets_
+          TF_GUARDED_BY(*mu_);
+      // Full (or, at the end of the input, partial) batches in the order in
+      // which they are produced, along with the bucket they belong to.
+      std::deque<std::pair<int64, std::vector<std::vector<Tensor>>>>
+          ready_batches_ TF_GUARDED_BY(*mu_);
+      // Elements of the last chunk that have not been added to their buckets,
+      // because a preceding element failed.
+      std::deque<PendingElement> pending_elements_ TF_GUARDED_BY(*mu_);
+      std::unique_ptr<InstantiatedCapturedFunction> instantiated_func_;
+    };
+
+    const DatasetBase* const input_;
+    const std::unique_ptr<CapturedFunction> captured_func_;
+    const std::vector<int64> bucket_boundaries_;
+    const std::vector<int64> bucket_batch_sizes_;
+    const std::vector<PartialTensorShape> padded_shapes_;
+    const std::vector<Tensor> padding_values_;
+    const bool pad_to_bucket_boundary_;
+    const bool drop_remainder_;
+    const int64 num_parallel_calls_;
+    const DataTypeVector output_types_;
+    const std::vector<PartialTensorShape> output_shapes_;
+  };
+
+  std::shared_ptr<FunctionMetadata> func_metadata_ = nullptr;
+  bool pad_to_bucket_boundary_;
+  DataTypeVector output_types_;
+  std::vector<PartialTensorShape> output_shapes_;
+};
+
+REGISTER_KERNEL_BUILDER(
+    Name("BucketBySequenceLengthDataset").Device(DEVICE_CPU),
+    BucketBySequenceLengthDatasetOp);
+
+REGISTER_INPUT_COLOCATION_EXEMPTION("BucketBySequenceLengthDataset");
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
@@ -12,6 +12,15 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <algorithm>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "tensorflow/core/framework/common_shape_fns.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/op.h"
@@ -26,6 +35,79 @@ namespace data {
 namespace experimental {
 namespace {
 
+#if defined(__AVX2__) || defined(__SSE2__)
+// Returns the index of the lowest set bit of `mask`, which must be non-zero.
+inline int CountTrailingZeros(uint32 mask) {
+#ifdef __GNUC__
+  return __builtin_ctz(mask);
+#else
+  int n = 0;
+  while ((mask & 1u) == 0u) {
+    mask >>= 1;
+    ++n;
+  }
+  return n;
+#endif
+}
+#endif
+
+// Returns a pointer to the first character in [begin, end) which can end an
+// unquoted field: `delim`, '\n', '\r', or, if `quote` is true, '"'. Returns
+// `end` if there is no such character. Fields are typically much longer than
+// the handful of characters we look for, so we compare a full vector register
+// of input at a time where SIMD instructions are available.
+const char* FindFieldEnd(const char* begin, const char* end, char delim,
+                         bool quote) {
+  // When quotes are not special, compare against `delim` twice instead.
+  const char quote_char = quote ? '"' : delim;
+#if defined(__AVX2__)
+  const __m256i delim_v = _mm256_set1_epi8(delim);
+  const __m256i newline_v = _mm256_set1_epi8('\n');
+  const __m256i return_v = _mm256_set1_epi8('\r');
+  const __m256i quote_v = _mm256_set1_epi8(quote_char);
+  while (end - begin >= 32) {
+    const __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+    const __m256i matches = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, delim_v),
+                        _mm256_cmpeq_epi8(chunk, newline_v)),
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, return_v),
+                        _mm256_cmpeq_epi8(chunk, quote_v)));
+    const uint32 mask = static_cast<uint32>(_mm256_movemask_epi8(matches));
+    if (mask != 0) {
+      return begin + CountTrailingZeros(mask);
+    }
+    begin += 32;
+  }
+#elif defined(__SSE2__)
+  const __m128i delim_v = _mm_set1_epi8(delim);
+  const __m128i newline_v = _mm_set1_epi8('\n');
+  const __m128i return_v = _mm_set1_epi8('\r');
+  const __m128i quote_v = _mm_set1_epi8(quote_char);
+  while (end - begin >= 16) {
+    const __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+    const __m128i matches =
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, delim_v),
+                                  _mm_cmpeq_epi8(chunk, newline_v)),
+                     _mm_or_si128(_mm_cmpeq_epi8(chunk, return_v),
+                                  _mm_cmpeq_epi8(chunk, quote_v)));
+    const uint32 mask = static_cast<uint32>(_mm_movemask_epi8(matches));
+    if (mask != 0) {
+      return begin + CountTrailingZeros(mask);
+    }
+    begin += 16;
+  }
+#endif
+  for (; begin < end; ++begin) {
+    const char ch = *begin;
+    if (ch == delim || ch == '\n' || ch == '\r' || ch == quote_char) {
+      return begin;
+    }
+  }
+  return end;
+}
+
 class CSVDatasetOp : public DatasetOpKernel {
  public:
   explicit CSVDatasetOp(OpKernelConstruction* ctx)
@@ -33,6 +115,9 @@ class CSVDatasetOp : public DatasetOpKernel {
         op_version_(ctx->def().op() == "CSVDatasetV2" ? 2 : 1) {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("output_types", &output_types_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("output_shapes", &output_shapes_));
+    if (op_version_ > 1) {
+      OP_REQUIRES_OK(ctx, ctx->GetAttr("batch_size", &batch_size_));
+    }
   }
 
   void MakeDataset(OpKernelContext* ctx, DatasetBase** output) override {
@@ -157,7 +242,7 @@ class CSVDatasetOp : public DatasetOpKernel {
                           output_types_, output_shapes_,
                           std::move(record_defaults), std::move(select_cols),
                           std::move(exclude_cols), use_quote_delim, delim[0],
-                          std::move(na_value), op_version_);
+                          std::move(na_value), op_version_, batch_size_);
   }
 
  private:
@@ -169,7 +254,7 @@ class CSVDatasetOp : public DatasetOpKernel {
             const std::vector<PartialTensorShape>& output_shapes,
             std::vector<Tensor> record_defaults, std::vector<int64> select_cols,
             std::vector<int64> exclude_cols, bool use_quote_delim, char delim,
-            string na_value, int op_version)
+            string na_value, int op_version, int64 batch_size)
         : DatasetBase(DatasetContext(ctx)),
           filenames_(std::move(filenames)),
           header_(header),
@@ -182,6 +267,7 @@ class CSVDatasetOp : public DatasetOpKernel {
           delim_(delim),
           na_value_(std::move(na_value)),
           op_version_(op_version),
+          batch_size_(batch_size),
           use_compression_(!compression_type.empty()),
           compression_type_(std::move(compression_type)),
           options_(options) {}
@@ -238,6 +324,14 @@ class CSVDatasetOp : public DatasetOpKernel {
       TF_RETURN_IF_ERROR(b->AddVector(exclude_cols_, &exclude_cols));
 
       if (op_version_ > 1) {
+        // The attr is only added when batching, so that graphs which don't
+        // batch can still be read by binaries that predate it.
+        std::vector<std::pair<StringPiece, AttrValue>> attrs;
+        if (batch_size_ > 0) {
+          AttrValue batch_size_attr;
+          b->BuildAttrValue(batch_size_, &batch_size_attr);
+          attrs.emplace_back("batch_size", batch_size_attr);
+        }
         TF_RETURN_IF_ERROR(b->AddDataset(
             this,
             {std::make_pair(0, filenames), std::make_pair(1, compression_type),
@@ -246,7 +340,7 @@ class CSVDatasetOp : public DatasetOpKernel {
              std::make_pair(6, na_value), std::make_pair(7, select_cols),
              std::make_pair(9, exclude_cols)},     // Single tensor inputs
             {std::make_pair(8, record_defaults)},  // Tensor list inputs
-            {}, output));
+            attrs, output));
       } else {
         TF_RETURN_IF_ERROR(b->AddDataset(
             this,
@@ -276,42 +370,11 @@ class CSVDatasetOp : public DatasetOpKernel {
                              std::vector<Tensor>* out_tensors,
                              bool* end_of_sequence) override {
         mutex_lock l(mu_);
-        bool select_all =
-            dataset()->select_cols_.empty() && dataset()->exclude_cols_.empty();
-        do {
-          // We are currently processing a file, so try to read the next record
-          if (input_stream_) {
-            Status s =
-                ReadRecord(ctx, out_tensors, select_all,
-                           dataset()->select_cols_, dataset()->exclude_cols_);
-            if (s.ok()) {
-              // Validate output
-              if (out_tensors->size() != dataset()->out_type_.size()) {
-                return errors::InvalidArgument(
-                    "Expect ", dataset()->out_type_.size(), " fields but have ",
-                    out_tensors->size(), " in record");
-              }
-
-              *end_of_sequence = false;
-              return s;
-            }
-            if (!errors::IsOutOfRange(s)) {
-              // Not at the end of file, return OK or non-EOF errors to caller.
-              *end_of_sequence = false;
-              return s;
-            }
-            // We have reached the end of the current file, so maybe
-            // move on to next file.
-            ResetStreamsLocked();
-            ++current_file_index_;
-          }
-          // Iteration ends when there are no more files to process.
-          if (current_file_index_ == dataset()->filenames_.size()) {
-            *end_of_sequence = true;
-            return Status::OK();
-          }
-          TF_RETURN_IF_ERROR(SetupStreamsLocked(ctx->env()));
-        } while (true);
+        if (dataset()->batch_size_ > 0) {
+          return GetNextBatch(ctx, out_tensors, end_of_sequence);
+        }
+        RecordOutput out(out_tensors);
+        return ReadNextRecord(ctx, &out, end_of_sequence);
       }
 
      protected:
@@ -378,15 +441,112 @@ class CSVDatasetOp : public DatasetOpKernel {
       }
 
      private:
+      // The destination of the fields of a record.
+      struct RecordOutput {
+        explicit RecordOutput(std::vector<Tensor>* tensors, int64 row = -1)
+            : tensors(tensors), row(row) {}
+
+        // The output components. If `row` is -1, each field is appended as a
+        // scalar component. Otherwise, `tensors` holds one vector per
+        // component, and each field is written to element `row` of its
+        // component.
+        std::vector<Tensor>* tensors;
+        const int64 row;
+        // The number of fields of the record converted so far.
+        size_t num_fields = 0;
+      };
+
+      // Reads the next record into `out`, moving on to the next file when the
+      // current one is exhausted. Sets `*end_of_input` if there are no more
+      // records in any file.
+      Status ReadNextRecord(IteratorContext* ctx, RecordOutput* out,
+                            bool* end_of_input)
+          TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        bool select_all =
+            dataset()->select_cols_.empty() && dataset()->exclude_cols_.empty();
+        do {
+          // We are currently processing a file, so try to read the next record
+          if (input_stream_) {
+            Status s = ReadRecord(ctx, out, select_all, dataset()->select_cols_,
+                                  dataset()->exclude_cols_);
+            if (s.ok()) {
+              // Validate output
+              if (out->num_fields != dataset()->out_type_.size()) {
+                return errors::InvalidArgument(
+                    "Expect ", dataset()->out_type_.size(), " fields but have ",
+                    out->num_fields, " in record");
+              }
+
+              *end_of_input = false;
+              return s;
+            }
+            if (!errors::IsOutOfRange(s)) {
+              // Not at the end of file, return OK or non-EOF errors to caller.
+              *end_of_input = false;
+              return s;
+            }
+            // We have reached the end of the current file, so maybe
+            // move on to next file.
+            ResetStreamsLocked();
+            ++current_file_index_;
+          }
+          // Iteration ends when there are no more files to process.
+          if (current_file_index_ == dataset()->filenames_.size()) {
+            *end_of_input = true;
+            return Status::OK();
+          }
+          TF_RETURN_IF_ERROR(SetupStreamsLocked(ctx->env()));
+        } while (true);
+      }
+
+      // Reads up to `batch_size_` records, converting their fields directly
+      // into one vector per component. The last batch may be smaller. An
+      // invalid record fails the whole batch, but the next call continues
+      // with the record after it.
+      Status GetNextBatch(IteratorContext* ctx,
+                          std::vector<Tensor>* out_tensors,
+                          bool* end_of_sequence)
+          TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        const int64 batch_size = dataset()->batch_size_;
+        out_tensors->clear();
+        out_tensors->reserve(dataset()->out_type_.size());
+        for (DataType dtype : dataset()->out_type_) {
+          out_tensors->emplace_back(ctx->allocator({}), dtype,
+                                    TensorShape({batch_size}));
+        }
+        int64 num_records = 0;
+        while (num_records < batch_size) {
+          RecordOutput out(out_tensors, num_records);
+          bool end_of_input = false;
+          TF_RETURN_IF_ERROR(ReadNextRecord(ctx, &out, &end_of_input));
+          if (end_of_input) {
+            break;
+          }
+          ++num_records;
+        }
+        if (num_records == 0) {
+          out_tensors->clear();
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        if (num_records < batch_size) {
+          for (Tensor& component : *out_tensors) {
+            component = component.Slice(0, num_records);
+          }
+        }
+        *end_of_sequence = false;
+        return Status::OK();
+      }
+
       // Reads an entire CSV row from the input stream, either from the
       // existing buffer or by filling the buffer as needed. Converts extracted
       // fields to output tensors as we go.
       //
       // When this function is called, pos_ should be the index of the first
       // character of the record in buffer_, or past the end of the buffer.
-      // Note: ctx and out_tensors are only used in this function
+      // Note: ctx and out are only used in this function
       // when fields are included in the record.
-      Status ReadRecord(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
+      Status ReadRecord(IteratorContext* ctx, RecordOutput* out,
                         bool select_all, const std::vector<int64>& selected,
                         const std::vector<int64>& excluded)
           TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
@@ -416,8 +576,7 @@ class CSVDatasetOp : public DatasetOpKernel {
 
           // Don't fail fast, so that the next call to GetNext may still return
           // a valid record
-          result.Update(
-              ParseOneField(ctx, out_tensors, &end_of_record, include));
+          result.Update(ParseOneField(ctx, out, &end_of_record, include));
 
           num_parsed++;
           if (include) num_selected_parsed++;
@@ -430,8 +589,7 @@ class CSVDatasetOp : public DatasetOpKernel {
       // Parses one field from position pos_ in the buffer. Fields are
       // delimited by delim, CRLF, or EOF. Advances pos_ to the first char of
       // the next field.
-      Status ParseOneField(IteratorContext* ctx,
-                           std::vector<Tensor>* out_tensors,
+      Status ParseOneField(IteratorContext* ctx, RecordOutput* out,
                            bool* end_of_record, bool include)
           TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
         if (pos_ >= buffer_.size()) {
@@ -443,7 +601,7 @@ class CSVDatasetOp : public DatasetOpKernel {
             // Reached EOF, and last field is empty
             *end_of_record = true;
             if (include) {
-              return FieldToOutput(ctx, StringPiece(), out_tensors);
+              return FieldToOutput(ctx, StringPiece(), out);
             } else {
               return Status::OK();
             }
@@ -455,10 +613,10 @@ class CSVDatasetOp : public DatasetOpKernel {
         }
 
         if (dataset()->use_quote_delim_ && buffer_[pos_] == '"') {
-          return ParseQuotedField(ctx, out_tensors, end_of_record, include);
+          return ParseQuotedField(ctx, out, end_of_record, include);
         }
 
-        return ParseUnquotedField(ctx, out_tensors, end_of_record, include);
+        return ParseUnquotedField(ctx, out, end_of_record, include);
       }
 
       // For keeping track of relevant parts of a field from a previous buffer
@@ -493,8 +651,7 @@ class CSVDatasetOp : public DatasetOpKernel {
       // reads from buffer until end of field is reached (delim, CRLF, or EOF).
       // Advances pos_ to keep track of our position in the buffer as we go,
       // stopping at the first character of the next field.
-      Status ParseQuotedField(IteratorContext* ctx,
-                              std::vector<Tensor>* out_tensors,
+      Status ParseQuotedField(IteratorContext* ctx, RecordOutput* out,
                               bool* end_of_record, bool include)
           TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
         std::vector<Piece> earlier_pieces;
@@ -502,7 +659,8 @@ class CSVDatasetOp : public DatasetOpKernel {
         pos_++;  // Starting quotation mark
 
         Status parse_result;
-        while (true) {  // Each iter reads 1 char, filling buffer if necessary
+        while (true) {  // Each iter scans to the next quote, filling buffer
+                        // if necessary
           if (pos_ >= buffer_.size()) {
             Status s = SaveAndFillBuffer(&earlier_pieces, &start, include);
             if (errors::IsOutOfRange(s)) {
@@ -525,7 +683,7 @@ class CSVDatasetOp : public DatasetOpKernel {
                 // This was the last field. We are done
                 *end_of_record = true;
                 parse_result.Update(QuotedFieldToOutput(
-                    ctx, StringPiece(), out_tensors, earlier_pieces, include));
+                    ctx, StringPiece(), out, earlier_pieces, include));
                 return parse_result;
               } else if (!s.ok()) {
                 return s;
@@ -536,15 +694,15 @@ class CSVDatasetOp : public DatasetOpKernel {
             pos_++;
             if (next == dataset()->delim_) {
               parse_result.Update(QuotedFieldToOutput(
-                  ctx, StringPiece(&buffer_[start], pos_ - 1 - start),
-                  out_tensors, earlier_pieces, include));
+                  ctx, StringPiece(&buffer_[start], pos_ - 1 - start), out,
+                  earlier_pieces, include));
               return parse_result;
 
             } else if (next == '\n' || next == '\r') {
               *end_of_record = true;
               parse_result.Update(QuotedFieldToOutput(
-                  ctx, StringPiece(&buffer_[start], pos_ - 1 - start),
-                  out_tensors, earlier_pieces, include));
+                  ctx, StringPiece(&buffer_[start], pos_ - 1 - start), out,
+                  earlier_pieces, include));
               if (next == '\r') SkipNewLineIfNecessary();
               return parse_result;
             } else if (next != '"') {
@@ -556,7 +714,13 @@ class CSVDatasetOp : public DatasetOpKernel {
             }
 
           } else {
-            pos_++;
+            // Only a quote can end a quoted field, so skip straight to the
+            // next one.
+            const void* quote = std::memchr(&buffer_[pos_], '"',
+                                            buffer_.size() - pos_);
+            pos_ = quote == nullptr
+                       ? buffer_.size()
+                       : static_cast<const char*>(quote) - buffer_.data();
           }
         }
       }
@@ -565,7 +729,7 @@ class CSVDatasetOp : public DatasetOpKernel {
       // and ending quotes from it and unescaping double quotations if
       // necessary.
       Status QuotedFieldToOutput(IteratorContext* ctx, StringPiece field,
-                                 std::vector<Tensor>* out_tensors,
+                                 RecordOutput* out,
                                  const std::vector<Piece>& earlier_pieces,
                                  bool include)
           TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
@@ -577,7 +741,7 @@ class CSVDatasetOp : public DatasetOpKernel {
             // Exclude framing quotation marks
             field.remove_prefix(1);
             field.remove_suffix(1);
-            return FieldToOutput(ctx, field, out_tensors);
+            return FieldToOutput(ctx, field, out);
           }
         }
         string field_complete;
@@ -601,7 +765,7 @@ class CSVDatasetOp : public DatasetOpKernel {
         StringPiece result = StringPiece(field_complete);
         result.remove_suffix(1);  // Skip final quote
 
-        return FieldToOutput(ctx, result, out_tensors);
+        return FieldToOutput(ctx, result, out);
       }
 
       void AppendUnescapedPiece(StringPiece piece, string* field_complete,
@@ -627,15 +791,15 @@ class CSVDatasetOp : public DatasetOpKernel {
       // reads from buffer until end of field is reached (delim, CRLF, or EOF).
       // Advances pos_ to keep track of our position in the buffer as we go,
       // stopping at the first character of the next field.
-      Status ParseUnquotedField(IteratorContext* ctx,
-                                std::vector<Tensor>* out_tensors,
+      Status ParseUnquotedField(IteratorContext* ctx, RecordOutput* out,
                                 bool* end_of_record, bool include)
           TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
         std::vector<Piece> earlier_pieces;
         size_t start = pos_;
         Status parse_result;
 
-        while (true) {  // Each iter reads 1 char, filling buffer if necessary
+        while (true) {  // Each iter scans to the next special char, filling
+                        // buffer if necessary
           if (pos_ >= buffer_.size()) {
             Status s = SaveAndFillBuffer(&earlier_pieces, &start, include);
             // Handle errors
@@ -643,7 +807,7 @@ class CSVDatasetOp : public DatasetOpKernel {
               // Whatever we have is the last field of the last record
               *end_of_record = true;
               parse_result.Update(UnquotedFieldToOutput(
-                  ctx, StringPiece(&buffer_[start], pos_ - start), out_tensors,
+                  ctx, StringPiece(&buffer_[start], pos_ - start), out,
                   earlier_pieces, include));
               return parse_result;
             } else if (!s.ok()) {
@@ -651,11 +815,20 @@ class CSVDatasetOp : public DatasetOpKernel {
             }
           }
 
+          // Skip the ordinary characters in the field in bulk.
+          pos_ = FindFieldEnd(buffer_.data() + pos_,
+                              buffer_.data() + buffer_.size(),
+                              dataset()->delim_, dataset()->use_quote_delim_) -
+                 buffer_.data();
+          if (pos_ >= buffer_.size()) {
+            continue;
+          }
+
           char ch = buffer_[pos_];
 
           if (ch == dataset()->delim_) {
             parse_result.Update(UnquotedFieldToOutput(
-                ctx, StringPiece(&buffer_[start], pos_ - start), out_tensors,
+                ctx, StringPiece(&buffer_[start], pos_ - start), out,
                 earlier_pieces, include));
             pos_++;
             return parse_result;
@@ -664,7 +837,7 @@ class CSVDatasetOp : public DatasetOpKernel {
             // need special case to skip over first \n of record if the line
             // breaks are \r\n
             parse_result.Update(UnquotedFieldToOutput(
-                ctx, StringPiece(&buffer_[start], pos_ - start), out_tensors,
+                ctx, StringPiece(&buffer_[start], pos_ - start), out,
                 earlier_pieces, include));
             *end_of_record = true;
             pos_++;
@@ -694,19 +867,26 @@ class CSVDatasetOp : public DatasetOpKernel {
         return s;
       }
 
-      // Given a field, converts it to the right output tensor type
+      // Given a field, converts it to the right output tensor type, writing
+      // the value directly into its output component. When batching, the
+      // components are the column vectors of the whole batch.
       Status FieldToOutput(IteratorContext* ctx, StringPiece field,
-                           std::vector<Tensor>* out_tensors) {
-        size_t output_idx = out_tensors->size();
+                           RecordOutput* out) {
+        size_t output_idx = out->num_fields;
         if (output_idx >= dataset()->out_type_.size()) {
           // We can get here if we're selecting all columns, but the number of
           // fields exceeds the number of defaults provided
           return errors::InvalidArgument("Expect ", dataset()->out_type_.size(),
                                          " fields but have more in record");
         }
+        ++out->num_fields;
         const DataType& dtype = dataset()->out_type_[output_idx];
-        out_tensors->emplace_back(ctx->allocator({}), dtype, TensorShape({}));
-        Tensor& component = out_tensors->back();
+        if (out->row < 0) {
+          out->tensors->emplace_back(ctx->allocator({}), dtype,
+                                     TensorShape({}));
+        }
+        Tensor& component = (*out->tensors)[output_idx];
+        const int64 row = std::max<int64>(out->row, 0);
         if ((field.empty() || field == dataset()->na_value_) &&
             dataset()->record_defaults_[output_idx].NumElements() != 1) {
           // If the field is empty or NA value, and default is not given,
@@ -720,7 +900,7 @@ class CSVDatasetOp : public DatasetOpKernel {
           // Otherwise, we convert it to the right type.
           case DT_INT32: {
             if (field.empty() || field == dataset()->na_value_) {
-              component.scalar<int32>()() =
+              component.flat<int32>()(row) =
                   dataset()->record_defaults_[output_idx].flat<int32>()(0);
             } else {
               int32 value;
@@ -729,13 +909,13 @@ class CSVDatasetOp : public DatasetOpKernel {
                     "Field ", output_idx,
                     " in record is not a valid int32: ", field);
               }
-              component.scalar<int32>()() = value;
+              component.flat<int32>()(row) = value;
             }
             break;
           }
           case DT_INT64: {
             if (field.empty() || field == dataset()->na_value_) {
-              component.scalar<int64>()() =
+              component.flat<int64>()(row) =
                   dataset()->record_defaults_[output_idx].flat<int64>()(0);
             } else {
               int64 value;
@@ -744,13 +924,13 @@ class CSVDatasetOp : public DatasetOpKernel {
                     "Field ", output_idx,
                     " in record is not a valid int64: ", field);
               }
-              component.scalar<int64>()() = value;
+              component.flat<int64>()(row) = value;
             }
             break;
           }
           case DT_FLOAT: {
             if (field.empty() || field == dataset()->na_value_) {
-              component.scalar<float>()() =
+              component.flat<float>()(row) =
                   dataset()->record_defaults_[output_idx].flat<float>()(0);
             } else {
               float value;
@@ -759,13 +939,13 @@ class CSVDatasetOp : public DatasetOpKernel {
                     "Field ", output_idx,
                     " in record is not a valid float: ", field);
               }
-              component.scalar<float>()() = value;
+              component.flat<float>()(row) = value;
             }
             break;
           }
           case DT_DOUBLE: {
             if (field.empty() || field == dataset()->na_value_) {
-              component.scalar<double>()() =
+              component.flat<double>()(row) =
                   dataset()->record_defaults_[output_idx].flat<double>()(0);
             } else {
               double value;
@@ -774,16 +954,16 @@ class CSVDatasetOp : public DatasetOpKernel {
                     "Field ", output_idx,
                     " in record is not a valid double: ", field);
               }
-              component.scalar<double>()() = value;
+              component.flat<double>()(row) = value;
             }
             break;
           }
           case DT_STRING: {
             if (field.empty() || field == dataset()->na_value_) {
-              component.scalar<tstring>()() =
+              component.flat<tstring>()(row) =
                   dataset()->record_defaults_[output_idx].flat<tstring>()(0);
             } else {
-              component.scalar<tstring>()() = string(field);
+              component.flat<tstring>()(row).assign(field.data(), field.size());
             }
             break;
           }
@@ -813,16 +993,16 @@ class CSVDatasetOp : public DatasetOpKernel {
 
       // Given a string field, and its index in the output,
       // converts it to a Tensor of the right type and adds it to the
-      // out_tensors vector.
+      // out vector.
       Status UnquotedFieldToOutput(IteratorContext* ctx, StringPiece field,
-                                   std::vector<Tensor>* out_tensors,
+                                   RecordOutput* out,
                                    const std::vector<Piece>& earlier_pieces,
                                    bool include)
           TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
         if (!include) return Status::OK();
 
         if (earlier_pieces.empty()) {
-          return FieldToOutput(ctx, field, out_tensors);
+          return FieldToOutput(ctx, field, out);
         }
 
         size_t str_len = field.size();
@@ -837,7 +1017,7 @@ class CSVDatasetOp : public DatasetOpKernel {
         }
 
         field_complete.append(field.data(), field.size());
-        return FieldToOutput(ctx, field_complete, out_tensors);
+        return FieldToOutput(ctx, field_complete, out);
       }
 
       // Sets up reader streams to read from the file at `current_file_index_`.
@@ -911,12 +1091,15 @@ class CSVDatasetOp : public DatasetOpKernel {
     const char delim_;
     const tstring na_value_;
     const int op_version_;
+    // If positive, the number of records in each element.
+    const int64 batch_size_;
     const bool use_compression_;
     const tstring compression_type_;
     const io::ZlibCompressionOptions options_;
   };  // class Dataset
 
   const int op_version_;
+  int64 batch_size_ = 0;
 
   DataTypeVector output_types_;
   std::vector<PartialTensorShape> output_shapes_;
@@ -14,10 +14,12 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/experimental/data_service_dataset_op.h"
 
+#include <algorithm>
 #include <limits>
 #include <map>
 #include <memory>
 #include <queue>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
@@ -29,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/data/service/worker.pb.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
 #include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/model.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -40,6 +43,7 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/random.h"
 #include "tensorflow/core/platform/snappy.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
@@ -71,6 +75,8 @@ namespace data {
 namespace {
 // Default interval between task list refreshes.
 const int64 kDefaultTaskRefreshIntervalMs = 1000;  // 1 second.
+// Maximum number of elements to ask a worker for in a single request.
+const int64 kMaxElementsPerRequest = 16;
 
 constexpr char kDataServiceDatasetV1[] = "DataServiceDataset";
 constexpr char kDataServiceDatasetV2[] = "DataServiceDatasetV2";
@@ -363,8 +369,11 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
     data::TraceMeMetadata GetTraceMeMetadata() const override {
       data::TraceMeMetadata result;
       int64 num_tasks = -1;
+      int64 num_outstanding_elements = -1;
       if (mu_.try_lock()) {
         num_tasks = tasks_.size() - finished_tasks_;
+        num_outstanding_elements =
+            outstanding_requests_ + outstanding_extra_elements_;
         mu_.unlock();
       }
       std::string num_tasks_string =
@@ -372,6 +381,12 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
               ? "unavailable"
               : strings::Printf("%lld", static_cast<long long>(num_tasks));
       result.push_back(std::make_pair("num_tasks", num_tasks_string));
+      result.push_back(std::make_pair(
+          "num_outstanding_elements",
+          num_outstanding_elements == -1
+              ? "unavailable"
+              : strings::Printf("%lld", static_cast<long long>(
+                                            num_outstanding_elements))));
       result.push_back(std::make_pair("job_name", dataset()->job_name_));
       result.push_back(std::make_pair(
           "max_outstanding_requests",
@@ -397,8 +412,13 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
       bool skipped_previous_round = false;
       // Indicates whether a worker thread is currently processing the task.
       bool in_use TF_GUARDED_BY(&Iterator::mu_) = false;
+      // The number of elements requested from the task by the in-progress
+      // request, or 0 if the task is not in use.
+      int64 num_outstanding_elements TF_GUARDED_BY(&Iterator::mu_) = 0;
       // Indicates whether the worker has returned end_of_sequence for the task.
       bool end_of_sequence TF_GUARDED_BY(&Iterator::mu_) = false;
+      // The worker's load as of the latest dispatcher heartbeat.
+      WorkerLoad worker_load TF_GUARDED_BY(&Iterator::mu_);
     };
 
     struct Result {
@@ -479,6 +499,7 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
           task_info.transfer_address(), dataset()->protocol_,
           dataset()->data_transfer_protocol_, worker));
       tasks_.push_back(std::make_shared<Task>(task_info, std::move(worker)));
+      tasks_.back()->worker_load = task_info.worker_load();
       worker_thread_cv_.notify_one();
       if (StrictRoundRobin()) {
         VLOG(1) << "Consumer " << dataset()->consumer_index_.value()
@@ -537,10 +558,12 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
       int index = 0;
       while (index < tasks_.size()) {
         std::shared_ptr<Task> task = tasks_[index];
-        if (task_id_to_task.contains(task->info.task_id())) {
+        auto it = task_id_to_task.find(task->info.task_id());
+        if (it != task_id_to_task.end()) {
+          task->worker_load = it->second.worker_load();
           // Remove already-known tasks from `task_id_to_task`, so that at the
           // end of the loop, only new tasks remain.
-          task_id_to_task.erase(task->info.task_id());
+          task_id_to_task.erase(it);
           ++index;
         } else {
           // Task has been removed.
@@ -627,13 +650,42 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
           AdvanceTaskIndex();
           continue;
         }
-        task->round = current_round_;
+        std::shared_ptr<Task> result = task;
+        result->round = current_round_;
         AdvanceTaskIndex();
-        return task;
+        if (!StrictRoundRobin()) {
+          result = PreferLighterLoadedTask(std::move(result));
+        }
+        return result;
       }
       return nullptr;
     }
 
+    // Compares `task` against one other randomly chosen task and returns
+    // whichever is available and on the less loaded worker ("power of two
+    // choices"). This steers requests away from backed-up workers without
+    // needing to rank all tasks. Only valid for non-round-robin reads.
+    std::shared_ptr<Task> PreferLighterLoadedTask(std::shared_ptr<Task> task)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (tasks_.size() < 2) {
+        return task;
+      }
+      const std::shared_ptr<Task>& other =
+          tasks_[random::New64() % tasks_.size()];
+      if (other == task || other->in_use || other->end_of_sequence ||
+          other->removed || current_round_ < other->info.starting_round() ||
+          !IsLighterLoad(other->worker_load, other->info.task_id(),
+                         task->worker_load, task->info.task_id())) {
+        return task;
+      }
+      VLOG(3) << "Preferring task " << other->info.task_id() << " on worker "
+              << other->info.worker_address() << " over task "
+              << task->info.task_id() << " on more loaded worker "
+              << task->info.worker_address();
+      other->round = task->round;
+      return other;
+    }
+
     void RunWorkerThread(std::function<void()> done) {
       auto cleanup = gtl::MakeCleanup([done = std::move(done)]() {
         done();
@@ -646,6 +698,7 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
         {
           mutex_lock l(mu_);
           if (task_to_process) {
+            ReleaseOutstandingElements(*task_to_process);
             task_to_process->in_use = false;
             task_to_process = nullptr;
             worker_thread_cv_.notify_one();
@@ -671,6 +724,12 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
           }
           DCHECK(task_to_process != nullptr);
           task_to_process->in_use = true;
+          task_to_process->num_outstanding_elements = ElementsToRequest();
+          outstanding_extra_elements_ +=
+              task_to_process->num_outstanding_elements - 1;
+          metrics::UpdateTFDataServiceTaskElementsInFlight(
+              task_to_process->info.task_id(),
+              task_to_process->num_outstanding_elements);
           VLOG(3) << "Processing task " << task_to_process->info.task_id();
         }
         int64 deadline_micros = kint64max;
@@ -687,6 +746,7 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
           mutex_lock l(mu_);
           VLOG(1) << "Failed to get element from worker "
                   << task_to_process->info.worker_address() << ": " << s;
+          ReleaseOutstandingElements(*task_to_process);
           task_to_process->in_use = false;
           status_ = Status(s.code(),
                            absl::StrCat("Failed to get element from worker ",
@@ -698,18 +758,23 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
       }
     }
 
-    Status TryGetElement(const Task& task, GetElementResult& result) {
+    Status TryGetElements(const Task& task,
+                          std::vector<GetElementResult>& results) {
       GetElementRequest req;
       req.set_task_id(task.info.task_id());
       req.set_skipped_previous_round(task.skipped_previous_round);
       absl::optional<int64> round_index;
+      int64 max_elements = 1;
       if (StrictRoundRobin()) {
         round_index = task.round;
         req.set_consumer_index(dataset()->consumer_index_.value());
         req.set_round_index(task.round);
         req.set_allow_skip(true);
+      } else {
+        mutex_lock l(mu_);
+        max_elements = task.num_outstanding_elements;
       }
-      return task.worker->GetElement(req, result);
+      return task.worker->GetElements(req, max_elements, results);
     }
 
     void ProcessGetElementResponse(bool enqueue_result,
@@ -742,9 +807,15 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
       VLOG(3) << "Getting an element for task id " << task->info.task_id();
       tensorflow::profiler::TraceMe activity(
           "GetDataServiceElement", tensorflow::profiler::TraceMeLevel::kInfo);
+      int64 max_elements;
+      {
+        mutex_lock l(mu_);
+        max_elements = task->num_outstanding_elements;
+      }
       activity.AppendMetadata([&]() {
         return profiler::TraceMeEncode(
-            {{"address", task->info.worker_address()}});
+            {{"address", task->info.worker_address()},
+             {"max_elements", max_elements}});
       });
       if (StrictRoundRobin()) {
         VLOG(3) << "Requesting element from consumer index "
@@ -794,9 +865,10 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
 
     Status GetElement(Task* task, int64 deadline_micros, bool enqueue_result,
                       Result& result) TF_LOCKS_EXCLUDED(mu_) {
-      GetElementResult get_element_result;
+      std::vector<GetElementResult> get_element_results;
       for (int num_retries = 0;; ++num_retries) {
-        Status s = TryGetElement(*task, get_element_result);
+        get_element_results.clear();
+        Status s = TryGetElements(*task, get_element_results);
         if (s.ok()) break;
         // Retry all errors that could indicate preemption.
         if (!errors::IsUnavailable(s) && !errors::IsCancelled(s) &&
@@ -829,8 +901,16 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
                 << " microseconds";
         Env::Default()->SleepForMicroseconds(backoff_until - now_micros);
       }
-      ProcessGetElementResponse(enqueue_result, get_element_result, result,
-                                *task);
+      for (GetElementResult& get_element_result : get_element_results) {
+        if (enqueue_result) {
+          Result r;
+          ProcessGetElementResponse(/*enqueue_result=*/true, get_element_result,
+                                    r, *task);
+        } else {
+          ProcessGetElementResponse(/*enqueue_result=*/false,
+                                    get_element_result, result, *task);
+        }
+      }
       return Status::OK();
     }
 
@@ -844,11 +924,37 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
       }
       // Otherwise, results aren't added to `results_` until the data has been
       // successfully retrieved. We need to count requests already added to
-      // `results_` as well as in-progress requests.
-      return results_.size() + outstanding_requests_ <
+      // `results_` as well as elements requested by in-progress requests.
+      return results_.size() + outstanding_requests_ +
+                 outstanding_extra_elements_ <
              max_outstanding_requests_;
     }
 
+    // Returns how many elements the next request may ask for. The request
+    // itself must already be counted in `outstanding_requests_`. Round-robin
+    // reads always request a single element.
+    int64 ElementsToRequest() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (StrictRoundRobin()) {
+        return 1;
+      }
+      int64 available = max_outstanding_requests_ -
+                        static_cast<int64>(results_.size()) -
+                        outstanding_requests_ - outstanding_extra_elements_ +
+                        1;
+      return std::max<int64>(1, std::min(available, kMaxElementsPerRequest));
+    }
+
+    // Returns the buffer space reserved by the request in progress for `task`.
+    void ReleaseOutstandingElements(Task& task)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (task.num_outstanding_elements > 0) {
+        outstanding_extra_elements_ -= task.num_outstanding_elements - 1;
+        metrics::UpdateTFDataServiceTaskElementsInFlight(
+            task.info.task_id(), -task.num_outstanding_elements);
+        task.num_outstanding_elements = 0;
+      }
+    }
+
     bool StrictRoundRobin() { return dataset()->num_consumers_.has_value(); }
 
     const int64 iterator_index_;
@@ -862,6 +968,11 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
     std::function<void()> deregister_fn_;
 
     int64 outstanding_requests_ TF_GUARDED_BY(mu_) = 0;
+    // Elements requested by in-progress requests beyond the one element per
+    // request counted in `outstanding_requests_`. Requests for tasks which are
+    // not read in round-robin order may ask for several elements at once to
+    // amortize RPC overhead.
+    int64 outstanding_extra_elements_ TF_GUARDED_BY(mu_) = 0;
     // max_outstanding_requests controls how many elements may be held in memory
     // at the same time. This count includes both in-progress requests for
     // elements as well as completed requests which haven't yet been produced.
@@ -70,6 +70,12 @@ class SnapshotDatasetV2Op : public UnaryDatasetOpKernel {
  private:
   static constexpr const int kFileFormatVersion = 2;
 
+  // Returns the file format version used for writing snapshots. This is
+  // `kFileFormatVersion` unless overridden with the
+  // `TF_DATA_SNAPSHOT_FILE_FORMAT_VERSION` environment variable, e.g. set to 3
+  // to write snapshots in the columnar format.
+  static int64 WriterFileFormatVersion();
+
   class Dataset;
 
   const int graph_def_version_;
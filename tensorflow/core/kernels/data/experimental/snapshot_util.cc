@@ -22,7 +22,11 @@ limitations under the License.
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/kernels/data/name_utils.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/io/buffered_inputstream.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
 #include "tensorflow/core/lib/io/record_writer.h"
@@ -32,10 +36,12 @@ limitations under the License.
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
 #include "tensorflow/core/lib/io/zlib_outputbuffer.h"
 #include "tensorflow/core/platform/coding.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/random.h"
+#include "tensorflow/core/platform/snappy.h"
 #include "tensorflow/core/platform/stringprintf.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/core/protobuf/snapshot.pb.h"
@@ -48,6 +54,245 @@ namespace snapshot_util {
     CustomReader::kSnappyReaderInputBufferSizeBytes;
 /* static */ constexpr const int64
     CustomReader::kSnappyReaderOutputBufferSizeBytes;
+/* static */ constexpr const int64 ColumnarWriter::kBlockSizeBytes;
+/* static */ constexpr const int64 ColumnarWriter::kMaxBlockElements;
+/* static */ constexpr const int64 ColumnarReader::kMinSharedElementBytes;
+
+namespace {
+
+// Identifies files written by `ColumnarWriter`.
+constexpr uint64 kColumnarMagic = 0x3172616e6d756c6fULL;
+
+// The footer of a columnar file holds the offset and size of the block index,
+// followed by `kColumnarMagic`.
+constexpr size_t kColumnarFooterSize = 3 * sizeof(uint64);
+
+// Codecs for the data of a column of a columnar file.
+enum class ColumnCodec : uint8 {
+  // Raw bytes.
+  kRaw = 0,
+  // Zig-zag encoded differences between consecutive values, as varints.
+  kDeltaVarint = 1,
+  // Byte `j` of value `i` is stored at position `j * num_values + i`.
+  kByteShuffle = 2,
+  // The varint lengths of all strings, followed by their bytes.
+  kString = 3,
+  // A varint length and a serialized `TensorProto` for each element.
+  kProto = 4,
+};
+
+ColumnCodec ColumnCodecForType(DataType dtype) {
+  switch (dtype) {
+    case DT_INT32:
+    case DT_INT64:
+      return ColumnCodec::kDeltaVarint;
+    case DT_STRING:
+      return ColumnCodec::kString;
+    default:
+      break;
+  }
+  if (!DataTypeCanUseMemcpy(dtype)) {
+    return ColumnCodec::kProto;
+  }
+  return DataTypeSize(dtype) > 1 ? ColumnCodec::kByteShuffle
+                                 : ColumnCodec::kRaw;
+}
+
+uint64 ZigZagEncode(uint64 value) {
+  return (value << 1) ^ static_cast<uint64>(static_cast<int64>(value) >> 63);
+}
+
+uint64 ZigZagDecode(uint64 value) { return (value >> 1) ^ -(value & 1); }
+
+template <typename T>
+void EncodeDeltaVarints(const std::vector<Tensor>& elements,
+                        std::string* out) {
+  uint64 previous = 0;
+  for (const Tensor& element : elements) {
+    auto values = element.flat<T>();
+    for (int64 i = 0; i < values.size(); ++i) {
+      const uint64 value = static_cast<uint64>(static_cast<int64>(values(i)));
+      core::PutVarint64(out, ZigZagEncode(value - previous));
+      previous = value;
+    }
+  }
+}
+
+template <typename T>
+Status DecodeDeltaVarints(StringPiece data, int64 num_values, char* out) {
+  T* values = reinterpret_cast<T*>(out);
+  uint64 previous = 0;
+  for (int64 i = 0; i < num_values; ++i) {
+    uint64 delta;
+    if (!core::GetVarint64(&data, &delta)) {
+      return errors::DataLoss("Corrupted delta encoded snapshot column.");
+    }
+    previous += ZigZagDecode(delta);
+    values[i] = static_cast<T>(static_cast<int64>(previous));
+  }
+  if (!data.empty()) {
+    return errors::DataLoss("Unexpected data at the end of snapshot column.");
+  }
+  return Status::OK();
+}
+
+void EncodeShape(const TensorShape& shape, std::string* out) {
+  core::PutVarint64(out, shape.dims());
+  for (int64 dim : shape.dim_sizes()) {
+    core::PutVarint64(out, dim);
+  }
+}
+
+Status DecodeShape(StringPiece* data, TensorShape* shape) {
+  uint64 rank;
+  if (!core::GetVarint64(data, &rank) || rank > TensorShape::MaxDimensions()) {
+    return errors::DataLoss("Corrupted shape in snapshot column.");
+  }
+  gtl::InlinedVector<int64, 4> dims(rank);
+  for (uint64 i = 0; i < rank; ++i) {
+    uint64 dim;
+    if (!core::GetVarint64(data, &dim)) {
+      return errors::DataLoss("Corrupted shape in snapshot column.");
+    }
+    dims[i] = static_cast<int64>(dim);
+  }
+  Status s = TensorShapeUtils::MakeShape(dims.data(), dims.size(), shape);
+  if (!s.ok()) {
+    return errors::DataLoss("Corrupted shape in snapshot column: ",
+                            s.error_message());
+  }
+  return Status::OK();
+}
+
+// Encodes the given components of consecutive elements as a column.
+Status EncodeColumn(DataType dtype, const std::vector<Tensor>& elements,
+                    bool compress, std::string* out) {
+  const ColumnCodec codec = ColumnCodecForType(dtype);
+  std::string payload;
+  bool uniform_shape = true;
+  for (const Tensor& element : elements) {
+    uniform_shape &= element.shape() == elements.front().shape();
+  }
+  core::PutVarint64(&payload, uniform_shape ? 1 : 0);
+  for (const Tensor& element : elements) {
+    EncodeShape(element.shape(), &payload);
+    if (uniform_shape) break;
+  }
+  switch (codec) {
+    case ColumnCodec::kRaw:
+      for (const Tensor& element : elements) {
+        const StringPiece data = element.tensor_data();
+        payload.append(data.data(), data.size());
+      }
+      break;
+    case ColumnCodec::kDeltaVarint:
+      if (dtype == DT_INT32) {
+        EncodeDeltaVarints<int32>(elements, &payload);
+      } else {
+        EncodeDeltaVarints<int64>(elements, &payload);
+      }
+      break;
+    case ColumnCodec::kByteShuffle: {
+      const int64 width = DataTypeSize(dtype);
+      int64 num_values = 0;
+      for (const Tensor& element : elements) {
+        num_values += element.NumElements();
+      }
+      const size_t start = payload.size();
+      payload.resize(start + num_values * width);
+      char* shuffled = &payload[start];
+      int64 i = 0;
+      for (const Tensor& element : elements) {
+        const char* data = element.tensor_data().data();
+        for (int64 j = 0; j < element.NumElements(); ++j, ++i) {
+          for (int64 k = 0; k < width; ++k) {
+            shuffled[k * num_values + i] = data[j * width + k];
+          }
+        }
+      }
+      break;
+    }
+    case ColumnCodec::kString: {
+      for (const Tensor& element : elements) {
+        auto values = element.flat<tstring>();
+        for (int64 i = 0; i < values.size(); ++i) {
+          core::PutVarint64(&payload, values(i).size());
+        }
+      }
+      for (const Tensor& element : elements) {
+        auto values = element.flat<tstring>();
+        for (int64 i = 0; i < values.size(); ++i) {
+          payload.append(values(i).data(), values(i).size());
+        }
+      }
+      break;
+    }
+    case ColumnCodec::kProto:
+      for (const Tensor& element : elements) {
+        TensorProto proto;
+        element.AsProtoTensorContent(&proto);
+        const std::string serialized = proto.SerializeAsString();
+        core::PutVarint64(&payload, serialized.size());
+        payload.append(serialized);
+      }
+      break;
+  }
+
+  out->push_back(static_cast<char>(codec));
+  std::string compressed;
+  // Falls back to storing the column uncompressed if snappy is not available
+  // or does not reduce the size of the column.
+  if (compress &&
+      port::Snappy_Compress(payload.data(), payload.size(), &compressed) &&
+      compressed.size() < payload.size()) {
+    out->push_back(1);
+    out->append(compressed);
+  } else {
+    out->push_back(0);
+    out->append(payload);
+  }
+  return Status::OK();
+}
+
+// Decodes the data of a fixed-width column into `out`, which must have room
+// for `num_values` values.
+Status DecodeFixedWidthColumn(ColumnCodec codec, DataType dtype,
+                              StringPiece data, int64 num_values, char* out) {
+  const int64 width = DataTypeSize(dtype);
+  if (codec == ColumnCodec::kDeltaVarint) {
+    if (dtype == DT_INT32) {
+      return DecodeDeltaVarints<int32>(data, num_values, out);
+    }
+    return DecodeDeltaVarints<int64>(data, num_values, out);
+  }
+  if (data.size() != num_values * width) {
+    return errors::DataLoss("Snapshot column has ", data.size(),
+                            " bytes but ", num_values * width,
+                            " bytes were expected.");
+  }
+  if (codec == ColumnCodec::kRaw) {
+    if (!data.empty()) {
+      memcpy(out, data.data(), data.size());
+    }
+    return Status::OK();
+  }
+  for (int64 i = 0; i < num_values; ++i) {
+    for (int64 k = 0; k < width; ++k) {
+      out[i * width + k] = data[k * num_values + i];
+    }
+  }
+  return Status::OK();
+}
+
+// Returns the thread pool used by `ColumnarReader`s to decode columns in
+// parallel.
+thread::ThreadPool* ColumnDecodeThreadPool() {
+  static thread::ThreadPool* pool = new thread::ThreadPool(
+      Env::Default(), "snapshot_column_decode", port::MaxParallelism());
+  return pool;
+}
+
+}  // namespace
 
 std::string HashDirectory(const std::string& path, uint64 hash) {
   return io::JoinPath(
@@ -92,6 +337,10 @@ Status Writer::Create(Env* env, const std::string& filename,
       *out_writer =
           absl::make_unique<TFRecordWriter>(filename, compression_type);
       break;
+    case 3:
+      *out_writer =
+          absl::make_unique<ColumnarWriter>(filename, compression_type, dtypes);
+      break;
     default:
       return errors::InvalidArgument("Snapshot writer version: ", version,
                                      " is not supported.");
@@ -318,6 +567,104 @@ Status CustomWriter::WriteRecord(const absl::Cord& data) {
 }
 #endif  // TF_CORD_SUPPORT
 
+ColumnarWriter::ColumnarWriter(const std::string& filename,
+                               const std::string& compression_type,
+                               const DataTypeVector& dtypes)
+    : filename_(filename),
+      compress_(compression_type != io::compression::kNone),
+      dtypes_(dtypes) {}
+
+Status ColumnarWriter::Initialize(tensorflow::Env* env) {
+  columns_.resize(dtypes_.size());
+  return env->NewWritableFile(filename_, &dest_);
+}
+
+Status ColumnarWriter::WriteTensors(const std::vector<Tensor>& tensors) {
+  if (tensors.size() != dtypes_.size()) {
+    return errors::InvalidArgument("Expected ", dtypes_.size(),
+                                   " tensors but got ", tensors.size(), ".");
+  }
+  for (int i = 0, end = tensors.size(); i < end; ++i) {
+    if (tensors[i].dtype() != dtypes_[i]) {
+      return errors::InvalidArgument(
+          "Expected tensor ", i, " to be of type ", DataTypeString(dtypes_[i]),
+          " but got ", DataTypeString(tensors[i].dtype()), ".");
+    }
+    columns_[i].push_back(tensors[i]);
+    buffered_bytes_ += tensors[i].TotalBytes();
+  }
+  num_buffered_++;
+  if (buffered_bytes_ >= kBlockSizeBytes ||
+      num_buffered_ >= kMaxBlockElements) {
+    return FlushBlock();
+  }
+  return Status::OK();
+}
+
+Status ColumnarWriter::FlushBlock() {
+  if (num_buffered_ == 0) {
+    return Status::OK();
+  }
+  profiler::TraceMe activity(
+      [&]() { return absl::StrCat(kClassName, kSeparator, "FlushBlock"); },
+      profiler::TraceMeLevel::kInfo);
+  // A block consists of the sizes of its columns, followed by the columns.
+  std::vector<std::string> columns(dtypes_.size());
+  std::string header;
+  uint64 block_size = 0;
+  for (int i = 0, end = dtypes_.size(); i < end; ++i) {
+    TF_RETURN_IF_ERROR(
+        EncodeColumn(dtypes_[i], columns_[i], compress_, &columns[i]));
+    core::PutFixed64(&header, columns[i].size());
+    block_size += columns[i].size();
+    columns_[i].clear();
+  }
+  block_size += header.size();
+  TF_RETURN_IF_ERROR(dest_->Append(header));
+  for (const auto& column : columns) {
+    TF_RETURN_IF_ERROR(dest_->Append(column));
+  }
+  core::PutVarint64(&index_, offset_);
+  core::PutVarint64(&index_, block_size);
+  core::PutVarint64(&index_, num_buffered_);
+  offset_ += block_size;
+  num_blocks_++;
+  num_buffered_ = 0;
+  buffered_bytes_ = 0;
+  return Status::OK();
+}
+
+Status ColumnarWriter::Sync() {
+  TF_RETURN_IF_ERROR(FlushBlock());
+  return dest_->Sync();
+}
+
+Status ColumnarWriter::Close() {
+  if (dest_ == nullptr) {
+    return Status::OK();
+  }
+  TF_RETURN_IF_ERROR(FlushBlock());
+  std::string index;
+  core::PutVarint64(&index, num_blocks_);
+  index.append(index_);
+  std::string footer;
+  core::PutFixed64(&footer, offset_);
+  core::PutFixed64(&footer, index.size());
+  core::PutFixed64(&footer, kColumnarMagic);
+  TF_RETURN_IF_ERROR(dest_->Append(index));
+  TF_RETURN_IF_ERROR(dest_->Append(footer));
+  TF_RETURN_IF_ERROR(dest_->Close());
+  dest_ = nullptr;
+  return Status::OK();
+}
+
+ColumnarWriter::~ColumnarWriter() {
+  Status s = Close();
+  if (!s.ok()) {
+    LOG(ERROR) << "Failed to close snapshot file " << filename_ << ": " << s;
+  }
+}
+
 Status Reader::Create(Env* env, const std::string& filename,
                       const string& compression_type, int version,
                       const DataTypeVector& dtypes,
@@ -335,6 +682,9 @@ Status Reader::Create(Env* env, const std::string& filename,
       *out_reader =
           absl::make_unique<TFRecordReader>(filename, compression_type, dtypes);
       break;
+    case 3:
+      *out_reader = absl::make_unique<ColumnarReader>(filename, dtypes);
+      break;
     default:
       return errors::InvalidArgument("Snapshot reader version: ", version,
                                      " is not supported.");
@@ -648,6 +998,311 @@ Status TFRecordReader::ReadTensors(std::vector<Tensor>* read_tensors) {
   return Status::OK();
 }
 
+ColumnarReader::ColumnarReader(const std::string& filename,
+                               const DataTypeVector& dtypes)
+    : filename_(filename), dtypes_(dtypes) {}
+
+Status ColumnarReader::Initialize(Env* env) {
+  TF_RETURN_IF_ERROR(env->NewRandomAccessFile(filename_, &file_));
+  uint64 file_size;
+  TF_RETURN_IF_ERROR(env->GetFileSize(filename_, &file_size));
+  if (file_size < kColumnarFooterSize) {
+    return errors::DataLoss("Snapshot file ", filename_, " is truncated.");
+  }
+  char footer_scratch[kColumnarFooterSize];
+  StringPiece footer;
+  TF_RETURN_IF_ERROR(file_->Read(file_size - kColumnarFooterSize,
+                                 kColumnarFooterSize, &footer,
+                                 footer_scratch));
+  const uint64 index_offset = core::DecodeFixed64(footer.data());
+  const uint64 index_size = core::DecodeFixed64(footer.data() + 8);
+  if (core::DecodeFixed64(footer.data() + 16) != kColumnarMagic ||
+      index_offset + index_size + kColumnarFooterSize != file_size) {
+    return errors::DataLoss("Snapshot file ", filename_,
+                            " is not a columnar snapshot file or has not "
+                            "been closed properly.");
+  }
+
+  auto index_scratch = absl::make_unique<char[]>(index_size);
+  StringPiece index;
+  TF_RETURN_IF_ERROR(
+      file_->Read(index_offset, index_size, &index, index_scratch.get()));
+  uint64 num_blocks;
+  if (!core::GetVarint64(&index, &num_blocks)) {
+    return errors::DataLoss("Corrupted index in snapshot file ", filename_);
+  }
+  blocks_.reserve(num_blocks);
+  for (uint64 i = 0; i < num_blocks; ++i) {
+    BlockInfo block;
+    uint64 num_elements;
+    if (!core::GetVarint64(&index, &block.offset) ||
+        !core::GetVarint64(&index, &block.size) ||
+        !core::GetVarint64(&index, &num_elements) ||
+        block.offset + block.size > index_offset) {
+      return errors::DataLoss("Corrupted index in snapshot file ", filename_);
+    }
+    block.num_elements = static_cast<int64>(num_elements);
+    blocks_.push_back(block);
+  }
+  return Status::OK();
+}
+
+Status ColumnarReader::ReadTensors(std::vector<Tensor>* read_tensors) {
+  profiler::TraceMe activity(
+      [&]() { return absl::StrCat(kClassName, kSeparator, "ReadTensors"); },
+      profiler::TraceMeLevel::kInfo);
+  while (next_element_ == num_elements_in_block_) {
+    if (next_block_ == blocks_.size()) {
+      return errors::OutOfRange("No more elements in snapshot file ",
+                                filename_);
+    }
+    TF_RETURN_IF_ERROR(ReadBlock(next_block_++));
+  }
+  read_tensors->reserve(read_tensors->size() + columns_.size());
+  for (auto& column : columns_) {
+    if (column.is_batched) {
+      Tensor tensor = column.batched.SubSlice(next_element_);
+      if (!tensor.IsAligned() ||
+          tensor.TotalBytes() < kMinSharedElementBytes) {
+        tensor = tensor::DeepCopy(tensor);
+      }
+      read_tensors->push_back(std::move(tensor));
+    } else {
+      read_tensors->push_back(std::move(column.elements[next_element_]));
+    }
+  }
+  next_element_++;
+  return Status::OK();
+}
+
+Status ColumnarReader::SkipRecords(int64 num_records) {
+  while (num_records > 0) {
+    const int64 num_remaining = num_elements_in_block_ - next_element_;
+    if (num_records <= num_remaining) {
+      next_element_ += num_records;
+      return Status::OK();
+    }
+    num_records -= num_remaining;
+    next_element_ = num_elements_in_block_;
+    while (next_block_ < blocks_.size() &&
+           blocks_[next_block_].num_elements <= num_records) {
+      num_records -= blocks_[next_block_].num_elements;
+      next_block_++;
+    }
+    if (num_records == 0) {
+      break;
+    }
+    if (next_block_ == blocks_.size()) {
+      return errors::OutOfRange("No more elements in snapshot file ",
+                                filename_);
+    }
+    TF_RETURN_IF_ERROR(ReadBlock(next_block_++));
+  }
+  return Status::OK();
+}
+
+Status ColumnarReader::ReadBlock(int64 block_index) {
+  profiler::TraceMe activity(
+      [&]() { return absl::StrCat(kClassName, kSeparator, "ReadBlock"); },
+      profiler::TraceMeLevel::kInfo);
+  const BlockInfo& block = blocks_[block_index];
+  const int64 num_columns = dtypes_.size();
+  auto scratch = absl::make_unique<char[]>(block.size);
+  StringPiece data;
+  TF_RETURN_IF_ERROR(
+      file_->Read(block.offset, block.size, &data, scratch.get()));
+  if (data.size() < num_columns * sizeof(uint64)) {
+    return errors::DataLoss("Corrupted block in snapshot file ", filename_);
+  }
+  std::vector<StringPiece> column_data(num_columns);
+  uint64 column_offset = num_columns * sizeof(uint64);
+  for (int64 i = 0; i < num_columns; ++i) {
+    const uint64 size = core::DecodeFixed64(data.data() + i * sizeof(uint64));
+    if (column_offset + size > data.size()) {
+      return errors::DataLoss("Corrupted block in snapshot file ", filename_);
+    }
+    column_data[i] = data.substr(column_offset, size);
+    column_offset += size;
+  }
+
+  columns_.clear();
+  columns_.resize(num_columns);
+  std::vector<Status> statuses(num_columns);
+  auto decode_column = [this, &block, &column_data, &statuses](int64 i) {
+    statuses[i] = DecodeColumn(dtypes_[i], block.num_elements, column_data[i],
+                               &columns_[i]);
+  };
+  // Decodes the first column on the calling thread and the remaining ones in
+  // the shared thread pool.
+  BlockingCounter counter(std::max<int64>(num_columns - 1, 0));
+  for (int64 i = 1; i < num_columns; ++i) {
+    ColumnDecodeThreadPool()->Schedule([&decode_column, &counter, i]() {
+      decode_column(i);
+      counter.DecrementCount();
+    });
+  }
+  if (num_columns > 0) {
+    decode_column(0);
+  }
+  counter.Wait();
+  for (const Status& s : statuses) {
+    TF_RETURN_IF_ERROR(s);
+  }
+  num_elements_in_block_ = block.num_elements;
+  next_element_ = 0;
+  return Status::OK();
+}
+
+Status ColumnarReader::DecodeColumn(DataType dtype, int64 num_elements,
+                                    StringPiece data, Column* column) {
+  if (data.size() < 2) {
+    return errors::DataLoss("Snapshot column is truncated.");
+  }
+  if (num_elements < 0) {
+    return errors::DataLoss("Corrupted element count in snapshot column.");
+  }
+  const ColumnCodec codec = static_cast<ColumnCodec>(data[0]);
+  if (codec != ColumnCodecForType(dtype)) {
+    return errors::DataLoss("Unexpected codec ", static_cast<int>(data[0]),
+                            " for snapshot column of type ",
+                            DataTypeString(dtype), ".");
+  }
+  const bool compressed = data[1] != 0;
+  data.remove_prefix(2);
+  std::string uncompressed;
+  if (compressed) {
+    size_t size;
+    if (!port::Snappy_GetUncompressedLength(data.data(), data.size(),
+                                            &size)) {
+      return errors::Internal("Could not get snappy uncompressed length");
+    }
+    uncompressed.resize(size);
+    if (!port::Snappy_Uncompress(data.data(), data.size(), &uncompressed[0])) {
+      return errors::Internal("Failed to perform snappy decompression.");
+    }
+    data = uncompressed;
+  }
+
+  uint64 uniform_shape;
+  if (!core::GetVarint64(&data, &uniform_shape)) {
+    return errors::DataLoss("Snapshot column is truncated.");
+  }
+  // Every encoded shape takes at least one byte, so this bounds the allocation
+  // below for corrupt element counts.
+  if (!uniform_shape && num_elements > static_cast<int64>(data.size())) {
+    return errors::DataLoss("Snapshot column is truncated.");
+  }
+  std::vector<TensorShape> shapes(uniform_shape ? 1 : num_elements);
+  for (auto& shape : shapes) {
+    TF_RETURN_IF_ERROR(DecodeShape(&data, &shape));
+  }
+  auto element_shape = [&shapes, uniform_shape](int64 i) -> const TensorShape& {
+    return shapes[uniform_shape ? 0 : i];
+  };
+
+  switch (codec) {
+    case ColumnCodec::kRaw:
+    case ColumnCodec::kDeltaVarint:
+    case ColumnCodec::kByteShuffle: {
+      if (uniform_shape) {
+        // Decode directly into a batched tensor.
+        gtl::InlinedVector<int64, 4> batched_dims = {num_elements};
+        for (const auto& dim : shapes[0]) {
+          batched_dims.push_back(dim.size);
+        }
+        TensorShape batched_shape;
+        Status s = TensorShapeUtils::MakeShape(
+            batched_dims.data(), batched_dims.size(), &batched_shape);
+        if (!s.ok()) {
+          return errors::DataLoss("Corrupted shape in snapshot column: ",
+                                  s.error_message());
+        }
+        // Every encoded value takes at least one byte.
+        if (batched_shape.num_elements() > static_cast<int64>(data.size())) {
+          return errors::DataLoss("Snapshot column is truncated.");
+        }
+        column->batched = Tensor(dtype, batched_shape);
+        column->is_batched = true;
+        return DecodeFixedWidthColumn(
+            codec, dtype, data, column->batched.NumElements(),
+            static_cast<char*>(DMAHelper::base(&column->batched)));
+      }
+      int64 num_values = 0;
+      for (const auto& shape : shapes) {
+        num_values += shape.num_elements();
+        if (num_values > static_cast<int64>(data.size())) {
+          return errors::DataLoss("Snapshot column is truncated.");
+        }
+      }
+      std::vector<char> buffer(num_values * DataTypeSize(dtype));
+      TF_RETURN_IF_ERROR(DecodeFixedWidthColumn(codec, dtype, data,
+                                                num_values, buffer.data()));
+      const char* position = buffer.data();
+      column->elements.reserve(num_elements);
+      for (const auto& shape : shapes) {
+        Tensor tensor(dtype, shape);
+        if (tensor.TotalBytes() > 0) {
+          memcpy(DMAHelper::base(&tensor), position, tensor.TotalBytes());
+          position += tensor.TotalBytes();
+        }
+        column->elements.push_back(std::move(tensor));
+      }
+      return Status::OK();
+    }
+    case ColumnCodec::kString: {
+      int64 num_strings = 0;
+      for (int64 i = 0; i < num_elements; ++i) {
+        num_strings += element_shape(i).num_elements();
+        // Every string length takes at least one byte.
+        if (num_strings > static_cast<int64>(data.size())) {
+          return errors::DataLoss("Snapshot column is truncated.");
+        }
+      }
+      std::vector<uint64> lengths(num_strings);
+      for (auto& length : lengths) {
+        if (!core::GetVarint64(&data, &length)) {
+          return errors::DataLoss("Snapshot column is truncated.");
+        }
+      }
+      column->elements.reserve(num_elements);
+      auto length = lengths.begin();
+      for (int64 i = 0; i < num_elements; ++i) {
+        Tensor tensor(DT_STRING, element_shape(i));
+        auto values = tensor.flat<tstring>();
+        for (int64 j = 0; j < values.size(); ++j) {
+          if (*length > data.size()) {
+            return errors::DataLoss("Snapshot column is truncated.");
+          }
+          values(j).assign(data.data(), *length);
+          data.remove_prefix(*length);
+          ++length;
+        }
+        column->elements.push_back(std::move(tensor));
+      }
+      return Status::OK();
+    }
+    case ColumnCodec::kProto: {
+      column->elements.reserve(num_elements);
+      for (int64 i = 0; i < num_elements; ++i) {
+        uint64 size;
+        if (!core::GetVarint64(&data, &size) || size > data.size()) {
+          return errors::DataLoss("Snapshot column is truncated.");
+        }
+        TensorProto proto;
+        Tensor tensor;
+        if (!proto.ParseFromArray(data.data(), size) ||
+            !tensor.FromProto(proto)) {
+          return errors::DataLoss("Unable to parse tensor from stored proto.");
+        }
+        data.remove_prefix(size);
+        column->elements.push_back(std::move(tensor));
+      }
+      return Status::OK();
+    }
+  }
+  return errors::DataLoss("Unknown snapshot column codec.");
+}
+
 CustomReader::CustomReader(const std::string& filename,
                            const string& compression_type, const int version,
                            const DataTypeVector& dtypes)
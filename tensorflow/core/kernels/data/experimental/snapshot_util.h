@@ -163,6 +163,59 @@ class CustomWriter : public Writer {
   int num_complex_ = 0;
 };
 
+// Writes snapshots with a columnar file format.
+//
+// Elements are buffered into blocks of up to `kBlockSizeBytes`. Within a
+// block, each component (column) is encoded separately with a codec chosen
+// based on its dtype: zig-zag encoded delta varints for 32 and 64 bit integers,
+// byte shuffling for other fixed-width types (which groups bytes of equal
+// significance and makes e.g. floating point data much more compressible) and
+// raw bytes otherwise. Unless `compression_type` is `io::compression::kNone`,
+// each column is then compressed with snappy. The file ends with an index of
+// its blocks, which allows readers to seek to any element and to decode the
+// columns of a block independently of each other.
+class ColumnarWriter : public Writer {
+ public:
+  static constexpr const int64 kBlockSizeBytes = 8 << 20;  // 8 MiB
+  static constexpr const int64 kMaxBlockElements = 1 << 16;
+
+  static constexpr const char* const kClassName = "SnapshotColumnarWriter";
+  static constexpr const char* const kSeparator = "::";
+
+  ColumnarWriter(const std::string& filename,
+                 const std::string& compression_type,
+                 const DataTypeVector& dtypes);
+
+  Status WriteTensors(const std::vector<Tensor>& tensors) override;
+
+  Status Sync() override;
+
+  Status Close() override;
+
+  ~ColumnarWriter() override;
+
+ protected:
+  Status Initialize(tensorflow::Env* env) override;
+
+ private:
+  // Encodes the buffered elements as a block and appends it to the file.
+  Status FlushBlock();
+
+  std::unique_ptr<WritableFile> dest_;
+  const std::string filename_;
+  const bool compress_;
+  const DataTypeVector dtypes_;
+  // The components of the buffered elements, grouped by column.
+  std::vector<std::vector<Tensor>> columns_;
+  int64 num_buffered_ = 0;
+  int64 buffered_bytes_ = 0;
+  // The offset at which the next block will be written.
+  uint64 offset_ = 0;
+  // The encoded index entries of the blocks written so far.
+  std::string index_;
+  int64 num_blocks_ = 0;
+};
+
 // Interface class for reading snapshot files previous written with Writer.
 class Reader {
  public:
@@ -280,6 +333,69 @@ class CustomReader : public Reader {
   std::vector<bool> simple_tensor_mask_;  // true for simple, false for complex.
 };
 
+// Reads snapshots previously written with `ColumnarWriter`.
+//
+// Blocks are read one at a time and the columns of a block are decoded in
+// parallel. Fixed-width columns whose shape does not change within a block are
+// decoded directly into a single batched tensor. Returned elements of at least
+// `kMinSharedElementBytes` share the buffer of that tensor (unless this would
+// violate alignment requirements), so retaining any of them keeps the whole
+// column of the block, up to `ColumnarWriter::kBlockSizeBytes`, alive. Smaller
+// elements are copied out of the batched tensor to avoid pinning a large buffer
+// for a few bytes.
+class ColumnarReader : public Reader {
+ public:
+  static constexpr const int64 kMinSharedElementBytes = 4 << 10;  // 4 KiB
+
+  static constexpr const char* const kClassName = "SnapshotColumnarReader";
+  static constexpr const char* const kSeparator = "::";
+
+  ColumnarReader(const std::string& filename, const DataTypeVector& dtypes);
+
+  Status ReadTensors(std::vector<Tensor>* read_tensors) override;
+
+  // Uses the index of the file to skip whole blocks without reading them.
+  Status SkipRecords(int64 num_records) override;
+
+  ~ColumnarReader() override {}
+
+ protected:
+  Status Initialize(Env* env) override;
+
+ private:
+  struct BlockInfo {
+    uint64 offset;
+    uint64 size;
+    int64 num_elements;
+  };
+
+  // A column of the current block.
+  struct Column {
+    // If set, the column has been decoded into `batched`, whose first
+    // dimension indexes elements. Otherwise, it has been decoded into
+    // `elements`.
+    bool is_batched = false;
+    Tensor batched;
+    std::vector<Tensor> elements;
+  };
+
+  // Reads and decodes the block at the given position of the index.
+  Status ReadBlock(int64 block_index);
+
+  // Decodes a column of a block holding `num_elements` elements.
+  static Status DecodeColumn(DataType dtype, int64 num_elements,
+                             StringPiece data, Column* column);
+
+  const std::string filename_;
+  const DataTypeVector dtypes_;
+  std::unique_ptr<RandomAccessFile> file_;
+  std::vector<BlockInfo> blocks_;
+  int64 next_block_ = 0;
+  std::vector<Column> columns_;
+  int64 num_elements_in_block_ = 0;
+  int64 next_element_ = 0;
+};
+
 // Writes snapshot metadata to the given directory.
 Status WriteMetadataFile(Env* env, const string& dir,
                          const experimental::SnapshotMetadataRecord* metadata);
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/data/experimental/snapshot_util.h"
 
+#include <limits>
+
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/compression.h"
@@ -89,6 +91,185 @@ TEST(SnapshotUtilTest, CombinationRoundTripTest) {
   SnapshotRoundTrip(io::compression::kNone, 2);
   SnapshotRoundTrip(io::compression::kGzip, 2);
   SnapshotRoundTrip(io::compression::kSnappy, 2);
+
+  SnapshotRoundTrip(io::compression::kNone, 3);
+  SnapshotRoundTrip(io::compression::kSnappy, 3);
+}
+
+void ExpectEqualTensors(const Tensor& expected, const Tensor& actual) {
+  TensorProto expected_proto;
+  TensorProto actual_proto;
+  expected.AsProtoTensorContent(&expected_proto);
+  actual.AsProtoTensorContent(&actual_proto);
+  EXPECT_EQ(expected_proto.SerializeAsString(),
+            actual_proto.SerializeAsString());
+}
+
+// Returns an element whose components exercise each of the column codecs of
+// the columnar format, with the shape of the last component depending on `i`.
+std::vector<Tensor> MakeColumnarElement(int64 i) {
+  Tensor int64_tensor(static_cast<int64>(i * i - 1000));
+  Tensor int32_tensor(DT_INT32, TensorShape({2}));
+  int32_tensor.flat<int32>()(0) = -i;
+  int32_tensor.flat<int32>()(1) = std::numeric_limits<int32>::max() - i;
+  Tensor float_tensor(DT_FLOAT, TensorShape({3}));
+  for (int j = 0; j < 3; ++j) {
+    float_tensor.flat<float>()(j) = 0.5f * i + j;
+  }
+  Tensor bool_tensor(i % 2 == 0);
+  Tensor string_tensor(DT_STRING, TensorShape({2}));
+  string_tensor.flat<tstring>()(0) = std::string(i % 7, 'a');
+  string_tensor.flat<tstring>()(1) = strings::StrCat("element_", i);
+  Tensor ragged_tensor(DT_DOUBLE, TensorShape({i % 4}));
+  for (int j = 0; j < i % 4; ++j) {
+    ragged_tensor.flat<double>()(j) = -1.0 * i * j;
+  }
+  return {int64_tensor, int32_tensor,  float_tensor,
+          bool_tensor,  string_tensor, ragged_tensor};
+}
+
+class ColumnarSnapshotTest
+    : public ::testing::TestWithParam<std::tuple<std::string, int64>> {};
+
+TEST_P(ColumnarSnapshotTest, RoundTripAndSkip) {
+  const std::string& compression_type = std::get<0>(GetParam());
+  const int64 num_elements = std::get<1>(GetParam());
+  const DataTypeVector dtypes = {DT_INT64, DT_INT32,  DT_FLOAT,
+                                 DT_BOOL,  DT_STRING, DT_DOUBLE};
+
+  std::string filename;
+  EXPECT_TRUE(Env::Default()->LocalTempFilename(&filename));
+  std::unique_ptr<Writer> writer;
+  TF_ASSERT_OK(Writer::Create(Env::Default(), filename, compression_type,
+                              /*version=*/3, dtypes, &writer));
+  for (int64 i = 0; i < num_elements; ++i) {
+    TF_ASSERT_OK(writer->WriteTensors(MakeColumnarElement(i)));
+  }
+  TF_ASSERT_OK(writer->Close());
+
+  std::unique_ptr<Reader> reader;
+  TF_ASSERT_OK(Reader::Create(Env::Default(), filename, compression_type,
+                              /*version=*/3, dtypes, &reader));
+  for (int64 i = 0; i < num_elements; ++i) {
+    std::vector<Tensor> read_tensors;
+    TF_ASSERT_OK(reader->ReadTensors(&read_tensors));
+    std::vector<Tensor> expected = MakeColumnarElement(i);
+    ASSERT_EQ(expected.size(), read_tensors.size());
+    for (int j = 0; j < expected.size(); ++j) {
+      ExpectEqualTensors(expected[j], read_tensors[j]);
+    }
+  }
+  std::vector<Tensor> read_tensors;
+  EXPECT_TRUE(errors::IsOutOfRange(reader->ReadTensors(&read_tensors)));
+
+  // Skipping uses the index to seek into the middle of the file.
+  TF_ASSERT_OK(Reader::Create(Env::Default(), filename, compression_type,
+                              /*version=*/3, dtypes, &reader));
+  const int64 num_to_skip = num_elements - 3;
+  TF_ASSERT_OK(reader->SkipRecords(num_to_skip));
+  for (int64 i = num_to_skip; i < num_elements; ++i) {
+    std::vector<Tensor> read_tensors;
+    TF_ASSERT_OK(reader->ReadTensors(&read_tensors));
+    ExpectEqualTensors(MakeColumnarElement(i)[4], read_tensors[4]);
+  }
+  EXPECT_TRUE(errors::IsOutOfRange(reader->SkipRecords(1)));
+
+  TF_ASSERT_OK(Env::Default()->DeleteFile(filename));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    SnapshotUtilTest, ColumnarSnapshotTest,
+    ::testing::Combine(
+        ::testing::Values(io::compression::kNone, io::compression::kSnappy),
+        // The second value spans multiple blocks.
+        ::testing::Values(10, ColumnarWriter::kMaxBlockElements + 10)));
+
+TEST(SnapshotUtilTest, ColumnarReaderRejectsUnclosedFile) {
+  std::string filename;
+  EXPECT_TRUE(Env::Default()->LocalTempFilename(&filename));
+  std::unique_ptr<Writer> writer;
+  TF_ASSERT_OK(Writer::Create(Env::Default(), filename,
+                              io::compression::kNone, /*version=*/3,
+                              {DT_INT64}, &writer));
+  TF_ASSERT_OK(writer->WriteTensors({Tensor(static_cast<int64>(42))}));
+  TF_ASSERT_OK(writer->Sync());
+
+  std::unique_ptr<Reader> reader;
+  EXPECT_TRUE(errors::IsDataLoss(Reader::Create(Env::Default(), filename,
+                                                io::compression::kNone,
+                                                /*version=*/3, {DT_INT64},
+                                                &reader)));
+  TF_ASSERT_OK(writer->Close());
+  TF_ASSERT_OK(Env::Default()->DeleteFile(filename));
+}
+
+TEST(SnapshotUtilTest, ColumnarReaderCopiesSmallElements) {
+  const int64 num_large_values =
+      ColumnarReader::kMinSharedElementBytes / sizeof(float);
+  const DataTypeVector dtypes = {DT_INT32, DT_FLOAT};
+  std::string filename;
+  EXPECT_TRUE(Env::Default()->LocalTempFilename(&filename));
+  std::unique_ptr<Writer> writer;
+  TF_ASSERT_OK(Writer::Create(Env::Default(), filename, io::compression::kNone,
+                              /*version=*/3, dtypes, &writer));
+  for (int i = 0; i < 2; ++i) {
+    Tensor small_tensor(DT_INT32, TensorShape({2}));
+    small_tensor.flat<int32>().setConstant(i);
+    Tensor large_tensor(DT_FLOAT, TensorShape({num_large_values}));
+    large_tensor.flat<float>().setConstant(i);
+    TF_ASSERT_OK(writer->WriteTensors({small_tensor, large_tensor}));
+  }
+  TF_ASSERT_OK(writer->Close());
+
+  std::unique_ptr<Reader> reader;
+  TF_ASSERT_OK(Reader::Create(Env::Default(), filename, io::compression::kNone,
+                              /*version=*/3, dtypes, &reader));
+  std::vector<Tensor> first;
+  std::vector<Tensor> second;
+  TF_ASSERT_OK(reader->ReadTensors(&first));
+  TF_ASSERT_OK(reader->ReadTensors(&second));
+  EXPECT_EQ(first[0].flat<int32>()(1), 0);
+  EXPECT_EQ(second[0].flat<int32>()(1), 1);
+  EXPECT_EQ(second[1].flat<float>()(num_large_values - 1), 1.0f);
+  // Both elements of a column are cut from the same batched tensor, unless
+  // they are small enough to be copied out of it.
+  EXPECT_FALSE(first[0].SharesBufferWith(second[0]));
+  EXPECT_TRUE(first[1].SharesBufferWith(second[1]));
+
+  TF_ASSERT_OK(Env::Default()->DeleteFile(filename));
+}
+
+TEST(SnapshotUtilTest, ColumnarReaderRejectsOverflowingShape) {
+  std::string filename;
+  EXPECT_TRUE(Env::Default()->LocalTempFilename(&filename));
+  std::unique_ptr<Writer> writer;
+  TF_ASSERT_OK(Writer::Create(Env::Default(), filename, io::compression::kNone,
+                              /*version=*/3, {DT_BOOL}, &writer));
+  const TensorShape shape({1, 1, 1, 1, 1, 1, 1, 1, 1});
+  for (int i = 0; i < 2; ++i) {
+    Tensor tensor(DT_BOOL, shape);
+    tensor.flat<bool>().setConstant(false);
+    TF_ASSERT_OK(writer->WriteTensors({tensor}));
+  }
+  TF_ASSERT_OK(writer->Close());
+
+  // Rewrite the encoded dimensions from 1 to 127. The element shape is still
+  // valid, but batching both elements overflows the number of elements.
+  std::string contents;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), filename, &contents));
+  const std::string encoded_shape = "\x09" + std::string(9, '\x01');
+  const size_t pos = contents.find(encoded_shape);
+  ASSERT_NE(pos, std::string::npos);
+  contents.replace(pos + 1, 9, std::string(9, '\x7f'));
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), filename, contents));
+
+  std::unique_ptr<Reader> reader;
+  TF_ASSERT_OK(Reader::Create(Env::Default(), filename, io::compression::kNone,
+                              /*version=*/3, {DT_BOOL}, &reader));
+  std::vector<Tensor> read_tensors;
+  EXPECT_TRUE(errors::IsDataLoss(reader->ReadTensors(&read_tensors)));
+
+  TF_ASSERT_OK(Env::Default()->DeleteFile(filename));
 }
 
 void SnapshotReaderBenchmarkLoop(::testing::benchmark::State& state,
@@ -141,11 +322,22 @@ void SnapshotTFRecordReaderGzipBenchmark(::testing::benchmark::State& state) {
   SnapshotReaderBenchmarkLoop(state, io::compression::kGzip, 2);
 }
 
+void SnapshotColumnarReaderNoneBenchmark(::testing::benchmark::State& state) {
+  SnapshotReaderBenchmarkLoop(state, io::compression::kNone, 3);
+}
+
+void SnapshotColumnarReaderSnappyBenchmark(
+    ::testing::benchmark::State& state) {
+  SnapshotReaderBenchmarkLoop(state, io::compression::kSnappy, 3);
+}
+
 BENCHMARK(SnapshotCustomReaderNoneBenchmark);
 BENCHMARK(SnapshotCustomReaderGzipBenchmark);
 BENCHMARK(SnapshotCustomReaderSnappyBenchmark);
 BENCHMARK(SnapshotTFRecordReaderNoneBenchmark);
 BENCHMARK(SnapshotTFRecordReaderGzipBenchmark);
+BENCHMARK(SnapshotColumnarReaderNoneBenchmark);
+BENCHMARK(SnapshotColumnarReaderSnappyBenchmark);
 
 void SnapshotWriterBenchmarkLoop(::testing::benchmark::State& state,
                                  std::string compression_type, int version) {
@@ -192,12 +384,23 @@ void SnapshotTFRecordWriterSnappyBenchmark(::testing::benchmark::State& state) {
   SnapshotWriterBenchmarkLoop(state, io::compression::kSnappy, 2);
 }
 
+void SnapshotColumnarWriterNoneBenchmark(::testing::benchmark::State& state) {
+  SnapshotWriterBenchmarkLoop(state, io::compression::kNone, 3);
+}
+
+void SnapshotColumnarWriterSnappyBenchmark(
+    ::testing::benchmark::State& state) {
+  SnapshotWriterBenchmarkLoop(state, io::compression::kSnappy, 3);
+}
+
 BENCHMARK(SnapshotCustomWriterNoneBenchmark);
 BENCHMARK(SnapshotCustomWriterGzipBenchmark);
 BENCHMARK(SnapshotCustomWriterSnappyBenchmark);
 BENCHMARK(SnapshotTFRecordWriterNoneBenchmark);
 BENCHMARK(SnapshotTFRecordWriterGzipBenchmark);
 BENCHMARK(SnapshotTFRecordWriterSnappyBenchmark);
+BENCHMARK(SnapshotColumnarWriterNoneBenchmark);
+BENCHMARK(SnapshotColumnarWriterSnappyBenchmark);
 
 }  // namespace
 }  // namespace snapshot_util
@@ -149,9 +149,11 @@ class ModelDatasetOp::Dataset : public DatasetBase {
         int64 now_nanos = EnvTime::NowNanos();
         RecordInput(now_nanos);
       }
+      int64 start_nanos = EnvTime::NowNanos();
       Status s = input_impl_->GetNext(IteratorContext(std::move(params)),
                                       out_tensors, end_of_sequence);
       int64 now_nanos = EnvTime::NowNanos();
+      model_->RecordConsumerWaitTime(now_nanos - start_nanos);
       mutex_lock l(mu_);
       RecordOutput(now_nanos);
       return s;
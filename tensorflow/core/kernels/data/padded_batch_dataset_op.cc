@@ -19,8 +19,8 @@ limitations under the License.
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/kernels/data/dataset_utils.h"
 #include "tensorflow/core/kernels/data/name_utils.h"
-#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/platform/macros.h"
@@ -303,41 +303,24 @@ class PaddedBatchDatasetOp::Dataset : public DatasetBase {
           component_shape.AddDim(batch_component_shape.dim_size(i));
         }
         auto copy_element_fn = [component_index, &batch_elements,
-                                &batch_component, &component_shape](int index) {
+                                &batch_component,
+                                &component_shape](int64 index) {
           // Take the fast path if possible.
           if (batch_elements[index][component_index].shape() ==
               component_shape) {
-            TF_RETURN_IF_ERROR(batch_util::CopyElementToSlice(
+            return batch_util::CopyElementToSlice(
                 batch_elements[index][component_index], &batch_component,
-                index));
-          } else {
-            TF_RETURN_IF_ERROR(batch_util::CopyElementToLargerSlice(
-                batch_elements[index][component_index], &batch_component,
-                index));
+                index);
           }
-          return Status::OK();
+          return batch_util::CopyElementToLargerSlice(
+              batch_elements[index][component_index], &batch_component,
+              index);
         };
-        BlockingCounter counter(num_batch_elements);
-        Status status;
-        mutex status_mu;
-        for (size_t i = 0; i < num_batch_elements; ++i) {
-          if (TF_PREDICT_FALSE(dataset()->parallel_copy_)) {
-            (*ctx->runner())(
-                [i, &status, &status_mu, &counter, &copy_element_fn]() {
-                  Status s = copy_element_fn(i);
-                  {
-                    mutex_lock l(status_mu);
-                    status.Update(s);
-                  }
-                  counter.DecrementCount();
-                });
-          } else {
-            status.Update(copy_element_fn(i));
-            counter.DecrementCount();
-          }
-        }
-        counter.Wait();
-        TF_RETURN_IF_ERROR(status);
+        TF_RETURN_IF_ERROR(ParallelCopy(
+            ctx, dataset()->parallel_copy_, /*shard_large_copies=*/true,
+            num_batch_elements,
+            batch_component.TotalBytes() / num_batch_elements,
+            copy_element_fn));
       }
       *end_of_sequence = false;
       return Status::OK();
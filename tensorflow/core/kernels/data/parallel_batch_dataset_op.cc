@@ -372,7 +372,10 @@ class ParallelBatchDatasetOp::Dataset : public DatasetBase {
         Status status;
         {
           mutex_lock l(result->mu);
-          status = CopyBatch(/*parallel_copy=*/false, ctx.get(),
+          // This runs on the runner threadpool, so the copy must not block
+          // on other closures scheduled on it.
+          status = CopyBatch(/*parallel_copy=*/false,
+                             /*shard_large_copies=*/false, ctx.get(),
                              &result->output, batch_elements.get());
           result->status.Update(status);
           RecordBufferEnqueue(ctx.get(), result->output);
@@ -431,6 +431,40 @@ TEST_F(ParallelBatchDatasetOpTest, InvalidParallelBatchSize) {
             tensorflow::error::INVALID_ARGUMENT);
 }
 
+// Batches elements that are large enough for the copy into the batch to be
+// sharded, with as many parallel calls as there are runner threads. The copies
+// run on the runner threads, so they must not wait for shards queued behind
+// them.
+TEST_F(ParallelBatchDatasetOpTest, LargeElements) {
+  constexpr int64 kBatchSize = 8;
+  constexpr int64 kNumBatches = 4;
+  constexpr int64 kElementSize = 64 << 10;
+  Tensor components(DT_FLOAT,
+                    TensorShape({kNumBatches * kBatchSize, kElementSize}));
+  test::FillIota<float>(&components, 0.0f);
+  auto parallel_batch_dataset_params = ParallelBatchDatasetParams(
+      TensorSliceDatasetParams(/*components=*/{components},
+                               /*node_name=*/"tensor_slice"),
+      /*batch_size=*/kBatchSize,
+      /*num_parallel_calls=*/thread_num_,
+      /*drop_remainder=*/true,
+      /*output_dtypes=*/{DT_FLOAT},
+      /*output_shapes=*/{PartialTensorShape({kBatchSize, kElementSize})},
+      /*deterministic=*/DeterminismPolicy::kDeterministic,
+      /*node_name=*/kNodeName);
+  TF_ASSERT_OK(Initialize(parallel_batch_dataset_params));
+  for (int64 i = 0; i < kNumBatches; ++i) {
+    std::vector<Tensor> out_tensors;
+    bool end_of_sequence = false;
+    TF_ASSERT_OK(iterator_->GetNext(iterator_ctx_.get(), &out_tensors,
+                                    &end_of_sequence));
+    ASSERT_FALSE(end_of_sequence);
+    ASSERT_EQ(out_tensors.size(), 1);
+    test::ExpectTensorEqual<float>(
+        out_tensors[0], components.Slice(i * kBatchSize, (i + 1) * kBatchSize));
+  }
+}
+
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
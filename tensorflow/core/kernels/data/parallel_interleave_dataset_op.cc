@@ -42,6 +42,7 @@ limitations under the License.
 #include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/stringprintf.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/core/profiler/lib/traceme_encode.h"
@@ -138,6 +139,43 @@ int64 ComputePrefetchInputElements(int64 configured_prefetch_input_elements,
   return kDefaultCyclePrefetchFactor * cycle_length;
 }
 
+// Pins the calling thread to the NUMA node of the elements it processes and
+// restores the original CPU affinity of the thread when destroyed.
+class ScopedNumaAffinity {
+ public:
+  explicit ScopedNumaAffinity(bool enabled)
+      : enabled_(enabled),
+        current_node_(enabled ? port::NUMAGetThreadNodeAffinity()
+                              : port::kNUMANoAffinity) {
+    if (enabled_) {
+      initial_cpus_ = port::NUMAGetThreadCpuAffinity();
+    }
+  }
+
+  ~ScopedNumaAffinity() {
+    if (changed_) {
+      port::NUMASetThreadCpuAffinity(initial_cpus_);
+    }
+  }
+
+  // Sets the affinity of the calling thread to `node`, skipping the system
+  // call if the thread already has this affinity.
+  void Set(int node) {
+    if (enabled_ && node != current_node_) {
+      port::NUMASetThreadNodeAffinity(node);
+      current_node_ = node;
+      changed_ = true;
+    }
+  }
+
+ private:
+  const bool enabled_;
+  // The CPUs the thread could run on before it was first pinned.
+  std::vector<int> initial_cpus_;
+  int current_node_;
+  bool changed_ = false;
+};
+
 int64 OpVersionFromOpName(absl::string_view op_name) {
   if (op_name == kParallelInterleaveDatasetV2) {
     return 2;
@@ -347,6 +385,24 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       // TODO(jsimsa): Register cancellation callback once the implementation is
       // refactored not to hold mu_ while calling `GetNext` on the input.
       ctx_ = std::make_unique<IteratorContext>(*ctx);
+      if (ctx->numa_aware() && port::NUMAEnabled()) {
+        // Elements are assigned to NUMA nodes round-robin. Their results are
+        // produced by threads pinned to that node and allocated from memory
+        // local to it, so that only the consumer of this iterator crosses
+        // NUMA nodes.
+        for (int node = 0; node < port::NUMANumNodes(); ++node) {
+          IteratorContext::Params params(ctx);
+          // The threads running the input functions are already pinned, so
+          // nested NUMA-aware iterators must not pin them again.
+          params.numa_aware = false;
+          Allocator* allocator = GetNumaLocalAllocator(node);
+          params.allocator_getter = [allocator](AllocatorAttributes attrs) {
+            return allocator;
+          };
+          numa_ctxs_.push_back(
+              std::make_unique<IteratorContext>(std::move(params)));
+        }
+      }
       TF_RETURN_IF_ERROR(
           dataset()->input_->MakeIterator(ctx, this, prefix(), &input_impl_));
       return dataset()->captured_func_->Instantiate(
@@ -806,6 +862,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
     // current cycle and the results buffer is full.
     void CurrentWorkerThread() TF_LOCKS_EXCLUDED(mu_) {
       RecordStart(ctx_.get());
+      ScopedNumaAffinity numa_affinity(!numa_ctxs_.empty());
       auto done = [this]() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
         RecordStop(ctx_.get());
         DecrementActiveWorkers();
@@ -854,7 +911,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         // Loop on the element until we fill its results buffer or reach end of
         // input for the element.
         while (true) {
-          ProcessElement(element);
+          ProcessElement(element, &numa_affinity);
           {
             mutex_lock l(*mu_);
             // Check whether we have produced enough results for the current
@@ -874,6 +931,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
     // results computed.
     void FutureWorkerThread() TF_LOCKS_EXCLUDED(mu_) {
       RecordStart(ctx_.get());
+      ScopedNumaAffinity numa_affinity(!numa_ctxs_.empty());
       auto done = [this]() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
         RecordStop(ctx_.get());
         DecrementActiveWorkers();
@@ -910,13 +968,23 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
           element->active = true;
           future_elements_.push_back(element);
         }
-        ProcessElement(element);
+        ProcessElement(element, &numa_affinity);
       }
     }
 
+    // Returns the context to use for producing the results of the element with
+    // the given id.
+    IteratorContext* ElementContext(int64 element_id) {
+      if (numa_ctxs_.empty()) {
+        return ctx_.get();
+      }
+      return numa_ctxs_[element_id % numa_ctxs_.size()].get();
+    }
+
     // Generates results for the given element until the element's results
     // buffer is full or the element is done producing results.
-    void ProcessElement(std::shared_ptr<Element> element)
+    void ProcessElement(std::shared_ptr<Element> element,
+                        ScopedNumaAffinity* numa_affinity)
         TF_LOCKS_EXCLUDED(mu_) {
       DCHECK(element != nullptr);
       IteratorBase* iterator;
@@ -938,6 +1006,10 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         iterator = element->iterator.get();
       }
       DCHECK(iterator != nullptr);
+      IteratorContext* ctx = ElementContext(input_element_id);
+      if (!numa_ctxs_.empty()) {
+        numa_affinity->Set(input_element_id % numa_ctxs_.size());
+      }
       // Process until the results queue is full or we reach end of input.
       while (true) {
         auto result = std::make_shared<Result>();
@@ -949,8 +1021,8 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
                {"element_id", result->id}});
         });
         bool end_of_input = false;
-        result->status = iterator->GetNext(ctx_.get(), &result->return_values,
-                                           &end_of_input);
+        result->status =
+            iterator->GetNext(ctx, &result->return_values, &end_of_input);
         if (end_of_input) {
           mutex_lock l(*mu_);
           element->iterator.reset();
@@ -958,7 +1030,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
           NotifyElementUpdate(element);
           break;
         }
-        RecordBufferEnqueue(ctx_.get(), result->return_values);
+        RecordBufferEnqueue(ctx, result->return_values);
         mutex_lock l(*mu_);
         element->results.push_back(std::move(result));
         NotifyElementUpdate(element);
@@ -1006,7 +1078,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         element->inputs =
             absl::make_unique<std::vector<Tensor>>(std::move(inputs));
         status = MakeIteratorFromInputElement(
-            ctx_.get(), this, *element->inputs, element->id,
+            ElementContext(element->id), this, *element->inputs, element->id,
             *instantiated_captured_func_, prefix(), &element->iterator,
             model_node());
         if (!status.ok()) {
@@ -1539,6 +1611,10 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
     // Iterator context used in worker threads.
     std::unique_ptr<IteratorContext> ctx_;
 
+    // Per NUMA node iterator contexts used to produce the results of elements
+    // assigned to that node. Empty unless the pipeline is NUMA-aware.
+    std::vector<std::unique_ptr<IteratorContext>> numa_ctxs_;
+
     // Set to true during checkpointing to alert element threads that they
     // should pause operation. This is needed to prevent constantly-active
     // worker threads from blocking checkpointing indefinitely.
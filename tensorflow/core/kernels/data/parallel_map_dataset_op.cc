@@ -245,7 +245,9 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
         EnsureThreadsStarted(ctx);
         while (ShouldWait(&result)) {
           RecordStop(ctx);
+          num_waiting_consumers_++;
           cond_var_->wait(l);
+          num_waiting_consumers_--;
           RecordStart(ctx);
         }
         if (cancelled_) {
@@ -347,6 +349,9 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
         result.end_of_input = reader->Contains(element_prefix, kEndOfInput);
         RecordBufferEnqueue(ctx, result.return_values);
         result.notification.Notify();
+        if (!deterministic_) {
+          num_completed_++;
+        }
       }
       return Status::OK();
     }
@@ -411,8 +416,18 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
         TF_LOCKS_EXCLUDED(*mu_) {
       mutex_lock l(*mu_);
       num_calls_--;
+      if (!deterministic_) {
+        num_completed_++;
+      }
       result->notification.Notify();
-      cond_var_->notify_all();
+      // Only wake up the waiters if they can make progress. In particular, the
+      // runner thread is not woken up when it is blocked on a full buffer, and
+      // in deterministic mode the consumer waits on the result's notification
+      // rather than on `cond_var_`.
+      if (num_calls_ == 0 || (runner_waiting_ && !BusyLocked()) ||
+          (!deterministic_ && num_waiting_consumers_ > 0)) {
+        cond_var_->notify_all();
+      }
     }
 
     void CallFunction(const std::shared_ptr<IteratorContext>& ctx,
@@ -509,23 +524,20 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
         tf_shared_lock l(*mu_);  // mu_ == num_parallel_calls_->mu
         new_calls.reserve(num_parallel_calls_->value);
       }
-      auto busy = [this]() TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) -> bool {
-        int64 num_parallel_calls = num_parallel_calls_->value;
-        return num_calls_ >= num_parallel_calls ||
-               invocation_results_.size() >= num_parallel_calls;
-      };
       while (true) {
         {
           mutex_lock l(*mu_);
-          while (!cancelled_ && busy()) {
+          while (!cancelled_ && BusyLocked()) {
             RecordStop(ctx.get());
+            runner_waiting_ = true;
             cond_var_->wait(l);
+            runner_waiting_ = false;
             RecordStart(ctx.get());
           }
           if (cancelled_) {
             return;
           }
-          while (!busy()) {
+          while (!BusyLocked()) {
             invocation_results_.push_back(std::make_shared<InvocationResult>());
             new_calls.push_back(invocation_results_.back());
             num_calls_++;
@@ -539,6 +551,25 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
       }
     }
 
+    // Determines whether the runner thread has to wait before it can schedule
+    // more calls.
+    bool BusyLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+      const int64 num_parallel_calls = num_parallel_calls_->value;
+      return num_calls_ >= num_parallel_calls ||
+             invocation_results_.size() >= num_parallel_calls;
+    }
+
+    // Bookkeeping for a result that has been taken out of the buffer.
+    void ConsumeLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+      if (!deterministic_) {
+        // In non-deterministic mode, only completed results are consumed.
+        num_completed_--;
+      }
+      if (runner_waiting_ && !BusyLocked()) {
+        cond_var_->notify_all();
+      }
+    }
+
     // Determines whether the caller needs to wait for a result. Upon returning
     // false, `result` will point to the result.
     bool ShouldWait(std::shared_ptr<InvocationResult>* result)
@@ -551,21 +582,25 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
         // found to be available and not end-of-input. If the first result (in
         // order) is end-of-input, we know that all earlier iterations have
         // already been completed, so it is safe to return that result for the
-        // caller to process end of iteration.
+        // caller to process end of iteration. The scan is skipped altogether
+        // if no call has completed yet.
+        if (num_completed_ == 0) {
+          return true;
+        }
         for (auto it = invocation_results_.begin();
              it != invocation_results_.end(); ++it) {
           if ((*it)->notification.HasBeenNotified() &&
               (it == invocation_results_.begin() || !(*it)->end_of_input)) {
             std::swap(*result, *it);
             invocation_results_.erase(it);
-            cond_var_->notify_all();
+            ConsumeLocked();
             return false;
           }
         }
       } else if (!invocation_results_.empty()) {
         std::swap(*result, invocation_results_.front());
         invocation_results_.pop_front();
-        cond_var_->notify_all();
+        ConsumeLocked();
         return false;
       }
       return true;
@@ -643,6 +678,13 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
     const bool autotune_;
     // Counts the number of outstanding calls.
     int64 num_calls_ TF_GUARDED_BY(*mu_) = 0;
+    // Counts the number of completed calls whose results are still buffered.
+    // Only maintained in non-deterministic mode.
+    int64 num_completed_ TF_GUARDED_BY(*mu_) = 0;
+    // Whether the runner thread is blocked on `cond_var_` and the number of
+    // consumers blocked on it. Used to avoid spurious wake-ups.
+    bool runner_waiting_ TF_GUARDED_BY(*mu_) = false;
+    int64 num_waiting_consumers_ TF_GUARDED_BY(*mu_) = 0;
     // Controls cancellation of `input_impl_`.
     // Must be ordered before `input_impl_` so that `input_impl_` is destroyed
     // first.
@@ -52,6 +52,11 @@ namespace {
 
 // Determines the fraction of slack time by which to delay prefetching of data.
 constexpr double kSleepFactor = 0.2;
+// Bounds for the number of iterations a consumer polls for an element before
+// blocking on the condition variable. The number of iterations adapts between
+// these bounds depending on whether polling recently succeeded.
+constexpr int64 kMinSpinIterations = 16;
+constexpr int64 kMaxSpinIterations = 4096;
 constexpr char kBuffer[] = "buffer";
 constexpr char kStatus[] = "status";
 constexpr char kSizeSuffix[] = ".size";
@@ -167,6 +172,7 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
                            std::vector<Tensor>* out_tensors,
                            bool* end_of_sequence) override {
       const auto& stats_aggregator = ctx->stats_aggregator();
+      MaybeSpinForElement();
       {
         mutex_lock l(*mu_);
         TF_RETURN_IF_ERROR(EnsurePrefetchThreadStarted(ctx));
@@ -178,14 +184,18 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
             auto_tuner_.RecordEmpty();
             buffer_size_->value = auto_tuner_.buffer_limit();
             RecordStop(ctx);
+            num_waiting_consumers_++;
             cond_var_->wait(l);
+            num_waiting_consumers_--;
             RecordStart(ctx);
           }
         } else {
           while (!cancelled_ && buffer_.empty() && !prefetch_thread_finished_ &&
                  buffer_size_->value != 0) {
             RecordStop(ctx);
+            num_waiting_consumers_++;
             cond_var_->wait(l);
+            num_waiting_consumers_--;
             RecordStart(ctx);
           }
         }
@@ -295,6 +305,7 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
         }
         RecordBufferEnqueue(ctx, buffer_element.value);
       }
+      num_buffered_ = buffer_.size();
       return Status::OK();
     }
 
@@ -356,6 +367,38 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
       return buffer_size_->value;
     }
 
+    // Returns the buffer size at or below which a prefetch thread that blocked
+    // on a full buffer is woken up. Refilling the buffer in batches rather
+    // than after every consumed element avoids a producer wake-up per element
+    // when the consumer is the bottleneck.
+    int64 refill_threshold() const TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+      const int64 limit = buffer_limit();
+      return limit - std::max<int64>(1, limit / 4);
+    }
+
+    // Polls for a buffered element for a bounded number of iterations before
+    // the caller blocks on `cond_var_`. If the producer is only slightly
+    // behind the consumer, this avoids parking and waking the consumer thread
+    // for every element.
+    void MaybeSpinForElement() {
+      if (dataset()->buffer_size_ == 0 ||
+          num_buffered_.load(std::memory_order_relaxed) > 0) {
+        return;
+      }
+      const int64 spin_iterations =
+          spin_iterations_.load(std::memory_order_relaxed);
+      for (int64 i = 0; i < spin_iterations; ++i) {
+        if (num_buffered_.load(std::memory_order_relaxed) > 0) {
+          spin_iterations_.store(
+              std::min(spin_iterations * 2, kMaxSpinIterations),
+              std::memory_order_relaxed);
+          return;
+        }
+      }
+      spin_iterations_.store(std::max(spin_iterations / 2, kMinSpinIterations),
+                             std::memory_order_relaxed);
+    }
+
     void CancelThreads() TF_LOCKS_EXCLUDED(mu_) {
       mutex_lock l(*mu_);
       cancelled_ = true;
@@ -416,14 +459,18 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
         buffer_size_->value = auto_tuner_.buffer_limit();
       }
       buffer_.pop_front();
+      num_buffered_ = buffer_.size();
       *end_of_sequence = false;
 
-      // Wake the prefetch thread, in case it has been waiting for space
-      // in the buffer. Also wake up threads from other calls to GetNext.
+      // Wake the prefetch thread if it has been waiting for space in the
+      // buffer and enough space has been freed up.
       //
       // TODO(mrry): Consider using different condition variables for
       // GetNext and Prefetch.
-      cond_var_->notify_all();
+      if (prefetch_thread_waiting_ &&
+          static_cast<int64>(buffer_.size()) <= refill_threshold()) {
+        cond_var_->notify_all();
+      }
       return s;
     }
 
@@ -450,9 +497,16 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
         // 1. Wait for a slot in the buffer.
         {
           mutex_lock l(*mu_);
-          while (!cancelled_ && buffer_.size() >= buffer_limit()) {
+          if (!cancelled_ && buffer_.size() >= buffer_limit()) {
+            // Once the buffer is full, wait until the consumer drained it to
+            // the refill threshold.
             RecordStop(ctx.get());
-            cond_var_->wait(l);
+            prefetch_thread_waiting_ = true;
+            while (!cancelled_ &&
+                   static_cast<int64>(buffer_.size()) > refill_threshold()) {
+              cond_var_->wait(l);
+            }
+            prefetch_thread_waiting_ = false;
             RecordStart(ctx.get());
           }
 
@@ -502,7 +556,10 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
           RecordBufferEnqueue(ctx.get(), buffer_element.value);
           buffer_element.created_us = EnvTime::NowMicros();
           buffer_.push_back(std::move(buffer_element));
-          cond_var_->notify_all();
+          num_buffered_ = buffer_.size();
+          if (num_waiting_consumers_ > 0) {
+            cond_var_->notify_all();
+          }
         }
         ++num_produced;
       }
@@ -563,6 +620,16 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
     std::unique_ptr<Thread> prefetch_thread_ TF_GUARDED_BY(*mu_);
     bool cancelled_ TF_GUARDED_BY(*mu_) = false;
     bool prefetch_thread_finished_ TF_GUARDED_BY(*mu_) = false;
+    // Number of `GetNext` calls blocked on `cond_var_` waiting for an element.
+    int64 num_waiting_consumers_ TF_GUARDED_BY(*mu_) = 0;
+    // Whether the prefetch thread is blocked on `cond_var_` waiting for space
+    // in the buffer.
+    bool prefetch_thread_waiting_ TF_GUARDED_BY(*mu_) = false;
+    // Mirrors `buffer_.size()` so that consumers can poll for an element
+    // without acquiring `mu_`.
+    std::atomic<int64> num_buffered_{0};
+    // Number of iterations `MaybeSpinForElement` polls for an element.
+    std::atomic<int64> spin_iterations_{kMinSpinIterations};
     const bool legacy_autotune_;
 
     std::atomic<int64> slack_us_;
@@ -12,7 +12,12 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/data/prefetch_dataset_op.h"
 
+#include <limits>
+
+#include "tensorflow/core/data/standalone.h"
+#include "tensorflow/core/framework/function_testlib.h"
 #include "tensorflow/core/kernels/data/dataset_test_base.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 namespace data {
@@ -332,6 +337,70 @@ TEST_F(PrefetchDatasetOpTest, InvalidBufferSize) {
   EXPECT_EQ(Initialize(dataset_params).code(), error::INVALID_ARGUMENT);
 }
 
+// Returns a graph producing a prefetch dataset over an unbounded range.
+GraphDef PrefetchBenchmarkGraph(int64 buffer_size, bool legacy_autotune) {
+  using test::function::NDef;
+  const DataTypeVector output_dtypes = {DT_INT64};
+  const std::vector<PartialTensorShape> output_shapes = {
+      PartialTensorShape({})};
+  return test::function::GDef({
+      NDef("start", "Const", {},
+           {{"dtype", DT_INT64}, {"value", Tensor(int64{0})}}),
+      NDef("stop", "Const", {},
+           {{"dtype", DT_INT64},
+            {"value", Tensor(std::numeric_limits<int64>::max())}}),
+      NDef("step", "Const", {},
+           {{"dtype", DT_INT64}, {"value", Tensor(int64{1})}}),
+      NDef("range", "RangeDataset", {"start", "stop", "step"},
+           {{"output_types", output_dtypes},
+            {"output_shapes", output_shapes}}),
+      NDef("buffer_size", "Const", {},
+           {{"dtype", DT_INT64}, {"value", Tensor(buffer_size)}}),
+      NDef(kNodeName, "PrefetchDataset", {"range", "buffer_size"},
+           {{"output_types", output_dtypes},
+            {"output_shapes", output_shapes},
+            {"slack_period", 0},
+            {"legacy_autotune", legacy_autotune},
+            {"buffer_size_min", 0}}),
+      NDef("retval", "_Retval", {kNodeName},
+           {{"T", DT_VARIANT}, {"index", 0}}),
+  });
+}
+
+// Measures the rate at which small elements are handed off from the prefetch
+// thread to the consumer. The input produces elements much faster than the
+// buffer handoff, so the benchmark is dominated by the synchronization between
+// the prefetch thread and `GetNext`.
+void RunPrefetchBenchmark(::testing::benchmark::State& state,
+                          int64 buffer_size, bool legacy_autotune) {
+  std::unique_ptr<standalone::Dataset> dataset;
+  TF_CHECK_OK(standalone::Dataset::FromGraph(
+      {}, PrefetchBenchmarkGraph(buffer_size, legacy_autotune), &dataset));
+  std::unique_ptr<standalone::Iterator> iterator;
+  TF_CHECK_OK(dataset->MakeIterator(&iterator));
+  std::vector<Tensor> outputs;
+  bool end_of_input = false;
+  for (auto s : state) {
+    outputs.clear();
+    TF_CHECK_OK(iterator->GetNext(&outputs, &end_of_input));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_PrefetchHandoff(::testing::benchmark::State& state) {
+  RunPrefetchBenchmark(state, /*buffer_size=*/state.range(0),
+                       /*legacy_autotune=*/false);
+}
+
+BENCHMARK(BM_PrefetchHandoff)->Arg(1)->Arg(8)->Arg(64)->Arg(1024);
+
+void BM_PrefetchHandoffLegacyAutotune(::testing::benchmark::State& state) {
+  RunPrefetchBenchmark(state, /*buffer_size=*/model::kAutotune,
+                       /*legacy_autotune=*/true);
+}
+
+BENCHMARK(BM_PrefetchHandoffLegacyAutotune);
+
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
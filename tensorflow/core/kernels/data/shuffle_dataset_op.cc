@@ -46,6 +46,7 @@ namespace data {
 /* static */ constexpr const char* const ShuffleDatasetOpBase::kOutputShapes;
 /* static */ constexpr const char* const
     ShuffleDatasetOpBase::kReshuffleEachIteration;
+/* static */ constexpr const char* const ShuffleDatasetOpBase::kMaxBufferBytes;
 
 /* static */ constexpr const char* const ShuffleDatasetOp::kDatasetType;
 
@@ -83,15 +84,20 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
  public:
   ShuffleDatasetBase(OpKernelContext* ctx, const DatasetBase* input,
                      int64 buffer_size,
-                     std::shared_ptr<SeedGenerator> seed_generator, int64 count)
+                     std::shared_ptr<SeedGenerator> seed_generator, int64 count,
+                     int64 max_buffer_bytes)
       : DatasetBase(DatasetContext(ctx)),
         input_(input),
         buffer_size_(buffer_size),
         seed_generator_(std::move(seed_generator)),
         count_(count),
+        max_buffer_bytes_(max_buffer_bytes),
         traceme_metadata_(
             {{"buffer_size",
-              strings::Printf("%lld", static_cast<long long>(buffer_size))}}) {
+              strings::Printf("%lld", static_cast<long long>(buffer_size))},
+             {"max_buffer_bytes",
+              strings::Printf("%lld",
+                              static_cast<long long>(max_buffer_bytes))}}) {
     input_->Ref();
   }
 
@@ -171,6 +177,9 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
             ctx, this, this->prefix(), &input_impl_));
       }
       while (input_impl_ && num_elements_ < this->dataset()->buffer_size_) {
+        if (BufferBudgetExhausted()) {
+          break;
+        }
         if (EnvTime::NowMicros() >
             ((num_log_entries + 1) * kLogIntervalMicros) + start_micros) {
           num_log_entries++;
@@ -210,6 +219,9 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
                     << this->dataset()->buffer_size_;
           }
           this->RecordBufferEnqueue(ctx, input_element);
+          if (this->dataset()->max_buffer_bytes_ > 0) {
+            buffered_bytes_ += GetTotalBytes(input_element);
+          }
           buffer_->at(slices_.back()->end % this->dataset()->buffer_size_) =
               std::move(input_element);
           num_elements_++;
@@ -250,6 +262,9 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
             (slices_.front()->start + offset) % this->dataset()->buffer_size_;
         *out_tensors = std::move(buffer_->at(index));
         this->RecordBufferDequeue(ctx, *out_tensors);
+        if (this->dataset()->max_buffer_bytes_ > 0) {
+          buffered_bytes_ -= GetTotalBytes(*out_tensors);
+        }
         std::swap(buffer_->at(index),
                   buffer_->at(slices_.front()->start %
                               this->dataset()->buffer_size_));
@@ -375,12 +390,37 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
         slices_.push_back(absl::make_unique<Slice>(start, end));
       }
       data_produced_ = reader->Contains(this->full_name(kDataProduced));
+      buffered_bytes_ = 0;
+      if (this->dataset()->max_buffer_bytes_ > 0) {
+        for (const auto& element : *buffer_) {
+          buffered_bytes_ += GetTotalBytes(element);
+        }
+      }
 
       return Status::OK();
     }
 
     TraceMeMetadata GetTraceMeMetadata() const override {
-      return this->dataset()->traceme_metadata_;
+      if (this->dataset()->max_buffer_bytes_ <= 0) {
+        return this->dataset()->traceme_metadata_;
+      }
+      int64 num_elements = -1;
+      int64 buffered_bytes = -1;
+      // NOTE: We only report the current mixing window if the lock can be
+      // acquired right away to avoid introducing tracing overhead.
+      if (mu_.try_lock()) {
+        num_elements = num_elements_;
+        buffered_bytes = buffered_bytes_;
+        mu_.unlock();
+      }
+      data::TraceMeMetadata result = this->dataset()->traceme_metadata_;
+      result.push_back(std::make_pair(
+          "num_elements",
+          strings::Printf("%lld", static_cast<long long>(num_elements))));
+      result.push_back(std::make_pair(
+          "buffered_bytes",
+          strings::Printf("%lld", static_cast<long long>(buffered_bytes))));
+      return result;
     }
 
    private:
@@ -396,6 +436,26 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       int64 end;
     };
 
+    // Returns true if the buffered elements use up the memory budget of the
+    // dataset. The buffer always admits at least one element so that elements
+    // larger than the budget can still be produced.
+    bool BufferBudgetExhausted() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      const int64 max_buffer_bytes = this->dataset()->max_buffer_bytes_;
+      if (max_buffer_bytes <= 0 || num_elements_ == 0 ||
+          buffered_bytes_ < max_buffer_bytes) {
+        return false;
+      }
+      if (!budget_reported_) {
+        budget_reported_ = true;
+        LOG(INFO) << "Shuffle buffer reached its memory budget of "
+                  << max_buffer_bytes << " bytes with " << num_elements_
+                  << " of " << this->dataset()->buffer_size_
+                  << " elements; the effective shuffle window is "
+                  << num_elements_ << " elements.";
+      }
+      return true;
+    }
+
     random::SingleSampleAdapter<random::PhiloxRandom>::ResultType Random()
         TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       num_random_samples_++;
@@ -403,7 +463,7 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       return out;
     }
 
-    mutex mu_;
+    mutable mutex mu_;
     SeedGenerator* const seed_generator_ TF_GUARDED_BY(mu_);  // Not owned.
     std::unique_ptr<std::vector<std::vector<Tensor>>> buffer_
         TF_GUARDED_BY(mu_);
@@ -422,6 +482,10 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
         TF_GUARDED_BY(mu_);
     int64 num_random_samples_ TF_GUARDED_BY(mu_) = 0;
     bool data_produced_ TF_GUARDED_BY(mu_) = false;
+    // Total size of the elements in `buffer_`. Only tracked when the dataset
+    // has a memory budget.
+    int64 buffered_bytes_ TF_GUARDED_BY(mu_) = 0;
+    bool budget_reported_ TF_GUARDED_BY(mu_) = false;
   };
 
   const DatasetBase* const input_;
@@ -431,6 +495,9 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
   // fuse shuffle and repeat together, and make the shuffle dataset op
   // responsible for repeating as well.
   const int64 count_;
+  // The maximum number of bytes to buffer, or 0 if only `buffer_size_` bounds
+  // the shuffle buffer.
+  const int64 max_buffer_bytes_;
   const TraceMeMetadata traceme_metadata_;
 };  // ShuffleDatasetBase
 
@@ -443,7 +510,8 @@ class ShuffleDatasetOp::Dataset : public ShuffleDatasetBase {
   Dataset(OpKernelContext* ctx, const DatasetBase* input, int64 buffer_size,
           int64 count, RandomSeeds&& seeds, SeedGeneratorManager* manager,
           ResourceHandle&& resource_handle)
-      : ShuffleDatasetBase(ctx, input, buffer_size, manager->get(), count),
+      : ShuffleDatasetBase(ctx, input, buffer_size, manager->get(), count,
+                           /*max_buffer_bytes=*/0),
         manager_(manager),
         resource_handle_(std::move(resource_handle)),
         resource_mgr_(ctx->resource_manager()),
@@ -501,7 +569,8 @@ class ShuffleDatasetOp::DatasetV2 : public ShuffleDatasetBase {
   DatasetV2(OpKernelContext* ctx, const DatasetBase* input, int64 buffer_size,
             int64 count, SeedGeneratorManager* manager,
             ResourceHandle&& resource_handle, bool owns_resource)
-      : ShuffleDatasetBase(ctx, input, buffer_size, manager->get(), count),
+      : ShuffleDatasetBase(ctx, input, buffer_size, manager->get(), count,
+                           /*max_buffer_bytes=*/0),
         manager_(manager),
         owns_resource_(owns_resource),
         resource_handle_(std::move(resource_handle)),
@@ -553,9 +622,11 @@ class ShuffleDatasetOp::DatasetV2 : public ShuffleDatasetBase {
 class ShuffleDatasetOp::DatasetV3 : public ShuffleDatasetBase {
  public:
   DatasetV3(OpKernelContext* ctx, const DatasetBase* input, int64 buffer_size,
-            int64 count, RandomSeeds&& seeds, SeedGeneratorManager* manager,
-            ResourceHandle&& resource_handle, bool owns_resource)
-      : ShuffleDatasetBase(ctx, input, buffer_size, manager->get(), count),
+            int64 count, int64 max_buffer_bytes, RandomSeeds&& seeds,
+            SeedGeneratorManager* manager, ResourceHandle&& resource_handle,
+            bool owns_resource)
+      : ShuffleDatasetBase(ctx, input, buffer_size, manager->get(), count,
+                           max_buffer_bytes),
         manager_(manager),
         owns_resource_(owns_resource),
         resource_handle_(std::move(resource_handle)),
@@ -594,13 +665,15 @@ class ShuffleDatasetOp::DatasetV3 : public ShuffleDatasetBase {
     AttrValue reshuffle_each_iteration;
     b->BuildAttrValue(seed_generator_->reshuffle_each_iteration(),
                       &reshuffle_each_iteration);
-    TF_RETURN_IF_ERROR(
-        b->AddDataset(this,
-                      {input_graph_node, buffer_size_node, seed_node,
-                       seed2_node, resource_handle_node},  // Inputs
-                      {std::make_pair(kReshuffleEachIteration,
-                                      reshuffle_each_iteration)},  // Attrs
-                      output));
+    AttrValue max_buffer_bytes;
+    b->BuildAttrValue(max_buffer_bytes_, &max_buffer_bytes);
+    TF_RETURN_IF_ERROR(b->AddDataset(
+        this,
+        {input_graph_node, buffer_size_node, seed_node, seed2_node,
+         resource_handle_node},  // Inputs
+        {std::make_pair(kReshuffleEachIteration, reshuffle_each_iteration),
+         std::make_pair(kMaxBufferBytes, max_buffer_bytes)},  // Attrs
+        output));
     return Status::OK();
   }
 
@@ -626,6 +699,12 @@ ShuffleDatasetOp::ShuffleDatasetOp(OpKernelConstruction* ctx)
     OP_REQUIRES_OK(
         ctx, ctx->GetAttr(kReshuffleEachIteration, &reshuffle_each_iteration_));
   }
+  if (ctx->HasAttr(kMaxBufferBytes)) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr(kMaxBufferBytes, &max_buffer_bytes_));
+    OP_REQUIRES(ctx, max_buffer_bytes_ >= 0,
+                errors::InvalidArgument(
+                    "max_buffer_bytes must be greater than or equal to zero."));
+  }
 }
 
 void ShuffleDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
@@ -676,9 +755,9 @@ void ShuffleDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
     }
 
     // Ownership of manager is transferred onto `DatasetV3`.
-    *output = new ShuffleDatasetOp::DatasetV3(ctx, input, buffer_size, count,
-                                              std::move(seeds), manager,
-                                              std::move(handle), owns_resource);
+    *output = new ShuffleDatasetOp::DatasetV3(
+        ctx, input, buffer_size, count, max_buffer_bytes_, std::move(seeds),
+        manager, std::move(handle), owns_resource);
   } else if (op_version_ == 2) {
     auto handle = HandleFromInput(ctx, 2);
     SeedGeneratorManager* manager = nullptr;
@@ -749,7 +828,8 @@ class ShuffleAndRepeatDatasetOp::Dataset : public ShuffleDatasetBase {
   Dataset(OpKernelContext* ctx, const DatasetBase* input, int64 buffer_size,
           RandomSeeds&& seeds, SeedGeneratorManager* manager, int64 count,
           ResourceHandle&& resource_handle)
-      : ShuffleDatasetBase(ctx, input, buffer_size, manager->get(), count),
+      : ShuffleDatasetBase(ctx, input, buffer_size, manager->get(), count,
+                           /*max_buffer_bytes=*/0),
         manager_(manager),
         resource_handle_(std::move(resource_handle)),
         resource_mgr_(ctx->resource_manager()),
@@ -804,7 +884,8 @@ class ShuffleAndRepeatDatasetOp::DatasetV2 : public ShuffleDatasetBase {
   DatasetV2(OpKernelContext* ctx, const DatasetBase* input, int64 buffer_size,
             int64 count, RandomSeeds&& seeds, SeedGeneratorManager* manager,
             ResourceHandle&& resource_handle, bool owns_resource)
-      : ShuffleDatasetBase(ctx, input, buffer_size, manager->get(), count),
+      : ShuffleDatasetBase(ctx, input, buffer_size, manager->get(), count,
+                           /*max_buffer_bytes=*/0),
         manager_(manager),
         owns_resource_(owns_resource),
         resource_handle_(std::move(resource_handle)),
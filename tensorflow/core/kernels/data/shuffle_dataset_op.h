@@ -30,6 +30,7 @@ class ShuffleDatasetOpBase : public UnaryDatasetOpKernel {
   static constexpr const char* const kOutputShapes = "output_shapes";
   static constexpr const char* const kReshuffleEachIteration =
       "reshuffle_each_iteration";
+  static constexpr const char* const kMaxBufferBytes = "max_buffer_bytes";
 
   explicit ShuffleDatasetOpBase(OpKernelConstruction* ctx);
 
@@ -53,6 +54,7 @@ class ShuffleDatasetOp : public ShuffleDatasetOpBase {
   class DatasetV3;
   int op_version_ = 0;
   bool reshuffle_each_iteration_ = true;
+  int64 max_buffer_bytes_ = 0;
 };
 
 class ShuffleAndRepeatDatasetOp : public ShuffleDatasetOpBase {
@@ -35,6 +35,9 @@ namespace data {
 /* static */ constexpr const char* const TFRecordDatasetOp::kFileNames;
 /* static */ constexpr const char* const TFRecordDatasetOp::kCompressionType;
 /* static */ constexpr const char* const TFRecordDatasetOp::kBufferSize;
+/* static */ constexpr const char* const TFRecordDatasetOp::kUseMemoryMap;
+/* static */ constexpr const char* const TFRecordDatasetOp::kVerifyChecksums;
+/* static */ constexpr const char* const TFRecordDatasetOp::kReadaheadBuffers;
 
 constexpr char kCurrentFileIndex[] = "current_file_index";
 constexpr char kOffset[] = "offset";
@@ -42,6 +45,8 @@ constexpr char kGcsFsPrefix[] = "gs://";
 constexpr char kS3FsPrefix[] = "s3://";
 constexpr int64 kCloudTpuBlockSize = 127LL << 20;  // 127MB.
 constexpr int64 kS3BlockSize = kCloudTpuBlockSize;
+// Maximum number of records read from the file at once when reading ahead.
+constexpr int kMaxReadaheadRecords = 256;
 
 bool is_cloud_tpu_gcs_fs() {
 #if defined(PLATFORM_CLOUD_TPU) && defined(TPU_GCS_FS)
@@ -53,15 +58,20 @@ bool is_cloud_tpu_gcs_fs() {
 class TFRecordDatasetOp::Dataset : public DatasetBase {
  public:
   explicit Dataset(OpKernelContext* ctx, std::vector<string> filenames,
-                   const string& compression_type, int64 buffer_size)
+                   const string& compression_type, int64 buffer_size,
+                   bool use_memory_map, bool verify_checksums,
+                   int64 readahead_buffers)
       : DatasetBase(DatasetContext(ctx)),
         filenames_(std::move(filenames)),
         compression_type_(compression_type),
         options_(io::RecordReaderOptions::CreateRecordReaderOptions(
-            compression_type)) {
+            compression_type)),
+        use_memory_map_(use_memory_map) {
     if (buffer_size > 0) {
       options_.buffer_size = buffer_size;
     }
+    options_.verify_checksums = verify_checksums;
+    options_.readahead_buffers = readahead_buffers;
   }
 
   std::unique_ptr<IteratorBase> MakeIteratorInternal(
@@ -101,8 +111,19 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
     TF_RETURN_IF_ERROR(b->AddScalar(compression_type_, &compression_type));
     Node* buffer_size = nullptr;
     TF_RETURN_IF_ERROR(b->AddScalar(options_.buffer_size, &buffer_size));
+    AttrValue use_memory_map;
+    b->BuildAttrValue(use_memory_map_, &use_memory_map);
+    AttrValue verify_checksums;
+    b->BuildAttrValue(options_.verify_checksums, &verify_checksums);
+    AttrValue readahead_buffers;
+    b->BuildAttrValue(static_cast<int64>(options_.readahead_buffers),
+                      &readahead_buffers);
     TF_RETURN_IF_ERROR(b->AddDataset(
-        this, {filenames, compression_type, buffer_size}, output));
+        this, {filenames, compression_type, buffer_size},
+        {std::make_pair(kUseMemoryMap, use_memory_map),
+         std::make_pair(kVerifyChecksums, verify_checksums),
+         std::make_pair(kReadaheadBuffers, readahead_buffers)},
+        output));
     return Status::OK();
   }
 
@@ -119,11 +140,11 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
       mutex_lock l(mu_);
       do {
         // We are currently processing a file, so try to read the next record.
-        if (reader_) {
+        if (reader_ || mmap_reader_) {
           out_tensors->emplace_back(ctx->allocator({}), DT_STRING,
                                     TensorShape({}));
           Status s =
-              reader_->ReadRecord(&out_tensors->back().scalar<tstring>()());
+              ReadRecordLocked(&out_tensors->back().scalar<tstring>()());
           if (s.ok()) {
             static monitoring::CounterCell* bytes_counter =
                 metrics::GetTFDataBytesReadCounter(kDatasetType);
@@ -165,10 +186,10 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
       do {
         // We are currently processing a file, so try to skip reading
         // the next (num_to_skip - *num_skipped) record.
-        if (reader_) {
+        if (reader_ || mmap_reader_) {
           int last_num_skipped;
-          Status s = reader_->SkipRecords(num_to_skip - *num_skipped,
-                                          &last_num_skipped);
+          Status s = SkipRecordsLocked(num_to_skip - *num_skipped,
+                                       &last_num_skipped);
           *num_skipped += last_num_skipped;
           if (s.ok()) {
             *end_of_sequence = false;
@@ -211,9 +232,9 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
       TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kCurrentFileIndex),
                                              current_file_index_));
 
-      if (reader_) {
+      if (reader_ || mmap_reader_) {
         TF_RETURN_IF_ERROR(
-            writer->WriteScalar(full_name(kOffset), reader_->TellOffset()));
+            writer->WriteScalar(full_name(kOffset), TellOffsetLocked()));
       }
       return Status::OK();
     }
@@ -230,7 +251,7 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
         int64 offset;
         TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kOffset), &offset));
         TF_RETURN_IF_ERROR(SetupStreamsLocked(ctx->env()));
-        TF_RETURN_IF_ERROR(reader_->SeekOffset(offset));
+        TF_RETURN_IF_ERROR(SeekOffsetLocked(offset));
       }
       return Status::OK();
     }
@@ -246,9 +267,25 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
 
       // Actually move on to next file.
       const string& next_filename = dataset()->filenames_[current_file_index_];
+      if (dataset()->use_memory_map_ &&
+          dataset()->options_.compression_type ==
+              io::RecordReaderOptions::NONE) {
+        Status s =
+            env->NewReadOnlyMemoryRegionFromFile(next_filename, &region_);
+        if (s.ok()) {
+          mmap_reader_ = absl::make_unique<io::MemmappedRecordReader>(
+              region_.get(), dataset()->options_.verify_checksums);
+          mmap_offset_ = 0;
+          return Status::OK();
+        }
+        // Not every file system supports memory mapping (and empty files
+        // cannot be mapped), so fall back to reading through the file.
+        VLOG(2) << "Failed to memory map " << next_filename
+                << ", falling back to buffered reads: " << s;
+      }
       TF_RETURN_IF_ERROR(env->NewRandomAccessFile(next_filename, &file_));
       reader_ = absl::make_unique<io::SequentialRecordReader>(
-          file_.get(), dataset()->options_);
+          file_.get(), dataset()->options_, env);
       return Status::OK();
     }
 
@@ -256,6 +293,86 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
     void ResetStreamsLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       reader_.reset();
       file_.reset();
+      mmap_reader_.reset();
+      region_.reset();
+      mmap_offset_ = 0;
+      records_.clear();
+      next_record_ = 0;
+      records_status_ = Status::OK();
+    }
+
+    Status ReadRecordLocked(tstring* record) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (mmap_reader_) {
+        return mmap_reader_->ReadRecord(&mmap_offset_, record);
+      }
+      if (dataset()->options_.readahead_buffers == 0) {
+        return reader_->ReadRecord(record);
+      }
+      // When reading ahead, records are read in batches of up to one buffer
+      // to amortize the cost of reading from the stream. Without a buffer,
+      // batches are only bounded by the number of records.
+      if (next_record_ == records_.size()) {
+        if (!records_status_.ok()) {
+          return records_status_;
+        }
+        records_.clear();
+        next_record_ = 0;
+        const int64 max_bytes = dataset()->options_.buffer_size > 0
+                                    ? dataset()->options_.buffer_size
+                                    : kint64max;
+        records_status_ =
+            reader_->ReadRecords(kMaxReadaheadRecords, max_bytes, &records_);
+        if (records_.empty()) {
+          return records_status_;
+        }
+      }
+      *record = std::move(records_[next_record_++]);
+      return Status::OK();
+    }
+
+    Status SkipRecordsLocked(int num_to_skip, int* num_skipped)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (mmap_reader_) {
+        return mmap_reader_->SkipRecords(&mmap_offset_, num_to_skip,
+                                         num_skipped);
+      }
+      const int num_buffered = std::min<int64>(
+          num_to_skip, static_cast<int64>(records_.size() - next_record_));
+      next_record_ += num_buffered;
+      *num_skipped = num_buffered;
+      if (num_buffered == num_to_skip) {
+        return Status::OK();
+      }
+      if (!records_status_.ok()) {
+        return records_status_;
+      }
+      int last_num_skipped = 0;
+      Status s = reader_->SkipRecords(num_to_skip - num_buffered,
+                                      &last_num_skipped);
+      *num_skipped += last_num_skipped;
+      return s;
+    }
+
+    uint64 TellOffsetLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (mmap_reader_) {
+        return mmap_offset_;
+      }
+      // Records that have been read but not yet produced are re-read after
+      // restoring.
+      uint64 offset = reader_->TellOffset();
+      for (size_t i = next_record_; i < records_.size(); ++i) {
+        offset -= io::RecordReader::kHeaderSize + records_[i].size() +
+                  io::RecordReader::kFooterSize;
+      }
+      return offset;
+    }
+
+    Status SeekOffsetLocked(uint64 offset) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (mmap_reader_) {
+        mmap_offset_ = offset;
+        return Status::OK();
+      }
+      return reader_->SeekOffset(offset);
     }
 
     mutex mu_;
@@ -265,15 +382,34 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
     // we must destroy `reader_` before `file_`.
     std::unique_ptr<RandomAccessFile> file_ TF_GUARDED_BY(mu_);
     std::unique_ptr<io::SequentialRecordReader> reader_ TF_GUARDED_BY(mu_);
+
+    // Used instead of `file_` and `reader_` when the current file is memory
+    // mapped. Likewise, `mmap_reader_` borrows `region_`.
+    std::unique_ptr<ReadOnlyMemoryRegion> region_ TF_GUARDED_BY(mu_);
+    std::unique_ptr<io::MemmappedRecordReader> mmap_reader_ TF_GUARDED_BY(mu_);
+    uint64 mmap_offset_ TF_GUARDED_BY(mu_) = 0;
+
+    // Records read from `reader_` ahead of the consumer, and the status of the
+    // read that ended the batch. Only used when reading ahead.
+    std::vector<tstring> records_ TF_GUARDED_BY(mu_);
+    size_t next_record_ TF_GUARDED_BY(mu_) = 0;
+    Status records_status_ TF_GUARDED_BY(mu_);
   };
 
   const std::vector<string> filenames_;
   const tstring compression_type_;
   io::RecordReaderOptions options_;
+  const bool use_memory_map_;
 };
 
 TFRecordDatasetOp::TFRecordDatasetOp(OpKernelConstruction* ctx)
-    : DatasetOpKernel(ctx) {}
+    : DatasetOpKernel(ctx) {
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kUseMemoryMap, &use_memory_map_));
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kVerifyChecksums, &verify_checksums_));
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kReadaheadBuffers, &readahead_buffers_));
+  OP_REQUIRES(ctx, readahead_buffers_ >= 0,
+              errors::InvalidArgument("`readahead_buffers` must be >= 0"));
+}
 
 void TFRecordDatasetOp::MakeDataset(OpKernelContext* ctx,
                                     DatasetBase** output) {
@@ -321,8 +457,9 @@ void TFRecordDatasetOp::MakeDataset(OpKernelContext* ctx,
     buffer_size = kS3BlockSize;
   }
 
-  *output =
-      new Dataset(ctx, std::move(filenames), compression_type, buffer_size);
+  *output = new Dataset(ctx, std::move(filenames), compression_type,
+                        buffer_size, use_memory_map_, verify_checksums_,
+                        readahead_buffers_);
 }
 
 namespace {
@@ -26,6 +26,9 @@ class TFRecordDatasetOp : public DatasetOpKernel {
   static constexpr const char* const kFileNames = "filenames";
   static constexpr const char* const kCompressionType = "compression_type";
   static constexpr const char* const kBufferSize = "buffer_size";
+  static constexpr const char* const kUseMemoryMap = "use_memory_map";
+  static constexpr const char* const kVerifyChecksums = "verify_checksums";
+  static constexpr const char* const kReadaheadBuffers = "readahead_buffers";
 
   explicit TFRecordDatasetOp(OpKernelConstruction* ctx);
 
@@ -34,6 +37,10 @@ class TFRecordDatasetOp : public DatasetOpKernel {
 
  private:
   class Dataset;
+
+  bool use_memory_map_;
+  bool verify_checksums_;
+  int64 readahead_buffers_;
 };
 
 }  // namespace data
@@ -0,0 +1,164 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/readahead_inputstream.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace io {
+
+ReadaheadInputStream::ReadaheadInputStream(Env* env, RandomAccessFile* file,
+                                           size_t chunk_bytes, int num_chunks)
+    : file_(file),
+      chunk_bytes_(chunk_bytes),
+      num_chunks_(std::max(num_chunks, 1)) {
+  DCHECK_GT(chunk_bytes_, 0);
+  thread_.reset(env->StartThread(ThreadOptions(), "tf_readahead_inputstream",
+                                 [this]() { PrefetchLoop(); }));
+}
+
+ReadaheadInputStream::~ReadaheadInputStream() {
+  {
+    mutex_lock l(mu_);
+    cancelled_ = true;
+    cond_var_.notify_all();
+  }
+  // Joins the background thread.
+  thread_.reset();
+}
+
+void ReadaheadInputStream::PrefetchLoop() {
+  while (true) {
+    int64 offset;
+    int64 generation;
+    {
+      mutex_lock l(mu_);
+      while (!cancelled_ && (fetch_done_ || chunks_.size() >= num_chunks_)) {
+        cond_var_.wait(l);
+      }
+      if (cancelled_) {
+        return;
+      }
+      offset = fetch_offset_;
+      generation = generation_;
+    }
+
+    Chunk chunk;
+    chunk.offset = offset;
+    chunk.data.resize_uninitialized(chunk_bytes_);
+    StringPiece data;
+    chunk.status = file_->Read(offset, chunk_bytes_, &data, &chunk.data[0]);
+    if (data.data() != chunk.data.data()) {
+      // Some file systems return data without copying it into the scratch
+      // buffer.
+      memmove(&chunk.data[0], data.data(), data.size());
+    }
+    chunk.data.resize(data.size());
+
+    mutex_lock l(mu_);
+    if (generation != generation_) {
+      // The consumer has seeked elsewhere while we were reading.
+      continue;
+    }
+    fetch_offset_ = offset + data.size();
+    fetch_done_ = !chunk.status.ok();
+    chunks_.push_back(std::move(chunk));
+    cond_var_.notify_all();
+  }
+}
+
+Status ReadaheadInputStream::Consume(int64 n, char* dst, int64* consumed) {
+  *consumed = 0;
+  mutex_lock l(mu_);
+  while (*consumed < n) {
+    while (chunks_.empty()) {
+      cond_var_.wait(l);
+    }
+    const Chunk& chunk = chunks_.front();
+    const int64 chunk_end = chunk.offset + chunk.data.size();
+    if (pos_ < chunk_end) {
+      const int64 bytes = std::min(n - *consumed, chunk_end - pos_);
+      if (dst != nullptr) {
+        memcpy(dst + *consumed, chunk.data.data() + (pos_ - chunk.offset),
+               bytes);
+      }
+      pos_ += bytes;
+      *consumed += bytes;
+      continue;
+    }
+    if (!chunk.status.ok()) {
+      // Keep the chunk around so that subsequent reads fail the same way.
+      return chunk.status;
+    }
+    chunks_.pop_front();
+    cond_var_.notify_all();
+  }
+  return Status::OK();
+}
+
+Status ReadaheadInputStream::ReadNBytes(int64 bytes_to_read, tstring* result) {
+  if (bytes_to_read < 0) {
+    return errors::InvalidArgument("Can't read a negative number of bytes: ",
+                                   bytes_to_read);
+  }
+  result->clear();
+  result->resize_uninitialized(bytes_to_read);
+  int64 consumed = 0;
+  Status s = Consume(bytes_to_read, &(*result)[0], &consumed);
+  result->resize(consumed);
+  return s;
+}
+
+Status ReadaheadInputStream::SkipNBytes(int64 bytes_to_skip) {
+  if (bytes_to_skip < 0) {
+    return errors::InvalidArgument("Can't skip a negative number of bytes: ",
+                                   bytes_to_skip);
+  }
+  int64 consumed = 0;
+  return Consume(bytes_to_skip, nullptr, &consumed);
+}
+
+int64 ReadaheadInputStream::Tell() const { return pos_; }
+
+Status ReadaheadInputStream::Seek(int64 position) {
+  if (position < 0) {
+    return errors::InvalidArgument("Seeking to a negative position: ",
+                                   position);
+  }
+  mutex_lock l(mu_);
+  // Drop the chunks before `position`.
+  while (!chunks_.empty() &&
+         chunks_.front().offset + chunks_.front().data.size() <= position &&
+         chunks_.front().status.ok()) {
+    chunks_.pop_front();
+  }
+  if (chunks_.empty() || chunks_.front().offset > position) {
+    chunks_.clear();
+    ++generation_;
+    fetch_offset_ = position - position % chunk_bytes_;
+    fetch_done_ = false;
+  }
+  pos_ = position;
+  cond_var_.notify_all();
+  return Status::OK();
+}
+
+}  // namespace io
+}  // namespace tensorflow
@@ -0,0 +1,109 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_IO_READAHEAD_INPUTSTREAM_H_
+#define TENSORFLOW_CORE_LIB_IO_READAHEAD_INPUTSTREAM_H_
+
+#include <deque>
+#include <memory>
+
+#include "tensorflow/core/lib/io/inputstream_interface.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace io {
+
+// Wraps a RandomAccessFile in an InputStreamInterface that reads ahead of the
+// consumer on a background thread.
+//
+// The file is fetched in chunks of `chunk_bytes`, aligned to multiples of
+// `chunk_bytes` within the file, into a ring of at most `num_chunks` buffers.
+// Reads are served from the ring, so small sequential reads (e.g. the headers
+// and payloads of TFRecords) neither issue system calls nor wait on I/O while
+// the consumer is slower than the file.
+//
+// A given instance of ReadaheadInputStream is NOT safe for concurrent use by
+// multiple threads.
+class ReadaheadInputStream : public InputStreamInterface {
+ public:
+  // Does not take ownership of `file`, which must outlive *this.
+  ReadaheadInputStream(Env* env, RandomAccessFile* file, size_t chunk_bytes,
+                       int num_chunks);
+
+  ~ReadaheadInputStream() override;
+
+  Status ReadNBytes(int64 bytes_to_read, tstring* result) override;
+
+  Status SkipNBytes(int64 bytes_to_skip) override;
+
+  int64 Tell() const override;
+
+  // Seeks to `position` within the file. Buffered data past `position` is
+  // reused; otherwise read ahead restarts at `position`.
+  Status Seek(int64 position);
+
+  Status Reset() override { return Seek(0); }
+
+ private:
+  struct Chunk {
+    int64 offset;  // Offset of `data` within the file.
+    tstring data;
+    // Status of the read that produced `data`. A non-OK status (including
+    // OUT_OF_RANGE at end of file) is returned once `data` is consumed.
+    Status status;
+  };
+
+  // Body of the background thread.
+  void PrefetchLoop();
+
+  // Consumes up to `n` bytes at `pos_`, copying them to `dst` unless `dst` is
+  // null. Blocks until the bytes are available or the end of the file or an
+  // error is reached.
+  Status Consume(int64 n, char* dst, int64* consumed);
+
+  RandomAccessFile* const file_;  // Not owned.
+  const size_t chunk_bytes_;
+  const size_t num_chunks_;
+
+  // Position of the consumer. Only accessed by the consumer thread.
+  int64 pos_ = 0;
+
+  mutex mu_;
+  condition_variable cond_var_;
+  // Fetched chunks, in file order, starting with the one holding `pos_`.
+  std::deque<Chunk> chunks_ TF_GUARDED_BY(mu_);
+  // Offset of the next chunk to fetch.
+  int64 fetch_offset_ TF_GUARDED_BY(mu_) = 0;
+  // Set once a read returns a non-OK status; fetching resumes after a seek.
+  bool fetch_done_ TF_GUARDED_BY(mu_) = false;
+  // Incremented on every seek that discards buffered data so that reads
+  // issued before the seek are dropped.
+  int64 generation_ TF_GUARDED_BY(mu_) = 0;
+  bool cancelled_ TF_GUARDED_BY(mu_) = false;
+
+  // Must be declared last so that the thread is joined before any of the state
+  // it accesses is destroyed.
+  std::unique_ptr<Thread> thread_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ReadaheadInputStream);
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_IO_READAHEAD_INPUTSTREAM_H_
@@ -0,0 +1,135 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/readahead_inputstream.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace io {
+namespace {
+
+static std::vector<int> ChunkSizes() { return {1, 2, 3, 5, 7, 11, 64}; }
+
+static std::vector<int> NumChunks() { return {1, 2, 4}; }
+
+TEST(ReadaheadInputStream, ReadAll) {
+  Env* env = Env::Default();
+  string fname;
+  ASSERT_TRUE(env->LocalTempFilename(&fname));
+  TF_ASSERT_OK(WriteStringToFile(env, fname, "0123456789abcdefghij"));
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+
+  for (auto chunk_size : ChunkSizes()) {
+    for (auto num_chunks : NumChunks()) {
+      ReadaheadInputStream in(env, file.get(), chunk_size, num_chunks);
+      tstring read;
+      TF_ASSERT_OK(in.ReadNBytes(0, &read));
+      EXPECT_EQ(read, "");
+      TF_ASSERT_OK(in.ReadNBytes(3, &read));
+      EXPECT_EQ(read, "012");
+      EXPECT_EQ(3, in.Tell());
+      TF_ASSERT_OK(in.ReadNBytes(12, &read));
+      EXPECT_EQ(read, "3456789abcde");
+      EXPECT_EQ(15, in.Tell());
+      EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(10, &read)));
+      EXPECT_EQ(read, "fghij");
+      EXPECT_EQ(20, in.Tell());
+      EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(1, &read)));
+      EXPECT_EQ(read, "");
+      EXPECT_EQ(20, in.Tell());
+    }
+  }
+}
+
+TEST(ReadaheadInputStream, Skip) {
+  Env* env = Env::Default();
+  string fname;
+  ASSERT_TRUE(env->LocalTempFilename(&fname));
+  TF_ASSERT_OK(WriteStringToFile(env, fname, "0123456789abcdefghij"));
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+
+  for (auto chunk_size : ChunkSizes()) {
+    for (auto num_chunks : NumChunks()) {
+      ReadaheadInputStream in(env, file.get(), chunk_size, num_chunks);
+      tstring read;
+      TF_ASSERT_OK(in.SkipNBytes(4));
+      TF_ASSERT_OK(in.ReadNBytes(3, &read));
+      EXPECT_EQ(read, "456");
+      TF_ASSERT_OK(in.SkipNBytes(10));
+      EXPECT_EQ(17, in.Tell());
+      TF_ASSERT_OK(in.ReadNBytes(2, &read));
+      EXPECT_EQ(read, "hi");
+      EXPECT_TRUE(errors::IsOutOfRange(in.SkipNBytes(5)));
+      EXPECT_EQ(20, in.Tell());
+    }
+  }
+}
+
+TEST(ReadaheadInputStream, SeekAndReset) {
+  Env* env = Env::Default();
+  string fname;
+  ASSERT_TRUE(env->LocalTempFilename(&fname));
+  TF_ASSERT_OK(WriteStringToFile(env, fname, "0123456789abcdefghij"));
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+
+  for (auto chunk_size : ChunkSizes()) {
+    for (auto num_chunks : NumChunks()) {
+      ReadaheadInputStream in(env, file.get(), chunk_size, num_chunks);
+      tstring read;
+      TF_ASSERT_OK(in.Seek(13));
+      TF_ASSERT_OK(in.ReadNBytes(3, &read));
+      EXPECT_EQ(read, "def");
+      TF_ASSERT_OK(in.Seek(5));
+      TF_ASSERT_OK(in.ReadNBytes(3, &read));
+      EXPECT_EQ(read, "567");
+      TF_ASSERT_OK(in.Seek(9));
+      TF_ASSERT_OK(in.ReadNBytes(2, &read));
+      EXPECT_EQ(read, "9a");
+      EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(20, &read)));
+      EXPECT_EQ(read, "bcdefghij");
+      TF_ASSERT_OK(in.Reset());
+      EXPECT_EQ(0, in.Tell());
+      TF_ASSERT_OK(in.ReadNBytes(4, &read));
+      EXPECT_EQ(read, "0123");
+      TF_ASSERT_OK(in.Seek(25));
+      EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(1, &read)));
+    }
+  }
+}
+
+TEST(ReadaheadInputStream, EmptyFile) {
+  Env* env = Env::Default();
+  string fname;
+  ASSERT_TRUE(env->LocalTempFilename(&fname));
+  TF_ASSERT_OK(WriteStringToFile(env, fname, ""));
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+
+  ReadaheadInputStream in(env, file.get(), /*chunk_bytes=*/8,
+                          /*num_chunks=*/2);
+  tstring read;
+  EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(1, &read)));
+  EXPECT_EQ(read, "");
+}
+
+}  // anonymous namespace
+}  // namespace io
+}  // namespace tensorflow
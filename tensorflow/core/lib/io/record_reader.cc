@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/buffered_inputstream.h"
 #include "tensorflow/core/lib/io/compression.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
+#include "tensorflow/core/lib/io/readahead_inputstream.h"
 #include "tensorflow/core/platform/env.h"
 
 namespace tensorflow {
@@ -55,13 +56,25 @@ RecordReaderOptions RecordReaderOptions::CreateRecordReaderOptions(
 }
 
 RecordReader::RecordReader(RandomAccessFile* file,
-                           const RecordReaderOptions& options)
-    : options_(options),
-      input_stream_(new RandomAccessInputStream(file)),
-      last_read_failed_(false) {
-  if (options.buffer_size > 0) {
-    input_stream_.reset(new BufferedInputStream(input_stream_.release(),
-                                                options.buffer_size, true));
+                           const RecordReaderOptions& options, Env* env)
+    : options_(options), last_read_failed_(false) {
+  if (options.buffer_size > 0 && options.readahead_buffers > 0) {
+    auto* stream = new ReadaheadInputStream(
+        env, file, options.buffer_size, options.readahead_buffers);
+    input_stream_.reset(stream);
+    seek_ = [stream](int64 position) { return stream->Seek(position); };
+  } else if (options.buffer_size > 0) {
+    auto* stream = new BufferedInputStream(new RandomAccessInputStream(file),
+                                           options.buffer_size, true);
+    input_stream_.reset(stream);
+    seek_ = [stream](int64 position) { return stream->Seek(position); };
+  } else {
+    auto* stream = new RandomAccessInputStream(file);
+    input_stream_.reset(stream);
+    seek_ = [stream](int64 position) { return stream->Seek(position); };
+  }
+  if (options.compression_type != RecordReaderOptions::NONE) {
+    seek_ = nullptr;
   }
 #if defined(IS_SLIM_BUILD)
   if (options.compression_type != RecordReaderOptions::NONE) {
@@ -87,10 +100,14 @@ RecordReader::RecordReader(RandomAccessFile* file,
 
 // Read n+4 bytes from file, verify that checksum of first n bytes is
 // stored in the last 4 bytes and store the first n bytes in *result.
+// The checksum of a record payload is only verified if
+// options_.verify_checksums is set; the checksum of a header, which holds
+// the record length, is always verified.
 //
 // offset corresponds to the user-provided value to ReadRecord()
 // and is used only in error messages.
-Status RecordReader::ReadChecksummed(uint64 offset, size_t n, tstring* result) {
+Status RecordReader::ReadChecksummed(uint64 offset, size_t n, bool is_header,
+                                     tstring* result) {
   if (n >= SIZE_MAX - sizeof(uint32)) {
     return errors::DataLoss("record size too large");
   }
@@ -106,9 +123,11 @@ Status RecordReader::ReadChecksummed(uint64 offset, size_t n, tstring* result) {
     }
   }
 
-  const uint32 masked_crc = core::DecodeFixed32(result->data() + n);
-  if (crc32c::Unmask(masked_crc) != crc32c::Value(result->data(), n)) {
-    return errors::DataLoss("corrupted record at ", offset);
+  if (is_header || options_.verify_checksums) {
+    const uint32 masked_crc = core::DecodeFixed32(result->data() + n);
+    if (crc32c::Unmask(masked_crc) != crc32c::Value(result->data(), n)) {
+      return errors::DataLoss("corrupted record at ", offset);
+    }
   }
   result->resize(n);
   return Status::OK();
@@ -134,7 +153,8 @@ Status RecordReader::GetMetadata(Metadata* md) {
     tstring record;
     while (true) {
       // Read header, containing size of data.
-      Status s = ReadChecksummed(offset, sizeof(uint64), &record);
+      Status s =
+          ReadChecksummed(offset, sizeof(uint64), /*is_header=*/true, &record);
       if (!s.ok()) {
         if (errors::IsOutOfRange(s)) {
           // We should reach out of range when the record file is complete.
@@ -173,8 +193,12 @@ Status RecordReader::PositionInputStream(uint64 offset) {
   if (curr_pos > desired_pos || curr_pos < 0 /* EOF */ ||
       (curr_pos == desired_pos && last_read_failed_)) {
     last_read_failed_ = false;
-    TF_RETURN_IF_ERROR(input_stream_->Reset());
-    TF_RETURN_IF_ERROR(input_stream_->SkipNBytes(desired_pos));
+    if (seek_) {
+      TF_RETURN_IF_ERROR(seek_(desired_pos));
+    } else {
+      TF_RETURN_IF_ERROR(input_stream_->Reset());
+      TF_RETURN_IF_ERROR(input_stream_->SkipNBytes(desired_pos));
+    }
   } else if (curr_pos < desired_pos) {
     TF_RETURN_IF_ERROR(input_stream_->SkipNBytes(desired_pos - curr_pos));
   }
@@ -186,7 +210,8 @@ Status RecordReader::ReadRecord(uint64* offset, tstring* record) {
   TF_RETURN_IF_ERROR(PositionInputStream(*offset));
 
   // Read header data.
-  Status s = ReadChecksummed(*offset, sizeof(uint64), record);
+  Status s =
+      ReadChecksummed(*offset, sizeof(uint64), /*is_header=*/true, record);
   if (!s.ok()) {
     last_read_failed_ = true;
     return s;
@@ -194,7 +219,8 @@ Status RecordReader::ReadRecord(uint64* offset, tstring* record) {
   const uint64 length = core::DecodeFixed64(record->data());
 
   // Read data
-  s = ReadChecksummed(*offset + kHeaderSize, length, record);
+  s = ReadChecksummed(*offset + kHeaderSize, length, /*is_header=*/false,
+                      record);
   if (!s.ok()) {
     last_read_failed_ = true;
     if (errors::IsOutOfRange(s)) {
@@ -209,6 +235,19 @@ Status RecordReader::ReadRecord(uint64* offset, tstring* record) {
   return Status::OK();
 }
 
+Status RecordReader::ReadRecords(uint64* offset, int max_records,
+                                 int64 max_bytes,
+                                 std::vector<tstring>* records) {
+  int64 bytes_read = 0;
+  for (int i = 0; i < max_records && bytes_read < max_bytes; ++i) {
+    tstring record;
+    TF_RETURN_IF_ERROR(ReadRecord(offset, &record));
+    bytes_read += record.size();
+    records->push_back(std::move(record));
+  }
+  return Status::OK();
+}
+
 Status RecordReader::SkipRecords(uint64* offset, int num_to_skip,
                                  int* num_skipped) {
   TF_RETURN_IF_ERROR(PositionInputStream(*offset));
@@ -217,7 +256,7 @@ Status RecordReader::SkipRecords(uint64* offset, int num_to_skip,
   tstring record;
   *num_skipped = 0;
   for (int i = 0; i < num_to_skip; ++i) {
-    s = ReadChecksummed(*offset, sizeof(uint64), &record);
+    s = ReadChecksummed(*offset, sizeof(uint64), /*is_header=*/true, &record);
     if (!s.ok()) {
       last_read_failed_ = true;
       return s;
@@ -242,8 +281,62 @@ Status RecordReader::SkipRecords(uint64* offset, int num_to_skip,
 }
 
 SequentialRecordReader::SequentialRecordReader(
-    RandomAccessFile* file, const RecordReaderOptions& options)
-    : underlying_(file, options), offset_(0) {}
+    RandomAccessFile* file, const RecordReaderOptions& options, Env* env)
+    : underlying_(file, options, env), offset_(0) {}
+
+MemmappedRecordReader::MemmappedRecordReader(ReadOnlyMemoryRegion* region,
+                                             bool verify_checksums)
+    : data_(static_cast<const char*>(region->data())),
+      size_(region->length()),
+      verify_checksums_(verify_checksums) {}
+
+Status MemmappedRecordReader::ReadHeader(uint64 offset, uint64* length) const {
+  if (offset >= size_) {
+    return errors::OutOfRange("eof");
+  }
+  if (size_ - offset < RecordReader::kHeaderSize) {
+    return errors::DataLoss("truncated record at ", offset);
+  }
+  const char* header = data_ + offset;
+  const uint32 masked_crc = core::DecodeFixed32(header + sizeof(uint64));
+  if (crc32c::Unmask(masked_crc) != crc32c::Value(header, sizeof(uint64))) {
+    return errors::DataLoss("corrupted record at ", offset);
+  }
+  *length = core::DecodeFixed64(header);
+  const uint64 remaining = size_ - offset - RecordReader::kHeaderSize;
+  if (remaining < RecordReader::kFooterSize ||
+      *length > remaining - RecordReader::kFooterSize) {
+    return errors::DataLoss("truncated record at ", offset);
+  }
+  return Status::OK();
+}
+
+Status MemmappedRecordReader::ReadRecord(uint64* offset, tstring* record) {
+  uint64 length;
+  TF_RETURN_IF_ERROR(ReadHeader(*offset, &length));
+  const char* payload = data_ + *offset + RecordReader::kHeaderSize;
+  if (verify_checksums_) {
+    const uint32 masked_crc = core::DecodeFixed32(payload + length);
+    if (crc32c::Unmask(masked_crc) != crc32c::Value(payload, length)) {
+      return errors::DataLoss("corrupted record at ", *offset);
+    }
+  }
+  record->assign(payload, length);
+  *offset += RecordReader::kHeaderSize + length + RecordReader::kFooterSize;
+  return Status::OK();
+}
+
+Status MemmappedRecordReader::SkipRecords(uint64* offset, int num_to_skip,
+                                          int* num_skipped) {
+  *num_skipped = 0;
+  for (int i = 0; i < num_to_skip; ++i) {
+    uint64 length;
+    TF_RETURN_IF_ERROR(ReadHeader(*offset, &length));
+    *offset += RecordReader::kHeaderSize + length + RecordReader::kFooterSize;
+    (*num_skipped)++;
+  }
+  return Status::OK();
+}
 
 }  // namespace io
 }  // namespace tensorflow
@@ -16,6 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_LIB_IO_RECORD_READER_H_
 #define TENSORFLOW_CORE_LIB_IO_RECORD_READER_H_
 
+#include <functional>
+#include <vector>
+
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/io/inputstream_interface.h"
@@ -25,12 +28,14 @@ limitations under the License.
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
 #endif  // IS_SLIM_BUILD
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
 
 class RandomAccessFile;
+class ReadOnlyMemoryRegion;
 
 namespace io {
 
@@ -47,6 +52,16 @@ struct RecordReaderOptions {
   // compressed files.) Consider using SequentialRecordReader.
   int64 buffer_size = 0;
 
+  // If non-zero and buffer_size is non-zero, the file is read ahead on a
+  // background thread in chunks of buffer_size bytes, keeping up to this many
+  // chunks in memory. See ReadaheadInputStream.
+  int readahead_buffers = 0;
+
+  // If false, the checksum of each record's payload is not verified. The
+  // checksum of the record header, which carries the payload length, is always
+  // verified so that a corrupted length is never trusted.
+  bool verify_checksums = true;
+
   static RecordReaderOptions CreateRecordReaderOptions(
       const string& compression_type);
 
@@ -85,10 +100,12 @@ class RecordReader {
   };
 
   // Create a reader that will return log records from "*file".
-  // "*file" must remain live while this Reader is in use.
+  // "*file" must remain live while this Reader is in use. "env" is used to
+  // start the readahead thread if "options.readahead_buffers" is set.
   explicit RecordReader(
       RandomAccessFile* file,
-      const RecordReaderOptions& options = RecordReaderOptions());
+      const RecordReaderOptions& options = RecordReaderOptions(),
+      Env* env = Env::Default());
 
   virtual ~RecordReader() = default;
 
@@ -97,6 +114,15 @@ class RecordReader {
   // OUT_OF_RANGE for end of file, or something else for an error.
   Status ReadRecord(uint64* offset, tstring* record);
 
+  // Read up to "max_records" records starting at "*offset", appending them to
+  // *records and updating *offset to point to the offset of the next record.
+  // Stops early once the records read by this call hold at least "max_bytes"
+  // bytes. Returns OK if the batch was ended by either limit, and otherwise the
+  // status of the read that ended it (OUT_OF_RANGE for end of file). Records
+  // read before a failure are appended to *records in either case.
+  Status ReadRecords(uint64* offset, int max_records, int64 max_bytes,
+                     std::vector<tstring>* records);
+
   // Skip num_to_skip record starting at "*offset" and update *offset
   // to point to the offset of the next num_to_skip + 1 record.
   // Return OK on success, OUT_OF_RANGE for end of file, or something
@@ -116,11 +142,16 @@ class RecordReader {
   Status GetMetadata(Metadata* md);
 
  private:
-  Status ReadChecksummed(uint64 offset, size_t n, tstring* result);
+  Status ReadChecksummed(uint64 offset, size_t n, bool is_header,
+                         tstring* result);
   Status PositionInputStream(uint64 offset);
 
   RecordReaderOptions options_;
   std::unique_ptr<InputStreamInterface> input_stream_;
+  // Seeks `input_stream_` to a file offset. Only set for uncompressed
+  // streams, whose positions are file offsets; compressed streams are
+  // rewound and skipped forward instead.
+  std::function<Status(int64)> seek_;
   bool last_read_failed_;
 
   std::unique_ptr<Metadata> cached_metadata_;
@@ -137,7 +168,8 @@ class SequentialRecordReader {
   // "*file" must remain live while this Reader is in use.
   explicit SequentialRecordReader(
       RandomAccessFile* file,
-      const RecordReaderOptions& options = RecordReaderOptions());
+      const RecordReaderOptions& options = RecordReaderOptions(),
+      Env* env = Env::Default());
 
   virtual ~SequentialRecordReader() = default;
 
@@ -147,6 +179,13 @@ class SequentialRecordReader {
     return underlying_.ReadRecord(&offset_, record);
   }
 
+  // Read up to "max_records" of the next records in the file into *records.
+  // See RecordReader::ReadRecords.
+  Status ReadRecords(int max_records, int64 max_bytes,
+                     std::vector<tstring>* records) {
+    return underlying_.ReadRecords(&offset_, max_records, max_bytes, records);
+  }
+
   // Skip the next num_to_skip record in the file. Return OK on success,
   // OUT_OF_RANGE for end of file, or something else for an error.
   // "*num_skipped" records the number of records that are actually skipped.
@@ -174,6 +213,44 @@ class SequentialRecordReader {
   uint64 offset_ = 0;
 };
 
+// Interface to read uncompressed TFRecord files that have been mapped into
+// memory, e.g. through `Env::NewReadOnlyMemoryRegionFromFile`.
+//
+// Unlike `RecordReader`, no read calls or intermediate buffering are involved:
+// records are copied exactly once, from the mapped region into the caller's
+// string.
+//
+// Note: this class is not thread safe; external synchronization required.
+class MemmappedRecordReader {
+ public:
+  // Create a reader that will return records from "*region".
+  // "*region" must remain live while this reader is in use.
+  explicit MemmappedRecordReader(ReadOnlyMemoryRegion* region,
+                                 bool verify_checksums = true);
+
+  // Read the record at "*offset" into *record and update *offset to point to
+  // the offset of the next record. Returns OK on success, OUT_OF_RANGE for end
+  // of file, or something else for an error.
+  Status ReadRecord(uint64* offset, tstring* record);
+
+  // Skip num_to_skip records starting at "*offset" and update *offset to point
+  // to the offset of the next record. Return OK on success, OUT_OF_RANGE for
+  // end of file, or something else for an error. "*num_skipped" records the
+  // number of records that are actually skipped.
+  Status SkipRecords(uint64* offset, int num_to_skip, int* num_skipped);
+
+ private:
+  // Validates the record framing at `offset` and sets `*length` to the length
+  // of its payload, which starts at `offset + RecordReader::kHeaderSize`.
+  Status ReadHeader(uint64 offset, uint64* length) const;
+
+  const char* const data_;
+  const uint64 size_;
+  const bool verify_checksums_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemmappedRecordReader);
+};
+
 }  // namespace io
 }  // namespace tensorflow
 
@@ -229,6 +229,93 @@ TEST(RecordReaderWriterTest, TestSkipOutOfRange) {
   }
 }
 
+TEST(RecordReaderWriterTest, TestReadRecords) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_read_records_test";
+
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+
+    io::RecordWriter writer(file.get());
+    TF_EXPECT_OK(writer.WriteRecord("abc"));
+    TF_EXPECT_OK(writer.WriteRecord("defg"));
+    TF_EXPECT_OK(writer.WriteRecord("hij"));
+    TF_EXPECT_OK(writer.WriteRecord("klmno"));
+    TF_CHECK_OK(writer.Flush());
+  }
+
+  for (int readahead_buffers : {0, 1, 3}) {
+    for (auto buf_size : BufferSizes()) {
+      std::unique_ptr<RandomAccessFile> read_file;
+      TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+      io::RecordReaderOptions options;
+      options.buffer_size = buf_size;
+      options.readahead_buffers = readahead_buffers;
+      io::SequentialRecordReader reader(read_file.get(), options);
+      std::vector<tstring> records;
+      // Limited by the number of records.
+      TF_CHECK_OK(reader.ReadRecords(1, 100, &records));
+      ASSERT_EQ(1, records.size());
+      EXPECT_EQ("abc", records[0]);
+      // Limited by the number of bytes.
+      TF_CHECK_OK(reader.ReadRecords(10, 5, &records));
+      ASSERT_EQ(3, records.size());
+      EXPECT_EQ("defg", records[1]);
+      EXPECT_EQ("hij", records[2]);
+      // Limited by the end of the file.
+      Status s = reader.ReadRecords(10, 100, &records);
+      EXPECT_EQ(error::OUT_OF_RANGE, s.code());
+      ASSERT_EQ(4, records.size());
+      EXPECT_EQ("klmno", records[3]);
+      EXPECT_EQ(GetFileSize(fname), reader.TellOffset());
+    }
+  }
+}
+
+TEST(RecordReaderWriterTest, TestReadBackwards) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_backwards_test";
+
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+
+    io::RecordWriter writer(file.get());
+    TF_EXPECT_OK(writer.WriteRecord("abc"));
+    TF_EXPECT_OK(writer.WriteRecord("defg"));
+    TF_EXPECT_OK(writer.WriteRecord("hij"));
+    TF_CHECK_OK(writer.Flush());
+  }
+
+  for (int readahead_buffers : {0, 2}) {
+    for (auto buf_size : BufferSizes()) {
+      std::unique_ptr<RandomAccessFile> read_file;
+      TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+      io::RecordReaderOptions options;
+      options.buffer_size = buf_size;
+      options.readahead_buffers = readahead_buffers;
+      io::RecordReader reader(read_file.get(), options, env);
+      uint64 offset = 0;
+      tstring record;
+      TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+      const uint64 second_offset = offset;
+      TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+      TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+      EXPECT_EQ("hij", record);
+      // Seeks back to the second record.
+      offset = second_offset;
+      TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+      EXPECT_EQ("defg", record);
+      // Seeks back to the first record.
+      offset = 0;
+      TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+      EXPECT_EQ("abc", record);
+      EXPECT_EQ(second_offset, offset);
+    }
+  }
+}
+
 TEST(RecordReaderWriterTest, TestSnappy) {
   Env* env = Env::Default();
   string fname = testing::TmpDir() + "/record_reader_writer_snappy_test";
@@ -305,6 +392,124 @@ TEST(RecordReaderWriterTest, TestZlib) {
   }
 }
 
+TEST(RecordReaderWriterTest, TestMemmapped) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_memmapped_test";
+
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+
+    io::RecordWriter writer(file.get());
+    TF_EXPECT_OK(writer.WriteRecord("abc"));
+    TF_EXPECT_OK(writer.WriteRecord(""));
+    TF_EXPECT_OK(writer.WriteRecord("defg"));
+    TF_EXPECT_OK(writer.WriteRecord("hij"));
+    TF_CHECK_OK(writer.Flush());
+  }
+
+  {
+    std::unique_ptr<ReadOnlyMemoryRegion> region;
+    TF_CHECK_OK(env->NewReadOnlyMemoryRegionFromFile(fname, &region));
+    io::MemmappedRecordReader reader(region.get());
+    uint64 offset = 0;
+    tstring record;
+    TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+    EXPECT_EQ("abc", record);
+    TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+    EXPECT_EQ("", record);
+    int num_skipped;
+    TF_CHECK_OK(reader.SkipRecords(&offset, 1, &num_skipped));
+    EXPECT_EQ(1, num_skipped);
+    TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+    EXPECT_EQ("hij", record);
+    EXPECT_EQ(region->length(), offset);
+    EXPECT_EQ(error::OUT_OF_RANGE, reader.ReadRecord(&offset, &record).code());
+  }
+}
+
+TEST(RecordReaderWriterTest, TestMemmappedCorruption) {
+  Env* env = Env::Default();
+  string fname =
+      testing::TmpDir() + "/record_reader_writer_memmapped_corruption_test";
+
+  string contents;
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get());
+    TF_EXPECT_OK(writer.WriteRecord("abc"));
+    TF_CHECK_OK(writer.Close());
+  }
+  TF_CHECK_OK(ReadFileToString(env, fname, &contents));
+  // Flip a payload byte so that only the payload checksum is violated.
+  contents[io::RecordReader::kHeaderSize] ^= 0x3;
+  TF_CHECK_OK(WriteStringToFile(env, fname, contents));
+
+  std::unique_ptr<ReadOnlyMemoryRegion> region;
+  TF_CHECK_OK(env->NewReadOnlyMemoryRegionFromFile(fname, &region));
+  {
+    io::MemmappedRecordReader reader(region.get());
+    uint64 offset = 0;
+    tstring record;
+    EXPECT_EQ(error::DATA_LOSS, reader.ReadRecord(&offset, &record).code());
+  }
+  {
+    io::MemmappedRecordReader reader(region.get(), /*verify_checksums=*/false);
+    uint64 offset = 0;
+    tstring record;
+    TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+    EXPECT_EQ("bbc", record);
+  }
+
+  // Truncate the footer of the record.
+  contents.resize(contents.size() - 1);
+  TF_CHECK_OK(WriteStringToFile(env, fname, contents));
+  TF_CHECK_OK(env->NewReadOnlyMemoryRegionFromFile(fname, &region));
+  {
+    io::MemmappedRecordReader reader(region.get(), /*verify_checksums=*/false);
+    uint64 offset = 0;
+    tstring record;
+    EXPECT_EQ(error::DATA_LOSS, reader.ReadRecord(&offset, &record).code());
+  }
+}
+
+TEST(RecordReaderWriterTest, TestSkipPayloadChecksum) {
+  Env* env = Env::Default();
+  string fname =
+      testing::TmpDir() + "/record_reader_writer_skip_payload_checksum_test";
+
+  string contents;
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get());
+    // A payload with the same size as a header.
+    TF_EXPECT_OK(writer.WriteRecord("abcdefgh"));
+    TF_CHECK_OK(writer.Close());
+  }
+  TF_CHECK_OK(ReadFileToString(env, fname, &contents));
+  contents[io::RecordReader::kHeaderSize] ^= 0x3;
+  TF_CHECK_OK(WriteStringToFile(env, fname, contents));
+
+  std::unique_ptr<RandomAccessFile> read_file;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+  for (bool verify_checksums : {false, true}) {
+    io::RecordReaderOptions options;
+    options.verify_checksums = verify_checksums;
+    io::RecordReader reader(read_file.get(), options);
+    uint64 offset = 0;
+    tstring record;
+    Status s = reader.ReadRecord(&offset, &record);
+    if (verify_checksums) {
+      EXPECT_EQ(error::DATA_LOSS, s.code());
+    } else {
+      TF_EXPECT_OK(s);
+      EXPECT_EQ("bbcdefgh", record);
+    }
+  }
+}
+
 TEST(RecordReaderWriterTest, TestUseAfterClose) {
   Env* env = Env::Default();
   string fname = testing::TmpDir() + "/record_reader_writer_flush_close_test";
@@ -515,6 +515,7 @@ REGISTER_OP("ShuffleDatasetV3")
     .Attr("reshuffle_each_iteration: bool = true")
     .Attr("output_types: list(type) >= 1")
     .Attr("output_shapes: list(shape) >= 1")
+    .Attr("max_buffer_bytes: int = 0")
     .SetShapeFn([](shape_inference::InferenceContext* c) {
       shape_inference::ShapeHandle unused;
       // buffer_size, seed, seed2, and seed_generator should be scalars.
@@ -685,6 +686,9 @@ REGISTER_OP("TFRecordDataset")
     .Input("compression_type: string")
     .Input("buffer_size: int64")
     .Output("handle: variant")
+    .Attr("use_memory_map: bool = false")
+    .Attr("verify_checksums: bool = true")
+    .Attr("readahead_buffers: int = 0")
     .SetDoNotOptimize()  // TODO(b/123753214): Source dataset ops must
                          // disable constant folding.
     .SetShapeFn([](shape_inference::InferenceContext* c) {
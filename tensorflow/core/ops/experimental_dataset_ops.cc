@@ -207,6 +207,7 @@ REGISTER_OP("CSVDatasetV2")
     .Output("handle: variant")
     .Attr("output_types: list({float,double,int32,int64,string}) >= 1")
     .Attr("output_shapes: list(shape) >= 1")
+    .Attr("batch_size: int >= 0 = 0")
     .SetDoNotOptimize()  // TODO(b/123753214): Source dataset ops must
                          // disable constant folding.
     .SetShapeFn([](shape_inference::InferenceContext* c) {
@@ -433,6 +434,35 @@ REGISTER_OP("ExperimentalGroupByWindowDataset")
     .Attr("output_shapes: list(shape) >= 1")
     .SetShapeFn(shape_inference::ScalarShape);
 
+REGISTER_OP("BucketBySequenceLengthDataset")
+    .Input("input_dataset: variant")
+    .Input(
+        "element_length_func_other_arguments: "
+        "Telement_length_func_other_arguments")
+    .Input("bucket_boundaries: int64")
+    .Input("bucket_batch_sizes: int64")
+    .Input("padded_shapes: N * int64")
+    .Input("padding_values: Toutput_types")
+    .Input("drop_remainder: bool")
+    .Input("num_parallel_calls: int64")
+    .Output("handle: variant")
+    .Attr("element_length_func: func")
+    .Attr("Telement_length_func_other_arguments: list(type) >= 0")
+    .Attr("pad_to_bucket_boundary: bool = false")
+    .Attr("Toutput_types: list(type) >= 1")
+    .Attr("output_shapes: list(shape) >= 1")
+    .Attr("N: int >= 1")
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      shape_inference::ShapeHandle unused;
+      // drop_remainder should be a scalar.
+      TF_RETURN_IF_ERROR(
+          c->WithRank(c->input(c->num_inputs() - 2), 0, &unused));
+      // num_parallel_calls should be a scalar.
+      TF_RETURN_IF_ERROR(
+          c->WithRank(c->input(c->num_inputs() - 1), 0, &unused));
+      return shape_inference::ScalarShape(c);
+    });
+
 REGISTER_OP("IgnoreErrorsDataset")
     .Input("input_dataset: variant")
     .Output("handle: variant")
@@ -745,6 +775,13 @@ REGISTER_OP("ExperimentalPrivateThreadPoolDataset")
     .Attr("output_shapes: list(shape) >= 1")
     .SetShapeFn(shape_inference::ScalarShape);
 
+REGISTER_OP("NumaAwareDataset")
+    .Input("input_dataset: variant")
+    .Output("handle: variant")
+    .Attr("output_types: list(type) >= 1")
+    .Attr("output_shapes: list(shape) >= 1")
+    .SetShapeFn(shape_inference::ScalarShape);
+
 REGISTER_OP("ExperimentalRandomDataset")
     .Input("seed: int64")
     .Input("seed2: int64")
@@ -193,6 +193,13 @@ int NUMANumNodes() {
 void NUMASetThreadNodeAffinity(int node) {
 #ifdef TENSORFLOW_USE_NUMA
   if (HaveHWLocTopology()) {
+    if (node == kNUMANoAffinity) {
+      // Allow the thread to run on any CPU of the machine.
+      hwloc_set_cpubind(hwloc_topology_handle,
+                        hwloc_get_root_obj(hwloc_topology_handle)->cpuset,
+                        HWLOC_CPUBIND_THREAD);
+      return;
+    }
     // Find the corresponding NUMA node topology object.
     hwloc_obj_t obj = GetHWLocTypeIndex(HWLOC_OBJ_NUMANODE, node);
     if (obj) {
@@ -228,6 +235,38 @@ int NUMAGetThreadNodeAffinity() {
   return node_index;
 }
 
+std::vector<int> NUMAGetThreadCpuAffinity() {
+  std::vector<int> cpus;
+#ifdef TENSORFLOW_USE_NUMA
+  if (HaveHWLocTopology()) {
+    hwloc_cpuset_t thread_cpuset = hwloc_bitmap_alloc();
+    if (hwloc_get_cpubind(hwloc_topology_handle, thread_cpuset,
+                          HWLOC_CPUBIND_THREAD) == 0) {
+      for (int cpu = hwloc_bitmap_first(thread_cpuset); cpu != -1;
+           cpu = hwloc_bitmap_next(thread_cpuset, cpu)) {
+        cpus.push_back(cpu);
+      }
+    }
+    hwloc_bitmap_free(thread_cpuset);
+  }
+#endif  // TENSORFLOW_USE_NUMA
+  return cpus;
+}
+
+void NUMASetThreadCpuAffinity(const std::vector<int>& cpus) {
+#ifdef TENSORFLOW_USE_NUMA
+  if (HaveHWLocTopology() && !cpus.empty()) {
+    hwloc_cpuset_t thread_cpuset = hwloc_bitmap_alloc();
+    for (int cpu : cpus) {
+      hwloc_bitmap_set(thread_cpuset, cpu);
+    }
+    hwloc_set_cpubind(hwloc_topology_handle, thread_cpuset,
+                      HWLOC_CPUBIND_THREAD);
+    hwloc_bitmap_free(thread_cpuset);
+  }
+#endif  // TENSORFLOW_USE_NUMA
+}
+
 void* AlignedMalloc(size_t size, int minimum_alignment) {
 #if defined(__ANDROID__)
   return memalign(minimum_alignment, size);
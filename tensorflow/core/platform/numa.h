@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_PLATFORM_NUMA_H_
 #define TENSORFLOW_CORE_PLATFORM_NUMA_H_
 
+#include <vector>
+
 #include "tensorflow/core/platform/platform.h"
 #include "tensorflow/core/platform/types.h"
 
@@ -39,6 +41,14 @@ void NUMASetThreadNodeAffinity(int node);
 // Returns NUMA node affinity of the current thread, kNUMANoAffinity if none.
 int NUMAGetThreadNodeAffinity();
 
+// Returns the ids of the CPUs the current thread may run on, or an empty
+// vector if thread affinities are not supported.
+std::vector<int> NUMAGetThreadCpuAffinity();
+
+// If possible restricts the current thread to the CPUs in `cpus`, as returned
+// by NUMAGetThreadCpuAffinity(). Does nothing if `cpus` is empty.
+void NUMASetThreadCpuAffinity(const std::vector<int>& cpus);
+
 // Like AlignedMalloc, but allocates memory with affinity to the specified NUMA
 // node.
 //
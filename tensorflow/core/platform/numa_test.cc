@@ -57,5 +57,15 @@ TEST(Numa, SetNodeAffinity) {
   }
 }
 
+TEST(Numa, RestoreCpuAffinity) {
+  const std::vector<int> cpus = port::NUMAGetThreadCpuAffinity();
+  if (port::NUMAEnabled()) {
+    EXPECT_FALSE(cpus.empty());
+    port::NUMASetThreadNodeAffinity(0);
+    port::NUMASetThreadCpuAffinity(cpus);
+    EXPECT_EQ(port::NUMAGetThreadCpuAffinity(), cpus);
+  }
+}
+
 }  // namespace internal
 }  // namespace tensorflow
@@ -110,6 +110,10 @@ void NUMASetThreadNodeAffinity(int node) {}
 
 int NUMAGetThreadNodeAffinity() { return kNUMANoAffinity; }
 
+std::vector<int> NUMAGetThreadCpuAffinity() { return {}; }
+
+void NUMASetThreadCpuAffinity(const std::vector<int>& cpus) {}
+
 void* AlignedMalloc(size_t size, int minimum_alignment) {
   return _aligned_malloc(size, minimum_alignment);
 }
@@ -113,6 +113,45 @@ constexpr uint8 kVarintTag(uint32 tag) { return (tag << 3) | 0; }
 constexpr uint8 kDelimitedTag(uint32 tag) { return (tag << 3) | 2; }
 constexpr uint8 kFixed32Tag(uint32 tag) { return (tag << 3) | 5; }
 
+// Returns the number of varints in the packed encoding [begin, end), i.e. the
+// number of bytes that do not have the continuation bit set. The loop is kept
+// trivial so that the compiler can vectorize it.
+inline size_t CountPackedVarints(const uint8* begin, const uint8* end) {
+  size_t count = 0;
+  for (const uint8* p = begin; p < end; ++p) {
+    count += (*p < 0x80);
+  }
+  return count;
+}
+
+// Decodes the packed varints in [begin, end), storing the first `max_values`
+// of them in `values`. Returns false if the encoding is malformed.
+inline bool DecodePackedVarints(const uint8* begin, const uint8* end,
+                                int64* values, size_t max_values) {
+  size_t index = 0;
+  const uint8* p = begin;
+  while (p < end) {
+    uint64 value;
+    if (*p < 0x80) {
+      // Single byte varints are by far the most common case for ids and small
+      // counts, so they get their own branch.
+      value = *p++;
+    } else {
+      value = 0;
+      for (int shift = 0;; shift += 7) {
+        // A 64-bit varint is at most 10 bytes long.
+        if (p == end || shift > 63) return false;
+        const uint8 byte = *p++;
+        value |= static_cast<uint64>(byte & 0x7f) << shift;
+        if (byte < 0x80) break;
+      }
+    }
+    if (index < max_values) values[index] = static_cast<int64>(value);
+    ++index;
+  }
+  return true;
+}
+
 namespace parsed {
 
 // ParseDataType has to be called first, then appropriate ParseZzzzList.
@@ -301,10 +340,28 @@ class Feature {
         if (!stream.ReadVarint32(&packed_length)) return false;
         auto packed_limit = stream.PushLimit(packed_length);
 
-        while (!stream.ExpectAtEnd()) {
-          protobuf_uint64 n;  // There is no API for int64
-          if (!stream.ReadVarint64(&n)) return false;
-          int64_list->push_back(static_cast<int64>(n));
+        if (packed_length > 0) {
+          // Size the output once from the number of terminating bytes and
+          // decode straight from the underlying buffer, instead of growing
+          // the output one value at a time.
+          const void* packed_data;
+          int available;
+          if (!stream.GetDirectBufferPointer(&packed_data, &available) ||
+              static_cast<uint32>(available) < packed_length) {
+            return false;
+          }
+          const uint8* begin = static_cast<const uint8*>(packed_data);
+          const uint8* end = begin + packed_length;
+          const size_t initial_size = int64_list->size();
+          int64_list->resize(initial_size + CountPackedVarints(begin, end));
+          // The available size can be less than what we requested in resize
+          // in case of a LimitedArraySlice.
+          if (!DecodePackedVarints(begin, end,
+                                   int64_list->data() + initial_size,
+                                   int64_list->size() - initial_size)) {
+            return false;
+          }
+          if (!stream.Skip(packed_length)) return false;
         }
 
         stream.PopLimit(packed_limit);
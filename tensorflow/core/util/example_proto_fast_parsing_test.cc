@@ -249,6 +249,27 @@ static string ExampleWithSomeFeatures() {
 
 TEST(FastParse, SomeFeatures) { TestCorrectness(ExampleWithSomeFeatures()); }
 
+TEST(FastParse, PackedInt64Varints) {
+  Example example;
+  Int64List* int64_list =
+      (*example.mutable_features()->mutable_feature())["int64_list"]
+          .mutable_int64_list();
+  // Covers single byte, multi-byte and 10 byte (negative) encodings.
+  for (int64 value : {int64{0}, int64{1}, int64{127}, int64{128}, int64{300},
+                      int64{1} << 35, kint64max, int64{-1}, kint64min}) {
+    int64_list->add_value(value);
+  }
+  TestCorrectness(Serialize(example));
+}
+
+TEST(FastParse, PackedInt64TruncatedVarint) {
+  // A packed int64_list whose only value has its continuation bit set.
+  Example example;
+  EXPECT_FALSE(TestFastParse(
+      "\x0a\x0e\x0a\x0c\x0a\x03\x61\x67\x65\x12\x05\x1a\x03\x0a\x01\x8d",
+      &example));
+}
+
 static void AddDenseFeature(const char* feature_name, DataType dtype,
                             PartialTensorShape shape, bool variable_length,
                             size_t elements_per_stride,
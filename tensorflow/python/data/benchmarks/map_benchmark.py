@@ -208,6 +208,26 @@ class MapBenchmark(benchmark_base.DatasetBenchmarkBase):
       for num_parallel_calls in nums_parallel_calls:
         self._benchmark_nested_parallel_map(cycle_length, num_parallel_calls)
 
+  def benchmark_parallel_map_num_parallel_calls(self):
+    nums_parallel_calls = [1, 2, 4, 8, 16, 32, 64, 128]
+    for deterministic in [True, False]:
+      for num_parallel_calls in nums_parallel_calls:
+        dataset = dataset_ops.Dataset.range(10000).repeat()
+        dataset = dataset.map(
+            lambda x: x + 1, num_parallel_calls=num_parallel_calls)
+        options = dataset_ops.Options()
+        options.experimental_deterministic = deterministic
+        dataset = dataset.with_options(options)
+        self.run_and_report_benchmark(
+            dataset,
+            num_elements=100000,
+            extras={
+                "model_name": "map.benchmark.11",
+                "parameters": "%d_%s" % (num_parallel_calls, deterministic),
+            },
+            name="parallel_calls_%d_deterministic_%s" %
+            (num_parallel_calls, deterministic))
+
 
 if __name__ == "__main__":
   benchmark_base.test.main()
@@ -21,6 +21,7 @@ import random
 
 from absl.testing import parameterized
 
+from tensorflow.python.data.experimental.ops import error_ops
 from tensorflow.python.data.experimental.ops import grouping
 from tensorflow.python.data.kernel_tests import test_base
 from tensorflow.python.data.ops import dataset_ops
@@ -31,6 +32,7 @@ from tensorflow.python.framework import errors
 from tensorflow.python.framework import sparse_tensor
 from tensorflow.python.framework import tensor_shape
 from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import math_ops
 from tensorflow.python.platform import test
 
 
@@ -483,6 +485,52 @@ class BucketBySequenceLengthTest(test_base.DatasetTestBase,
                 pad_to_bucket_boundary=True))
     self.assertEqual(self.evaluate(dataset.cardinality()), dataset_ops.INFINITE)
 
+  @combinations.generate(
+      combinations.times(
+          test_base.default_test_combinations(),
+          combinations.combine(param_drop_remainder=[True, False])))
+  def testOutputOrder(self, param_drop_remainder):
+    # Full batches are produced in the order in which their buckets fill up,
+    # followed by the partial batches in bucket order.
+    elements = [[0], [1, 2, 3, 4], [5, 6, 7], [7, 8, 9, 10, 11],
+                [13, 14, 15, 16, 19, 20], [21, 22], [23, 24, 25, 26, 27]]
+    dataset = dataset_ops.Dataset.from_generator(
+        lambda: elements, dtypes.int64, output_shapes=[None]).apply(
+            grouping.bucket_by_sequence_length(
+                element_length_func=lambda x: array_ops.shape(x)[0],
+                bucket_boundaries=[3, 5],
+                bucket_batch_sizes=[2, 2, 2],
+                drop_remainder=param_drop_remainder))
+    expected_output = [
+        [[1, 2, 3, 4], [5, 6, 7, 0]],
+        [[7, 8, 9, 10, 11, 0], [13, 14, 15, 16, 19, 20]],
+        [[0, 0], [21, 22]],
+    ]
+    if not param_drop_remainder:
+      expected_output.append([[23, 24, 25, 26, 27]])
+    self.assertDatasetProduces(dataset, expected_output=expected_output)
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testElementLengthFuncError(self):
+
+    def element_length_func(x):
+      # Fails for the element 2.
+      check = array_ops.check_numerics(
+          1.0 / math_ops.cast(x[0] - 2, dtypes.float32), "element 2")
+      return array_ops.shape(x)[0] + math_ops.cast(check * 0, dtypes.int32)
+
+    dataset = dataset_ops.Dataset.range(8).map(
+        lambda x: array_ops.expand_dims(x, 0)).apply(
+            grouping.bucket_by_sequence_length(
+                element_length_func=element_length_func,
+                bucket_boundaries=[10],
+                bucket_batch_sizes=[2, 2]))
+    # Only the failed element is skipped, even if the lengths of the elements
+    # after it were computed together with it.
+    dataset = dataset.apply(error_ops.ignore_errors())
+    self.assertDatasetProduces(
+        dataset, expected_output=[[[0], [1]], [[3], [4]], [[5], [6]], [[7]]])
+
 
 if __name__ == "__main__":
   test.main()
@@ -238,6 +238,25 @@ class CsvDatasetTest(test_base.DatasetTestBase, parameterized.TestCase):
     inputs = [['1,2,3,4', '5,6,7,8'], ['5,6,7,8']]
     self._test_by_comparison(inputs, record_defaults=record_defaults)
 
+  @combinations.generate(
+      combinations.times(test_base.default_test_combinations(),
+                         combinations.combine(batch_size=[1, 2, 5])))
+  def testCsvDataset_withBatchSize(self, batch_size):
+    record_defaults = [[0], [0.0], ['']]
+    inputs = [['1,2.5,a', '3,,"b,c"', '5,6.5,'], ['7,8.5,"d""e"']]
+    filenames = self._setup_files(inputs)
+    dataset = readers.CsvDataset(
+        filenames, record_defaults=record_defaults, batch_size=batch_size)
+    expected = readers.CsvDataset(
+        filenames, record_defaults=record_defaults).batch(batch_size)
+    self.assertEqual([None], dataset.element_spec[0].shape.as_list())
+    self.assertDatasetsEqual(dataset, expected)
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testCsvDataset_withInvalidBatchSize(self):
+    with self.assertRaisesRegex(ValueError, '`batch_size` must be positive'):
+      readers.CsvDataset(['unused.csv'], record_defaults=[[0]], batch_size=0)
+
   @combinations.generate(test_base.default_test_combinations())
   def testCsvDataset_withLeadingAndTrailingSpaces(self):
     record_defaults = [[0.0]] * 4
@@ -552,6 +571,26 @@ class CsvDatasetTest(test_base.DatasetTestBase, parameterized.TestCase):
     self._test_dataset_on_buffer_sizes(
         inputs, expected, linebreak='\r\n', record_defaults=record_defaults)
 
+  @combinations.generate(test_base.default_test_combinations())
+  def testCsvDataset_withLongFields(self):
+    # Fields longer than a vector register exercise the bulk scan for field
+    # ends, including when the field end falls just before or after a full
+    # register of input.
+    record_defaults = [['NA']] * 3
+    long_fields = ['a' * n for n in [15, 16, 17, 31, 32, 33, 64]]
+    inputs = [[
+        ','.join([field, field + 'b', '"%s""%s"' % (field, field)])
+        for field in long_fields
+    ]]
+    expected = [[field, field + 'b', '%s"%s' % (field, field)]
+                for field in long_fields]
+    self._test_dataset_on_buffer_sizes(
+        inputs,
+        expected,
+        linebreak='\r\n',
+        record_defaults=record_defaults,
+        num_sizes_to_test=40)
+
   @combinations.generate(test_base.default_test_combinations())
   def testCsvDataset_withGzipCompressionType(self):
     record_defaults = [['NA']] * 3
@@ -136,6 +136,28 @@ class DataServiceOpsTest(data_service_test_base.TestBase,
                                 range(num_elements_start, num_elements_end)):
       self.assertDatasetProduces(ds, list(range(num_elements)))
 
+  @combinations.generate(
+      combinations.times(
+          test_base.eager_only_combinations(),
+          combinations.combine(journal_snapshot_interval=[1, 3])))
+  def testDispatcherRestartWithSnapshots(self, journal_snapshot_interval):
+    cluster = data_service_test_base.TestCluster(
+        num_workers=1, journal_snapshot_interval=journal_snapshot_interval)
+    num_elements = 100
+    ds = self.make_distributed_range_dataset(
+        num_elements, cluster, processing_mode="distributed_epoch")
+    iterator = iter(ds)
+    results = []
+    for _ in range(num_elements // 2):
+      results.append(next(iterator).numpy())
+    cluster.restart_dispatcher()
+    for elem in iterator:
+      results.append(elem.numpy())
+    cluster.restart_dispatcher()
+
+    self.assertEqual(list(range(num_elements)), results)
+    self.assertEqual(cluster.num_registered_workers(), 1)
+
   @combinations.generate(test_base.eager_only_combinations())
   def testDispatcherAndWorkerRestart(self):
     cluster = data_service_test_base.TestCluster(num_workers=1)
@@ -76,6 +76,19 @@ class DataServiceOpsTest(data_service_test_base.TestBase,
     results = [elem.numpy() for elem in ds]
     self.assertEqual(list(range(num_elements)), results)
 
+  @combinations.generate(test_base.eager_only_combinations())
+  def testDistributeLocalDataTransfer(self):
+    cluster = data_service_test_base.TestCluster(num_workers=2)
+    num_elements = 10
+    ds = dataset_ops.Dataset.range(num_elements)
+    ds = ds.apply(
+        data_service_ops._distribute(  # pylint: disable=protected-access
+            processing_mode="parallel_epochs",
+            service=cluster.target,
+            data_transfer_protocol="local"))
+    self.assertDatasetProduces(
+        ds, list(range(num_elements)) * 2, assert_items_equal=True)
+
   @combinations.generate(test_base.default_test_combinations())
   def testDistributeInvalidCompression(self):
     cluster = data_service_test_base.TestCluster(num_workers=1)
@@ -209,6 +222,23 @@ class DataServiceOpsTest(data_service_test_base.TestBase,
     self.assertCountEqual(num_workers * list(range(num_elements)),
                           self.getDatasetOutput(ds))
 
+  @combinations.generate(
+      combinations.times(test_base.eager_only_combinations(),
+                         combinations.combine(compression=[None, "AUTO"])))
+  def testMultipleElementsPerRequest(self, compression):
+    # With few tasks and many outstanding requests, each request may fetch
+    # several elements from the same worker.
+    num_workers = 2
+    cluster = data_service_test_base.TestCluster(num_workers=num_workers)
+    num_elements = 100
+    ds = self.make_distributed_range_dataset(
+        num_elements,
+        cluster,
+        max_outstanding_requests=50,
+        compression=compression)
+    self.assertCountEqual(num_workers * list(range(num_elements)),
+                          self.getDatasetOutput(ds))
+
   @combinations.generate(test_base.eager_only_combinations())
   def testInsideFunction(self):
     num_workers = 3
@@ -111,6 +111,7 @@ class TestCluster(object):
                fault_tolerant_mode=True,
                job_gc_check_interval_ms=None,
                job_gc_timeout_ms=None,
+               journal_snapshot_interval=None,
                worker_shutdown_quiet_period_ms=0,
                start=True):
     """Creates a tf.data service test cluster.
@@ -128,6 +129,8 @@ class TestCluster(object):
         delete old and unused jobs, in milliseconds.
       job_gc_timeout_ms: How long a job needs to be unused before it becomes a
         candidate for garbage collection, in milliseconds.
+      journal_snapshot_interval: How many journal updates the dispatcher writes
+        before snapshotting its state and truncating the journal.
       worker_shutdown_quiet_period_ms: When shutting down a worker, how long to
         wait for the gRPC server to process the final requests.
       start: Whether to immediately start the servers in the cluster. If
@@ -143,7 +146,8 @@ class TestCluster(object):
             work_dir=work_dir,
             fault_tolerant_mode=fault_tolerant_mode,
             job_gc_check_interval_ms=job_gc_check_interval_ms,
-            job_gc_timeout_ms=job_gc_timeout_ms),
+            job_gc_timeout_ms=job_gc_timeout_ms,
+            journal_snapshot_interval=journal_snapshot_interval),
         start=start)
 
     self.workers = []
@@ -191,7 +195,9 @@ class TestCluster(object):
         server_lib.DispatcherConfig(
             port=port,
             work_dir=self.dispatcher._config.work_dir,
-            fault_tolerant_mode=self.dispatcher._config.fault_tolerant_mode))
+            fault_tolerant_mode=self.dispatcher._config.fault_tolerant_mode,
+            journal_snapshot_interval=(
+                self.dispatcher._config.journal_snapshot_interval)))
 
   def num_registered_workers(self):
     return self.dispatcher._num_workers()
@@ -45,6 +45,7 @@ from tensorflow.python.ops import nn
 from tensorflow.python.ops import parsing_ops
 from tensorflow.python.ops import script_ops
 from tensorflow.python.ops import special_math_ops
+from tensorflow.python.ops import string_ops
 from tensorflow.python.platform import test
 
 
@@ -188,6 +189,39 @@ def _binary_real_test_combinations():
   return _generate_test_combinations(cases)
 
 
+def _string_test_combinations():
+
+  def regex_full_match(x):
+    return string_ops.regex_full_match(x, constant_op.constant("[0-9]+"))
+
+  def regex_replace(x):
+    return string_ops.regex_replace(x, constant_op.constant("[0-9]"),
+                                    constant_op.constant("#"))
+
+  cases = [
+      ("DecodeBase64",
+       lambda x: string_ops.decode_base64(string_ops.encode_base64(x))),
+      ("EncodeBase64", string_ops.encode_base64),
+      ("RegexFullMatch", regex_full_match),
+      ("RegexReplace", regex_replace),
+      ("StaticRegexFullMatch",
+       lambda x: string_ops.regex_full_match(x, "[0-9]+")),
+      ("StaticRegexReplace",
+       lambda x: string_ops.regex_replace(x, "[0-9]", "#")),
+      ("StringLength", string_ops.string_length),
+      ("StringLower", string_ops.string_lower),
+      ("StringStrip", string_ops.string_strip),
+      ("StringToHashBucket",
+       lambda x: string_ops.string_to_hash_bucket(x, 10)),
+      ("StringToHashBucketFast",
+       lambda x: string_ops.string_to_hash_bucket_fast(x, 10)),
+      ("StringToHashBucketStrong",
+       lambda x: string_ops.string_to_hash_bucket_strong(x, 10, [1, 2])),
+      ("StringUpper", string_ops.string_upper),
+  ]
+  return _generate_test_combinations(cases)
+
+
 # TODO(rachelim): Consolidate tests with pfor when APIs are somewhat shared.
 class MapVectorizationTest(test_base.DatasetTestBase, parameterized.TestCase):
 
@@ -393,6 +427,28 @@ class MapVectorizationTest(test_base.DatasetTestBase, parameterized.TestCase):
     dataset_factory = lambda: dataset_ops.Dataset.from_tensors((x, y))
     self._testOptimization(map_fn, dataset_factory, num_parallel_calls)
 
+  @combinations.generate(
+      combinations.times(test_base.default_test_combinations(),
+                         _string_test_combinations(),
+                         combinations.combine(num_parallel_calls=[None, 12])))
+  def testStringOperations(self, map_fn, num_parallel_calls):
+    x = [[" Abc1 ", "23", "dEf"], ["456", " g7 ", "HIJ"]]
+    dataset_factory = lambda: dataset_ops.Dataset.from_tensor_slices(x)
+    self._testOptimization(map_fn, dataset_factory, num_parallel_calls)
+
+  @combinations.generate(
+      combinations.times(test_base.default_test_combinations(),
+                         combinations.combine(num_parallel_calls=[None, 12])))
+  def testStringConversions(self, num_parallel_calls):
+    x = np.random.randint(0, 100, (7, 3, 5))
+    dataset_factory = lambda: dataset_ops.Dataset.from_tensor_slices(x)
+
+    def map_fn(x):
+      return string_ops.string_to_number(
+          string_ops.as_string(x), out_type=dtypes.int64)
+
+    self._testOptimization(map_fn, dataset_factory, num_parallel_calls)
+
   @combinations.generate(
       combinations.times(test_base.default_test_combinations(),
                          combinations.combine(num_parallel_calls=[None, 12])))
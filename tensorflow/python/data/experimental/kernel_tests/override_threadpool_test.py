@@ -122,6 +122,18 @@ class OverrideThreadpoolTest(test_base.DatasetTestBase,
     self.assertTrue(
         any(node.op != "MaxIntraOpParallelismDataset" for node in graph.node))
 
+  @combinations.generate(test_base.default_test_combinations())
+  def testNumaAware(self):
+    dataset = dataset_ops.Dataset.range(10).interleave(
+        lambda x: dataset_ops.Dataset.range(10 * x, 10 * x + 10),
+        cycle_length=4,
+        num_parallel_calls=4)
+    options = dataset_ops.Options()
+    options.experimental_threading.numa_aware = True
+    dataset = dataset.with_options(options)
+    self.assertDatasetProduces(
+        dataset, expected_output=range(100), assert_items_equal=True)
+
 
 if __name__ == "__main__":
   test.main()
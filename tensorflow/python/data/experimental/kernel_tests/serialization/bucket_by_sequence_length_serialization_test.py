@@ -0,0 +1,54 @@
+# Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for the BucketBySequenceLength serialization."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+from absl.testing import parameterized
+
+from tensorflow.python.data.experimental.kernel_tests.serialization import dataset_serialization_test_base
+from tensorflow.python.data.experimental.ops import grouping
+from tensorflow.python.data.kernel_tests import test_base
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.framework import combinations
+from tensorflow.python.ops import array_ops
+from tensorflow.python.platform import test
+
+
+class BucketBySequenceLengthSerializationTest(
+    dataset_serialization_test_base.DatasetSerializationTestBase,
+    parameterized.TestCase):
+
+  def _build_dataset(self, pad_to_bucket_boundary):
+    # Elements of length 1 go into the first bucket, elements of length 2 and 3
+    # into the second bucket and elements of length 4 and 5 into the third one.
+    return dataset_ops.Dataset.range(20).map(
+        lambda x: array_ops.fill([x % 5 + 1], x)).apply(
+            grouping.bucket_by_sequence_length(
+                lambda x: array_ops.shape(x)[0], [2, 4, 6], [2, 2, 2, 2],
+                pad_to_bucket_boundary=pad_to_bucket_boundary))
+
+  @combinations.generate(
+      combinations.times(
+          test_base.default_test_combinations(),
+          combinations.combine(pad_to_bucket_boundary=[True, False])))
+  def testCore(self, pad_to_bucket_boundary):
+    self.run_core_tests(lambda: self._build_dataset(pad_to_bucket_boundary),
+                        10)
+
+
+if __name__ == '__main__':
+  test.main()
@@ -510,7 +510,9 @@ def distribute(processing_mode,
       of memory used, since `distribute` won't use more than `element_size` *
       `max_outstanding_requests` of memory.
     data_transfer_protocol: (Optional.) The protocol to use for transferring
-      data with the tf.data service, e.g. "grpc".
+      data with the tf.data service, e.g. "grpc". "local" reads elements
+      directly from workers running in the same process, skipping
+      serialization, and falls back to gRPC for other workers.
     compression: How to compress the dataset's elements before transferring them
       over the network. "AUTO" leaves the decision of how to compress up to the
       tf.data service runtime. `None` indicates not to compress.
@@ -27,8 +27,8 @@ from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import ops
 from tensorflow.python.framework import tensor_shape
 from tensorflow.python.framework import tensor_spec
+from tensorflow.python.framework import tensor_util
 from tensorflow.python.ops import array_ops
-from tensorflow.python.ops import check_ops
 from tensorflow.python.ops import gen_experimental_dataset_ops as ged_ops
 from tensorflow.python.ops import math_ops
 from tensorflow.python.util.tf_export import tf_export
@@ -225,43 +225,17 @@ def bucket_by_sequence_length(element_length_func,
       window_size = batch_sizes[bucket_id]
       return window_size
 
-    def make_padded_shapes(shapes, none_filler=None):
-      padded = []
-      for shape in nest.flatten(shapes):
-        shape = tensor_shape.TensorShape(shape)
-        shape = [
-            none_filler if tensor_shape.dimension_value(d) is None else d
-            for d in shape
-        ]
-        padded.append(shape)
-      return nest.pack_sequence_as(shapes, padded)
-
     def batching_fn(bucket_id, grouped_dataset):
       """Batch elements in dataset."""
       batch_size = window_size_fn(bucket_id)
-      if no_padding:
-        return grouped_dataset.batch(batch_size, drop_remainder=drop_remainder)
-      none_filler = None
-      if pad_to_bucket_boundary:
-        err_msg = ("When pad_to_bucket_boundary=True, elements must have "
-                   "length < max(bucket_boundaries).")
-        check = check_ops.assert_less(
-            bucket_id,
-            constant_op.constant(len(bucket_batch_sizes) - 1,
-                                 dtype=dtypes.int64),
-            message=err_msg)
-        with ops.control_dependencies([check]):
-          boundaries = constant_op.constant(bucket_boundaries,
-                                            dtype=dtypes.int64)
-          bucket_boundary = boundaries[bucket_id]
-          none_filler = bucket_boundary - 1
-      input_shapes = dataset_ops.get_legacy_output_shapes(grouped_dataset)
-      shapes = make_padded_shapes(padded_shapes or input_shapes,
-                                  none_filler=none_filler)
-      return grouped_dataset.padded_batch(
-          batch_size, shapes, padding_values, drop_remainder=drop_remainder)
+      return grouped_dataset.batch(batch_size, drop_remainder=drop_remainder)
 
     def _apply_fn(dataset):
+      if not no_padding:
+        return _BucketBySequenceLengthDataset(
+            dataset, element_length_func, bucket_boundaries,
+            bucket_batch_sizes, padded_shapes, padding_values,
+            pad_to_bucket_boundary, drop_remainder)
       return dataset.apply(
           group_by_window(element_to_bucket_id, batching_fn,
                           window_size_func=window_size_fn))
@@ -464,6 +438,104 @@ class _GroupByWindowDataset(dataset_ops.UnaryDataset):
     return "tf.data.experimental.group_by_window()"
 
 
+class _BucketBySequenceLengthDataset(dataset_ops.UnaryDataset):
+  """A `Dataset` that buckets its input by length and pads the batches."""
+
+  def __init__(self, input_dataset, element_length_func, bucket_boundaries,
+               bucket_batch_sizes, padded_shapes, padding_values,
+               pad_to_bucket_boundary, drop_remainder):
+    """See `bucket_by_sequence_length()` for details."""
+
+    def check_types(component_spec):
+      if not isinstance(component_spec, tensor_spec.TensorSpec):
+        raise TypeError("Padded batching of components of type ",
+                        type(component_spec), " is not supported.")
+
+    nest.map_structure(check_types, input_dataset.element_spec)
+    self._input_dataset = input_dataset
+    self._make_element_length_func(element_length_func, input_dataset)
+    self._bucket_boundaries = ops.convert_to_tensor(
+        bucket_boundaries, dtype=dtypes.int64, name="bucket_boundaries")
+    self._bucket_batch_sizes = ops.convert_to_tensor(
+        bucket_batch_sizes, dtype=dtypes.int64, name="bucket_batch_sizes")
+
+    input_shapes = dataset_ops.get_legacy_output_shapes(input_dataset)
+    if padded_shapes is None:
+      padded_shapes = input_shapes
+    flat_padded_shapes = nest.flatten_up_to(input_shapes, padded_shapes)
+    # pylint: disable=protected-access
+    flat_padded_shapes_as_tensors = [
+        dataset_ops._padded_shape_to_tensor(padded_shape, input_shape)
+        for input_shape, padded_shape in zip(
+            nest.flatten(input_shapes), flat_padded_shapes)
+    ]
+
+    padding_values = dataset_ops._padding_values_or_default(
+        padding_values, input_dataset)
+    # If padding_values is a single element and input_shapes is a structure,
+    # "broadcast" padding_values to the same structure as input_shapes.
+    if nest.is_sequence(input_shapes) and not nest.is_sequence(padding_values):
+      padding_values = nest.map_structure(lambda _: padding_values,
+                                          input_shapes)
+    self._padding_values = nest.map_structure_up_to(
+        input_shapes, dataset_ops._padding_value_to_tensor, padding_values,
+        dataset_ops.get_legacy_output_types(input_dataset))
+    # pylint: enable=protected-access
+    self._drop_remainder = ops.convert_to_tensor(
+        drop_remainder, dtype=dtypes.bool, name="drop_remainder")
+
+    # The size of the batch dimension depends on the bucket, and dimensions
+    # padded to the bucket boundary depend on the bucket as well.
+    output_shapes = nest.pack_sequence_as(input_shapes, [
+        tensor_shape.TensorShape([None]).concatenate(
+            tensor_util.constant_value_as_shape(s))
+        for s in flat_padded_shapes_as_tensors
+    ])
+    self._structure = structure.convert_legacy_structure(
+        dataset_ops.get_legacy_output_types(input_dataset), output_shapes,
+        dataset_ops.get_legacy_output_classes(input_dataset))
+
+    variant_tensor = ged_ops.bucket_by_sequence_length_dataset(
+        input_dataset._variant_tensor,  # pylint: disable=protected-access
+        self._element_length_func.function.captured_inputs,
+        bucket_boundaries=self._bucket_boundaries,
+        bucket_batch_sizes=self._bucket_batch_sizes,
+        padded_shapes=flat_padded_shapes_as_tensors,
+        padding_values=nest.flatten(self._padding_values),
+        drop_remainder=self._drop_remainder,
+        num_parallel_calls=dataset_ops.AUTOTUNE,
+        element_length_func=self._element_length_func.function,
+        pad_to_bucket_boundary=pad_to_bucket_boundary,
+        output_shapes=structure.get_flat_tensor_shapes(self._structure))
+    super(_BucketBySequenceLengthDataset, self).__init__(input_dataset,
+                                                         variant_tensor)
+
+  def _make_element_length_func(self, element_length_func, input_dataset):
+    """Make wrapping defun for element_length_func."""
+
+    self._element_length_func = dataset_ops.StructuredFunctionWrapper(
+        element_length_func,
+        self._transformation_name(),
+        dataset=input_dataset)
+    if not (self._element_length_func.output_structure.is_compatible_with(
+        tensor_spec.TensorSpec([], dtypes.int32)) or
+            self._element_length_func.output_structure.is_compatible_with(
+                tensor_spec.TensorSpec([], dtypes.int64))):
+      raise ValueError(
+          "`element_length_func` must return a single tf.int32 or tf.int64 "
+          "scalar tensor.")
+
+  @property
+  def element_spec(self):
+    return self._structure
+
+  def _functions(self):
+    return [self._element_length_func]
+
+  def _transformation_name(self):
+    return "tf.data.experimental.bucket_by_sequence_length()"
+
+
 @tf_export("data.experimental.Reducer")
 class Reducer(object):
   """A reducer is used for reducing a set of elements.
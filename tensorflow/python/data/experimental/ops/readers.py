@@ -656,7 +656,8 @@ class CsvDatasetV2(dataset_ops.DatasetSource):
                use_quote_delim=True,
                na_value="",
                select_cols=None,
-               exclude_cols=None):
+               exclude_cols=None,
+               batch_size=None):
     """Creates a `CsvDataset` by reading and decoding CSV files.
 
     The elements of this dataset correspond to records from the file(s).
@@ -743,6 +744,11 @@ class CsvDatasetV2(dataset_ops.DatasetSource):
         the input data. If specified, only the complement of this set of column
         will be parsed. Defaults to parsing all columns. At most one of
         `select_cols` and `exclude_cols` can be specified.
+      batch_size: (Optional.) A Python integer. If set, each element of the
+        dataset is a batch of up to `batch_size` records, with one vector per
+        column, as if the dataset were followed by `batch(batch_size)`. The
+        fields are converted directly into the batch, without creating a
+        tensor per field. A record that fails to parse fails its whole batch.
 
     Raises:
        InvalidArgumentError: If exclude_cols is not None and
@@ -787,9 +793,16 @@ class CsvDatasetV2(dataset_ops.DatasetSource):
         argument_default=[],
         argument_dtype=dtypes.int64,
     )
+    if batch_size is not None and batch_size <= 0:
+      raise ValueError("`batch_size` must be positive, but got %d." %
+                       batch_size)
+    self._batch_size = batch_size
+    element_shape = [] if batch_size is None else [None]
     self._element_spec = tuple(
-        tensor_spec.TensorSpec([], d.dtype) for d in self._record_defaults)
-    if compat.forward_compatible(2020, 7, 3) or exclude_cols is not None:
+        tensor_spec.TensorSpec(element_shape, d.dtype)
+        for d in self._record_defaults)
+    if (compat.forward_compatible(2020, 7, 3) or exclude_cols is not None or
+        batch_size is not None):
       variant_tensor = gen_experimental_dataset_ops.csv_dataset_v2(
           filenames=self._filenames,
           record_defaults=self._record_defaults,
@@ -801,7 +814,8 @@ class CsvDatasetV2(dataset_ops.DatasetSource):
           na_value=self._na_value,
           select_cols=self._select_cols,
           exclude_cols=self._exclude_cols,
-          compression_type=self._compression_type)
+          compression_type=self._compression_type,
+          batch_size=batch_size or 0)
     else:
       variant_tensor = gen_experimental_dataset_ops.csv_dataset(
           filenames=self._filenames,
@@ -107,3 +107,54 @@ def shuffle_and_repeat(buffer_size, count=None, seed=None):
     return _ShuffleAndRepeatDataset(dataset, buffer_size, count, seed)
 
   return _apply_fn
+
+
+@tf_export("data.experimental.shuffle_with_memory_budget")
+def shuffle_with_memory_budget(buffer_size,
+                               max_buffer_bytes,
+                               seed=None,
+                               reshuffle_each_iteration=None):
+  """Shuffles a Dataset using a buffer bounded by both elements and bytes.
+
+  This transformation behaves like `tf.data.Dataset.shuffle`, except that the
+  shuffle buffer also stops filling once the elements it holds use
+  `max_buffer_bytes` bytes. This makes it possible to pick a generous
+  `buffer_size` without risking running out of memory when elements are large
+  or vary in size:
+
+  >>> d = tf.data.Dataset.range(100)
+  >>> d = d.apply(tf.data.experimental.shuffle_with_memory_budget(
+  ...     buffer_size=100, max_buffer_bytes=80))
+  >>> len(list(d.as_numpy_iterator()))
+  100
+
+  The effective shuffle window is the number of elements that fit within the
+  budget (at least one element). It is logged when the budget is first reached
+  and reported in the iterator's trace metadata.
+
+  Args:
+    buffer_size: A `tf.int64` scalar `tf.Tensor`, representing the maximum
+      number of elements that will be buffered.
+    max_buffer_bytes: A Python integer, representing the maximum number of
+      bytes of elements that will be buffered.
+    seed: (Optional.) A `tf.int64` scalar `tf.Tensor`, representing the random
+      seed that will be used to create the distribution. See
+      `tf.random.set_seed` for behavior.
+    reshuffle_each_iteration: (Optional.) A boolean, which if true indicates
+      that the dataset should be pseudorandomly reshuffled each time it is
+      iterated over. (Defaults to `True`.)
+
+  Returns:
+    A `Dataset` transformation function, which can be passed to
+    `tf.data.Dataset.apply`.
+  """
+
+  def _apply_fn(dataset):  # pylint: disable=missing-docstring
+    return dataset_ops.ShuffleDataset(
+        dataset,
+        buffer_size,
+        seed=seed,
+        reshuffle_each_iteration=reshuffle_each_iteration,
+        max_buffer_bytes=max_buffer_bytes)
+
+  return _apply_fn
@@ -50,12 +50,24 @@ class ThreadingOptions(options.OptionsBase):
       docstring=
       "If set, the dataset will use a private threadpool of the given size.")
 
+  numa_aware = options.create_option(
+      name="numa_aware",
+      ty=bool,
+      docstring=
+      "Whether the dataset should pin independent shards of its input (e.g. "
+      "the elements processed concurrently by a parallel `interleave`) to NUMA "
+      "nodes and allocate their buffers from memory local to that node. Only "
+      "the consumer of the dataset crosses NUMA nodes. Has no effect on "
+      "machines with a single NUMA node. If None, defaults to False.")
+
   def _to_proto(self):
     pb = dataset_options_pb2.ThreadingOptions()
     if self.max_intra_op_parallelism is not None:
       pb.max_intra_op_parallelism = self.max_intra_op_parallelism
     if self.private_threadpool_size is not None:
       pb.private_threadpool_size = self.private_threadpool_size
+    if self.numa_aware is not None:
+      pb.numa_aware = self.numa_aware
     return pb
 
   def _from_proto(self, pb):
@@ -63,3 +75,5 @@ class ThreadingOptions(options.OptionsBase):
       self.max_intra_op_parallelism = pb.max_intra_op_parallelism
     if pb.WhichOneof("optional_private_threadpool_size") is not None:
       self.private_threadpool_size = pb.private_threadpool_size
+    if pb.WhichOneof("optional_numa_aware") is not None:
+      self.numa_aware = pb.numa_aware
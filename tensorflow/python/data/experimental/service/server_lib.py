@@ -31,7 +31,8 @@ from tensorflow.python.util.tf_export import tf_export
 class DispatcherConfig(
     collections.namedtuple("DispatcherConfig", [
         "port", "protocol", "work_dir", "fault_tolerant_mode",
-        "job_gc_check_interval_ms", "job_gc_timeout_ms"
+        "job_gc_check_interval_ms", "job_gc_timeout_ms",
+        "journal_snapshot_interval"
     ])):
   """Configuration class for tf.data service dispatchers.
 
@@ -59,6 +60,12 @@ class DispatcherConfig(
       around longer with no consumers. This is useful if there is a large gap in
       time between when consumers read from the job. A lower value will reduce
       the time it takes to reclaim the resources from expired jobs.
+    journal_snapshot_interval: In fault tolerant mode, how many journal updates
+      the dispatcher writes before snapshotting its state and deleting the
+      journal entries covered by the snapshot. If not set, the runtime will
+      select a reasonable default. A lower value bounds the journal size and
+      dispatcher restart time more tightly, at the cost of more frequent
+      snapshot writes. A value of 0 disables snapshotting.
   """
 
   def __new__(cls,
@@ -67,15 +74,18 @@ class DispatcherConfig(
               work_dir=None,
               fault_tolerant_mode=False,
               job_gc_check_interval_ms=None,
-              job_gc_timeout_ms=None):
+              job_gc_timeout_ms=None,
+              journal_snapshot_interval=None):
     if job_gc_check_interval_ms is None:
       job_gc_check_interval_ms = 10 * 60 * 1000  # 10 minutes.
     if job_gc_timeout_ms is None:
       job_gc_timeout_ms = 5 * 60 * 1000  # 5 minutes.
+    if journal_snapshot_interval is None:
+      journal_snapshot_interval = 10000
     return super(DispatcherConfig,
                  cls).__new__(cls, port, protocol, work_dir,
                               fault_tolerant_mode, job_gc_check_interval_ms,
-                              job_gc_timeout_ms)
+                              job_gc_timeout_ms, journal_snapshot_interval)
 
 
 @tf_export("data.experimental.service.DispatchServer", v1=[])
@@ -139,7 +149,8 @@ class DispatchServer(object):
         work_dir=config.work_dir,
         fault_tolerant_mode=config.fault_tolerant_mode,
         job_gc_check_interval_ms=config.job_gc_check_interval_ms,
-        job_gc_timeout_ms=config.job_gc_timeout_ms)
+        job_gc_timeout_ms=config.job_gc_timeout_ms,
+        journal_snapshot_interval=config.journal_snapshot_interval)
     self._server = _pywrap_server_lib.TF_DATA_NewDispatchServer(
         config_proto.SerializeToString())
     if start:
@@ -218,7 +229,8 @@ class DispatchServer(object):
 class WorkerConfig(
     collections.namedtuple("WorkerConfig", [
         "dispatcher_address", "worker_address", "port", "protocol",
-        "heartbeat_interval_ms", "dispatcher_timeout_ms"
+        "heartbeat_interval_ms", "dispatcher_timeout_ms",
+        "cross_job_sharing_window_size", "cross_job_sharing_lag_timeout_ms"
     ])):
   """Configuration class for tf.data service dispatchers.
 
@@ -238,6 +250,14 @@ class WorkerConfig(
       from finished jobs.
     dispatcher_timeout_ms: How long, in milliseconds, to retry requests to the
       dispatcher before giving up and reporting an error. Defaults to 1 hour.
+    cross_job_sharing_window_size: (Optional.) If positive, jobs which read the
+      same dataset in `"parallel_epochs"` mode share a single iterator on this
+      worker, buffering up to this many elements until all jobs have read them.
+      Defaults to 0, which disables sharing.
+    cross_job_sharing_lag_timeout_ms: How long, in milliseconds, jobs which
+      share an iterator wait for the slowest job to read before detaching it.
+      A detached job skips the buffered elements of an infinite dataset, and
+      continues with its own iterator otherwise. Defaults to 1 minute.
   """
 
   def __new__(cls,
@@ -246,18 +266,24 @@ class WorkerConfig(
               port=0,
               protocol="grpc",
               heartbeat_interval_ms=None,
-              dispatcher_timeout_ms=None):
+              dispatcher_timeout_ms=None,
+              cross_job_sharing_window_size=0,
+              cross_job_sharing_lag_timeout_ms=None):
     if worker_address is None:
       worker_address = "localhost:%port%"
     if heartbeat_interval_ms is None:
       heartbeat_interval_ms = 30 * 1000  # 30 seconds
     if dispatcher_timeout_ms is None:
       dispatcher_timeout_ms = 60 * 60 * 1000  # 1 hour
+    if cross_job_sharing_lag_timeout_ms is None:
+      cross_job_sharing_lag_timeout_ms = 60 * 1000  # 1 minute
 
     return super(WorkerConfig,
                  cls).__new__(cls, dispatcher_address, worker_address, port,
                               protocol, heartbeat_interval_ms,
-                              dispatcher_timeout_ms)
+                              dispatcher_timeout_ms,
+                              cross_job_sharing_window_size,
+                              cross_job_sharing_lag_timeout_ms)
 
 
 @tf_export("data.experimental.service.WorkerServer", v1=[])
@@ -310,7 +336,10 @@ class WorkerServer(object):
           protocol=config.protocol,
           heartbeat_interval_ms=config.heartbeat_interval_ms,
           dispatcher_timeout_ms=config.dispatcher_timeout_ms,
-          data_transfer_protocol=None)
+          data_transfer_protocol=None,
+          cross_job_sharing_window_size=config.cross_job_sharing_window_size,
+          cross_job_sharing_lag_timeout_ms=(
+              config.cross_job_sharing_lag_timeout_ms))
     self._server = _pywrap_server_lib.TF_DATA_NewWorkerServer(
         config_proto.SerializeToString())
     if start:
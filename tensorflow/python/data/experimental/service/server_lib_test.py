@@ -107,6 +107,17 @@ class ServerLibTest(test.TestCase):
         server_lib.WorkerConfig(dispatcher._address, port=port), start=True)
     self.assertEqual(worker._address, "localhost:{}".format(port))
 
+  def testStartWorkerWithCrossJobSharingConfig(self):
+    dispatcher = server_lib.DispatchServer()
+    config = server_lib.WorkerConfig(
+        dispatcher._address,
+        cross_job_sharing_window_size=4,
+        cross_job_sharing_lag_timeout_ms=1000)
+    self.assertEqual(config.cross_job_sharing_window_size, 4)
+    self.assertEqual(config.cross_job_sharing_lag_timeout_ms, 1000)
+    worker = server_lib.WorkerServer(config, start=True)
+    worker._stop()
+
   def testMultipleStartWorker(self):
     dispatcher = server_lib.DispatchServer()
     worker = server_lib.WorkerServer(
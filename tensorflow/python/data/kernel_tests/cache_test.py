@@ -365,6 +365,49 @@ class MemoryCacheTest(test_base.DatasetTestBase, parameterized.TestCase):
       self.assertEqual(next(it1), i)
       self.assertEqual(next(it2), i)
 
+  @combinations.generate(combinations.combine(tf_api_version=2, mode="eager"))
+  def testCacheV2ConcurrentIteratorsShareInput(self):
+    counter = variables.Variable(0)
+
+    def increment_fn(x):
+      counter.assign_add(1)
+      return x
+
+    dataset = dataset_ops.Dataset.range(10).map(increment_fn).cache()
+
+    it1 = iter(dataset)
+    for i in range(3):
+      self.assertEqual(next(it1), i)
+
+    # The second iterator follows the first one and produces the elements that
+    # have not been cached yet on its behalf.
+    it2 = iter(dataset)
+    self.assertEqual([next(it2).numpy() for _ in range(10)], list(range(10)))
+    self.assertEqual(10, self.evaluate(counter))
+
+    for i in range(3, 10):
+      self.assertEqual(next(it1), i)
+    self.assertEqual(10, self.evaluate(counter))
+    with self.assertRaises(StopIteration):
+      next(it1)
+    with self.assertRaises(StopIteration):
+      next(it2)
+
+  @combinations.generate(combinations.combine(tf_api_version=2, mode="eager"))
+  def testCacheV2FollowerOutlivesWriter(self):
+    dataset = dataset_ops.Dataset.range(10).cache()
+
+    it1 = iter(dataset)
+    it2 = iter(dataset)
+    for i in range(5):
+      self.assertEqual(next(it1), i)
+      self.assertEqual(next(it2), i)
+
+    # Deleting the first iterator discards the partially filled cache, so the
+    # second iterator has to produce the remaining elements itself.
+    del it1
+    self.assertEqual([elem.numpy() for elem in it2], list(range(5, 10)))
+
   @combinations.generate(combinations.combine(tf_api_version=2, mode="eager"))
   def testCacheKnownCardinality(self):
 
@@ -160,6 +160,7 @@ class OptionsTest(test_base.DatasetTestBase, parameterized.TestCase):
     options.experimental_slack = True
     options.experimental_threading.max_intra_op_parallelism = 30
     options.experimental_threading.private_threadpool_size = 40
+    options.experimental_threading.numa_aware = True
     pb = options._to_proto()
     result = dataset_ops.Options()
     result._from_proto(pb)
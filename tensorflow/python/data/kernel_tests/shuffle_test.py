@@ -23,6 +23,7 @@ import functools
 from absl.testing import parameterized
 import numpy as np
 
+from tensorflow.python.data.experimental.ops import shuffle_ops
 from tensorflow.python.data.kernel_tests import test_base
 from tensorflow.python.data.ops import dataset_ops
 from tensorflow.python.eager import function
@@ -350,6 +351,32 @@ class ShuffleTest(test_base.DatasetTestBase, parameterized.TestCase):
     self.assertCountEqual(shuffle_1, shuffle_2)
     self.assertNotEqual(shuffle_1, shuffle_2)
 
+  @combinations.generate(test_base.default_test_combinations())
+  def testMemoryBudgetBoundsShuffleWindow(self):
+    # Each int64 element occupies 8 bytes, so the budget admits 10 elements.
+    dataset = dataset_ops.Dataset.range(100).apply(
+        shuffle_ops.shuffle_with_memory_budget(
+            buffer_size=100, max_buffer_bytes=80, seed=42))
+    output = self.getDatasetOutput(dataset)
+    self.assertCountEqual(list(range(100)), output)
+    for i, value in enumerate(output):
+      self.assertLess(value, i + 10)
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testMemoryBudgetSmallerThanElement(self):
+    dataset = dataset_ops.Dataset.range(10).apply(
+        shuffle_ops.shuffle_with_memory_budget(
+            buffer_size=10, max_buffer_bytes=1))
+    # The buffer always admits one element, which degenerates to no shuffling.
+    self.assertDatasetProduces(dataset, expected_output=list(range(10)))
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testInvalidMemoryBudget(self):
+    with self.assertRaisesRegex(ValueError, "must be positive"):
+      dataset_ops.Dataset.range(10).apply(
+          shuffle_ops.shuffle_with_memory_budget(
+              buffer_size=10, max_buffer_bytes=-1))
+
   @combinations.generate(test_base.eager_only_combinations())
   def testCheckpointLargeShuffleBuffer(self):
     # Tensor of size 100M
@@ -166,6 +166,25 @@ class TFRecordDatasetTest(test_base.DatasetTestBase, parameterized.TestCase):
           [self._record(j, i) for i in range(self._num_records)])
     self.assertDatasetProduces(dataset, expected_output=expected_output)
 
+  @combinations.generate(
+      combinations.times(
+          test_base.default_test_combinations(),
+          combinations.combine(use_memory_map=[False, True]),
+          combinations.combine(verify_checksums=[False, True]),
+          combinations.combine(readahead_buffers=[0, 2])))
+  def testReadWithReaderOptions(self, use_memory_map, verify_checksums,
+                                readahead_buffers):
+    dataset = readers.TFRecordDataset(
+        self.test_filenames,
+        use_memory_map=use_memory_map,
+        verify_checksums=verify_checksums,
+        readahead_buffers=readahead_buffers)
+    expected_output = []
+    for j in range(self._num_files):
+      expected_output.extend(
+          [self._record(j, i) for i in range(self._num_records)])
+    self.assertDatasetProduces(dataset, expected_output=expected_output)
+
   @combinations.generate(test_base.default_test_combinations())
   def testReadFromDatasetOfFiles(self):
     files = dataset_ops.Dataset.from_tensor_slices(self.test_filenames)
@@ -374,6 +374,8 @@ class DatasetV2(collections_abc.Iterable, tracking_base.Trackable,
       if t_options.private_threadpool_size is not None:
         dataset = _PrivateThreadPoolDataset(dataset,
                                             t_options.private_threadpool_size)
+      if t_options.numa_aware:
+        dataset = _NumaAwareDataset(dataset)
 
     # (2) Apply autotune options
     autotune, algorithm, cpu_budget, ram_budget = options._autotune_settings()  # pylint: disable=protected-access
@@ -3877,7 +3879,8 @@ class ShuffleDataset(UnaryUnchangedStructureDataset):
                input_dataset,
                buffer_size,
                seed=None,
-               reshuffle_each_iteration=None):
+               reshuffle_each_iteration=None,
+               max_buffer_bytes=None):
     """Randomly shuffles the elements of this dataset.
 
     Args:
@@ -3890,6 +3893,10 @@ class ShuffleDataset(UnaryUnchangedStructureDataset):
       reshuffle_each_iteration: (Optional.) A boolean, which if true indicates
         that the dataset should be pseudorandomly reshuffled each time it is
         iterated over. (Defaults to `True`.)
+      max_buffer_bytes: (Optional.) A Python integer representing the maximum
+        number of bytes of elements to buffer. If set, the shuffle buffer stops
+        filling once either `buffer_size` elements or `max_buffer_bytes` bytes
+        are buffered. (Defaults to no byte limit.)
 
     Returns:
       A `Dataset`.
@@ -3904,9 +3911,18 @@ class ShuffleDataset(UnaryUnchangedStructureDataset):
     if reshuffle_each_iteration is None:
       reshuffle_each_iteration = True
     self._reshuffle_each_iteration = reshuffle_each_iteration
-
-    if (tf2.enabled() and
-        (context.executing_eagerly() or ops.inside_function())):
+    if max_buffer_bytes is None:
+      max_buffer_bytes = 0
+    elif max_buffer_bytes <= 0:
+      raise ValueError("`max_buffer_bytes` must be positive, got {}.".format(
+          max_buffer_bytes))
+    self._max_buffer_bytes = max_buffer_bytes
+
+    # Only `ShuffleDatasetV3` supports a memory budget, so it is used whenever
+    # one is requested.
+    if (self._max_buffer_bytes or
+        (tf2.enabled() and
+         (context.executing_eagerly() or ops.inside_function()))):
       variant_tensor = gen_dataset_ops.shuffle_dataset_v3(
           input_dataset._variant_tensor,  # pylint: disable=protected-access
           buffer_size=self._buffer_size,
@@ -3914,6 +3930,7 @@ class ShuffleDataset(UnaryUnchangedStructureDataset):
           seed2=self._seed2,
           seed_generator=gen_dataset_ops.dummy_seed_generator(),
           reshuffle_each_iteration=self._reshuffle_each_iteration,
+          max_buffer_bytes=self._max_buffer_bytes,
           **self._flat_structure)
     else:
       variant_tensor = gen_dataset_ops.shuffle_dataset(
@@ -4792,6 +4809,17 @@ class _PrivateThreadPoolDataset(UnaryUnchangedStructureDataset):
                                                     variant_tensor)
 
 
+class _NumaAwareDataset(UnaryUnchangedStructureDataset):
+  """A `Dataset` that acts as an identity, making its input NUMA-aware."""
+
+  def __init__(self, input_dataset):
+    self._input_dataset = input_dataset
+    variant_tensor = ged_ops.numa_aware_dataset(
+        input_dataset._variant_tensor,  # pylint: disable=protected-access
+        **self._flat_structure)
+    super(_NumaAwareDataset, self).__init__(input_dataset, variant_tensor)
+
+
 def normalize_to_dense(dataset):
   """Normalizes non-tensor components in a dataset to dense representations.
 
@@ -215,7 +215,13 @@ class TextLineDatasetV1(dataset_ops.DatasetV1Adapter):
 class _TFRecordDataset(dataset_ops.DatasetSource):
   """A `Dataset` comprising records from one or more TFRecord files."""
 
-  def __init__(self, filenames, compression_type=None, buffer_size=None):
+  def __init__(self,
+               filenames,
+               compression_type=None,
+               buffer_size=None,
+               use_memory_map=False,
+               verify_checksums=True,
+               readahead_buffers=0):
     """Creates a `TFRecordDataset`.
 
     Args:
@@ -224,6 +230,13 @@ class _TFRecordDataset(dataset_ops.DatasetSource):
         `""` (no compression), `"ZLIB"`, or `"GZIP"`.
       buffer_size: (Optional.) A `tf.int64` scalar representing the number of
         bytes in the read buffer. 0 means no buffering.
+      use_memory_map: (Optional.) A Python boolean. If true, uncompressed
+        files on local file systems are read through a memory mapping.
+      verify_checksums: (Optional.) A Python boolean. If false, the checksums
+        of record payloads are not verified.
+      readahead_buffers: (Optional.) A Python integer. If non-zero, files are
+        read ahead on a background thread into up to this many buffers of
+        `buffer_size` bytes.
     """
     self._filenames = filenames
     self._compression_type = convert.optional_param_to_tensor(
@@ -235,9 +248,13 @@ class _TFRecordDataset(dataset_ops.DatasetSource):
         "buffer_size",
         buffer_size,
         argument_default=_DEFAULT_READER_BUFFER_SIZE_BYTES)
-    variant_tensor = gen_dataset_ops.tf_record_dataset(self._filenames,
-                                                       self._compression_type,
-                                                       self._buffer_size)
+    variant_tensor = gen_dataset_ops.tf_record_dataset(
+        self._filenames,
+        self._compression_type,
+        self._buffer_size,
+        use_memory_map=use_memory_map,
+        verify_checksums=verify_checksums,
+        readahead_buffers=readahead_buffers)
     super(_TFRecordDataset, self).__init__(variant_tensor)
 
   @property
@@ -307,7 +324,10 @@ class TFRecordDatasetV2(dataset_ops.DatasetV2):
                filenames,
                compression_type=None,
                buffer_size=None,
-               num_parallel_reads=None):
+               num_parallel_reads=None,
+               use_memory_map=False,
+               verify_checksums=True,
+               readahead_buffers=0):
     """Creates a `TFRecordDataset` to read one or more TFRecord files.
 
     Each element of the dataset will contain a single TFRecord.
@@ -327,6 +347,17 @@ class TFRecordDatasetV2(dataset_ops.DatasetV2):
         input pipeline is I/O bottlenecked, consider setting this parameter to a
         value greater than one to parallelize the I/O. If `None`, files will be
         read sequentially.
+      use_memory_map: (Optional.) A Python boolean. If true, uncompressed files
+        on local file systems are read through a memory mapping instead of
+        buffered reads, which avoids a copy of every record. Files that cannot
+        be mapped are read as usual.
+      verify_checksums: (Optional.) A Python boolean. If false, the checksums
+        of record payloads are not verified, which saves a pass over every
+        record. The checksums of record lengths are always verified.
+      readahead_buffers: (Optional.) A Python integer. If non-zero and the
+        read buffer is not disabled, files are read ahead on a background
+        thread in chunks of `buffer_size` bytes, keeping up to this many chunks
+        in memory. This overlaps I/O with the rest of the input pipeline.
 
     Raises:
       TypeError: If any argument does not have the expected type.
@@ -338,9 +369,14 @@ class TFRecordDatasetV2(dataset_ops.DatasetV2):
     self._compression_type = compression_type
     self._buffer_size = buffer_size
     self._num_parallel_reads = num_parallel_reads
+    self._use_memory_map = use_memory_map
+    self._verify_checksums = verify_checksums
+    self._readahead_buffers = readahead_buffers
 
     def creator_fn(filename):
-      return _TFRecordDataset(filename, compression_type, buffer_size)
+      return _TFRecordDataset(filename, compression_type, buffer_size,
+                              use_memory_map, verify_checksums,
+                              readahead_buffers)
 
     self._impl = _create_dataset_reader(creator_fn, filenames,
                                         num_parallel_reads)
@@ -355,7 +391,8 @@ class TFRecordDatasetV2(dataset_ops.DatasetV2):
     return TFRecordDatasetV2(filenames or self._filenames, compression_type or
                              self._compression_type, buffer_size or
                              self._buffer_size, num_parallel_reads or
-                             self._num_parallel_reads)
+                             self._num_parallel_reads, self._use_memory_map,
+                             self._verify_checksums, self._readahead_buffers)
 
   def _inputs(self):
     return self._impl._inputs()  # pylint: disable=protected-access
@@ -373,9 +410,13 @@ class TFRecordDatasetV1(dataset_ops.DatasetV1Adapter):
                filenames,
                compression_type=None,
                buffer_size=None,
-               num_parallel_reads=None):
+               num_parallel_reads=None,
+               use_memory_map=False,
+               verify_checksums=True,
+               readahead_buffers=0):
     wrapped = TFRecordDatasetV2(filenames, compression_type, buffer_size,
-                                num_parallel_reads)
+                                num_parallel_reads, use_memory_map,
+                                verify_checksums, readahead_buffers)
     super(TFRecordDatasetV1, self).__init__(wrapped)
 
   __init__.__doc__ = TFRecordDatasetV2.__init__.__doc__
@@ -390,7 +431,8 @@ class TFRecordDatasetV1(dataset_ops.DatasetV1Adapter):
         filenames or self._dataset._filenames, compression_type or
         self._dataset._compression_type, buffer_size or
         self._dataset._buffer_size, num_parallel_reads or
-        self._dataset._num_parallel_reads)
+        self._dataset._num_parallel_reads, self._dataset._use_memory_map,
+        self._dataset._verify_checksums, self._dataset._readahead_buffers)
 
   @property
   def _filenames(self):